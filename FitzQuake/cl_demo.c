@@ -252,6 +252,8 @@ void CL_Record_f (void)
 		return;
 	}
 
+	COM_AddFileToIndex (name + strlen (com_gamedir) + 1); // mh - so it can be played back straight away
+
 	cls.forcetrack = track;
 	fprintf (cls.demofile, "%i\n", cls.forcetrack);
 
@@ -134,6 +134,9 @@ void CL_Disconnect (void)
 
 	cls.demoplayback = cls.timedemo = false;
 	cls.signon = 0;
+
+	// mh - a map load that was stopped by an error
+	CL_EndPrefetch ();
 }
 
 void CL_Disconnect_f (void)
@@ -206,6 +209,7 @@ Con_DPrintf ("CL_SignonReply: %i\n", cls.signon);
 		break;
 
 	case 3:
+		MD5_CommitLoads ();		// mh - switch in the MD5s that were built on the loader thread
 		MSG_WriteByte (&cls.message, clc_stringcmd);
 		MSG_WriteString (&cls.message, "begin");
 		Cache_Report ();		// print remaining memory
@@ -793,6 +797,8 @@ void CL_Init (void)
 
 	Cvar_RegisterVariable (&cl_maxpitch, NULL); //johnfitz -- variable pitch clamping
 	Cvar_RegisterVariable (&cl_minpitch, NULL); //johnfitz -- variable pitch clamping
+	Cvar_RegisterVariable (&cl_prefetch, NULL); // mh
+	Cvar_RegisterVariable (&cl_prefetchspeeds, NULL); // mh
 
 	Cmd_AddCommand ("entities", CL_PrintEntities_f);
 	Cmd_AddCommand ("disconnect", CL_Disconnect_f);
@@ -346,12 +346,17 @@ void CL_ParseServerInfo (void)
 // now we try to load everything else until a cache allocation fails
 //
 
+	// mh - the files are read ahead of the loaders on other threads
+	CL_StartPrefetch (model_precache, nummodels, sound_precache, numsounds);
+
 	for (i=1 ; i<nummodels ; i++)
 	{
+		CL_PrefetchModel (i);
 		cl.model_precache[i] = Mod_ForName (model_precache[i], false);
 		if (cl.model_precache[i] == NULL)
 		{
 			Con_Printf("Model %s not found\n", model_precache[i]);
+			CL_EndPrefetch ();
 			return;
 		}
 		CL_KeepaliveMessage ();
@@ -360,11 +365,14 @@ void CL_ParseServerInfo (void)
 	S_BeginPrecaching ();
 	for (i=1 ; i<numsounds ; i++)
 	{
+		CL_PrefetchSound (i);
 		cl.sound_precache[i] = S_PrecacheSound (sound_precache[i]);
 		CL_KeepaliveMessage ();
 	}
 	S_EndPrecaching ();
 
+	CL_EndPrefetch ();
+
 
 // local state
 	cl_entities[0].model = cl.worldmodel = cl.model_precache[1];
@@ -378,6 +386,9 @@ void CL_ParseServerInfo (void)
 
 	Hunk_Check ();		// make sure nothing is hurt
 
+	// mh - file index; what the map load cost in lookups
+	Con_DPrintf ("%i file lookups, %i not found (%.2f ms)\n", com_filelookups, com_filemisses, com_filemisstime * 1000.0);
+
 	noclip_anglehack = false;		// noclip is turned off at start
 
 	warn_about_nehahra_protocol = true; //johnfitz -- warn about nehahra protocol hack once per server connection
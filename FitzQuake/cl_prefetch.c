@@ -0,0 +1,387 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// cl_prefetch.c -- reads the precaches ahead of the map load; this file is common to the GL and software renderers
+
+// CL_ParseServerInfo loads the models and then the sounds in precache order, and each one used to wait for the disk
+// before anything else could happen.  the prefetch is given both lists up front and splits each file into stages:
+//
+//	open	main thread		the file is looked up and mapped, as the filesystem isn't safe on any other thread
+//	read	job threads		every page of the mapping is touched, so it's in memory before the loader gets to it
+//	decode	job threads		sounds are parsed and resampled into memory from malloc, by the job that read them
+//	load	main thread		in precache order; models are loaded and uploaded as before, and the decoded sounds are
+//							copied into the cache
+//
+// each file that's opened is a job on the job threads (see sys_jobs.c), and the main thread does the job itself if
+// none of them have got to it by the time it's needed.  the main thread keeps at most PREFETCH_WINDOW files open ahead
+// of the one it's loading.  models are still built whole on the main thread because their loaders allocate on the
+// hunk and upload as they go, so what they get from the prefetch is a file that's already been read.
+
+#include "quakedef.h"
+
+// mh - read the precaches ahead of the map load on other threads
+cvar_t cl_prefetch = {"cl_prefetch", "1"};
+
+// mh - print how long each stage of the prefetch took after the map is loaded
+cvar_t cl_prefetchspeeds = {"cl_prefetchspeeds", "0"};
+
+#define PREFETCH_MAX_ITEMS			(MAX_MODELS + MAX_SOUNDS)
+
+// files open at once; loose files each take one of COM_MapFile's slots
+#define PREFETCH_WINDOW				16
+
+// the reads only have to touch each page once
+#define PREFETCH_PAGESIZE			4096
+
+#define PREFETCH_MODEL	0
+#define PREFETCH_SOUND	1
+
+typedef struct prefetchitem_s
+{
+	int				type;
+	char			name[MAX_QPATH + 8];	// the file, which for a sound is under sound/
+	sfx_t			*sfx;					// the sound it's going into
+
+	// set when the item is opened
+	const byte		*data;
+	int				len;
+
+	// reads it and decodes it, if it's a sound; started when it's opened
+	sysjob_t		job;
+
+	// a sound that's ready for S_CommitSound
+	sfxcache_t		*decoded;
+	int				decodedsize;
+
+	// thread time in each stage
+	double			readtime;
+	double			decodetime;
+} prefetchitem_t;
+
+static prefetchitem_t	prefetch_items[PREFETCH_MAX_ITEMS];
+static int				prefetch_numitems;
+
+// the item for each precache, or -1 if it isn't being prefetched
+static int				prefetch_modelitems[MAX_MODELS];
+static int				prefetch_sounditems[MAX_SOUNDS];
+
+static int				prefetch_numopened;
+static int				prefetch_numfinished;	// items before this have been loaded and closed
+static qboolean			prefetch_active = false;
+
+// stage times for the load, in seconds
+static double			prefetch_starttime;
+static double			prefetch_opentime;
+static double			prefetch_waittime;
+
+
+/*
+==================
+CL_PrefetchRun
+
+the job for an item; runs on whichever thread takes it
+==================
+*/
+static void CL_PrefetchRun (void *data, int first, int count)
+{
+	prefetchitem_t *item = (prefetchitem_t *) data;
+	const volatile byte *filedata;
+	double time1, time2;
+	int i;
+
+	time1 = Sys_ThreadTime ();
+
+	// filedata is volatile so that the reads can't be left out
+	filedata = item->data;
+
+	for (i = 0; i < item->len; i += PREFETCH_PAGESIZE)
+		(void) filedata[i];
+
+	if (item->len > 0)
+		(void) filedata[item->len - 1];
+
+	time2 = Sys_ThreadTime ();
+	item->readtime = time2 - time1;
+
+	if (item->type != PREFETCH_SOUND) return;
+
+	item->decoded = S_DecodeSound (item->data, item->len, &item->decodedsize);
+
+	item->decodetime = Sys_ThreadTime () - time2;
+}
+
+
+/*
+==================
+CL_PrefetchOpen
+
+opens items until there are PREFETCH_WINDOW open that haven't been loaded yet
+==================
+*/
+static void CL_PrefetchOpen (void)
+{
+	double time1 = Sys_FloatTime ();
+
+	while (prefetch_numopened < prefetch_numitems && prefetch_numopened < prefetch_numfinished + PREFETCH_WINDOW)
+	{
+		prefetchitem_t *item = &prefetch_items[prefetch_numopened++];
+		int load = Prof_Begin (PROF_PREFETCH, item->name);
+
+		item->data = COM_MapFile (item->name, &item->len);
+
+		Prof_End (load);
+
+		// missing files are left for the loaders to report
+		if (!item->data) continue;
+
+		item->job.func = CL_PrefetchRun;
+		item->job.data = item;
+		item->job.count = 1;
+		item->job.batch = 1;
+		item->job.maxthreads = 1;
+
+		Sys_StartJob (&item->job);
+	}
+
+	prefetch_opentime += Sys_FloatTime () - time1;
+}
+
+
+/*
+==================
+CL_PrefetchWait
+
+waits for the job threads to finish with an item that's been opened, or does it here if they haven't started it
+==================
+*/
+static void CL_PrefetchWait (prefetchitem_t *item)
+{
+	double time1 = Sys_FloatTime ();
+
+	if (item->data)
+		Sys_FinishJob (&item->job);
+
+	prefetch_waittime += Sys_FloatTime () - time1;
+}
+
+
+/*
+==================
+CL_PrefetchFinish
+
+closes an item once it's been loaded
+==================
+*/
+static void CL_PrefetchFinish (prefetchitem_t *item)
+{
+	CL_PrefetchWait (item);
+
+	if (item->decoded)
+	{
+		free (item->decoded);
+		item->decoded = NULL;
+	}
+
+	COM_UnmapFile (item->data);
+	item->data = NULL;
+}
+
+
+/*
+==================
+CL_PrefetchItem
+
+called before the loader for the item runs; everything before it is closed and it's waited for
+==================
+*/
+static prefetchitem_t *CL_PrefetchItem (int index)
+{
+	prefetchitem_t *item;
+
+	if (!prefetch_active || index < 0) return NULL;
+
+	while (prefetch_numfinished < index)
+		CL_PrefetchFinish (&prefetch_items[prefetch_numfinished++]);
+
+	// the window moves up to this one
+	CL_PrefetchOpen ();
+
+	item = &prefetch_items[index];
+
+	CL_PrefetchWait (item);
+
+	return item;
+}
+
+
+/*
+==================
+CL_PrefetchAdd
+
+==================
+*/
+static int CL_PrefetchAdd (int type, char *name, sfx_t *sfx)
+{
+	prefetchitem_t *item = &prefetch_items[prefetch_numitems];
+
+	memset (item, 0, sizeof (prefetchitem_t));
+
+	item->type = type;
+	item->sfx = sfx;
+
+	if (type == PREFETCH_SOUND)
+		sprintf (item->name, "sound/%s", name);
+	else
+		strcpy (item->name, name);
+
+	return prefetch_numitems++;
+}
+
+
+/*
+==================
+CL_StartPrefetch
+
+index 0 of both lists is unused, the same as the precaches
+==================
+*/
+void CL_StartPrefetch (char models[][MAX_QPATH], int nummodels, char sounds[][MAX_QPATH], int numsounds)
+{
+	sfx_t *sfx;
+	int i;
+
+	// anything left from a load that was stopped by an error
+	CL_EndPrefetch ();
+
+	if (!cl_prefetch.value || !Sys_JobThreads ()) return;
+
+	prefetch_numitems = 0;
+	prefetch_numopened = 0;
+	prefetch_numfinished = 0;
+
+	prefetch_opentime = 0;
+	prefetch_waittime = 0;
+
+	for (i = 0; i < nummodels; i++)
+	{
+		// only what Mod_ForName will read from disk; inline models come with the world
+		if (i > 0 && models[i][0] != '*' && !Mod_IsLoaded (models[i]))
+			prefetch_modelitems[i] = CL_PrefetchAdd (PREFETCH_MODEL, models[i], NULL);
+		else prefetch_modelitems[i] = -1;
+	}
+
+	for (i = 0; i < numsounds; i++)
+	{
+		if (i > 0 && (sfx = S_PrefetchTarget (sounds[i])) != NULL)
+			prefetch_sounditems[i] = CL_PrefetchAdd (PREFETCH_SOUND, sounds[i], sfx);
+		else prefetch_sounditems[i] = -1;
+	}
+
+	if (!prefetch_numitems) return;
+
+	prefetch_active = true;
+	prefetch_starttime = Sys_FloatTime ();
+
+	CL_PrefetchOpen ();
+}
+
+
+/*
+==================
+CL_PrefetchModel
+
+called before Mod_ForName for the model
+==================
+*/
+void CL_PrefetchModel (int index)
+{
+	if (!prefetch_active || index < 0 || index >= MAX_MODELS) return;
+
+	CL_PrefetchItem (prefetch_modelitems[index]);
+}
+
+
+/*
+==================
+CL_PrefetchSound
+
+called before S_PrecacheSound, which will find the sound already in the cache
+==================
+*/
+void CL_PrefetchSound (int index)
+{
+	prefetchitem_t *item;
+
+	if (!prefetch_active || index < 0 || index >= MAX_SOUNDS) return;
+
+	if ((item = CL_PrefetchItem (prefetch_sounditems[index])) == NULL) return;
+
+	// otherwise S_LoadSound reads it again and says what's wrong with it
+	if (item->decoded)
+		S_CommitSound (item->sfx, item->decoded, item->decodedsize);
+}
+
+
+/*
+==================
+CL_EndPrefetch
+
+waits for everything that's still being read and closes it
+==================
+*/
+void CL_EndPrefetch (void)
+{
+	double readtime = 0, decodetime = 0, total;
+	int i, nummodels = 0, numsounds = 0, bytes = 0;
+
+	if (!prefetch_active) return;
+
+	while (prefetch_numfinished < prefetch_numopened)
+		CL_PrefetchFinish (&prefetch_items[prefetch_numfinished++]);
+
+	prefetch_active = false;
+
+	total = Sys_FloatTime () - prefetch_starttime;
+
+	for (i = 0; i < prefetch_numopened; i++)
+	{
+		prefetchitem_t *item = &prefetch_items[i];
+
+		// not found
+		if (item->len < 0) continue;
+
+		if (item->type == PREFETCH_SOUND)
+			numsounds++;
+		else nummodels++;
+
+		bytes += item->len;
+
+		readtime += item->readtime;
+		decodetime += item->decodetime;
+	}
+
+	if (!cl_prefetchspeeds.value) return;
+
+	Con_Printf ("Prefetched %i models and %i sounds, %i KB, in %.1f ms\n", nummodels, numsounds, bytes / 1024, total * 1000.0);
+	Con_Printf ("  open %.1f ms, read %.1f ms and decode %.1f ms on %i job threads\n",
+		prefetch_opentime * 1000.0, readtime * 1000.0, decodetime * 1000.0, Sys_JobThreads ());
+	Con_Printf ("  load %.1f ms, waiting for the prefetch %.1f ms\n",
+		(total - prefetch_opentime - prefetch_waittime) * 1000.0, prefetch_waittime * 1000.0);
+}
@@ -261,6 +261,9 @@ extern	cvar_t	m_yaw;
 extern	cvar_t	m_forward;
 extern	cvar_t	m_side;
 
+extern	cvar_t	cl_prefetch;
+extern	cvar_t	cl_prefetchspeeds;
+
 
 #define	MAX_TEMP_ENTITIES	256		//johnfitz -- was 64
 #define	MAX_STATIC_ENTITIES	512		//johnfitz -- was 128
@@ -349,6 +352,14 @@ void CL_TimeDemo_f (void);
 void CL_ParseServerMessage (void);
 void CL_NewTranslation (int slot);
 
+//
+// cl_prefetch.c
+//
+void CL_StartPrefetch (char models[][MAX_QPATH], int nummodels, char sounds[][MAX_QPATH], int numsounds);
+void CL_PrefetchModel (int index);
+void CL_PrefetchSound (int index);
+void CL_EndPrefetch (void);
+
 //
 // view
 //
@@ -43,6 +43,17 @@ int		mod_numknown;
 texture_t	*r_notexture_mip; //johnfitz -- moved here from r_main.c
 texture_t	*r_notexture_mip2; //johnfitz -- used for non-lightmapped surfs with a missing texture
 
+extern cvar_t r_md5cache;
+extern cvar_t r_md5animcompress;
+void MD5_TimeLoad_f (void);
+void MD5_TimeAnim_f (void);
+
+extern cvar_t r_md5weldtolerance;
+void MD5_TimeWeld_f (void);
+
+extern cvar_t r_md5async;
+extern cvar_t r_md5parsethreads;
+
 /*
 ===============
 Mod_Init
@@ -61,6 +72,24 @@ void Mod_Init (void)
 	strcpy (r_notexture_mip2->name, "notexture2");
 	r_notexture_mip2->height = r_notexture_mip2->width = 32;
 	//johnfitz
+
+	// mh - MD5 cache
+	Cvar_RegisterVariable (&r_md5cache, NULL);
+	Cmd_AddCommand ("timemd5load", MD5_TimeLoad_f);
+
+	// mh - packed MD5 animations
+	Cvar_RegisterVariable (&r_md5animcompress, NULL);
+	Cmd_AddCommand ("timemd5anim", MD5_TimeAnim_f);
+
+	// mh - MD5 normal welding
+	Cvar_RegisterVariable (&r_md5weldtolerance, NULL);
+	Cmd_AddCommand ("timemd5weld", MD5_TimeWeld_f);
+
+	// mh - MD5 loader thread
+	Cvar_RegisterVariable (&r_md5async, NULL);
+
+	// mh - MD5 parse threads
+	Cvar_RegisterVariable (&r_md5parsethreads, NULL);
 }
 
 /*
@@ -182,6 +211,9 @@ void Mod_ClearAll (void)
 	int		i;
 	model_t	*mod;
 
+	// mh - nothing still on the MD5 loader thread can be switched in after this
+	MD5_CancelLoads ();
+
 	for (i=0 , mod=mod_known ; i<mod_numknown ; i++, mod++)
 	{
 		// fixes a texture corruption bug that can occur when a MD5 texture is freed and it's slot gets reused by something else, but that texture was
@@ -253,6 +285,28 @@ void Mod_TouchModel (char *name)
 	}
 }
 
+/*
+==================
+Mod_IsLoaded
+
+mh - false if Mod_ForName will have to load the model from disk
+==================
+*/
+qboolean Mod_IsLoaded (char *name)
+{
+	model_t	*mod;
+
+	mod = Mod_FindName (name);
+
+	if (mod->needload)
+		return false;
+
+	if (mod->type == mod_alias)
+		return Cache_Check (&mod->cache) != NULL;
+
+	return true;
+}
+
 /*
 ==================
 Mod_LoadModel
@@ -265,6 +319,9 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 	void	*d;
 	unsigned *buf;
 	byte	stackbuf[1024];		// avoid dirtying the cache heap
+	const byte	*mapped; // mh
+	int		len;
+	int		load; // mh
 
 	if (!mod->needload)
 	{
@@ -289,14 +346,29 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 //
 // load the file
 //
-	buf = (unsigned *)COM_LoadStackFile (mod->name, stackbuf, sizeof(stackbuf));
-	if (!buf)
+	load = Prof_Begin (PROF_MODEL, mod->name);
+
+	// mh - a brush model is read straight from the file; the others are byte-swapped in place so they get a copy
+	if ((mapped = COM_MapFile (mod->name, &len)) == NULL)
 	{
+		Prof_End (load);
 		if (crash)
 			Sys_Error ("Mod_LoadModel: %s not found", mod->name); //johnfitz -- was "Mod_NumForName"
 		return NULL;
 	}
 
+	if (len < 4 || LittleLong (*(unsigned *)mapped) == IDPOLYHEADER || LittleLong (*(unsigned *)mapped) == IDSPRITEHEADER)
+	{
+		buf = (len + 1 > sizeof(stackbuf)) ? (unsigned *)Hunk_TempAlloc (len + 1) : (unsigned *)stackbuf;
+		memcpy (buf, mapped, len);
+		((byte *)buf)[len] = 0;
+
+		COM_UnmapFile (mapped);
+		mapped = NULL;
+	}
+	else
+		buf = (unsigned *)mapped;
+
 //
 // allocate a new model
 //
@@ -315,19 +387,31 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 	{
 	case IDPOLYHEADER:
 		// attempt to load an MD5 first, falling back on MDL if it fails
-		if (!Mod_LoadMD5Model (mod, buf))
+		if (Mod_LoadMD5Model (mod, buf))
+			Prof_SetType (load, PROF_MD5MODEL);
+		else
+		{
+			Prof_SetType (load, PROF_ALIASMODEL);
 			Mod_LoadAliasModel (mod, buf);
+			MD5_StandIn (mod);
+		}
 		break;
 
 	case IDSPRITEHEADER:
+		Prof_SetType (load, PROF_SPRITEMODEL);
 		Mod_LoadSpriteModel (mod, buf);
 		break;
 
 	default:
+		Prof_SetType (load, PROF_BRUSHMODEL);
 		Mod_LoadBrushModel (mod, buf);
 		break;
 	}
 
+	COM_UnmapFile (mapped);
+
+	Prof_End (load);
+
 	return mod;
 }
 
@@ -390,6 +474,7 @@ void Mod_LoadTextures (lump_t *l)
 	int			nummiptex;
 	unsigned	offset;
 	int			mark, fwidth, fheight;
+	int			dataofs, width, height; // mh
 	char		filename[MAX_OSPATH], filename2[MAX_OSPATH], mapname[MAX_OSPATH];
 	byte		*data;
 	FILE		*f;
@@ -405,8 +490,7 @@ void Mod_LoadTextures (lump_t *l)
 	else
 	{
 		m = (dmiptexlump_t *)(mod_base + l->fileofs);
-		m->nummiptex = LittleLong (m->nummiptex);
-		nummiptex = m->nummiptex;
+		nummiptex = LittleLong (m->nummiptex); // mh - the bsp is read-only now, so nothing in it is swapped in place
 	}
 	//johnfitz
 
@@ -415,26 +499,24 @@ void Mod_LoadTextures (lump_t *l)
 
 	for (i=0 ; i<nummiptex ; i++)
 	{
-		m->dataofs[i] = LittleLong(m->dataofs[i]);
-		if (m->dataofs[i] == -1)
+		dataofs = LittleLong (m->dataofs[i]);
+		if (dataofs == -1)
 			continue;
-		mt = (miptex_t *)((byte *)m + m->dataofs[i]);
-		mt->width = LittleLong (mt->width);
-		mt->height = LittleLong (mt->height);
-		for (j=0 ; j<MIPLEVELS ; j++)
-			mt->offsets[j] = LittleLong (mt->offsets[j]);
+		mt = (miptex_t *)((byte *)m + dataofs);
+		width = LittleLong (mt->width);
+		height = LittleLong (mt->height);
 
-		if ( (mt->width & 15) || (mt->height & 15) )
+		if ( (width & 15) || (height & 15) )
 			Sys_Error ("Texture %s is not 16 aligned", mt->name);
-		pixels = mt->width*mt->height/64*85;
+		pixels = width*height/64*85;
 		tx = Hunk_AllocName (sizeof(texture_t) +pixels, loadname );
 		loadmodel->textures[i] = tx;
 
 		memcpy (tx->name, mt->name, sizeof(tx->name));
-		tx->width = mt->width;
-		tx->height = mt->height;
+		tx->width = width;
+		tx->height = height;
 		for (j=0 ; j<MIPLEVELS ; j++)
-			tx->offsets[j] = mt->offsets[j] + sizeof(texture_t) - sizeof(miptex_t);
+			tx->offsets[j] = LittleLong (mt->offsets[j]) + sizeof(texture_t) - sizeof(miptex_t);
 		// the pixels immediately follow the structures
 		memcpy ( tx+1, mt+1, pixels);
 
@@ -1530,6 +1612,7 @@ void Mod_LoadBrushModel (model_t *mod, void *buffer)
 {
 	int			i, j;
 	dheader_t	*header;
+	dheader_t	swapped; // mh
 	dmodel_t 	*bm;
 	float		radius; //johnfitz
 
@@ -1544,6 +1627,10 @@ void Mod_LoadBrushModel (model_t *mod, void *buffer)
 // swap all the lumps
 	mod_base = (byte *)header;
 
+	// mh - into a copy, as the file is read-only now
+	swapped = *header;
+	header = &swapped;
+
 	for (i=0 ; i<sizeof(dheader_t)/4 ; i++)
 		((int *)header)[i] = LittleLong ( ((int *)header)[i]);
 
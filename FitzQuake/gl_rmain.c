@@ -35,6 +35,9 @@ mplane_t	frustum[4];
 //johnfitz -- rendering statistics
 int rs_brushpolys, rs_aliaspolys, rs_skypolys, rs_particles, rs_fogpolys;
 int rs_dynamiclightmaps, rs_brushpasses, rs_aliaspasses, rs_skypasses;
+int rs_md5skinhits, rs_md5skinmisses, rs_md5skins; // mh - MD5 skin cache
+int rs_md5drawn, rs_md5culled; // mh - MD5 culling
+int rs_md5drawcalls, rs_md5verts; // mh - MD5 submissions
 float rs_megatexels;
 
 qboolean	envmap;				// true during envmap command capture
@@ -783,10 +786,14 @@ void R_RenderScene (void)
 
 	Sky_DrawSky (); //johnfitz
 
+	R_BeginMD5Skinning (); // mh - skin MD5s on other threads while the world is drawn
+
 	R_DrawWorld ();
 
 	S_ExtraUpdate (); // don't let sound get messed up if going slow
 
+	R_FinishMD5Skinning (); // mh - everything after this may draw MD5s
+
 	R_DrawShadows (); //johnfitz -- render entity shadows
 
 	R_DrawEntitiesOnList (false); //johnfitz -- false means this is the pass for nonalpha entities
@@ -834,7 +841,8 @@ void R_RenderView (void)
 
 		//johnfitz -- rendering statistics
 		rs_brushpolys = rs_aliaspolys = rs_skypolys = rs_particles = rs_fogpolys = rs_megatexels =
-		rs_dynamiclightmaps = rs_aliaspasses = rs_skypasses = rs_brushpasses = 0;
+		rs_dynamiclightmaps = rs_aliaspasses = rs_skypasses = rs_brushpasses =
+		rs_md5skinhits = rs_md5skinmisses = rs_md5skins = rs_md5drawn = rs_md5culled = rs_md5drawcalls = rs_md5verts = 0;
 	}
 	else if (gl_finish.value)
 		glFinish ();
@@ -885,7 +893,7 @@ void R_RenderView (void)
 	//johnfitz -- modified r_speeds output
 	time2 = Sys_FloatTime ();
 	if (r_speeds.value == 2)
-		Con_Printf ("%3i ms  %4i/%4i wpoly %4i/%4i epoly %3i lmap %4i/%4i sky %1.1f mtex\n",
+		Con_Printf ("%3i ms  %4i/%4i wpoly %4i/%4i epoly %3i lmap %4i/%4i sky %1.1f mtex %3i/%3i md5skin %3i/%3i md5 %3i/%5i md5draw %3i/%3i md5inst\n",
 					(int)((time2-time1)*1000),
 					rs_brushpolys,
 					rs_brushpasses,
@@ -894,7 +902,15 @@ void R_RenderView (void)
 					rs_dynamiclightmaps,
 					rs_skypolys,
 					rs_skypasses,
-					TexMgr_FrameUsage ());
+					TexMgr_FrameUsage (),
+					rs_md5skinhits,
+					rs_md5skinmisses,
+					rs_md5drawn,
+					rs_md5culled,
+					rs_md5drawcalls,
+					rs_md5verts,
+					rs_md5skins,
+					rs_md5skinhits + rs_md5skinmisses);
 	else if (r_speeds.value)
 		Con_Printf ("%3i ms  %4i wpoly %4i epoly %3i lmap\n",
 					(int)((time2-time1)*1000),
@@ -44,6 +44,19 @@ extern cvar_t r_lerpmove;
 extern cvar_t r_nolerp_list;
 //johnfitz
 
+// mh - MD5 skinning
+extern cvar_t r_md5skin;
+extern cvar_t r_md5skincheck;
+extern cvar_t r_md5lerp;
+void MD5_TimeLerp_f (void);
+extern cvar_t r_md5threads;
+extern cvar_t r_md5vbo;
+extern cvar_t r_md5blendstep;
+extern cvar_t r_md5lod;
+extern cvar_t r_md5lodsize;
+extern cvar_t r_md5animlod;
+extern cvar_t r_md5animlodframes;
+
 extern float load_subdivide_size; //johnfitz -- remember what subdivide_size value was when this map was loaded
 
 extern cvar_t gl_subdivide_size; //johnfitz -- moved here from gl_model.c
@@ -235,6 +248,19 @@ void R_Init (void)
 
 	Cvar_RegisterVariable (&gl_subdivide_size, NULL); //johnfitz -- moved here from gl_model.c
 
+	// mh - MD5 skinning
+	Cvar_RegisterVariable (&r_md5skin, NULL);
+	Cvar_RegisterVariable (&r_md5skincheck, NULL);
+	Cvar_RegisterVariable (&r_md5threads, NULL);
+	Cvar_RegisterVariable (&r_md5lerp, NULL);
+	Cvar_RegisterVariable (&r_md5vbo, NULL);
+	Cvar_RegisterVariable (&r_md5blendstep, NULL);
+	Cvar_RegisterVariable (&r_md5lod, NULL);
+	Cvar_RegisterVariable (&r_md5lodsize, NULL);
+	Cvar_RegisterVariable (&r_md5animlod, NULL);
+	Cvar_RegisterVariable (&r_md5animlodframes, NULL);
+	Cmd_AddCommand ("timemd5lerp", MD5_TimeLerp_f);
+
 #ifdef UNDERWATER_WARP
 	Cvar_RegisterVariable (&r_waterwarp_cycle, NULL);
 	Cvar_RegisterVariable (&r_waterwarp_amp, NULL);
@@ -394,6 +420,10 @@ void R_NewMap (void)
 	Sky_NewMap (); //johnfitz -- skybox in worldspawn
 	Fog_NewMap (); //johnfitz -- global fog in worldspawn
 
+	R_FlushMD5SkinCache (); // mh - entities and r_framecount were just reset
+	MD5_FlushPoseCache (); // mh - models may have been freed
+	R_FlushMD5Buffers (); // mh - so have the buffers they were drawn from
+
 	load_subdivide_size = gl_subdivide_size.value; //johnfitz -- is this the right place to set this?
 }
 
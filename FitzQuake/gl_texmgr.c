@@ -1159,10 +1159,13 @@ gltexture_t *TexMgr_LoadImage (model_t *owner, char *name, int width, int height
 	unsigned short crc;
 	gltexture_t *glt;
 	int mark, bytes;
+	int load; // mh
 
 	if (isDedicated)
 		return NULL;
 
+	load = Prof_Begin (PROF_TEXTURE, name);
+
 	// cache check
 	switch (format)
 	{
@@ -1179,7 +1182,10 @@ gltexture_t *TexMgr_LoadImage (model_t *owner, char *name, int width, int height
 	if ((flags & TEXPREF_OVERWRITE) && (glt = TexMgr_FindTexture (owner, name)))
 	{
 		if (glt->source_crc == crc)
+		{
+			Prof_End (load);
 			return glt;
+		}
 	}
 	else
 		glt = TexMgr_NewTexture ();
@@ -1217,6 +1223,8 @@ gltexture_t *TexMgr_LoadImage (model_t *owner, char *name, int width, int height
 
 	Hunk_FreeToLowMark(mark);
 
+	Prof_End (load);
+
 	return glt;
 }
 
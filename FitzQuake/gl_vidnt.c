@@ -133,12 +133,20 @@ typedef void (APIENTRY *lp3DFXFUNC) (int, int, int, int, int, const void*);
 
 extern MTEXCOORDFUNC GL_MTexCoord2fFunc = NULL; //johnfitz
 extern SELECTTEXFUNC GL_SelectTextureFunc = NULL; //johnfitz
+SELECTTEXFUNC GL_ClientActiveTextureFunc = NULL; // mh
 
 typedef BOOL (APIENTRY * SETSWAPFUNC) (int); //johnfitz
 typedef int (APIENTRY * GETSWAPFUNC) (void); //johnfitz
 SETSWAPFUNC wglSwapIntervalEXT = NULL; //johnfitz
 GETSWAPFUNC wglGetSwapIntervalEXT = NULL; //johnfitz
 
+// mh - vertex buffer objects
+BINDBUFFERFUNC GL_BindBufferFunc = NULL;
+DELETEBUFFERSFUNC GL_DeleteBuffersFunc = NULL;
+GENBUFFERSFUNC GL_GenBuffersFunc = NULL;
+BUFFERDATAFUNC GL_BufferDataFunc = NULL;
+BUFFERSUBDATAFUNC GL_BufferSubDataFunc = NULL;
+
 qboolean isPermedia = false;
 qboolean isIntelVideo = false; //johnfitz -- intel video workarounds from Baker
 qboolean gl_mtexable = false;
@@ -146,6 +154,7 @@ qboolean gl_texture_env_combine = false; //johnfitz
 qboolean gl_texture_env_add = false; //johnfitz
 qboolean gl_swap_control = false; //johnfitz
 qboolean gl_anisotropy_able = false; //johnfitz
+qboolean gl_vbo_able = false; // mh
 float gl_max_anisotropy; //johnfitz
 
 int			gl_stencilbits; //johnfitz
@@ -792,6 +801,7 @@ void VID_Restart (void)
  				Sys_Error (szBuf);
 			}
 			TexMgr_ReloadImages ();
+			R_FlushMD5Buffers (); // mh - buffers went with the old context
 			GL_SetupState ();
 		}
 
@@ -1025,6 +1035,9 @@ void GL_CheckExtensions (void)
 				TEXTURE0 = GL_TEXTURE0_ARB;
 				TEXTURE1 = GL_TEXTURE1_ARB;
 				gl_mtexable = true;
+
+				// mh - only needed for multitexturing from vertex arrays
+				GL_ClientActiveTextureFunc = (void *) wglGetProcAddress("glClientActiveTextureARB");
 			}
 			else
 				Con_Warning ("multitexture not supported (wglGetProcAddress failed)\n");
@@ -1143,6 +1156,31 @@ void GL_CheckExtensions (void)
 	}
 	else
 		Con_Warning ("texture_filter_anisotropic not supported\n");
+
+	//
+	// vertex buffer objects (mh)
+	//
+	if (COM_CheckParm("-novbo"))
+		Con_Warning ("vertex buffer objects disabled at command line\n");
+	else
+		if (strstr(gl_extensions, "GL_ARB_vertex_buffer_object"))
+		{
+			GL_BindBufferFunc = (BINDBUFFERFUNC) wglGetProcAddress("glBindBufferARB");
+			GL_DeleteBuffersFunc = (DELETEBUFFERSFUNC) wglGetProcAddress("glDeleteBuffersARB");
+			GL_GenBuffersFunc = (GENBUFFERSFUNC) wglGetProcAddress("glGenBuffersARB");
+			GL_BufferDataFunc = (BUFFERDATAFUNC) wglGetProcAddress("glBufferDataARB");
+			GL_BufferSubDataFunc = (BUFFERSUBDATAFUNC) wglGetProcAddress("glBufferSubDataARB");
+
+			if (GL_BindBufferFunc && GL_DeleteBuffersFunc && GL_GenBuffersFunc && GL_BufferDataFunc && GL_BufferSubDataFunc)
+			{
+				Con_Printf("FOUND: ARB_vertex_buffer_object\n");
+				gl_vbo_able = true;
+			}
+			else
+				Con_Warning ("vertex buffer objects not supported (wglGetProcAddress failed)\n");
+		}
+		else
+			Con_Warning ("vertex buffer objects not supported (extension not found)\n");
 }
 
 /*
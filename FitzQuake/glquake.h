@@ -196,6 +196,7 @@ typedef void (APIENTRY *SELECTTEXFUNC) (GLenum);
 typedef void (APIENTRY *MTEXCOORDFUNC) (GLenum, GLfloat, GLfloat);
 extern MTEXCOORDFUNC GL_MTexCoord2fFunc;
 extern SELECTTEXFUNC GL_SelectTextureFunc;
+extern SELECTTEXFUNC GL_ClientActiveTextureFunc; // mh - NULL unless the texcoord arrays can be set per TMU
 #define	GL_TEXTURE0_ARB	0x84C0
 #define	GL_TEXTURE1_ARB	0x84C1
 extern GLenum TEXTURE0, TEXTURE1;
@@ -235,9 +236,29 @@ extern qboolean gl_texture_env_add; //johnfitz -- for GL_EXT_texture_env_add
 
 extern qboolean isIntelVideo; //johnfitz -- intel video workarounds from Baker
 
+// mh - GL_ARB_vertex_buffer_object
+#define GL_ARRAY_BUFFER_ARB			0x8892
+#define GL_ELEMENT_ARRAY_BUFFER_ARB	0x8893
+#define GL_STREAM_DRAW_ARB			0x88E0
+#define GL_STATIC_DRAW_ARB			0x88E4
+typedef void (APIENTRY *BINDBUFFERFUNC) (GLenum, GLuint);
+typedef void (APIENTRY *DELETEBUFFERSFUNC) (GLsizei, const GLuint *);
+typedef void (APIENTRY *GENBUFFERSFUNC) (GLsizei, GLuint *);
+typedef void (APIENTRY *BUFFERDATAFUNC) (GLenum, ptrdiff_t, const GLvoid *, GLenum);
+typedef void (APIENTRY *BUFFERSUBDATAFUNC) (GLenum, ptrdiff_t, ptrdiff_t, const GLvoid *);
+extern BINDBUFFERFUNC GL_BindBufferFunc;
+extern DELETEBUFFERSFUNC GL_DeleteBuffersFunc;
+extern GENBUFFERSFUNC GL_GenBuffersFunc;
+extern BUFFERDATAFUNC GL_BufferDataFunc;
+extern BUFFERSUBDATAFUNC GL_BufferSubDataFunc;
+extern qboolean gl_vbo_able;
+
 //johnfitz -- rendering statistics
 extern int rs_brushpolys, rs_aliaspolys, rs_skypolys, rs_particles, rs_fogpolys;
 extern int rs_dynamiclightmaps, rs_brushpasses, rs_aliaspasses, rs_skypasses;
+extern int rs_md5skinhits, rs_md5skinmisses, rs_md5skins;
+extern int rs_md5drawn, rs_md5culled;
+extern int rs_md5drawcalls, rs_md5verts;
 extern float rs_megatexels;
 //johnfitz
 
@@ -287,6 +308,12 @@ void Fog_NewMap (void);
 void Fog_Init (void);
 //johnfitz
 
+// mh - MD5 skinning threads
+void R_BeginMD5Skinning (void);
+void R_FinishMD5Skinning (void);
+void R_FlushMD5SkinCache (void);
+void R_FlushMD5Buffers (void);
+
 
 #ifdef UNDERWATER_WARP
 extern cvar_t r_waterwarp_cycle;
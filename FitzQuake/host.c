@@ -528,6 +528,12 @@ void Host_ClearMemory (void)
 	if (host_hunklevel)
 		Hunk_FreeToLowMark (host_hunklevel);
 
+	// mh - pick up anything that's been added to the game directories since the last map
+	COM_BuildFileIndex ();
+
+	// mh - the load profiler starts again with the new map
+	Prof_Reset ();
+
 	cls.signon = 0;
 	memset (&sv, 0, sizeof(sv));
 	memset (&cl, 0, sizeof(cl));
@@ -817,6 +823,7 @@ void Host_Init (quakeparms_t *parms)
 	V_Init ();
 	Chase_Init ();
 	COM_Init (parms->basedir);
+	Prof_Init (); // mh
 	Host_InitLocal ();
 	W_LoadWadFile (); //johnfitz -- filename is now hard-coded for honesty
 	Key_Init ();
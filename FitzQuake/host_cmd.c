@@ -67,6 +67,8 @@ typedef struct pack_s
 	int             handle;
 	int             numfiles;
 	packfile_t      *files;
+	byte            *mapped;
+	int             mappedlen;
 } pack_t;
 
 typedef struct searchpath_s
@@ -94,6 +96,7 @@ void KillGameDir(searchpath_t *search)
 			return; //once you hit the dir, youve already freed the paks
 		}
 		Sys_FileClose (search->pack->handle); //johnfitz
+		if (search->pack->mapped) Sys_UnmapFile (search->pack->mapped, search->pack->mappedlen); // mh
 		search_killer = search->next;
 		Z_Free(search->pack->files);
 		Z_Free(search->pack);
@@ -187,6 +190,9 @@ void Host_Game_f (void)
 			}
 		}
 
+		// mh - the search path has changed
+		COM_BuildFileIndex ();
+
 		//clear out and reload appropriate data
 		Cache_Flush ();
 		if (!isDedicated)
@@ -0,0 +1,375 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// md5_async.c -- MD5 loader jobs; this file is common to the GL and software renderers
+
+// MD5s that have to be built from the text files are built by jobs on the job threads (see sys_jobs.c), called the
+// loader thread here, so that the parse overlaps the rest of the map load, with the MDL they replace standing in
+// until they're ready.  the hunk belongs to the main thread, so anything that builds an MD5 allocates through
+// MD5_HunkAlloc, which puts it in a private staging arena when it's called from a job and on the hunk otherwise.  the
+// arena has marks the same as the hunk so that code which frees back to a mark works unchanged.  the job gives the
+// finished model back to the main thread in whatever form it likes (mod_md5.c uses the .md5c cache layout) and the
+// arena is thrown away.
+//
+// MD5_RunSplit spreads independent pieces of a load over the job threads as well, such as the frames of an md5anim.
+// whoever calls it helps out and it returns when everything's done, so it can be used from either the main thread or
+// a job.  the pieces mustn't allocate.
+
+#include "quakedef.h"
+
+// mh - build MD5s that aren't in the cache on the loader thread; the MDL is drawn until they're done
+cvar_t r_md5async = {"r_md5async", "1"};
+
+// mh - threads to help parse MD5s with; -1 is one less than the number of cores, 0 parses on the calling thread only
+cvar_t r_md5parsethreads = {"r_md5parsethreads", "-1"};
+
+#ifdef _MSC_VER
+#define MD5_THREADLOCAL	__declspec (thread)
+#else
+#define MD5_THREADLOCAL	__thread
+#endif
+
+// most MD5s fit in a few of these
+#define MD5_ARENA_CHUNK		(1024 * 1024)
+
+typedef struct md5arenachunk_s
+{
+	struct md5arenachunk_s *prev;
+
+	// the arena mark at the start of this chunk
+	int base;
+	int size;
+	int used;
+} md5arenachunk_t;
+
+// the chunk header is padded so that the memory after it stays 16-byte aligned
+#define MD5_CHUNK_HEADER	((sizeof (md5arenachunk_t) + 15) & ~15)
+
+// the job that's being built on this thread, NULL if it isn't building one
+static MD5_THREADLOCAL md5job_t *md5_currentjob = NULL;
+
+
+/*
+==================
+MD5_FreeArena
+
+==================
+*/
+static void MD5_FreeArena (md5job_t *job)
+{
+	while (job->arena)
+	{
+		md5arenachunk_t *chunk = job->arena;
+
+		job->arena = chunk->prev;
+		free (chunk);
+	}
+}
+
+
+/*
+==================
+MD5_HunkAlloc
+
+zero-filled and 16-byte aligned, the same as Hunk_Alloc
+==================
+*/
+void *MD5_HunkAlloc (int size)
+{
+	md5job_t *job = md5_currentjob;
+	md5arenachunk_t *chunk;
+	byte *buf;
+
+	if (!job) return Hunk_Alloc (size);
+
+	if (size < 0)
+		Sys_Error ("MD5_HunkAlloc: bad size: %i", size);
+
+	size = (size + 15) & ~15;
+	chunk = job->arena;
+
+	if (!chunk || chunk->size - chunk->used < size)
+	{
+		int chunksize = (size > MD5_ARENA_CHUNK) ? size : MD5_ARENA_CHUNK;
+		md5arenachunk_t *newchunk = (md5arenachunk_t *) malloc (MD5_CHUNK_HEADER + chunksize);
+
+		if (!newchunk)
+			Sys_Error ("MD5_HunkAlloc: failed on %i bytes", size);
+
+		// the unused end of the previous chunk is skipped over, so marks stay increasing
+		newchunk->prev = chunk;
+		newchunk->base = chunk ? chunk->base + chunk->used : 0;
+		newchunk->size = chunksize;
+		newchunk->used = 0;
+
+		job->arena = chunk = newchunk;
+	}
+
+	buf = (byte *) chunk + MD5_CHUNK_HEADER + chunk->used;
+	chunk->used += size;
+
+	memset (buf, 0, size);
+
+	return buf;
+}
+
+
+/*
+==================
+MD5_HunkLowMark
+
+==================
+*/
+int MD5_HunkLowMark (void)
+{
+	md5job_t *job = md5_currentjob;
+
+	if (!job) return Hunk_LowMark ();
+
+	return job->arena ? job->arena->base + job->arena->used : 0;
+}
+
+
+/*
+==================
+MD5_HunkFreeToLowMark
+
+==================
+*/
+void MD5_HunkFreeToLowMark (int mark)
+{
+	md5job_t *job = md5_currentjob;
+
+	if (!job)
+	{
+		Hunk_FreeToLowMark (mark);
+		return;
+	}
+
+	if (mark < 0 || mark > MD5_HunkLowMark ())
+		Sys_Error ("MD5_HunkFreeToLowMark: bad mark %i", mark);
+
+	// chunks that start after the mark go completely, and the one it's in is cut back to it
+	while (job->arena && job->arena->base > mark)
+	{
+		md5arenachunk_t *chunk = job->arena;
+
+		job->arena = chunk->prev;
+		free (chunk);
+	}
+
+	if (job->arena)
+		job->arena->used = mark - job->arena->base;
+}
+
+
+/*
+==================
+MD5_OnLoaderThread
+
+==================
+*/
+qboolean MD5_OnLoaderThread (void)
+{
+	return md5_currentjob != NULL;
+}
+
+
+/*
+==================
+MD5_DPrintf
+
+the console isn't safe to print to from the loader thread, so the job keeps it's messages until it's finished
+==================
+*/
+void MD5_DPrintf (char *fmt, ...)
+{
+	md5job_t *job = md5_currentjob;
+	va_list argptr;
+	char msg[4096];
+	int len;
+
+	if (job ? !job->developer : !developer.value) return;
+
+	va_start (argptr, fmt);
+	vsprintf (msg, fmt, argptr);
+	va_end (argptr);
+
+	if (!job)
+	{
+		Con_DPrintf ("%s", msg);
+		return;
+	}
+
+	len = strlen (msg);
+
+	if (job->loglen + len + 1 > job->logsize)
+	{
+		int newsize = (job->logsize + len + 1) * 2;
+		char *newlog = (char *) realloc (job->log, newsize);
+
+		// messages are dropped rather than failing the load
+		if (!newlog) return;
+
+		job->log = newlog;
+		job->logsize = newsize;
+	}
+
+	memcpy (job->log + job->loglen, msg, len + 1);
+	job->loglen += len;
+}
+
+
+/*
+==================
+MD5_RunJob
+
+runs a queued job's build on whichever thread takes it
+==================
+*/
+static void MD5_RunJob (void *data, int first, int count)
+{
+	md5job_t *job = (md5job_t *) data;
+
+	md5_currentjob = job;
+	job->build (job);
+	md5_currentjob = NULL;
+
+	// whatever the job wants to keep has been copied out of the arena by now
+	MD5_FreeArena (job);
+}
+
+
+/*
+==================
+MD5_ParseThreads
+
+==================
+*/
+static int MD5_ParseThreads (void)
+{
+	if (r_md5parsethreads.value < 0)
+		return Sys_NumProcessors () - 1;
+	else return (int) r_md5parsethreads.value;
+}
+
+
+/*
+==================
+MD5_RunSplit
+
+calls func for every piece from 0 to count, in batches of up to batch pieces spread over the job threads, and returns
+once they've all been done.  the order the batches are run in isn't defined, so each must only write it's own results.
+==================
+*/
+void MD5_RunSplit (md5splitfunc_t func, void *data, int count, int batch)
+{
+	sysjob_t split;
+
+	if (count < 1) return;
+	if (batch < 1) batch = 1;
+
+	split.func = func;
+	split.data = data;
+	split.count = count;
+	split.batch = batch;
+
+	// a job goes by what r_md5parsethreads was when it was queued
+	split.maxthreads = md5_currentjob ? md5_currentjob->parsethreads : MD5_ParseThreads ();
+
+	// there's no point in having threads sitting idle
+	if (split.maxthreads > (count + batch - 1) / batch - 1)
+		split.maxthreads = (count + batch - 1) / batch - 1;
+
+	Sys_StartJob (&split);
+	Sys_FinishJob (&split);
+}
+
+
+/*
+==================
+MD5_QueueJob
+
+returns false if the job can't be run on the loader thread, in which case the caller should load it itself
+==================
+*/
+qboolean MD5_QueueJob (md5job_t *job)
+{
+	if (!r_md5async.value) return false;
+
+	job->developer = (developer.value != 0);
+	job->parsethreads = MD5_ParseThreads ();
+	job->arena = NULL;
+	job->log = NULL;
+	job->loglen = job->logsize = 0;
+
+	job->sysjob.func = MD5_RunJob;
+	job->sysjob.data = job;
+	job->sysjob.count = 1;
+	job->sysjob.batch = 1;
+	job->sysjob.maxthreads = 1;
+
+	return Sys_StartJob (&job->sysjob);
+}
+
+
+/*
+==================
+MD5_JobDone
+
+==================
+*/
+qboolean MD5_JobDone (md5job_t *job)
+{
+	return Sys_JobDone (&job->sysjob);
+}
+
+
+/*
+==================
+MD5_WaitJob
+
+called by the main thread to wait for a queued job to finish, which builds it there if no job thread has started it
+==================
+*/
+void MD5_WaitJob (md5job_t *job)
+{
+	Sys_FinishJob (&job->sysjob);
+}
+
+
+/*
+==================
+MD5_ReleaseJob
+
+called by the main thread once it's done with a finished job; prints anything the job logged
+==================
+*/
+void MD5_ReleaseJob (md5job_t *job)
+{
+	if (job->log)
+	{
+		Con_DPrintf ("%s", job->log);
+		free (job->log);
+	}
+
+	job->log = NULL;
+	job->loglen = job->logsize = 0;
+}
@@ -0,0 +1,856 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// md5_lod.c -- distance-based level of detail for MD5 models; this file is common to the GL and software renderers
+
+// at load time each submesh is simplified into up to MD5_MAX_LODS lower detail levels by quadric edge collapse.  every
+// collapse moves a vertex onto one of it's neighbours (a half-edge collapse) so the levels are only different sets of
+// triangles over the same vertexes, and the skinning, lighting and texcoords are shared by all of them.  vertexes on
+// an open edge are never moved, which keeps UV seams, submesh borders and holes closed, and vertexes are only moved
+// onto neighbours with nearly the same weights so that they still follow the same joints when animated.
+//
+// at run time each entity picks a level from how big it is on screen, and entities that are small enough keep the
+// last skin they were given for a few frames instead of being skinned every frame.
+
+#include "quakedef.h"
+
+// the projected height in pixels below which the first level is used; each level after it is used below half the
+// size of the one before
+cvar_t r_md5lod = {"r_md5lod", "1"};
+cvar_t r_md5lodsize = {"r_md5lodsize", "160"};
+
+// entities smaller than this on screen only have their skin updated every r_md5animlodframes frames
+cvar_t r_md5animlod = {"r_md5animlod", "48"};
+cvar_t r_md5animlodframes = {"r_md5animlodframes", "3"};
+
+// fraction of each submesh's triangles kept at each level
+static const float md5_lodratios[MD5_MAX_LODS] = {0.5f, 0.25f, 0.125f};
+
+// a level must drop at least this much of the level before it to be kept
+#define MD5_LOD_MINREDUCTION	0.1f
+
+// vertexes are only collapsed together if the sum of their bias differences over all joints is no more than this
+#define MD5_LOD_MAXWEIGHTDELTA	0.5f
+
+// a collapse may not turn any triangle further than this from the way it faced (the cosine of the angle)
+#define MD5_LOD_MINFLIPDOT		0.2f
+
+// submeshes with fewer triangles than this are left as they are at every level
+#define MD5_LOD_MINTRIS			16
+
+#define MD5_LOD_NOCOST			1e30f
+
+// the plane quadrics; the upper triangle of the symmetric 4x4 matrix in the order aa ab ac ad bb bc bd cc cd dd
+typedef double md5quadric_t[10];
+
+typedef struct md5lodheap_s
+{
+	float	cost;
+	int		vert;
+	int		stamp;
+} md5lodheap_t;
+
+// working state for simplifying one submesh; vertexes and triangles are numbered from the start of the submesh
+typedef struct md5lodmesh_s
+{
+	int				numverts;
+	int				numtris;
+	int				numalive;
+
+	int				(*corners)[3];		// current corners of each triangle
+	byte			*dead;				// triangles that have collapsed away
+
+	float			(*pos)[3];			// bind-pose positions
+	float			(*bias)[MD5_MAX_INFLUENCES];
+	int				(*joint)[MD5_MAX_INFLUENCES];
+	md5quadric_t	*quadrics;
+	byte			*locked;			// vertexes on an open edge
+	byte			*removed;			// vertexes that have been collapsed onto another
+
+	// the original triangles for each vertex
+	int				*firsttri;
+	int				*trilist;
+
+	// every vertex collapsed onto a vertex is chained after it, so that the triangles around a vertex are the
+	// original triangles of everything on it's chain that are still alive
+	int				*chainnext;
+	int				*chaintail;
+
+	// best collapse for each vertex; stamp changes whenever it's worked out again so that old heap entries are skipped
+	int				*target;
+	float			*cost;
+	int				*stamp;
+
+	// scratch for gathering neighbours
+	int				*mark;
+	int				markcount;
+	int				*neighbours;
+
+	md5lodheap_t	*heap;
+	int				heapsize;
+	int				maxheap;
+} md5lodmesh_t;
+
+
+/*
+==================
+MD5_LODAlloc
+
+carves the working state out of a single block; everything is kept 16-byte aligned
+==================
+*/
+static void *MD5_LODAlloc (byte **buf, int size)
+{
+	void *p = *buf;
+
+	*buf += (size + 15) & ~15;
+
+	return p;
+}
+
+
+/*
+==================
+MD5_AddPlaneQuadric
+
+==================
+*/
+static void MD5_AddPlaneQuadric (md5quadric_t q, const double *p, double weight)
+{
+	q[0] += p[0] * p[0] * weight;
+	q[1] += p[0] * p[1] * weight;
+	q[2] += p[0] * p[2] * weight;
+	q[3] += p[0] * p[3] * weight;
+	q[4] += p[1] * p[1] * weight;
+	q[5] += p[1] * p[2] * weight;
+	q[6] += p[1] * p[3] * weight;
+	q[7] += p[2] * p[2] * weight;
+	q[8] += p[2] * p[3] * weight;
+	q[9] += p[3] * p[3] * weight;
+}
+
+
+/*
+==================
+MD5_QuadricError
+
+the area-weighted sum of squared distances from v to the planes in both quadrics
+==================
+*/
+static float MD5_QuadricError (const md5quadric_t a, const md5quadric_t b, const float *v)
+{
+	double q[10];
+	double x = v[0], y = v[1], z = v[2];
+	int i;
+
+	for (i = 0; i < 10; i++)
+		q[i] = a[i] + b[i];
+
+	return (float) (q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x +
+		q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y +
+		q[7] * z * z + 2 * q[8] * z + q[9]);
+}
+
+
+/*
+==================
+MD5_TriangleNormal
+
+unnormalized, so the length is twice the area
+==================
+*/
+static void MD5_TriangleNormal (const float *p0, const float *p1, const float *p2, vec3_t normal)
+{
+	vec3_t e1, e2;
+
+	VectorSubtract (p1, p0, e1);
+	VectorSubtract (p2, p0, e2);
+	CrossProduct (e1, e2, normal);
+}
+
+
+/*
+==================
+MD5_WeightDelta
+
+==================
+*/
+static float MD5_WeightDelta (const md5lodmesh_t *lm, int u, int v)
+{
+	float delta = 0;
+	int i, j;
+
+	// joints in u, matched against v or not
+	for (i = 0; i < MD5_MAX_INFLUENCES; i++)
+	{
+		float other = 0;
+
+		if (!(lm->bias[u][i] > 0)) continue;
+
+		for (j = 0; j < MD5_MAX_INFLUENCES; j++)
+		{
+			if (lm->joint[v][j] == lm->joint[u][i] && lm->bias[v][j] > 0)
+			{
+				other = lm->bias[v][j];
+				break;
+			}
+		}
+
+		delta += fabs (lm->bias[u][i] - other);
+	}
+
+	// and joints only in v
+	for (j = 0; j < MD5_MAX_INFLUENCES; j++)
+	{
+		if (!(lm->bias[v][j] > 0)) continue;
+
+		for (i = 0; i < MD5_MAX_INFLUENCES; i++)
+			if (lm->joint[u][i] == lm->joint[v][j] && lm->bias[u][i] > 0) break;
+
+		if (i == MD5_MAX_INFLUENCES) delta += lm->bias[v][j];
+	}
+
+	return delta;
+}
+
+
+/*
+==================
+MD5_GatherNeighbours
+
+returns the number of vertexes sharing a live triangle with u
+==================
+*/
+static int MD5_GatherNeighbours (md5lodmesh_t *lm, int u)
+{
+	int numneighbours = 0;
+	int m, i, k;
+
+	lm->markcount++;
+	lm->mark[u] = lm->markcount;
+
+	for (m = u; m != -1; m = lm->chainnext[m])
+	{
+		for (i = lm->firsttri[m]; i < lm->firsttri[m + 1]; i++)
+		{
+			int t = lm->trilist[i];
+
+			if (lm->dead[t]) continue;
+
+			for (k = 0; k < 3; k++)
+			{
+				int c = lm->corners[t][k];
+
+				if (lm->mark[c] == lm->markcount) continue;
+
+				lm->mark[c] = lm->markcount;
+				lm->neighbours[numneighbours++] = c;
+			}
+		}
+	}
+
+	return numneighbours;
+}
+
+
+/*
+==================
+MD5_CollapseFlips
+
+true if moving u onto v would flip or squash any of the triangles around u that don't also have v
+==================
+*/
+static qboolean MD5_CollapseFlips (const md5lodmesh_t *lm, int u, int v)
+{
+	int m, i, k;
+
+	for (m = u; m != -1; m = lm->chainnext[m])
+	{
+		for (i = lm->firsttri[m]; i < lm->firsttri[m + 1]; i++)
+		{
+			int t = lm->trilist[i];
+			const int *c = lm->corners[t];
+			const float *p[3];
+			vec3_t before, after;
+			float lb, la;
+
+			if (lm->dead[t]) continue;
+			if (c[0] == v || c[1] == v || c[2] == v) continue;
+
+			for (k = 0; k < 3; k++)
+				p[k] = lm->pos[c[k]];
+
+			MD5_TriangleNormal (p[0], p[1], p[2], before);
+
+			for (k = 0; k < 3; k++)
+				if (c[k] == u) p[k] = lm->pos[v];
+
+			MD5_TriangleNormal (p[0], p[1], p[2], after);
+
+			lb = Length (before);
+			la = Length (after);
+
+			// slivers with no area to begin with can't get any worse
+			if (!(lb > 0)) continue;
+			if (!(la > 0)) return true;
+
+			if (DotProduct (before, after) < MD5_LOD_MINFLIPDOT * lb * la)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+
+/*
+==================
+MD5_HeapPush
+
+==================
+*/
+static qboolean MD5_HeapPush (md5lodmesh_t *lm, int vert)
+{
+	int i = lm->heapsize;
+
+	if (lm->heapsize == lm->maxheap)
+	{
+		md5lodheap_t *heap = (md5lodheap_t *) realloc (lm->heap, lm->maxheap * 2 * sizeof (md5lodheap_t));
+
+		if (!heap) return false;
+
+		lm->heap = heap;
+		lm->maxheap *= 2;
+	}
+
+	// sift up
+	while (i > 0)
+	{
+		int parent = (i - 1) >> 1;
+
+		if (!(lm->cost[vert] < lm->heap[parent].cost)) break;
+
+		lm->heap[i] = lm->heap[parent];
+		i = parent;
+	}
+
+	lm->heap[i].cost = lm->cost[vert];
+	lm->heap[i].vert = vert;
+	lm->heap[i].stamp = lm->stamp[vert];
+	lm->heapsize++;
+
+	return true;
+}
+
+
+/*
+==================
+MD5_HeapPop
+
+==================
+*/
+static md5lodheap_t MD5_HeapPop (md5lodmesh_t *lm)
+{
+	md5lodheap_t top = lm->heap[0];
+	md5lodheap_t last = lm->heap[--lm->heapsize];
+	int i = 0;
+
+	// sift down
+	for (;;)
+	{
+		int child = i * 2 + 1;
+
+		if (child >= lm->heapsize) break;
+		if (child + 1 < lm->heapsize && lm->heap[child + 1].cost < lm->heap[child].cost) child++;
+		if (!(lm->heap[child].cost < last.cost)) break;
+
+		lm->heap[i] = lm->heap[child];
+		i = child;
+	}
+
+	if (lm->heapsize) lm->heap[i] = last;
+
+	return top;
+}
+
+
+/*
+==================
+MD5_UpdateCollapse
+
+works out the cheapest collapse for u and queues it; returns false if the heap couldn't grow
+==================
+*/
+static qboolean MD5_UpdateCollapse (md5lodmesh_t *lm, int u)
+{
+	int numneighbours, i;
+
+	lm->stamp[u]++;
+	lm->target[u] = -1;
+	lm->cost[u] = MD5_LOD_NOCOST;
+
+	if (lm->locked[u] || lm->removed[u]) return true;
+
+	numneighbours = MD5_GatherNeighbours (lm, u);
+
+	for (i = 0; i < numneighbours; i++)
+	{
+		int v = lm->neighbours[i];
+		float cost;
+
+		if (MD5_WeightDelta (lm, u, v) > MD5_LOD_MAXWEIGHTDELTA) continue;
+
+		if ((cost = MD5_QuadricError (lm->quadrics[u], lm->quadrics[v], lm->pos[v])) >= lm->cost[u]) continue;
+		if (MD5_CollapseFlips (lm, u, v)) continue;
+
+		lm->cost[u] = cost;
+		lm->target[u] = v;
+	}
+
+	if (lm->target[u] == -1) return true;
+
+	return MD5_HeapPush (lm, u);
+}
+
+
+/*
+==================
+MD5_Collapse
+
+moves u onto v, then requeues v and everything around it
+==================
+*/
+static qboolean MD5_Collapse (md5lodmesh_t *lm, int u, int v)
+{
+	int m, i, k, numneighbours;
+
+	for (m = u; m != -1; m = lm->chainnext[m])
+	{
+		for (i = lm->firsttri[m]; i < lm->firsttri[m + 1]; i++)
+		{
+			int t = lm->trilist[i];
+			int *c = lm->corners[t];
+
+			if (lm->dead[t]) continue;
+
+			if (c[0] == v || c[1] == v || c[2] == v)
+			{
+				lm->dead[t] = 1;
+				lm->numalive--;
+				continue;
+			}
+
+			for (k = 0; k < 3; k++)
+				if (c[k] == u) c[k] = v;
+		}
+	}
+
+	for (k = 0; k < 10; k++)
+		lm->quadrics[v][k] += lm->quadrics[u][k];
+
+	lm->chainnext[lm->chaintail[v]] = u;
+	lm->chaintail[v] = lm->chaintail[u];
+	lm->removed[u] = 1;
+	lm->stamp[u]++;
+
+	// the neighbours are gathered into the scratch list which MD5_UpdateCollapse reuses, so they're copied off first
+	numneighbours = MD5_GatherNeighbours (lm, v);
+
+	for (i = 0; i < numneighbours; i++)
+		lm->neighbours[lm->numverts + i] = lm->neighbours[i];
+
+	if (!MD5_UpdateCollapse (lm, v)) return false;
+
+	for (i = 0; i < numneighbours; i++)
+		if (!MD5_UpdateCollapse (lm, lm->neighbours[lm->numverts + i])) return false;
+
+	return true;
+}
+
+
+/*
+==================
+MD5_SetupLODMesh
+
+fills in the working state for one submesh; lm has all of it's arrays allocated
+==================
+*/
+static void MD5_SetupLODMesh (md5lodmesh_t *lm, const struct md5_mesh_t *mesh, const struct md5_submesh_t *submesh, const int *indexes)
+{
+	int i, j, k;
+
+	// positions and weights come out of the skin stream, which is in bind-pose space
+	for (i = 0; i < lm->numverts; i++)
+	{
+		const struct md5_skinblock_t *block = &mesh->skinblocks[(submesh->firstvert + i) / MD5_SKIN_LANES];
+		int lane = (submesh->firstvert + i) % MD5_SKIN_LANES;
+
+		for (k = 0; k < 3; k++)
+			lm->pos[i][k] = block->pos[k][lane];
+
+		for (j = 0; j < MD5_MAX_INFLUENCES; j++)
+		{
+			lm->joint[i][j] = block->joint[j][lane];
+			lm->bias[i][j] = (j < block->numslots) ? block->bias[j][lane] * (1.0f / MD5_BIAS_ONE) : 0;
+		}
+
+		lm->chainnext[i] = -1;
+		lm->chaintail[i] = i;
+		lm->target[i] = -1;
+	}
+
+	// triangles and their planes
+	for (i = 0; i < lm->numtris; i++)
+	{
+		const int *c = lm->corners[i];
+		vec3_t normal;
+		double plane[4];
+		float area;
+
+		for (k = 0; k < 3; k++)
+			lm->corners[i][k] = indexes[(submesh->firsttri + i) * 3 + k] - submesh->firstvert;
+
+		// anything degenerate to start with would only get in the way
+		if (c[0] == c[1] || c[1] == c[2] || c[2] == c[0])
+		{
+			lm->dead[i] = 1;
+			continue;
+		}
+
+		lm->numalive++;
+
+		MD5_TriangleNormal (lm->pos[c[0]], lm->pos[c[1]], lm->pos[c[2]], normal);
+
+		if (!((area = VectorNormalize (normal)) > 0)) continue;
+
+		plane[0] = normal[0];
+		plane[1] = normal[1];
+		plane[2] = normal[2];
+		plane[3] = -DotProduct (normal, lm->pos[c[0]]);
+
+		for (k = 0; k < 3; k++)
+			MD5_AddPlaneQuadric (lm->quadrics[c[k]], plane, area * 0.5);
+	}
+
+	// original triangles for each vertex
+	for (i = 0; i < lm->numtris; i++)
+		for (k = 0; k < 3; k++)
+			lm->firsttri[lm->corners[i][k] + 1]++;
+
+	for (i = 0; i < lm->numverts; i++)
+		lm->firsttri[i + 1] += lm->firsttri[i];
+
+	for (i = 0; i < lm->numtris; i++)
+		for (k = 0; k < 3; k++)
+			lm->trilist[lm->firsttri[lm->corners[i][k]] + lm->mark[lm->corners[i][k]]++] = i;
+
+	// lock any vertex with an edge that isn't shared by exactly two triangles; seams are open edges too because the
+	// vertexes either side of them are split
+	for (i = 0; i < lm->numverts; i++)
+	{
+		lm->mark[i] = 0;
+
+		for (j = lm->firsttri[i]; j < lm->firsttri[i + 1] && !lm->locked[i]; j++)
+		{
+			int t = lm->trilist[j];
+
+			if (lm->dead[t]) continue;
+
+			for (k = 0; k < 3; k++)
+			{
+				int other = lm->corners[t][k];
+				int n, shared = 0;
+
+				if (other == i) continue;
+
+				for (n = lm->firsttri[i]; n < lm->firsttri[i + 1]; n++)
+				{
+					const int *c = lm->corners[lm->trilist[n]];
+
+					if (lm->dead[lm->trilist[n]]) continue;
+					if (c[0] == other || c[1] == other || c[2] == other) shared++;
+				}
+
+				if (shared != 2)
+				{
+					lm->locked[i] = 1;
+					break;
+				}
+			}
+		}
+	}
+}
+
+
+/*
+==================
+MD5_CopySubmesh
+
+a level with every triangle of the submesh
+==================
+*/
+static void MD5_CopySubmesh (const struct md5_mesh_t *mesh, const struct md5_submesh_t *submesh, const int *indexes, int *lodindexes, int *lodsource, int *numtris, int l)
+{
+	int *out = lodindexes + (l * mesh->num_tris + numtris[l]) * 3;
+	int *source = lodsource + l * mesh->num_tris + numtris[l];
+	int i;
+
+	memcpy (out, indexes + submesh->firsttri * 3, submesh->numtris * 3 * sizeof (int));
+
+	for (i = 0; i < submesh->numtris; i++)
+		source[i] = submesh->firsttri + i;
+
+	numtris[l] += submesh->numtris;
+}
+
+
+#define MD5_LOD_ALIGN(size)	(((size) + 15) & ~15)
+
+/*
+==================
+MD5_SimplifySubmesh
+
+writes each level of one submesh to the end of that level's triangles in lodindexes and lodsource, and adds them
+to numtris.  if there's no memory every level gets the full submesh.
+==================
+*/
+static void MD5_SimplifySubmesh (const struct md5_mesh_t *mesh, const struct md5_submesh_t *submesh, const int *indexes, int *lodindexes, int *lodsource, int *numtris)
+{
+	md5lodmesh_t lm;
+	byte *buf = NULL, *p;
+	int size, l, i, k;
+
+	memset (&lm, 0, sizeof (lm));
+
+	lm.numverts = submesh->numverts;
+	lm.numtris = submesh->numtris;
+	lm.maxheap = lm.numverts * 2 + 16;
+
+	size = MD5_LOD_ALIGN (lm.numtris * 3 * sizeof (int)) * 2 +
+		MD5_LOD_ALIGN (lm.numtris) +
+		MD5_LOD_ALIGN (lm.numverts * sizeof (float) * 3) +
+		MD5_LOD_ALIGN (lm.numverts * sizeof (float) * MD5_MAX_INFLUENCES) +
+		MD5_LOD_ALIGN (lm.numverts * sizeof (int) * MD5_MAX_INFLUENCES) +
+		MD5_LOD_ALIGN (lm.numverts * sizeof (md5quadric_t)) +
+		MD5_LOD_ALIGN (lm.numverts) * 2 +
+		MD5_LOD_ALIGN ((lm.numverts + 1) * sizeof (int)) +
+		MD5_LOD_ALIGN (lm.numverts * sizeof (int)) * 7 +
+		MD5_LOD_ALIGN (lm.numverts * 2 * sizeof (int));
+
+	if (submesh->numtris < MD5_LOD_MINTRIS ||
+		(buf = (byte *) calloc (size, 1)) == NULL ||
+		(lm.heap = (md5lodheap_t *) malloc (lm.maxheap * sizeof (md5lodheap_t))) == NULL)
+	{
+		if (buf) free (buf);
+
+		for (l = 0; l < MD5_MAX_LODS; l++)
+			MD5_CopySubmesh (mesh, submesh, indexes, lodindexes, lodsource, numtris, l);
+
+		return;
+	}
+
+	p = buf;
+	lm.corners = (int (*)[3]) MD5_LODAlloc (&p, lm.numtris * 3 * sizeof (int));
+	lm.trilist = (int *) MD5_LODAlloc (&p, lm.numtris * 3 * sizeof (int));
+	lm.dead = (byte *) MD5_LODAlloc (&p, lm.numtris);
+	lm.pos = (float (*)[3]) MD5_LODAlloc (&p, lm.numverts * sizeof (float) * 3);
+	lm.bias = (float (*)[MD5_MAX_INFLUENCES]) MD5_LODAlloc (&p, lm.numverts * sizeof (float) * MD5_MAX_INFLUENCES);
+	lm.joint = (int (*)[MD5_MAX_INFLUENCES]) MD5_LODAlloc (&p, lm.numverts * sizeof (int) * MD5_MAX_INFLUENCES);
+	lm.quadrics = (md5quadric_t *) MD5_LODAlloc (&p, lm.numverts * sizeof (md5quadric_t));
+	lm.locked = (byte *) MD5_LODAlloc (&p, lm.numverts);
+	lm.removed = (byte *) MD5_LODAlloc (&p, lm.numverts);
+	lm.firsttri = (int *) MD5_LODAlloc (&p, (lm.numverts + 1) * sizeof (int));
+	lm.chainnext = (int *) MD5_LODAlloc (&p, lm.numverts * sizeof (int));
+	lm.chaintail = (int *) MD5_LODAlloc (&p, lm.numverts * sizeof (int));
+	lm.target = (int *) MD5_LODAlloc (&p, lm.numverts * sizeof (int));
+	lm.cost = (float *) MD5_LODAlloc (&p, lm.numverts * sizeof (float));
+	lm.stamp = (int *) MD5_LODAlloc (&p, lm.numverts * sizeof (int));
+	lm.mark = (int *) MD5_LODAlloc (&p, lm.numverts * sizeof (int));
+	lm.neighbours = (int *) MD5_LODAlloc (&p, lm.numverts * 2 * sizeof (int));
+
+	MD5_SetupLODMesh (&lm, mesh, submesh, indexes);
+
+	for (i = 0; i < lm.numverts; i++)
+		if (!MD5_UpdateCollapse (&lm, i)) break;
+
+	for (l = 0; l < MD5_MAX_LODS; l++)
+	{
+		int target = (int) (submesh->numtris * md5_lodratios[l]);
+		int *out = lodindexes + (l * mesh->num_tris + numtris[l]) * 3;
+		int *source = lodsource + l * mesh->num_tris + numtris[l];
+		int numout = 0;
+
+		// take the cheapest collapse that's still current until there are few enough triangles left, or nothing
+		// else can go
+		while (lm.numalive > target && lm.heapsize)
+		{
+			md5lodheap_t top = MD5_HeapPop (&lm);
+
+			if (top.stamp != lm.stamp[top.vert] || lm.target[top.vert] == -1) continue;
+			if (!MD5_Collapse (&lm, top.vert, lm.target[top.vert])) break;
+		}
+
+		// the surviving triangles keep their vertex cache order
+		for (i = 0; i < lm.numtris; i++)
+		{
+			if (lm.dead[i]) continue;
+
+			for (k = 0; k < 3; k++)
+				out[numout * 3 + k] = lm.corners[i][k] + submesh->firstvert;
+
+			source[numout++] = submesh->firsttri + i;
+		}
+
+		numtris[l] += numout;
+	}
+
+	free (lm.heap);
+	free (buf);
+}
+
+
+/*
+==================
+MD5_BuildLODs
+
+indexes are the mesh's triangles as ints, and the mesh's skin stream must already be built.  lodindexes and lodsource
+need room for MD5_MAX_LODS copies of the mesh's triangles; they get the triangles of each level in turn, each level
+in submesh order, and lodsource gets the mesh triangle that each one came from.  each submesh gets it's range in each
+level, and numtris the total for each level.  returns the number of levels, which may be fewer than MD5_MAX_LODS if
+the mesh wouldn't simplify far enough to make them worthwhile.
+==================
+*/
+int MD5_BuildLODs (const struct md5_mesh_t *mesh, struct md5_submesh_t *submeshes, int num_submeshes, const int *indexes, int *lodindexes, int *lodsource, int *numtris)
+{
+	int prevtris = mesh->num_tris;
+	int num_lods, firsttri, l, s;
+
+	for (l = 0; l < MD5_MAX_LODS; l++)
+		numtris[l] = 0;
+
+	for (s = 0; s < num_submeshes; s++)
+	{
+		for (l = 0; l < MD5_MAX_LODS; l++)
+			submeshes[s].lodfirsttri[l] = numtris[l];
+
+		MD5_SimplifySubmesh (mesh, &submeshes[s], indexes, lodindexes, lodsource, numtris);
+
+		for (l = 0; l < MD5_MAX_LODS; l++)
+			submeshes[s].lodnumtris[l] = numtris[l] - submeshes[s].lodfirsttri[l];
+	}
+
+	// keep the levels that are worth it
+	for (num_lods = 0; num_lods < MD5_MAX_LODS; num_lods++)
+	{
+		if (numtris[num_lods] > prevtris * (1.0f - MD5_LOD_MINREDUCTION)) break;
+
+		prevtris = numtris[num_lods];
+	}
+
+	// and pack them together
+	for (l = 0, firsttri = 0; l < num_lods; l++)
+	{
+		if (firsttri != l * mesh->num_tris)
+		{
+			memmove (lodindexes + firsttri * 3, lodindexes + l * mesh->num_tris * 3, numtris[l] * 3 * sizeof (int));
+			memmove (lodsource + firsttri, lodsource + l * mesh->num_tris, numtris[l] * sizeof (int));
+		}
+
+		for (s = 0; s < num_submeshes; s++)
+			submeshes[s].lodfirsttri[l] += firsttri;
+
+		firsttri += numtris[l];
+	}
+
+	for (l = num_lods; l < MD5_MAX_LODS; l++)
+	{
+		numtris[l] = 0;
+
+		for (s = 0; s < num_submeshes; s++)
+			submeshes[s].lodfirsttri[l] = submeshes[s].lodnumtris[l] = 0;
+	}
+
+	return num_lods;
+}
+
+
+/*
+==================
+MD5_ScreenSize
+
+roughly how many pixels high the bounding sphere of a frame is on screen.  the box centre isn't rotated with the
+entity, which is close enough for this.
+==================
+*/
+float MD5_ScreenSize (const struct md5_bbox_t *bbox, const vec3_t origin)
+{
+	vec3_t centre;
+	float dist, scale;
+	int i;
+
+	for (i = 0; i < 3; i++)
+		centre[i] = origin[i] + (bbox->min[i] + bbox->max[i]) * 0.5f - r_refdef.vieworg[i];
+
+	dist = Length (centre);
+	scale = tan (r_refdef.fov_y * M_PI / 360.0);
+
+	// the view is inside it so it may as well fill the screen
+	if (dist <= bbox->radius || !(scale > 0))
+		return r_refdef.vrect.height;
+
+	return bbox->radius * r_refdef.vrect.height / (dist * scale);
+}
+
+
+/*
+==================
+MD5_SelectLOD
+
+0 is the full mesh and 1 to num_lods are the simplified levels
+==================
+*/
+int MD5_SelectLOD (int num_lods, float size)
+{
+	float threshold = r_md5lodsize.value;
+	int lod;
+
+	if (!r_md5lod.value) return 0;
+
+	for (lod = 0; lod < num_lods && size < threshold; lod++)
+		threshold *= 0.5f;
+
+	return lod;
+}
+
+
+/*
+==================
+MD5_AnimLODFrames
+
+how many frames an entity of this size keeps it's skin for
+==================
+*/
+int MD5_AnimLODFrames (float size)
+{
+	if (size < r_md5animlod.value && r_md5animlodframes.value > 1)
+		return (int) r_md5animlodframes.value;
+
+	return 1;
+}
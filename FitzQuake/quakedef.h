@@ -46,6 +46,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <setjmp.h>
 #include <assert.h> //johnfitz
 
@@ -219,6 +220,7 @@ void	VID_UnlockBuffer (void);
 #include "vid.h"
 #include "sys.h"
 #include "zone.h"
+#include "prof.h"
 #include "mathlib.h"
 
 typedef struct
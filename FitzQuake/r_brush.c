@@ -867,6 +867,9 @@ void GL_BuildLightmaps (void)
 	byte	*data;
 	int		i, j;
 	model_t	*m;
+	int		load; // mh
+
+	load = Prof_Begin (PROF_LIGHTMAPS, "lightmaps");
 
 	memset (allocated, 0, sizeof(allocated));
 
@@ -935,6 +938,8 @@ void GL_BuildLightmaps (void)
 	if (i >= 64)
 		Con_Warning ("%i lightmaps exceeds standard limit of 64.\n", i);
 	//johnfitz
+
+	Prof_End (load);
 }
 
 /*
@@ -32,38 +32,442 @@ extern float	entalpha; //johnfitz
 extern vec3_t	lightspot;
 
 extern gltexture_t *playertextures[MAX_SCOREBOARD];
+extern cvar_t r_md5skincheck;
 
 
 // alias/md5 shared functions
 void R_SetupEntityTransform (entity_t *e, lerpdata_t *lerpdata);
 void R_SetupAliasLighting (entity_t	*e);
 
+// skinned vertexes can be shared by every entity on the same poses so only the positions go in here; texcoords come
+// from the static buffer or the mesh itself and the lit colours are worked out for each entity as it's drawn
 typedef struct md5polyvert_s
 {
 	float position[3];
-	float colour[4];
-	float texcoord[2];
 } md5polyvert_t;
 
 // store a single copy rather than individual vertex arrays per mesh
 md5polyvert_t r_md5vertexes[MAX_MD5_VERTEXES];
 
+// skinned normals are only needed for lighting so they're kept out of the vertex array
+static float r_md5normals[MAX_MD5_VERTEXES][3];
+
+// the colours for the entity being drawn
+static byte r_md5colours[MAX_MD5_VERTEXES][4];
+
+
+/*
+=================
+R_GetMD5SkinImage
+
+skin selection and auto-animation for a submesh
+=================
+*/
+static skinpair_t *R_GetMD5SkinImage (entity_t *e, const struct md5_submesh_t *submesh)
+{
+	md5skin_t *skin = &submesh->skins[e->skinnum % submesh->numskins];
+
+	return &skin->image[(int) ((cl.time + e->syncbase) * 10) % skin->numskins];
+}
+
+
+/*
+=================
+R_SetMD5BaseTexture
+
+only the first submesh is colormapped
+=================
+*/
+static void R_SetMD5BaseTexture (entity_t *e, int submeshnum, skinpair_t *image)
+{
+	GL_DisableMultitexture ();
+
+	if (submeshnum == 0 && e->colormap != vid.colormap && !gl_nocolors.value)
+	{
+		int i = e - cl_entities;
+
+		if (i >= 1 && i <= cl.maxclients /* && !strcmp (currententity->model->name, "progs/player.mdl") */)
+		{
+		    GL_Bind (playertextures[i - 1]);
+			return;
+		}
+	}
+
+	GL_Bind (image->tx);
+}
+
+
+/*
+=================
+R_MD5HasFullbrights
+
+=================
+*/
+static qboolean R_MD5HasFullbrights (entity_t *e, md5header_t *hdr)
+{
+	int i;
+
+	for (i = 0; i < hdr->num_submeshes; i++)
+		if (R_GetMD5SkinImage (e, &hdr->submeshes[i])->fb)
+			return true;
+
+	return false;
+}
+
+
+#define MD5_DRAW_UNTEXTURED		0
+#define MD5_DRAW_BASE			1
+#define MD5_DRAW_FULLBRIGHT		2
+#define MD5_DRAW_BASE_FULLBRIGHT	3	// base on TMU0 and fullbright added on TMU1
+
+/*
+==============================================================================
+
+MD5 VERTEX BUFFERS
+
+texcoords and indexes never change so they go in static buffers that are created the first time a model is drawn.
+only the skinned positions and lit colours are written each frame, into stream buffers that are orphaned before every
+upload so that the driver never has to wait on a draw that's still using the old contents.  positions aren't sent
+again if the last entity drawn used the same skin.  without ARB_vertex_buffer_object (or with r_md5vbo 0) the same
+streams are used as client arrays, with the texcoords read straight out of the mesh.
+
+==============================================================================
+*/
+
+cvar_t r_md5vbo = {"r_md5vbo", "1"};
+
+#define MAX_MD5_BUFFERS		1024
+
+// every buffer that's been created, so that they can all be deleted on a new map or after the context is recreated
+static GLuint r_md5buffers[MAX_MD5_BUFFERS];
+static int r_md5numbuffers = 0;
+
+// models with a different generation have buffers from before the last flush; 0 is never valid
+static int r_md5buffergeneration = 1;
+static GLuint r_md5streambuffer = 0;
+static GLuint r_md5colourbuffer = 0;
+
+// what's in the position stream; serial 0 is never reused
+static const md5polyvert_t *r_md5streamvertexes = NULL;
+static int r_md5streamserial = 0;
+
+// what GL_DrawMD5Frame passes as indexes; an offset into the index buffer if there is one
+static const struct md5_triangle_t *r_md5triangles = NULL;
+static const struct md5_triangle_t *r_md5lodtriangles = NULL;
+
+// how many TMUs have texcoord arrays enabled
+static int r_md5texcoordunits = 0;
+
+
+/*
+==================
+R_FlushMD5Buffers
+
+models are freed on a new map and buffers don't survive a new context, so everything is thrown out and models create
+their buffers again the next time they're drawn
+==================
+*/
+void R_FlushMD5Buffers (void)
+{
+	if (r_md5numbuffers)
+		GL_DeleteBuffersFunc (r_md5numbuffers, r_md5buffers);
+
+	r_md5numbuffers = 0;
+	r_md5streambuffer = 0;
+	r_md5colourbuffer = 0;
+	r_md5streamvertexes = NULL;
+	r_md5streamserial = 0;
+	r_md5buffergeneration++;
+}
+
+
+/*
+==================
+R_CreateMD5Buffer
+
+returns 0 if there's no room to track it
+==================
+*/
+static GLuint R_CreateMD5Buffer (GLenum target, int size, const void *data, GLenum usage)
+{
+	GLuint buffer = 0;
+
+	if (r_md5numbuffers == MAX_MD5_BUFFERS) return 0;
+
+	GL_GenBuffersFunc (1, &buffer);
+	GL_BindBufferFunc (target, buffer);
+	GL_BufferDataFunc (target, size, data, usage);
+	GL_BindBufferFunc (target, 0);
+
+	r_md5buffers[r_md5numbuffers++] = buffer;
+
+	return buffer;
+}
+
+
+/*
+==================
+R_CheckMD5Buffers
+
+creates the static buffers for a model if it doesn't have them yet; returns false if it should use client arrays
+==================
+*/
+static qboolean R_CheckMD5Buffers (md5header_t *hdr)
+{
+	const struct md5_mesh_t *mesh = &hdr->md5mesh.meshes[0];
+	float (*texcoords)[2];
+	struct md5_triangle_t *indexes;
+	int i;
+
+	if (!gl_vbo_able || !r_md5vbo.value) return false;
+
+	// a failed create isn't retried until the next flush
+	if (hdr->buffergeneration == r_md5buffergeneration)
+		return (r_md5streambuffer && r_md5colourbuffer && hdr->texcoordbuffer && hdr->indexbuffer);
+
+	hdr->buffergeneration = r_md5buffergeneration;
+	hdr->texcoordbuffer = hdr->indexbuffer = 0;
+
+	// the stream buffers are sized when they're orphaned so they start out empty
+	if (!r_md5streambuffer)
+		r_md5streambuffer = R_CreateMD5Buffer (GL_ARRAY_BUFFER_ARB, 0, NULL, GL_STREAM_DRAW_ARB);
+
+	if (!r_md5colourbuffer)
+		r_md5colourbuffer = R_CreateMD5Buffer (GL_ARRAY_BUFFER_ARB, 0, NULL, GL_STREAM_DRAW_ARB);
+
+	if (!r_md5streambuffer || !r_md5colourbuffer) return false;
+
+	// texcoords are interleaved with the weight ranges in the mesh so they must be packed first, and the levels of
+	// detail go after the full mesh in the same index buffer
+	texcoords = (float (*)[2]) malloc (mesh->num_verts * sizeof (float) * 2);
+	indexes = (struct md5_triangle_t *) malloc ((mesh->num_tris + hdr->num_lodtris) * sizeof (struct md5_triangle_t));
+
+	if (!texcoords || !indexes)
+	{
+		if (texcoords) free (texcoords);
+		if (indexes) free (indexes);
+
+		return false;
+	}
+
+	memcpy (indexes, mesh->triangles, mesh->num_tris * sizeof (struct md5_triangle_t));
+
+	if (hdr->num_lodtris)
+		memcpy (indexes + mesh->num_tris, hdr->lodtriangles, hdr->num_lodtris * sizeof (struct md5_triangle_t));
+
+	for (i = 0; i < mesh->num_verts; i++)
+	{
+		texcoords[i][0] = mesh->vertices[i].st[0];
+		texcoords[i][1] = mesh->vertices[i].st[1];
+	}
+
+	hdr->texcoordbuffer = R_CreateMD5Buffer (GL_ARRAY_BUFFER_ARB, mesh->num_verts * sizeof (float) * 2, texcoords, GL_STATIC_DRAW_ARB);
+	hdr->indexbuffer = R_CreateMD5Buffer (GL_ELEMENT_ARRAY_BUFFER_ARB, (mesh->num_tris + hdr->num_lodtris) * sizeof (struct md5_triangle_t), indexes, GL_STATIC_DRAW_ARB);
+
+	free (texcoords);
+	free (indexes);
+
+	return (hdr->texcoordbuffer && hdr->indexbuffer);
+}
+
+
+/*
+==================
+R_SetupMD5Arrays
+
+sets up the arrays for drawing skinned vertexes; serial identifies what was skinned into them, or is 0 if they're
+scratch space.  colours are only enabled if the passes will use them, in which case MD5_LightMesh must have been run
+first, and texcoords for the first texunits TMUs, which all use the same ones.
+==================
+*/
+static void R_SetupMD5Arrays (md5header_t *hdr, const md5polyvert_t *vertexes, int serial, qboolean colours, int texunits)
+{
+	const struct md5_mesh_t *mesh = &hdr->md5mesh.meshes[0];
+	qboolean buffered = R_CheckMD5Buffers (hdr);
+	int i;
+
+	if (buffered)
+	{
+		int size = mesh->num_verts * sizeof (md5polyvert_t);
+
+		GL_BindBufferFunc (GL_ARRAY_BUFFER_ARB, r_md5streambuffer);
+
+		// orphan the old contents before writing the new ones, unless they're the same
+		if (!serial || serial != r_md5streamserial || vertexes != r_md5streamvertexes)
+		{
+			GL_BufferDataFunc (GL_ARRAY_BUFFER_ARB, size, NULL, GL_STREAM_DRAW_ARB);
+			GL_BufferSubDataFunc (GL_ARRAY_BUFFER_ARB, 0, size, vertexes);
+
+			r_md5streamvertexes = vertexes;
+			r_md5streamserial = serial;
+		}
+
+		glVertexPointer (3, GL_FLOAT, sizeof (md5polyvert_t), NULL);
+
+		if (colours)
+		{
+			GL_BindBufferFunc (GL_ARRAY_BUFFER_ARB, r_md5colourbuffer);
+			GL_BufferDataFunc (GL_ARRAY_BUFFER_ARB, mesh->num_verts * 4, NULL, GL_STREAM_DRAW_ARB);
+			GL_BufferSubDataFunc (GL_ARRAY_BUFFER_ARB, 0, mesh->num_verts * 4, r_md5colours);
+			glColorPointer (4, GL_UNSIGNED_BYTE, 0, NULL);
+		}
+
+		// the index buffer stays bound for the draws
+		GL_BindBufferFunc (GL_ELEMENT_ARRAY_BUFFER_ARB, hdr->indexbuffer);
+		r_md5triangles = NULL;
+		r_md5lodtriangles = r_md5triangles + mesh->num_tris;
+	}
+	else
+	{
+		glVertexPointer (3, GL_FLOAT, sizeof (md5polyvert_t), vertexes->position);
+
+		if (colours)
+			glColorPointer (4, GL_UNSIGNED_BYTE, 0, r_md5colours);
+
+		r_md5triangles = mesh->triangles;
+		r_md5lodtriangles = hdr->lodtriangles;
+	}
+
+	glEnableClientState (GL_VERTEX_ARRAY);
+
+	if (colours)
+		glEnableClientState (GL_COLOR_ARRAY);
+
+	if (texunits && buffered)
+		GL_BindBufferFunc (GL_ARRAY_BUFFER_ARB, hdr->texcoordbuffer);
+
+	for (i = 0; i < texunits; i++)
+	{
+		if (i) GL_ClientActiveTextureFunc (TEXTURE1);
+
+		glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+
+		if (buffered)
+			glTexCoordPointer (2, GL_FLOAT, 0, NULL);
+		else glTexCoordPointer (2, GL_FLOAT, sizeof (struct md5_vertex_t), mesh->vertices[0].st);
+
+		if (i) GL_ClientActiveTextureFunc (TEXTURE0);
+	}
+
+	r_md5texcoordunits = texunits;
+
+	// the pointers keep the buffers they were set from so the array buffer can go now
+	if (buffered)
+		GL_BindBufferFunc (GL_ARRAY_BUFFER_ARB, 0);
+}
+
+
+/*
+==================
+R_FinishMD5Arrays
+
+leaves nothing bound, so that client array drawing elsewhere isn't read out of a buffer
+==================
+*/
+static void R_FinishMD5Arrays (void)
+{
+	glDisableClientState (GL_VERTEX_ARRAY);
+	glDisableClientState (GL_COLOR_ARRAY);
+	glDisableClientState (GL_TEXTURE_COORD_ARRAY);
+
+	if (r_md5texcoordunits > 1)
+	{
+		GL_ClientActiveTextureFunc (TEXTURE1);
+		glDisableClientState (GL_TEXTURE_COORD_ARRAY);
+		GL_ClientActiveTextureFunc (TEXTURE0);
+	}
+
+	r_md5texcoordunits = 0;
+
+	if (gl_vbo_able)
+	{
+		GL_BindBufferFunc (GL_ARRAY_BUFFER_ARB, 0);
+		GL_BindBufferFunc (GL_ELEMENT_ARRAY_BUFFER_ARB, 0);
+	}
+}
+
 
 /*
 =================
 GL_DrawMD5Frame
 
-assumes that the correct vertex array setup has already been done.
-this is just a single glDrawElements call, but it could be modified to use glBegin/glEnd code instead.
+assumes that the arrays have been set up with R_SetupMD5Arrays.  untextured draws are a single glDrawElements call
+for the whole model; textured draws need one per submesh (which is one per shader) to bind it's skin.  base and
+fullbright draws need texcoords on both TMUs and leave TMU0 selected.  lod is 0 for the full mesh or a level of
+detail from R_MD5LOD.
 =================
 */
-void GL_DrawMD5Frame (const struct md5_mesh_t *mesh)
+void GL_DrawMD5Frame (entity_t *e, md5header_t *hdr, int texture, int lod)
 {
-	// draw it - the triangles were loaded in the same order to allow them be used as index input
-	glDrawElements (GL_TRIANGLES, mesh->num_tris * 3, GL_UNSIGNED_SHORT, mesh->triangles);
+	const struct md5_mesh_t *mesh = &hdr->md5mesh.meshes[0];
+	const struct md5_triangle_t *triangles;
+	int i, numtris;
 
-	// keep the count consistent with GL_DrawAliasFrame
-	rs_aliaspasses += mesh->num_tris;
+	if (texture == MD5_DRAW_UNTEXTURED)
+	{
+		// draw it - the triangles were loaded in the same order to allow them be used as index input, and each level
+		// of detail is all together too
+		if (lod)
+		{
+			triangles = r_md5lodtriangles + hdr->submeshes[0].lodfirsttri[lod - 1];
+			numtris = hdr->lodnumtris[lod - 1];
+		}
+		else
+		{
+			triangles = r_md5triangles;
+			numtris = mesh->num_tris;
+		}
+
+		glDrawElements (GL_TRIANGLES, numtris * 3, GL_UNSIGNED_SHORT, triangles);
+
+		// keep the count consistent with GL_DrawAliasFrame
+		rs_aliaspasses += numtris;
+		rs_md5drawcalls++;
+		rs_md5verts += numtris * 3;
+		return;
+	}
+
+	for (i = 0; i < hdr->num_submeshes; i++)
+	{
+		const struct md5_submesh_t *submesh = &hdr->submeshes[i];
+		skinpair_t *image = R_GetMD5SkinImage (e, submesh);
+
+		if (lod)
+		{
+			triangles = r_md5lodtriangles + submesh->lodfirsttri[lod - 1];
+			numtris = submesh->lodnumtris[lod - 1];
+		}
+		else
+		{
+			triangles = r_md5triangles + submesh->firsttri;
+			numtris = submesh->numtris;
+		}
+
+		if (texture == MD5_DRAW_FULLBRIGHT)
+		{
+			if (!image->fb) continue;
+			GL_Bind (image->fb);
+		}
+		else
+		{
+			R_SetMD5BaseTexture (e, i, image);
+
+			// submeshes without a fullbright mask just leave TMU1 off
+			if (texture == MD5_DRAW_BASE_FULLBRIGHT && image->fb)
+			{
+				GL_EnableMultitexture (); // selects TEXTURE1
+				GL_Bind (image->fb);
+				glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_ADD);
+			}
+		}
+
+		glDrawElements (GL_TRIANGLES, numtris * 3, GL_UNSIGNED_SHORT, triangles);
+		rs_aliaspasses += numtris;
+		rs_md5drawcalls++;
+		rs_md5verts += numtris * 3;
+	}
+
+	GL_DisableMultitexture ();
 }
 
 
@@ -127,379 +531,812 @@ static void R_SetupMD5Frame (int frame, lerpdata_t *lerpdata)
 }
 
 
+// the blend between poses is rounded to this so that entities that are nearly in step can share a skin; 0 = exact
+cvar_t r_md5blendstep = {"r_md5blendstep", "0.0625"};
+
+/*
+==================
+MD5_SkinPoses
+
+reduces the lerp to the poses that are actually used, so that entities showing the same single pose can be
+recognised as such no matter what they're lerping between
+==================
+*/
+static void MD5_SkinPoses (const lerpdata_t *lerpdata, int *pose1, int *pose2, float *blend)
+{
+	float lerpblend = lerpdata->blend;
+
+	if (r_md5blendstep.value > 0 && r_md5blendstep.value < 1)
+		lerpblend = floor (lerpblend / r_md5blendstep.value + 0.5f) * r_md5blendstep.value;
+
+	// optimize the non-interpolated cases
+	if (lerpdata->pose1 == lerpdata->pose2)
+	{
+		// case #1 - not lerping, just animate from a single skeleton
+		*pose1 = *pose2 = lerpdata->pose1;
+		*blend = 0;
+	}
+	else if (!(lerpblend > 0))
+	{
+		// case #2 : lerpblend is 0 so just animate from one frame
+		*pose1 = *pose2 = lerpdata->pose1;
+		*blend = 0;
+	}
+	else if (!(lerpblend < 1))
+	{
+		// case #3 : lerpblend is 1 so just animate from one frame
+		*pose1 = *pose2 = lerpdata->pose2;
+		*blend = 0;
+	}
+	else
+	{
+		// case #4 : full interpolation
+		*pose1 = lerpdata->pose1;
+		*pose2 = lerpdata->pose2;
+		*blend = lerpblend;
+	}
+}
+
+
+// space for unpacking two frames of a packed animation when they're needed on the spot
+static struct md5_pose_t r_md5posescratch[2 * MAX_MD5_JOINTS];
+
+
+/*
+==================
+MD5_FrameSkeletons
+
+gets the frame skeletons for the poses from MD5_SkinPoses; scratch must have room for two skeletons if the animation
+is packed.  this must run on the main thread.
+==================
+*/
+static void MD5_FrameSkeletons (md5header_t *hdr, int pose1, int pose2, struct md5_pose_t *scratch, const struct md5_pose_t **skel1, const struct md5_pose_t **skel2)
+{
+	*skel1 = MD5_FramePose (&hdr->md5anim, pose1, scratch);
+
+	if (pose1 == pose2)
+		*skel2 = *skel1;
+	else *skel2 = MD5_FramePose (&hdr->md5anim, pose2, scratch + hdr->md5anim.num_joints);
+}
+
+
+/*
+==================
+MD5_SkinFrame
+
+builds the skeleton for the frame skeletons from MD5_FrameSkeletons and skins positions and normals into the given
+arrays.  this doesn't touch any global state so it's safe to run on the skinning threads; skeleton and palette
+are scratch space.
+==================
+*/
+static void MD5_SkinFrame (md5header_t *hdr, const struct md5_pose_t *skel1, const struct md5_pose_t *skel2, float blend, struct md5_pose_t *skeleton, md5_jointmat_t *palette, md5polyvert_t *vertexes, float (*normals)[3])
+{
+	const struct md5_mesh_t *mesh = &hdr->md5mesh.meshes[0];
+	const struct md5_pose_t *frameskel;
+
+	if (skel1 == skel2)
+		frameskel = skel1;
+	else
+	{
+		// run the skeletal animation
+		MD5_InterpolateSkeletons (skel1, skel2, hdr->md5anim.num_joints, blend, skeleton);
+		frameskel = skeleton;
+	}
+
+	// skin positions straight into the vertex array and normals to separate space for lighting
+	MD5_SkinMesh (&hdr->md5mesh, mesh, frameskel, palette, vertexes->position, sizeof (md5polyvert_t) / sizeof (float), normals[0], 3);
+}
+
+
+/*
+==================
+MD5_ColourByte
+
+==================
+*/
+static byte MD5_ColourByte (float f)
+{
+	if (f <= 0) return 0;
+	if (f >= 1) return 255;
+
+	return (byte) (f * 255.0f + 0.5f);
+}
+
+
+/*
+==================
+MD5_LightMesh
+
+lights the shared normals for the current entity; this uses the current entity lighting so it must run on the main
+thread
+==================
+*/
+static void MD5_LightMesh (const struct md5_mesh_t *mesh, float (*normals)[3])
+{
+	int i;
+
+	if (r_drawflat_cheatsafe)
+		srand ((int) mesh);
+
+	for (i = 0; i < mesh->num_verts; i++)
+	{
+		float Angle;
+
+		// store out colour
+		if (r_drawflat_cheatsafe)
+		{
+			r_md5colours[i][0] = rand () % 256;
+			r_md5colours[i][1] = rand () % 256;
+			r_md5colours[i][2] = rand () % 256;
+			r_md5colours[i][3] = 255;
+		}
+		else
+		{
+			// replicate GLQuake's anorm_dots table
+			if ((Angle = DotProduct (normals[i], shadevector)) < 0)
+				Angle = 1.0f + Angle * (13.0f / 44.0f);
+			else Angle += 1.0f;
+
+			// GL would clamp these anyway
+			r_md5colours[i][0] = MD5_ColourByte (lightcolor[0] * Angle);
+			r_md5colours[i][1] = MD5_ColourByte (lightcolor[1] * Angle);
+			r_md5colours[i][2] = MD5_ColourByte (lightcolor[2] * Angle);
+			r_md5colours[i][3] = MD5_ColourByte (entalpha);
+		}
+	}
+}
+
+
+/*
+==================
+MD5_WeldBaseNormals
+
+==================
+*/
+void MD5_WeldBaseNormals (md5header_t *hdr, vec3_t *positions, float tolerance)
+{
+	// the positions have already been built in MD5_BuildBaseNormals so we can just reference the array directly again
+	MD5_WeldNormals (positions[0], 3, hdr->vnorms, hdr->md5mesh.meshes[0].num_verts, tolerance);
+}
+
+
+/*
+==================
+MD5_BuildBaseNormals
+
+the base frame positions go in the caller's buffer rather than r_md5vertexes because this can be running on the loader thread
+==================
+*/
+void MD5_BuildBaseNormals (md5header_t *hdr, struct md5_mesh_t *mesh, vec3_t *positions)
+{
+	// allocate memory for normals
+	vertexnormals_t *vnorms = (vertexnormals_t *) MD5_HunkAlloc (sizeof (vertexnormals_t) * mesh->num_verts);
+
+	// get rhe rest of the data we need
+	const struct md5_joint_t *skeleton = hdr->md5mesh.baseSkel;
+
+	int i, j;
+
+	// Setup vertices for the base frame
+	for (i = 0; i < mesh->num_verts; i++)
+	{
+		vec3_t finalVertex = {0.0f, 0.0f, 0.0f};
+
+		// Calculate final vertex to draw with weights
+		for (j = 0; j < mesh->vertices[i].count; j++)
+		{
+			const struct md5_weight_t *weight = &mesh->weights[mesh->vertices[i].start + j];
+			const struct md5_joint_t *joint = &skeleton[weight->joint];
+
+			// Calculate transformed vertex for this weight
+			vec3_t wv;
+			Quat_rotatePoint (joint->orient, weight->pos, wv);
+
+			// The sum of all weight->bias should be 1.0
+			finalVertex[0] += (joint->pos[0] + wv[0]) * weight->bias;
+			finalVertex[1] += (joint->pos[1] + wv[1]) * weight->bias;
+			finalVertex[2] += (joint->pos[2] + wv[2]) * weight->bias;
+		}
+
+		// store out position
+		positions[i][0] = finalVertex[0];
+		positions[i][1] = finalVertex[1];
+		positions[i][2] = finalVertex[2];
+	}
+
+	// no normals initially
+	for (i = 0; i < mesh->num_verts; i++)
+	{
+		vnorms[i].normal[0] = vnorms[i].normal[1] = vnorms[i].normal[2] = 0;
+		vnorms[i].numnormals = 0;
+	}
+
+	// accumulate triangle normals to vnorms
+	for (i = 0; i < mesh->num_tris; i++)
+	{
+		float triverts[3][3];
+		float vtemp1[3], vtemp2[3], normal[3];
+
+		// undo the vertex rotation from modelgen.c here
+		// i don't know why id did it this way, but i decided to adapt it unmodified for consistency with modelgen.c
+		for (j = 0; j < 3; j++)
+		{
+			triverts[j][0] = positions[mesh->triangles[i].index[j]][1];
+			triverts[j][1] = -positions[mesh->triangles[i].index[j]][0];
+			triverts[j][2] = positions[mesh->triangles[i].index[j]][2];
+		}
+
+		// calc the per-triangle normal
+		VectorSubtract (triverts[0], triverts[1], vtemp1);
+		VectorSubtract (triverts[2], triverts[1], vtemp2);
+		CrossProduct (vtemp1, vtemp2, normal);
+		VectorNormalize (normal);
+
+		// and accumulate it into the calculated normals array
+		for (j = 0; j < 3; j++)
+		{
+			// rotate the normal so the model faces down the positive x axis
+			// i don't know why id did it this way, but i decided to adapt it unmodified for consistency with modelgen.c
+			vnorms[mesh->triangles[i].index[j]].normal[0] -= normal[1];
+			vnorms[mesh->triangles[i].index[j]].normal[1] += normal[0];
+			vnorms[mesh->triangles[i].index[j]].normal[2] += normal[2];
+
+			// count the normals for averaging
+			vnorms[mesh->triangles[i].index[j]].numnormals++;
+		}
+	}
+
+	// calculate final normals; these stay in object space for the base frame, which is the space the skin stream works in
+	for (i = 0; i < mesh->num_verts; i++)
+	{
+		// numnormals was checked for > 0 in modelgen.c so we shouldn't need to do it again 
+		// here but we do anyway just in case a rogue modder has used a bad modelling tool
+		if (vnorms[i].numnormals > 0)
+		{
+			VectorScale (vnorms[i].normal, (float) vnorms[i].numnormals, vnorms[i].normal);
+			VectorNormalize (vnorms[i].normal);
+		}
+		else
+		{
+			vnorms[i].normal[0] = vnorms[i].normal[1] = 0;
+			vnorms[i].normal[2] = 1;
+		}
+	}
+
+	// store the normals out in the MD5 header now
+	hdr->vnorms = vnorms;
+}
+
+
+/*
+==================
+R_CullMD5Model
+
+==================
+*/
+static qboolean R_CullMD5Model (lerpdata_t lerpdata, const struct md5_anim_t *anim)
+{
+	float planes[4][4];
+	int i;
+
+	for (i = 0; i < 4; i++)
+	{
+		VectorCopy (frustum[i].normal, planes[i]);
+		planes[i][3] = frustum[i].dist;
+	}
+
+	return MD5_CullBounds (anim, lerpdata.pose1, lerpdata.pose2, lerpdata.blend, lerpdata.origin, lerpdata.angles, planes, 4);
+}
+
+
+/*
+==================
+R_MD5LOD
+
+the level of detail to draw an entity with; the viewmodel is always drawn in full
+==================
+*/
+static int R_MD5LOD (entity_t *e, md5header_t *hdr, const lerpdata_t *lerpdata)
+{
+	if (e == &cl.viewent || !hdr->num_lods) return 0;
+
+	return MD5_SelectLOD (hdr->num_lods, MD5_ScreenSize (&hdr->md5anim.bboxes[lerpdata->pose1], lerpdata->origin));
+}
+
+
+/*
+==================
+R_MD5AnimLODFrames
+
+how many frames an entity can keep it's skin for; the viewmodel is skinned every frame
+==================
+*/
+static int R_MD5AnimLODFrames (entity_t *e, md5header_t *hdr, const lerpdata_t *lerpdata)
+{
+	if (e == &cl.viewent) return 1;
+
+	return MD5_AnimLODFrames (MD5_ScreenSize (&hdr->md5anim.bboxes[lerpdata->pose1], lerpdata->origin));
+}
+
+
+/*
+==============================================================================
+
+MD5 SKIN CACHE
+
+each cache slot holds a set of skinned vertexes and the model and poses they were skinned from.  every entity showing
+the same model on the same poses draws from the same slot, so a crowd of monsters running the same animation is only
+skinned once and each of them only needs it's own lighting pass over the shared normals.  the main, shadow and
+showtris passes all draw from the slot, and a slot stays valid across frames until it's needed for something else,
+so an entity that stays on the same pose (a dead monster, for example) keeps using it.  slots that weren't used this
+frame are handed out again oldest first.  r_md5blendstep rounds the blend between poses so that entities that are
+nearly in step can share, and entities that are small on screen keep the slot they had for r_md5animlodframes
+frames even after their poses have moved on.
+
+==============================================================================
+*/
+
+#define MAX_MD5_SKINCACHE	(MAX_VISEDICTS + 8)
+
+typedef struct md5skincache_s
+{
+	int				lastframe;
+
+	// r_framecount it was last counted in the stats
+	int				statframe;
+
+	// what the vertexes were skinned from
+	md5header_t		*hdr;
+	int				pose1;
+	int				pose2;
+	float			blend;
+	qboolean		valid;
+
+	// changes whenever the vertexes are skinned again
+	int				serial;
+	int				skinframe;
+
+	md5polyvert_t	*vertexes;
+	float			(*normals)[3];
+	int				maxverts;
+} md5skincache_t;
+
+static md5skincache_t md5_skincache[MAX_MD5_SKINCACHE];
+static int md5_skinserial = 0;
+
+
+/*
+==================
+R_FlushMD5SkinCache
+
+models may have been freed on a new map and r_framecount is reset so nothing can be carried over
+==================
+*/
+void R_FlushMD5SkinCache (void)
+{
+	int i;
+
+	for (i = 0; i < MAX_MD5_SKINCACHE; i++)
+	{
+		md5_skincache[i].lastframe = -1;
+		md5_skincache[i].statframe = -1;
+		md5_skincache[i].valid = false;
+	}
+}
+
+
 /*
 ==================
-MD5_InterpolateSkeletons
+R_MD5SkinMatches
 
 ==================
 */
-static void MD5_InterpolateSkeletons (const struct md5_joint_t *skelA, const struct md5_joint_t *skelB, int num_joints, float interp, struct md5_joint_t *out)
+static qboolean R_MD5SkinMatches (const md5skincache_t *cache, const md5header_t *hdr, int pose1, int pose2, float blend)
 {
-	int i;
+	return (cache && cache->valid && cache->hdr == hdr && cache->pose1 == pose1 && cache->pose2 == pose2 && cache->blend == blend);
+}
 
-	for (i = 0; i < num_joints; ++i)
-	{
-		// Copy parent index
-		out[i].parent = skelA[i].parent;
 
-		// Linear interpolation for position
-		out[i].pos[0] = skelA[i].pos[0] + interp * (skelB[i].pos[0] - skelA[i].pos[0]);
-		out[i].pos[1] = skelA[i].pos[1] + interp * (skelB[i].pos[1] - skelA[i].pos[1]);
-		out[i].pos[2] = skelA[i].pos[2] + interp * (skelB[i].pos[2] - skelA[i].pos[2]);
+/*
+==================
+R_MD5HoldSkin
 
-		// Spherical linear interpolation for orientation
-		Quat_slerp (skelA[i].orient, skelB[i].orient, interp, out[i].orient);
-	}
+true if an entity can go on drawing from the slot it used last even though it's poses have changed; the slot must
+still hold what the entity drew last time, not something another entity skinned into it since
+==================
+*/
+static qboolean R_MD5HoldSkin (entity_t *e, const md5skincache_t *cache, md5header_t *hdr, const lerpdata_t *lerpdata)
+{
+	if (!cache || !cache->valid || cache->hdr != hdr || cache->serial != e->md5skinserial) return false;
+
+	return (r_framecount - cache->skinframe < R_MD5AnimLODFrames (e, hdr, lerpdata));
 }
 
 
 /*
 ==================
-MD5_PrepareMesh
+R_CountMD5Skin
 
+the pre-pass and each of the drawing passes all look an entity up, so the stats only count it the first time each
+frame.  rs_md5skins is the number of different model/pose/blend keys drawn this frame; entities with no cache slot
+are skinned on their own so they each count as one.
 ==================
 */
-static void MD5_PrepareMesh (const struct md5_mesh_t *mesh, const struct md5_joint_t *skeleton, md5polyvert_t *vertexes, vertexnormals_t *vnorms)
+static void R_CountMD5Skin (entity_t *e, md5skincache_t *cache, qboolean hit)
 {
-	int i, j;
+	if (e->md5skinstatframe == r_framecount) return;
 
-	if (r_drawflat_cheatsafe)
-		srand ((int) mesh);
+	e->md5skinstatframe = r_framecount;
 
-	// Setup vertices
-	for (i = 0; i < mesh->num_verts; i++)
+	if (hit)
+		rs_md5skinhits++;
+	else rs_md5skinmisses++;
+
+	if (!cache)
+		rs_md5skins++;
+	else if (cache->statframe != r_framecount)
 	{
-		vec3_t finalVertex = {0.0f, 0.0f, 0.0f};
-		vec3_t finalNormal = {0.0f, 0.0f, 0.0f};
-		float Angle;
+		cache->statframe = r_framecount;
+		rs_md5skins++;
+	}
+}
 
-		// Calculate final vertex to draw with weights
-		for (j = 0; j < mesh->vertices[i].count; j++)
-		{
-			const struct md5_weight_t *weight = &mesh->weights[mesh->vertices[i].start + j];
-			const struct md5_joint_t *joint = &skeleton[weight->joint];
 
-			// Calculate transformed vertex for this weight
-			vec3_t wv;
-			Quat_rotatePoint (joint->orient, weight->pos, wv);
+/*
+==================
+R_GetMD5SkinCache
 
-			// The sum of all weight->bias should be 1.0
-			finalVertex[0] += (joint->pos[0] + wv[0]) * weight->bias;
-			finalVertex[1] += (joint->pos[1] + wv[1]) * weight->bias;
-			finalVertex[2] += (joint->pos[2] + wv[2]) * weight->bias;
+finds the cache slot holding the skin for an entity's poses and sets hit if it's already skinned.  otherwise the
+least recently used slot is claimed for them and whoever gets the miss must skin it before anything draws from it.
+returns NULL if there's no memory for it.
+==================
+*/
+static md5skincache_t *R_GetMD5SkinCache (entity_t *e, md5header_t *hdr, const lerpdata_t *lerpdata, qboolean *hit)
+{
+	md5skincache_t *cache = e->md5skincache;
+	int numverts = hdr->md5mesh.meshes[0].num_verts;
+	int pose1, pose2;
+	float blend;
+	int i;
 
-			// Calculate transformed normal for this weight
-			Quat_rotatePoint (joint->orient, vnorms[i].normal, wv);
+	MD5_SkinPoses (lerpdata, &pose1, &pose2, &blend);
 
-			// The sum of all weight->bias should be 1.0
-			finalNormal[0] += wv[0] * weight->bias;
-			finalNormal[1] += wv[1] * weight->bias;
-			finalNormal[2] += wv[2] * weight->bias;
-		}
+	// the slot this entity used last is the most likely, then anyone else's
+	if (!R_MD5SkinMatches (cache, hdr, pose1, pose2, blend) && !R_MD5HoldSkin (e, cache, hdr, lerpdata))
+	{
+		for (i = 0, cache = NULL; i < MAX_MD5_SKINCACHE; i++)
+		{
+			if (!R_MD5SkinMatches (&md5_skincache[i], hdr, pose1, pose2, blend)) continue;
 
-		// store out position
-		vertexes[i].position[0] = finalVertex[0];
-		vertexes[i].position[1] = finalVertex[1];
-		vertexes[i].position[2] = finalVertex[2];
+			cache = &md5_skincache[i];
+			break;
+		}
+	}
 
-		// store out colour
-		if (r_drawflat_cheatsafe)
+	if (cache)
+		*hit = true;
+	else
+	{
+		// take the least recently used slot that isn't in use this frame
+		for (i = 0; i < MAX_MD5_SKINCACHE; i++)
 		{
-			vertexes[i].colour[0] = (rand () % 256) / 255.0f;
-			vertexes[i].colour[1] = (rand () % 256) / 255.0f;
-			vertexes[i].colour[2] = (rand () % 256) / 255.0f;
-			vertexes[i].colour[3] = 1;
+			if (md5_skincache[i].lastframe == r_framecount) continue;
+			if (!cache || md5_skincache[i].lastframe < cache->lastframe) cache = &md5_skincache[i];
 		}
-		else
+
+		// this can only happen if R_FlushMD5SkinCache wasn't called after r_framecount was reset
+		if (!cache) return NULL;
+
+		// grow the storage; it's only ever needed for the current contents so it doesn't need to be kept
+		if (numverts > cache->maxverts)
 		{
-			// replicate GLQuake's anorm_dots table
-			if ((Angle = DotProduct (finalNormal, shadevector)) < 0)
-				Angle = 1.0f + Angle * (13.0f / 44.0f);
-			else Angle += 1.0f;
+			if (cache->vertexes) free (cache->vertexes);
+			if (cache->normals) free (cache->normals);
+
+			cache->vertexes = (md5polyvert_t *) malloc (numverts * sizeof (md5polyvert_t));
+			cache->normals = (float (*)[3]) malloc (numverts * sizeof (float) * 3);
+			cache->valid = false;
 
-			vertexes[i].colour[0] = lightcolor[0] * Angle;
-			vertexes[i].colour[1] = lightcolor[1] * Angle;
-			vertexes[i].colour[2] = lightcolor[2] * Angle;
-			vertexes[i].colour[3] = entalpha;
+			if (!cache->vertexes || !cache->normals)
+			{
+				if (cache->vertexes) free (cache->vertexes);
+				if (cache->normals) free (cache->normals);
+
+				cache->vertexes = NULL;
+				cache->normals = NULL;
+				cache->maxverts = 0;
+
+				return NULL;
+			}
+
+			cache->maxverts = numverts;
 		}
 
-		// store out texcoords
-		vertexes[i].texcoord[0] = mesh->vertices[i].st[0];
-		vertexes[i].texcoord[1] = mesh->vertices[i].st[1];
+		*hit = false;
+
+		cache->hdr = hdr;
+		cache->pose1 = pose1;
+		cache->pose2 = pose2;
+		cache->blend = blend;
+		cache->valid = true;
+		cache->serial = ++md5_skinserial;
+		cache->skinframe = r_framecount;
 	}
+
+	cache->lastframe = r_framecount;
+
+	R_CountMD5Skin (e, cache, *hit);
+
+	e->md5skincache = cache;
+	e->md5skinserial = cache->serial;
+
+	return cache;
 }
 
 
-void MD5_WeldNormals (md5header_t *hdr)
+/*
+==============================================================================
+
+MD5 SKINNING THREADS
+
+all visible MD5 entities that miss the skin cache are skinned before any of them are drawn.  the main thread kicks
+this off before drawing the world, and the skinning is a job on the job threads (see sys_jobs.c).  the threads take
+one entity at a time, so one that gets a few big models doesn't hold the frame up while the others sit idle, and the
+main thread does whatever's left when it needs the vertexes.  interpolated skeletons and joint matrices go in a
+per-frame arena and the vertexes go into the skin cache.  anything that wasn't skinned in advance (the viewmodel, for
+example) is skinned on the spot.
+
+==============================================================================
+*/
+
+// -1 = one per processor (leaving one for the main thread), 0 = skin on the main thread only
+cvar_t r_md5threads = {"r_md5threads", "-1"};
+
+typedef struct md5skinjob_s
 {
-	md5polyvert_t
-		* pervert
-	,	* vert
-		;
-	int
-		v
-	,	w
-	,	numverts
-	,	numnormals
-		;
+	md5skincache_t	*cache;
 
-	// these have already been built in MD5_BuildBaseNormals so we can just reference the array directly again
-	md5polyvert_t *vertexes = r_md5vertexes;
+	// frame skeletons, looked up before the threads start
+	const struct md5_pose_t *skel1;
+	const struct md5_pose_t *skel2;
 
-	// weld all normals per vertex position
-	numverts = hdr->md5mesh.meshes[0].num_verts;
+	// this entity's slice of the arena
+	struct md5_pose_t *skeleton;
+	md5_jointmat_t	*palette;
+	struct md5_pose_t *posescratch;
+} md5skinjob_t;
 
-	for (pervert = vertexes, v = 0 ; v < numverts ; v++, pervert++)
-	{
-		vec3_t
-			newnormal = {0.0f, 0.0f, 0.0f}
-			;
-		numnormals = 0;
+static md5skinjob_t		md5_skinjobs[MAX_VISEDICTS];
+static int				md5_numskinjobs;
 
-		// compute new normal
-		for (vert = pervert, w = v ; w < numverts ; w++, vert++)
-		{
-			if (vert->position[0] == pervert->position[0] &&
-				vert->position[1] == pervert->position[1] &&
-				vert->position[2] == pervert->position[2])
-			{
-				VectorAdd (newnormal, hdr->vnorms[w].normal, newnormal);
-				numnormals++;
-			}
-		}
+static sysjob_t			md5_skinjob;
 
-		if (numnormals > 1)
-		{
-			VectorNormalize (newnormal);
+static byte				*md5_skinarena;
+static int				md5_skinarenasize;
 
-			// iterate again, applying the new normal to all corresponding vertices
-			for (vert = pervert, w = v ; w < numverts ; w++, vert++)
-			{
-				if (vert->position[0] == pervert->position[0] &&
-					vert->position[1] == pervert->position[1] &&
-					vert->position[2] == pervert->position[2])
-				{
-					VectorCopy (newnormal, hdr->vnorms[w].normal);
-				}
-			}
-		}
+
+/*
+==================
+R_RunMD5SkinJobs
+
+==================
+*/
+static void R_RunMD5SkinJobs (void *data, int first, int count)
+{
+	int j;
+
+	for (j = first; j < first + count; j++)
+	{
+		md5skincache_t *cache = md5_skinjobs[j].cache;
+
+		MD5_SkinFrame (cache->hdr, md5_skinjobs[j].skel1, md5_skinjobs[j].skel2, cache->blend, md5_skinjobs[j].skeleton, md5_skinjobs[j].palette, cache->vertexes, cache->normals);
 	}
 }
 
 
 /*
 ==================
-MD5_BuildBaseNormals
+R_MD5SkinSize
 
+size of an entity's slice of the arena; every part is kept 16-byte aligned.  packed animations also need somewhere to
+unpack frames that don't fit in the pose cache.
 ==================
 */
-void MD5_BuildBaseNormals (md5header_t *hdr, struct md5_mesh_t *mesh)
+static int R_MD5SkinSize (md5header_t *hdr)
 {
-	// allocate memory for normals
-	vertexnormals_t *vnorms = (vertexnormals_t *) Hunk_Alloc (sizeof (vertexnormals_t) * mesh->num_verts);
+	int numjoints = hdr->md5anim.num_joints;
+	int size = ((sizeof (struct md5_pose_t) * numjoints + 15) & ~15) + ((sizeof (md5_jointmat_t) * numjoints + 15) & ~15);
 
-	// get rhe rest of the data we need
-	const struct md5_joint_t *skeleton = hdr->md5mesh.baseSkel;
-	md5polyvert_t *vertexes = r_md5vertexes;
+	if (hdr->md5anim.packed)
+		size += (sizeof (struct md5_pose_t) * numjoints * 2 + 15) & ~15;
 
-	int i, j;
+	return size;
+}
 
-	// Setup vertices for the base frame
-	for (i = 0; i < mesh->num_verts; i++)
-	{
-		vec3_t finalVertex = {0.0f, 0.0f, 0.0f};
 
-		// Calculate final vertex to draw with weights
-		for (j = 0; j < mesh->vertices[i].count; j++)
-		{
-			const struct md5_weight_t *weight = &mesh->weights[mesh->vertices[i].start + j];
-			const struct md5_joint_t *joint = &skeleton[weight->joint];
+/*
+==================
+R_BeginMD5Skinning
 
-			// Calculate transformed vertex for this weight
-			vec3_t wv;
-			Quat_rotatePoint (joint->orient, weight->pos, wv);
+collects the visible MD5 entities and starts skinning the ones that aren't already cached
+==================
+*/
+void R_BeginMD5Skinning (void)
+{
+	int i, numthreads, arenasize = 0;
+	byte *arena;
 
-			// The sum of all weight->bias should be 1.0
-			finalVertex[0] += (joint->pos[0] + wv[0]) * weight->bias;
-			finalVertex[1] += (joint->pos[1] + wv[1]) * weight->bias;
-			finalVertex[2] += (joint->pos[2] + wv[2]) * weight->bias;
-		}
+	md5_numskinjobs = 0;
 
-		// store out position
-		vertexes[i].position[0] = finalVertex[0];
-		vertexes[i].position[1] = finalVertex[1];
-		vertexes[i].position[2] = finalVertex[2];
-	}
+	if (!r_drawentities.value)
+		return;
 
-	// no normals initially
-	for (i = 0; i < mesh->num_verts; i++)
+	for (i = 0; i < cl_numvisedicts; i++)
 	{
-		vnorms[i].normal[0] = vnorms[i].normal[1] = vnorms[i].normal[2] = 0;
-		vnorms[i].numnormals = 0;
-	}
+		entity_t *e = cl_visedicts[i];
+		md5skincache_t *cache;
+		md5header_t *hdr;
+		lerpdata_t lerpdata;
+		qboolean hit;
 
-	// accumulate triangle normals to vnorms
-	for (i = 0; i < mesh->num_tris; i++)
-	{
-		float triverts[3][3];
-		float vtemp1[3], vtemp2[3], normal[3];
+		if (e->model->type != mod_md5) continue;
+		if (ENTALPHA_DECODE (e->alpha) == 0) continue;
 
-		// undo the vertex rotation from modelgen.c here
-		// i don't know why id did it this way, but i decided to adapt it unmodified for consistency with modelgen.c
-		for (j = 0; j < 3; j++)
-		{
-			triverts[j][0] = vertexes[mesh->triangles[i].index[j]].position[1];
-			triverts[j][1] = -vertexes[mesh->triangles[i].index[j]].position[0];
-			triverts[j][2] = vertexes[mesh->triangles[i].index[j]].position[2];
-		}
+		hdr = (md5header_t *) e->model->cache.data;
 
-		// calc the per-triangle normal
-		VectorSubtract (triverts[0], triverts[1], vtemp1);
-		VectorSubtract (triverts[2], triverts[1], vtemp2);
-		CrossProduct (vtemp1, vtemp2, normal);
-		VectorNormalize (normal);
+		// set up and cull the same as the drawing functions do
+		currententity = e;
+		R_SetupMD5Frame (e->frame, &lerpdata);
+		R_SetupEntityTransform (e, &lerpdata);
 
-		// and accumulate it into the calculated normals array
-		for (j = 0; j < 3; j++)
-		{
-			// rotate the normal so the model faces down the positive x axis
-			// i don't know why id did it this way, but i decided to adapt it unmodified for consistency with modelgen.c
-			vnorms[mesh->triangles[i].index[j]].normal[0] -= normal[1];
-			vnorms[mesh->triangles[i].index[j]].normal[1] += normal[0];
-			vnorms[mesh->triangles[i].index[j]].normal[2] += normal[2];
+		if (e != &cl.viewent)
+			if (R_CullMD5Model (lerpdata, &hdr->md5anim))
+				continue;
 
-			// count the normals for averaging
-			vnorms[mesh->triangles[i].index[j]].numnormals++;
-		}
+		// anything without a cache slot will be skinned as it's drawn instead, and anything sharing a slot with an
+		// entity earlier in the list was claimed by that one
+		if ((cache = R_GetMD5SkinCache (e, hdr, &lerpdata, &hit)) == NULL) continue;
+		if (hit) continue;
+
+		md5_skinjobs[md5_numskinjobs++].cache = cache;
+
+		arenasize += R_MD5SkinSize (hdr);
 	}
 
-	// calculate final normals
-	for (i = 0; i < mesh->num_verts; i++)
+	if (!md5_numskinjobs)
+		return;
+
+	// grow the arena if needed; it's contents don't need to be kept
+	if (arenasize > md5_skinarenasize)
 	{
-		vec3_t finalNormal = {0.0f, 0.0f, 0.0f};
+		if (md5_skinarena) free (md5_skinarena);
 
-		// numnormals was checked for > 0 in modelgen.c so we shouldn't need to do it again 
-		// here but we do anyway just in case a rogue modder has used a bad modelling tool
-		if (vnorms[i].numnormals > 0)
-		{
-			VectorScale (vnorms[i].normal, (float) vnorms[i].numnormals, vnorms[i].normal);
-			VectorNormalize (vnorms[i].normal);
-		}
-		else
+		if ((md5_skinarena = (byte *) malloc (arenasize + 15)) == NULL)
 		{
-			vnorms[i].normal[0] = vnorms[i].normal[1] = 0;
-			vnorms[i].normal[2] = 1;
-		}
+			// the cache entries were claimed so they must be filled now
+			md5_skinarenasize = 0;
 
-		// this normal is now in object space for the base frame so rotate it back to joint-local space
-		for (j = 0; j < mesh->vertices[i].count; j++)
-		{
-			const struct md5_weight_t *weight = &mesh->weights[mesh->vertices[i].start + j];
-			const struct md5_joint_t *joint = &skeleton[weight->joint];
+			for (i = 0; i < md5_numskinjobs; i++)
+			{
+				md5skincache_t *cache = md5_skinjobs[i].cache;
+				const struct md5_pose_t *skel1, *skel2;
 
-			// Calculate transformed normal for this weight - inverse rotate it back to joint-local space
-			vec3_t wv;
-			Quat_inverseRotatePoint (joint->orient, vnorms[i].normal, wv);
+				MD5_FrameSkeletons (cache->hdr, cache->pose1, cache->pose2, r_md5posescratch, &skel1, &skel2);
+				MD5_SkinFrame (cache->hdr, skel1, skel2, cache->blend, cache->hdr->skeleton, cache->hdr->palette, cache->vertexes, cache->normals);
+			}
 
-			// The sum of all weight->bias should be 1.0
-			finalNormal[0] += wv[0] * weight->bias;
-			finalNormal[1] += wv[1] * weight->bias;
-			finalNormal[2] += wv[2] * weight->bias;
+			md5_numskinjobs = 0;
+			return;
 		}
 
-		// store out the final normal in joint-local space
-		vnorms[i].normal[0] = finalNormal[0];
-		vnorms[i].normal[1] = finalNormal[1];
-		vnorms[i].normal[2] = finalNormal[2];
+		md5_skinarenasize = arenasize;
 	}
 
-	// store the normals out in the MD5 header now
-	hdr->vnorms = vnorms;
-}
+	// carve it up
+	arena = md5_skinarena + ((16 - ((size_t) md5_skinarena & 15)) & 15);
 
+	for (i = 0; i < md5_numskinjobs; i++)
+	{
+		md5skinjob_t *job = &md5_skinjobs[i];
+		md5skincache_t *cache = job->cache;
+		int numjoints = cache->hdr->md5anim.num_joints;
 
-/*
-==================
-R_CullMD5Model
+		job->skeleton = (struct md5_pose_t *) arena;
+		arena += (sizeof (struct md5_pose_t) * numjoints + 15) & ~15;
 
-==================
-*/
-static qboolean R_CullMD5Model (lerpdata_t lerpdata, const struct md5_anim_t *anim)
-{
-	// for simplicity and clarity i didn't bother doing bbox rotation
-	float mins[3] = {
-		anim->bboxes[lerpdata.pose1].min[0] * (1.0f - lerpdata.blend) + anim->bboxes[lerpdata.pose2].min[0] * lerpdata.blend + lerpdata.origin[0],
-		anim->bboxes[lerpdata.pose1].min[1] * (1.0f - lerpdata.blend) + anim->bboxes[lerpdata.pose2].min[1] * lerpdata.blend + lerpdata.origin[1],
-		anim->bboxes[lerpdata.pose1].min[2] * (1.0f - lerpdata.blend) + anim->bboxes[lerpdata.pose2].min[2] * lerpdata.blend + lerpdata.origin[2]
-	};
+		job->palette = (md5_jointmat_t *) arena;
+		arena += (sizeof (md5_jointmat_t) * numjoints + 15) & ~15;
+
+		if (cache->hdr->md5anim.packed)
+		{
+			job->posescratch = (struct md5_pose_t *) arena;
+			arena += (sizeof (struct md5_pose_t) * numjoints * 2 + 15) & ~15;
+		}
+		else job->posescratch = NULL;
 
-	float maxs[3] = {
-		anim->bboxes[lerpdata.pose1].max[0] * (1.0f - lerpdata.blend) + anim->bboxes[lerpdata.pose2].max[0] * lerpdata.blend + lerpdata.origin[0],
-		anim->bboxes[lerpdata.pose1].max[1] * (1.0f - lerpdata.blend) + anim->bboxes[lerpdata.pose2].max[1] * lerpdata.blend + lerpdata.origin[1],
-		anim->bboxes[lerpdata.pose1].max[2] * (1.0f - lerpdata.blend) + anim->bboxes[lerpdata.pose2].max[2] * lerpdata.blend + lerpdata.origin[2]
-	};
+		// packed frames are unpacked here because the pose cache is main-thread only
+		MD5_FrameSkeletons (cache->hdr, cache->pose1, cache->pose2, job->posescratch, &job->skel1, &job->skel2);
+	}
 
-	return R_CullBox (mins, maxs);
+	// r_md5skincheck uses static scratch space so it must stay on the main thread
+	if (r_md5skincheck.value)
+		numthreads = 0;
+	else if (r_md5threads.value < 0)
+		numthreads = Sys_NumProcessors () - 1;
+	else numthreads = (int) r_md5threads.value;
+
+	// there's no point in having threads sitting idle
+	if (numthreads > md5_numskinjobs - 1)
+		numthreads = md5_numskinjobs - 1;
+
+	// one entity at a time so that the threads stay busy until they're all done
+	md5_skinjob.func = R_RunMD5SkinJobs;
+	md5_skinjob.data = NULL;
+	md5_skinjob.count = md5_numskinjobs;
+	md5_skinjob.batch = 1;
+	md5_skinjob.maxthreads = numthreads;
+
+	Sys_StartJob (&md5_skinjob);
 }
 
 
 /*
 ==================
-R_SetMD5BaseTexture
+R_FinishMD5Skinning
 
+the main thread helps out with whatever is left then waits for the job threads
 ==================
 */
-static void R_SetMD5BaseTexture (entity_t *e, skinpair_t *image)
+void R_FinishMD5Skinning (void)
 {
-	GL_DisableMultitexture ();
-
-	if (e->colormap != vid.colormap && !gl_nocolors.value)
-	{
-		int i = e - cl_entities;
+	if (!md5_numskinjobs)
+		return;
 
-		if (i >= 1 && i <= cl.maxclients /* && !strcmp (currententity->model->name, "progs/player.mdl") */)
-		{
-		    GL_Bind (playertextures[i - 1]);
-			return;
-		}
-	}
+	Sys_FinishJob (&md5_skinjob);
 
-	GL_Bind (image->tx);
+	// so that it can't be waited on again
+	md5_numskinjobs = 0;
 }
 
 
 /*
 ==================
-R_InterpolateMD5Model
+R_SkinMD5Entity
 
+returns the skinned vertexes for an entity, skinning them now if they're not in the cache, and their serial for
+R_SetupMD5Arrays
 ==================
 */
-void R_InterpolateMD5Model (md5header_t *hdr, lerpdata_t *lerpdata)
+static md5polyvert_t *R_SkinMD5Entity (entity_t *e, md5header_t *hdr, lerpdata_t *lerpdata, float (**normals)[3], int *serial)
 {
-	// optimize the non-interpolated cases
-	if (lerpdata->pose1 == lerpdata->pose2)
-	{
-		// case #1 - not lerping, just animate from a single skeleton
-		MD5_PrepareMesh (&hdr->md5mesh.meshes[0], hdr->md5anim.skelFrames[lerpdata->pose1], r_md5vertexes, hdr->vnorms);
-	}
-	else if (!(lerpdata->blend > 0))
+	qboolean hit;
+	md5skincache_t *cache = R_GetMD5SkinCache (e, hdr, lerpdata, &hit);
+	const struct md5_pose_t *skel1, *skel2;
+	int pose1, pose2;
+	float blend;
+
+	if (!cache)
 	{
-		// case #2 : lerpblend is 0 so just animate from one frame
-		MD5_PrepareMesh (&hdr->md5mesh.meshes[0], hdr->md5anim.skelFrames[lerpdata->pose1], r_md5vertexes, hdr->vnorms);
+		// no memory so use the scratch space
+		MD5_SkinPoses (lerpdata, &pose1, &pose2, &blend);
+		MD5_FrameSkeletons (hdr, pose1, pose2, r_md5posescratch, &skel1, &skel2);
+		MD5_SkinFrame (hdr, skel1, skel2, blend, hdr->skeleton, hdr->palette, r_md5vertexes, r_md5normals);
+		R_CountMD5Skin (e, NULL, false);
+
+		*normals = r_md5normals;
+		*serial = 0;
+		return r_md5vertexes;
 	}
-	else if (!(lerpdata->blend < 1))
+
+	if (!hit)
 	{
-		// case #3 : lerpblend is 1 so just animate from one frame
-		MD5_PrepareMesh (&hdr->md5mesh.meshes[0], hdr->md5anim.skelFrames[lerpdata->pose2], r_md5vertexes, hdr->vnorms);
+		MD5_FrameSkeletons (hdr, cache->pose1, cache->pose2, r_md5posescratch, &skel1, &skel2);
+		MD5_SkinFrame (hdr, skel1, skel2, cache->blend, hdr->skeleton, hdr->palette, cache->vertexes, cache->normals);
 	}
-	else
-	{
-		// case #4 : full interpolation - run the skeletal animation
-		MD5_InterpolateSkeletons (hdr->md5anim.skelFrames[lerpdata->pose1], hdr->md5anim.skelFrames[lerpdata->pose2], hdr->md5anim.num_joints, lerpdata->blend, hdr->skeleton);
 
-		// and set up the vertex array
-		MD5_PrepareMesh (&hdr->md5mesh.meshes[0], hdr->skeleton, r_md5vertexes, hdr->vnorms);
-	}
+	*normals = cache->normals;
+	*serial = cache->serial;
+	return cache->vertexes;
 }
 
 
@@ -513,18 +1350,27 @@ void R_DrawMD5Model (entity_t *e)
 {
 	md5header_t *hdr = (md5header_t *) e->model->cache.data;
 	lerpdata_t	lerpdata;
-
-	// auto-animation for skins
-	md5skin_t *skin = &hdr->skins[e->skinnum % hdr->numskins];
-	skinpair_t *image = &skin->image[(int) ((cl.time + e->syncbase) * 10) % skin->numskins];
+	md5polyvert_t *vertexes;
+	float		(*normals)[3];
+	int			serial, lod;
+	qboolean	mtexfullbright;
 
 	R_SetupMD5Frame (e->frame, &lerpdata);
 	R_SetupEntityTransform (e, &lerpdata);
 
-	// cull it (don't cull the viewmodel)
+	// cull it (don't cull the viewmodel); this is done before any of the lighting
 	if (e != &cl.viewent)
+	{
 		if (R_CullMD5Model (lerpdata, &hdr->md5anim))
+		{
+			rs_md5culled++;
 			return;
+		}
+	}
+
+	rs_md5drawn++;
+
+	lod = R_MD5LOD (e, hdr, &lerpdata);
 
 	// transform it
     glPushMatrix ();
@@ -532,7 +1378,7 @@ void R_DrawMD5Model (entity_t *e)
 
 	// set up lighting
 	overbright = gl_overbright_models.value;
-	rs_aliaspolys += hdr->md5mesh.meshes[0].num_tris;
+	rs_aliaspolys += lod ? hdr->lodnumtris[lod - 1] : hdr->md5mesh.meshes[0].num_tris;
 	R_SetupAliasLighting (e);
 
 	// set up shadevector from the specified yaw angle
@@ -541,21 +1387,8 @@ void R_DrawMD5Model (entity_t *e)
 	shadevector[2] = 1;
 	VectorNormalize (shadevector);
 
-	// base texture
-	R_SetMD5BaseTexture (e, image);
-
 	// set up the MD5 interpolation and frame
-	R_InterpolateMD5Model (hdr, &lerpdata);
-
-	// set up arrays
-	glEnableClientState (GL_VERTEX_ARRAY);
-	glEnableClientState (GL_COLOR_ARRAY);
-	glEnableClientState (GL_TEXTURE_COORD_ARRAY);
-
-	// set up pointers
-	glVertexPointer (3, GL_FLOAT, sizeof (md5polyvert_t), r_md5vertexes->position);
-	glColorPointer (4, GL_FLOAT, sizeof (md5polyvert_t), r_md5vertexes->colour);
-	glTexCoordPointer (2, GL_FLOAT, sizeof (md5polyvert_t), r_md5vertexes->texcoord);
+	vertexes = R_SkinMD5Entity (e, hdr, &lerpdata, &normals, &serial);
 
 	// other stuff for consistency/compat with the MDL renderer
 	if (gl_smoothmodels.value && !r_drawflat_cheatsafe)
@@ -572,6 +1405,19 @@ void R_DrawMD5Model (entity_t *e)
 	if (entalpha == 0)
 		goto cleanup;
 
+	// light it now that the alpha is known
+	MD5_LightMesh (&hdr->md5mesh.meshes[0], normals);
+
+	// base, overbright and fullbright go in one pass if there's a TMU for the fullbrights, the same as cases 1 and 4 in
+	// R_DrawAliasModel; without combiners overbright takes two passes anyway so the fullbrights stay a pass of their own
+	mtexfullbright = (gl_mtexable && gl_texture_env_add && GL_ClientActiveTextureFunc &&
+		!r_drawflat_cheatsafe && !r_fullbright_cheatsafe && !r_lightmap_cheatsafe &&
+		(!overbright || gl_texture_env_combine) &&
+		gl_fullbrights.value && R_MD5HasFullbrights (e, hdr));
+
+	// set up arrays and pointers with the lit vertexes
+	R_SetupMD5Arrays (hdr, vertexes, serial, true, mtexfullbright ? 2 : 1);
+
 	if (entalpha < 1)
 	{
 		if (!gl_texture_env_combine) overbright = false; //overbright can't be done in a single pass without combiners
@@ -584,26 +1430,25 @@ void R_DrawMD5Model (entity_t *e)
 	{
 		glDisable (GL_TEXTURE_2D);
 		glShadeModel (GL_FLAT);
-		GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+		GL_DrawMD5Frame (e, hdr, MD5_DRAW_UNTEXTURED, lod);
 		glEnable (GL_TEXTURE_2D);
 		srand ((int) (cl.time * 1000)); //restore randomness
 	}
 	else if (r_fullbright_cheatsafe)
 	{
 		glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-		GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+		GL_DrawMD5Frame (e, hdr, MD5_DRAW_BASE, lod);
 
 		// fullbright mask (if present)
-		if (image->fb && gl_fullbrights.value)
+		if (gl_fullbrights.value && R_MD5HasFullbrights (e, hdr))
 		{
-			GL_Bind (image->fb);
 			glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
 			glEnable (GL_BLEND);
 			glBlendFunc (GL_ONE, GL_ONE);
 			glDepthMask (GL_FALSE);
 
 			Fog_StartAdditive ();
-			GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+			GL_DrawMD5Frame (e, hdr, MD5_DRAW_FULLBRIGHT, lod);
 			Fog_StopAdditive ();
 
 			glDepthMask (GL_TRUE);
@@ -614,12 +1459,32 @@ void R_DrawMD5Model (entity_t *e)
 	else if (r_lightmap_cheatsafe)
 	{
 		glDisable (GL_TEXTURE_2D);
-		GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+		GL_DrawMD5Frame (e, hdr, MD5_DRAW_UNTEXTURED, lod);
 		glEnable (GL_TEXTURE_2D);
 	}
+	else if (mtexfullbright)
+	{
+		GL_DisableMultitexture (); // selects TEXTURE0
+
+		if (overbright)
+		{
+			glTexEnvi (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE_EXT);
+			glTexEnvi (GL_TEXTURE_ENV, GL_COMBINE_RGB_EXT, GL_MODULATE);
+			glTexEnvi (GL_TEXTURE_ENV, GL_SOURCE0_RGB_EXT, GL_TEXTURE);
+			glTexEnvi (GL_TEXTURE_ENV, GL_SOURCE1_RGB_EXT, GL_PRIMARY_COLOR_EXT);
+			glTexEnvf (GL_TEXTURE_ENV, GL_RGB_SCALE_EXT, 2.0f);
+		}
+		else glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+		GL_DrawMD5Frame (e, hdr, MD5_DRAW_BASE_FULLBRIGHT, lod);
+
+		if (overbright)
+			glTexEnvf (GL_TEXTURE_ENV, GL_RGB_SCALE_EXT, 1.0f);
+
+		glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	}
 	else
 	{
-		// for simplicity and clarity i didn't bother doing a multitextured base+fullbright pass
 		if (overbright)
 		{
 			if (gl_texture_env_combine)
@@ -631,7 +1496,7 @@ void R_DrawMD5Model (entity_t *e)
 				glTexEnvi (GL_TEXTURE_ENV, GL_SOURCE1_RGB_EXT, GL_PRIMARY_COLOR_EXT);
 				glTexEnvf (GL_TEXTURE_ENV, GL_RGB_SCALE_EXT, 2.0f);
 
-				GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+				GL_DrawMD5Frame (e, hdr, MD5_DRAW_BASE, lod);
 
 				glTexEnvf (GL_TEXTURE_ENV, GL_RGB_SCALE_EXT, 1.0f);
 				glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
@@ -640,7 +1505,7 @@ void R_DrawMD5Model (entity_t *e)
 			{
 				// first pass
 				glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-				GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+				GL_DrawMD5Frame (e, hdr, MD5_DRAW_BASE, lod);
 
 				// second pass
 				glEnable (GL_BLEND);
@@ -648,7 +1513,7 @@ void R_DrawMD5Model (entity_t *e)
 				glDepthMask (GL_FALSE);
 
 				Fog_StartAdditive ();
-				GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+				GL_DrawMD5Frame (e, hdr, MD5_DRAW_BASE, lod);
 				Fog_StopAdditive ();
 
 				glDepthMask (GL_TRUE);
@@ -661,20 +1526,19 @@ void R_DrawMD5Model (entity_t *e)
 		{
 			// one pass only
 			glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-			GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+			GL_DrawMD5Frame (e, hdr, MD5_DRAW_BASE, lod);
 		}
 
 		// fullbright mask (if present)
-		if (image->fb && gl_fullbrights.value)
+		if (gl_fullbrights.value && R_MD5HasFullbrights (e, hdr))
 		{
-			GL_Bind (image->fb);
 			glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
 			glEnable (GL_BLEND);
 			glBlendFunc (GL_ONE, GL_ONE);
 			glDepthMask (GL_FALSE);
 
 			Fog_StartAdditive ();
-			GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+			GL_DrawMD5Frame (e, hdr, MD5_DRAW_FULLBRIGHT, lod);
 			Fog_StopAdditive ();
 
 			glDepthMask (GL_TRUE);
@@ -692,9 +1556,7 @@ cleanup:;
 	glDisable (GL_BLEND);
 
 	// shut down arrays
-	glDisableClientState (GL_VERTEX_ARRAY);
-	glDisableClientState (GL_COLOR_ARRAY);
-	glDisableClientState (GL_TEXTURE_COORD_ARRAY);
+	R_FinishMD5Arrays ();
 
 	glPopMatrix ();
 
@@ -727,6 +1589,9 @@ void GL_DrawMD5Shadow (entity_t *e)
 	md5header_t *hdr = (md5header_t *) e->model->cache.data;
 	lerpdata_t	lerpdata;
 	float		lheight;
+	md5polyvert_t *vertexes;
+	float		(*normals)[3];
+	int			serial, lod;
 
 	R_SetupMD5Frame (e->frame, &lerpdata);
 	R_SetupEntityTransform (e, &lerpdata);
@@ -738,6 +1603,8 @@ void GL_DrawMD5Shadow (entity_t *e)
 	if (R_CullMD5Model (lerpdata, &hdr->md5anim))
 		return;
 
+	lod = R_MD5LOD (e, hdr, &lerpdata);
+
 	entalpha = ENTALPHA_DECODE (e->alpha);
 	if (entalpha == 0) return;
 
@@ -755,11 +1622,10 @@ void GL_DrawMD5Shadow (entity_t *e)
 	glRotatef (lerpdata.angles[2], 1, 0, 0);
 
 	// set up the MD5 interpolation and frame
-	R_InterpolateMD5Model (hdr, &lerpdata);
+	vertexes = R_SkinMD5Entity (e, hdr, &lerpdata, &normals, &serial);
 
 	// set up array and pointer
-	glEnableClientState (GL_VERTEX_ARRAY);
-	glVertexPointer (3, GL_FLOAT, sizeof (md5polyvert_t), r_md5vertexes->position);
+	R_SetupMD5Arrays (hdr, vertexes, serial, false, 0);
 
 	// draw it
 	glDepthMask (GL_FALSE);
@@ -768,14 +1634,14 @@ void GL_DrawMD5Shadow (entity_t *e)
 	glDisable (GL_TEXTURE_2D);
 	glColor4f (0, 0, 0, entalpha * 0.5);
 
-	GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+	GL_DrawMD5Frame (e, hdr, MD5_DRAW_UNTEXTURED, lod);
 
 	glEnable (GL_TEXTURE_2D);
 	glDisable (GL_BLEND);
 	glDepthMask (GL_TRUE);
 
 	//clean up
-	glDisableClientState (GL_VERTEX_ARRAY);
+	R_FinishMD5Arrays ();
 	glPopMatrix ();
 }
 
@@ -790,6 +1656,9 @@ void R_DrawMD5Model_ShowTris (entity_t *e)
 {
 	md5header_t *hdr = (md5header_t *) e->model->cache.data;
 	lerpdata_t	lerpdata;
+	md5polyvert_t *vertexes;
+	float		(*normals)[3];
+	int			serial, lod;
 
 	R_SetupMD5Frame (e->frame, &lerpdata);
 	R_SetupEntityTransform (e, &lerpdata);
@@ -799,20 +1668,21 @@ void R_DrawMD5Model_ShowTris (entity_t *e)
 		if (R_CullMD5Model (lerpdata, &hdr->md5anim))
 			return;
 
+	lod = R_MD5LOD (e, hdr, &lerpdata);
+
     glPushMatrix ();
 	R_RotateForEntity (lerpdata.origin, lerpdata.angles);
 
 	// set up the MD5 interpolation and frame
-	R_InterpolateMD5Model (hdr, &lerpdata);
+	vertexes = R_SkinMD5Entity (e, hdr, &lerpdata, &normals, &serial);
 
 	// set up array and pointer
-	glEnableClientState (GL_VERTEX_ARRAY);
-	glVertexPointer (3, GL_FLOAT, sizeof (md5polyvert_t), r_md5vertexes->position);
+	R_SetupMD5Arrays (hdr, vertexes, serial, false, 0);
 
 	glColor3f (1, 1, 1);
-	GL_DrawMD5Frame (&hdr->md5mesh.meshes[0]);
+	GL_DrawMD5Frame (e, hdr, MD5_DRAW_UNTEXTURED, lod);
 
-	glDisableClientState (GL_VERTEX_ARRAY);
+	R_FinishMD5Arrays ();
 	glPopMatrix ();
 }
 
@@ -81,14 +81,17 @@ typedef struct entity_s
 	float					lerpstart;		//johnfitz -- animation lerping
 	float					lerptime;		//johnfitz -- animation lerping
 	float					lerpfinish;		//johnfitz -- lerping -- server sent us a more accurate interval, use it instead of 0.1
-	short					previouspose;	//johnfitz -- animation lerping
-	short					currentpose;	//johnfitz -- animation lerping
+	int						previouspose;	//johnfitz -- animation lerping (mh - was short)
+	int						currentpose;	//johnfitz -- animation lerping (mh - was short)
 //	short					futurepose;		//johnfitz -- animation lerping
 	float					movelerpstart;	//johnfitz -- transform lerping
 	vec3_t					previousorigin;	//johnfitz -- transform lerping
 	vec3_t					currentorigin;	//johnfitz -- transform lerping
 	vec3_t					previousangles;	//johnfitz -- transform lerping
 	vec3_t					currentangles;	//johnfitz -- transform lerping
+	struct md5skincache_s	*md5skincache;	// mh - skin cache slot it last drew from
+	int						md5skinserial;	// mh - and what was in it
+	int						md5skinstatframe;	// mh - r_framecount it was last counted in the skin cache stats
 } entity_t;
 
 // !!! if this is changed, it must be changed in asm_draw.h too !!!
@@ -347,6 +347,28 @@ sfx_t *S_PrecacheSound (char *name)
 	return sfx;
 }
 
+/*
+==================
+S_PrefetchTarget
+
+mh - the sfx that S_PrecacheSound will have to load name into, or NULL if it won't load anything
+==================
+*/
+sfx_t *S_PrefetchTarget (char *name)
+{
+	sfx_t	*sfx;
+
+	if (!sound_started || nosound.value || !precache.value)
+		return NULL;
+
+	sfx = S_FindName (name);
+
+	if (Cache_Check (&sfx->cache))
+		return NULL;
+
+	return sfx;
+}
+
 
 //=============================================================================
 
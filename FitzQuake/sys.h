@@ -37,6 +37,14 @@ int Sys_FileWrite (int handle, void *data, int count);
 int	Sys_FileTime (char *path);
 void Sys_mkdir (char *path);
 
+// mh - calls func for everything in the directory except . and ..; false if it can't be read
+typedef void (*sysdirfunc_t) (char *name, qboolean isdir, void *param);
+qboolean Sys_ListDirectory (char *path, sysdirfunc_t func, void *param);
+
+// mh - maps the whole file read-only and sets length; NULL if it can't be mapped, which includes empty files
+void *Sys_MapFile (char *path, int *length);
+void Sys_UnmapFile (void *data, int length);
+
 //
 // memory protection
 //
@@ -66,4 +74,52 @@ void Sys_Sleep (void);
 void Sys_SendKeyEvents (void);
 // Perform Key_Event () callbacks until the input que is empty
 
+//
+// threads
+//
+typedef void (*threadfunc_t) (void *param);
+
+int Sys_NumProcessors (void);
+qboolean Sys_CreateThread (threadfunc_t func, void *param);
+// threads run until the program exits
+
+void *Sys_CreateSemaphore (int maxcount);
+void Sys_SemaphoreWait (void *sem);
+void Sys_SemaphoreRelease (void *sem, int count);
+
+int Sys_AtomicIncrement (volatile int *value);
+int Sys_AtomicDecrement (volatile int *value);
+// full memory barriers; return the new value
+
+double Sys_ThreadTime (void);
+// seconds from an arbitrary start, for timing work on any thread; Sys_FloatTime is only safe on the main thread
+
+//
+// jobs (sys_jobs.c)
+//
+typedef void (*jobfunc_t) (void *data, int first, int count);
+// does pieces first to first + count - 1 of whatever data is
+
+typedef struct sysjob_s
+{
+	jobfunc_t		func;
+	void			*data;
+	int				count;
+	int				batch;
+	int				maxthreads;		// pool threads that can work on it at once, besides the one that finishes it
+
+	// set by Sys_StartJob
+	int				numbatches;
+	qboolean		queued;			// only touched with the queue locked
+	volatile int	next;			// the next batch to be taken
+	volatile int	numthreads;		// pool threads working on it
+} sysjob_t;
+
+int Sys_JobThreads (void);
+qboolean Sys_StartJob (sysjob_t *job);
+qboolean Sys_JobDone (sysjob_t *job);
+void Sys_FinishJob (sysjob_t *job);
+// every job that's started must be finished before it goes away; the order the batches are run in isn't defined, so
+// each must only write it's own results
+
 
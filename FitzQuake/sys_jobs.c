@@ -0,0 +1,311 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sys_jobs.c -- the job queue; it's built on the thread functions in sys_*.c so this file is common to every system
+// and to the GL and software renderers
+
+// everything that runs work on other threads shares one pool of threads through here.  a job is a function that's
+// called for pieces 0 to count - 1 in batches of up to batch pieces.  the pool threads take the batches of the oldest
+// job that has any left, and the thread that started the job takes whatever's left when it calls Sys_FinishJob and
+// then waits for the batches that are still running.  so a job can start and finish jobs of it's own: whoever waits
+// has always run everything that nobody else was running first.
+
+#include "quakedef.h"
+
+// jobs that can be waiting for a thread at once; a job leaves the queue once it's last batch is taken
+#define SYS_MAX_JOBS		512
+
+#define SYS_MAX_JOBTHREADS	16
+
+// the wake and done semaphores can be released more than they're waited on
+#define SYS_MAX_JOBSEMCOUNT	0x7fffffff
+
+// the number of threads in the pool, or -1 if it couldn't be started
+static int				sys_numjobthreads = 0;
+
+// a semaphore with a count of 1 taken around everything that reads or writes the queue
+static void				*sys_joblock;
+
+// released once for each thread that a new job can use
+static void				*sys_jobwake;
+
+// released whenever a job might have finished, once for each thread that's waiting for one
+static void				*sys_jobdone;
+static volatile int		sys_numjobwaiters;
+
+static sysjob_t			*sys_jobqueue[SYS_MAX_JOBS];
+static int				sys_numjobs;
+
+
+/*
+==================
+Sys_RunJobBatches
+
+==================
+*/
+static void Sys_RunJobBatches (sysjob_t *job)
+{
+	for (;;)
+	{
+		int first = (Sys_AtomicIncrement (&job->next) - 1) * job->batch;
+
+		if (first >= job->count) break;
+
+		job->func (job->data, first, (job->count - first < job->batch) ? job->count - first : job->batch);
+	}
+}
+
+
+/*
+==================
+Sys_RemoveJob
+
+the lock must be held
+==================
+*/
+static void Sys_RemoveJob (int index)
+{
+	sys_jobqueue[index]->queued = false;
+
+	for (sys_numjobs--; index < sys_numjobs; index++)
+		sys_jobqueue[index] = sys_jobqueue[index + 1];
+}
+
+
+/*
+==================
+Sys_TakeJob
+
+returns the oldest job that has batches left and room for another thread, with the calling thread counted on it
+==================
+*/
+static sysjob_t *Sys_TakeJob (void)
+{
+	sysjob_t *job = NULL;
+	int i = 0;
+
+	Sys_SemaphoreWait (sys_joblock);
+
+	while (i < sys_numjobs)
+	{
+		sysjob_t *next = sys_jobqueue[i];
+
+		// every batch has been taken, so nothing else needs to find it
+		if (next->next >= next->numbatches)
+		{
+			Sys_RemoveJob (i);
+			continue;
+		}
+
+		// it's finisher can't get past the lock until this is counted
+		if (next->numthreads < next->maxthreads)
+		{
+			Sys_AtomicIncrement (&next->numthreads);
+			job = next;
+			break;
+		}
+
+		i++;
+	}
+
+	Sys_SemaphoreRelease (sys_joblock, 1);
+
+	return job;
+}
+
+
+/*
+==================
+Sys_JobThread
+
+==================
+*/
+static void Sys_JobThread (void *param)
+{
+	for (;;)
+	{
+		sysjob_t *job;
+
+		Sys_SemaphoreWait (sys_jobwake);
+
+		while ((job = Sys_TakeJob ()) != NULL)
+		{
+			Sys_RunJobBatches (job);
+
+			// publishes everything the batches wrote; the job mustn't be touched after this as it can be finished
+			if (Sys_AtomicDecrement (&job->numthreads) == 0)
+			{
+				int numwaiters = sys_numjobwaiters;
+
+				if (numwaiters > 0)
+					Sys_SemaphoreRelease (sys_jobdone, numwaiters);
+			}
+		}
+	}
+}
+
+
+/*
+==================
+Sys_JobThreads
+
+returns the number of threads in the pool, starting them the first time it's called, which must be on the main thread
+==================
+*/
+int Sys_JobThreads (void)
+{
+	int numthreads;
+
+	if (sys_numjobthreads) return (sys_numjobthreads > 0) ? sys_numjobthreads : 0;
+
+	sys_numjobthreads = -1;
+
+	if ((sys_joblock = Sys_CreateSemaphore (1)) == NULL) return 0;
+	if ((sys_jobwake = Sys_CreateSemaphore (SYS_MAX_JOBSEMCOUNT)) == NULL) return 0;
+	if ((sys_jobdone = Sys_CreateSemaphore (SYS_MAX_JOBSEMCOUNT)) == NULL) return 0;
+
+	Sys_SemaphoreRelease (sys_joblock, 1);
+
+	// one for each core besides the main thread, but at least two as the prefetch reads spend most of their time
+	// waiting on the disk
+	if ((numthreads = Sys_NumProcessors () - 1) < 2) numthreads = 2;
+	if (numthreads > SYS_MAX_JOBTHREADS) numthreads = SYS_MAX_JOBTHREADS;
+
+	sys_numjobthreads = 0;
+
+	while (sys_numjobthreads < numthreads && Sys_CreateThread (Sys_JobThread, NULL))
+		sys_numjobthreads++;
+
+	// the queue is never used, so any threads that did start just wait
+	if (!sys_numjobthreads)
+	{
+		Con_DPrintf ("Couldn't start the job threads\n");
+		sys_numjobthreads = -1;
+		return 0;
+	}
+
+	return sys_numjobthreads;
+}
+
+
+/*
+==================
+Sys_StartJob
+
+sets up a job and lets up to maxthreads pool threads work on it.  returns false if it couldn't be queued, in which
+case Sys_FinishJob runs all of it on the calling thread.
+==================
+*/
+qboolean Sys_StartJob (sysjob_t *job)
+{
+	qboolean queued = false;
+	int numthreads;
+
+	if (job->batch < 1) job->batch = 1;
+
+	job->numbatches = (job->count > 0) ? (job->count + job->batch - 1) / job->batch : 0;
+	job->queued = false;
+	job->next = 0;
+	job->numthreads = 0;
+
+	if ((numthreads = job->maxthreads) > job->numbatches) numthreads = job->numbatches;
+	if (numthreads > Sys_JobThreads ()) numthreads = Sys_JobThreads ();
+
+	if (numthreads < 1) return false;
+
+	Sys_SemaphoreWait (sys_joblock);
+
+	// a thread can take the job and clear queued as soon as the lock is released
+	if (sys_numjobs < SYS_MAX_JOBS)
+	{
+		sys_jobqueue[sys_numjobs++] = job;
+		job->queued = queued = true;
+	}
+
+	Sys_SemaphoreRelease (sys_joblock, 1);
+
+	if (!queued) return false;
+
+	Sys_SemaphoreRelease (sys_jobwake, numthreads);
+
+	return true;
+}
+
+
+/*
+==================
+Sys_JobDone
+
+true once every batch of a job that's been started is done; Sys_FinishJob must still be called
+==================
+*/
+qboolean Sys_JobDone (sysjob_t *job)
+{
+	// once every batch is taken, none are running if there are no threads on it
+	if (job->next < job->numbatches) return false;
+
+	return !job->numthreads;
+}
+
+
+/*
+==================
+Sys_FinishJob
+
+runs whatever batches of a job that's been started haven't been taken, then waits for the rest.  it's done when this
+returns and it can be called again.
+==================
+*/
+void Sys_FinishJob (sysjob_t *job)
+{
+	Sys_RunJobBatches (job);
+
+	// once it's out of the queue no more threads can start on it, and it's taken the lock to get out
+	if (sys_numjobthreads > 0)
+	{
+		Sys_SemaphoreWait (sys_joblock);
+
+		if (job->queued)
+		{
+			int i;
+
+			for (i = 0; i < sys_numjobs; i++)
+			{
+				if (sys_jobqueue[i] == job)
+				{
+					Sys_RemoveJob (i);
+					break;
+				}
+			}
+		}
+
+		Sys_SemaphoreRelease (sys_joblock, 1);
+	}
+
+	if (!job->numthreads) return;
+
+	// the semaphore is released when any job's last thread leaves it, not just this one's
+	Sys_AtomicIncrement (&sys_numjobwaiters);
+
+	while (job->numthreads)
+		Sys_SemaphoreWait (sys_jobdone);
+
+	Sys_AtomicDecrement (&sys_numjobwaiters);
+}
@@ -245,6 +245,88 @@ void Sys_mkdir (char *path)
 	_mkdir (path);
 }
 
+/*
+================
+Sys_ListDirectory
+
+mh - for the file index
+================
+*/
+qboolean Sys_ListDirectory (char *path, sysdirfunc_t func, void *param)
+{
+	WIN32_FIND_DATA	fdat;
+	HANDLE			fhnd;
+	char			pattern[MAX_OSPATH * 2];
+	int				t;
+
+	sprintf (pattern, "%s/*", path);
+
+	t = VID_ForceUnlockedAndReturnState ();
+	fhnd = FindFirstFile (pattern, &fdat);
+	VID_ForceLockState (t);
+
+	if (fhnd == INVALID_HANDLE_VALUE)
+		return false;
+
+	do
+	{
+		if (!strcmp (fdat.cFileName, ".") || !strcmp (fdat.cFileName, ".."))
+			continue;
+
+		func (fdat.cFileName, (fdat.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? true : false, param);
+	} while (FindNextFile (fhnd, &fdat));
+
+	FindClose (fhnd);
+	return true;
+}
+
+/*
+================
+Sys_MapFile
+
+mh - for COM_MapFile
+================
+*/
+void *Sys_MapFile (char *path, int *length)
+{
+	HANDLE	hfile, hmap;
+	DWORD	size;
+	void	*data = NULL;
+	int		t;
+
+	t = VID_ForceUnlockedAndReturnState ();
+
+	hfile = CreateFile (path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (hfile != INVALID_HANDLE_VALUE)
+	{
+		size = GetFileSize (hfile, NULL);
+
+		// an empty file can't be mapped
+		if (size != 0xffffffff && size > 0 && size < 0x7fffffff)
+		{
+			if ((hmap = CreateFileMapping (hfile, NULL, PAGE_READONLY, 0, 0, NULL)) != NULL)
+			{
+				// the view keeps the file open after the handles are closed
+				if ((data = MapViewOfFile (hmap, FILE_MAP_READ, 0, 0, 0)) != NULL)
+					*length = (int) size;
+
+				CloseHandle (hmap);
+			}
+		}
+
+		CloseHandle (hfile);
+	}
+
+	VID_ForceLockState (t);
+	return data;
+}
+
+void Sys_UnmapFile (void *data, int length)
+{
+	UnmapViewOfFile (data);
+}
+
 /*
 ===============================================================================
 
@@ -625,6 +707,130 @@ void Sys_SendKeyEvents (void)
 }
 
 
+/*
+==============================================================================
+
+ THREADS
+
+==============================================================================
+*/
+
+typedef struct systhread_s
+{
+	threadfunc_t	func;
+	void			*param;
+} systhread_t;
+
+
+static DWORD WINAPI Sys_ThreadProc (LPVOID lpParameter)
+{
+	systhread_t thread = *(systhread_t *) lpParameter;
+
+	free (lpParameter);
+	thread.func (thread.param);
+
+	return 0;
+}
+
+
+/*
+================
+Sys_NumProcessors
+================
+*/
+int Sys_NumProcessors (void)
+{
+	SYSTEM_INFO	info;
+
+	GetSystemInfo (&info);
+
+	return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+}
+
+
+/*
+================
+Sys_CreateThread
+
+threads run until the program exits; there is no way to stop one
+================
+*/
+qboolean Sys_CreateThread (threadfunc_t func, void *param)
+{
+	systhread_t *thread = (systhread_t *) malloc (sizeof (systhread_t));
+	HANDLE		hThread;
+
+	if (!thread) return false;
+
+	thread->func = func;
+	thread->param = param;
+
+	if ((hThread = CreateThread (NULL, 0, Sys_ThreadProc, thread, 0, NULL)) == NULL)
+	{
+		free (thread);
+		return false;
+	}
+
+	// we never wait on the thread so the handle isn't needed
+	CloseHandle (hThread);
+
+	return true;
+}
+
+
+/*
+================
+Sys_CreateSemaphore
+================
+*/
+void *Sys_CreateSemaphore (int maxcount)
+{
+	return CreateSemaphore (NULL, 0, maxcount, NULL);
+}
+
+
+void Sys_SemaphoreWait (void *sem)
+{
+	WaitForSingleObject ((HANDLE) sem, INFINITE);
+}
+
+
+void Sys_SemaphoreRelease (void *sem, int count)
+{
+	ReleaseSemaphore ((HANDLE) sem, count, NULL);
+}
+
+
+/*
+================
+Sys_AtomicIncrement
+
+these are full memory barriers and return the new value
+================
+*/
+int Sys_AtomicIncrement (volatile int *value)
+{
+	return InterlockedIncrement ((volatile LONG *) value);
+}
+
+
+int Sys_AtomicDecrement (volatile int *value)
+{
+	return InterlockedDecrement ((volatile LONG *) value);
+}
+
+
+double Sys_ThreadTime (void)
+{
+	LARGE_INTEGER	count, freq;
+
+	QueryPerformanceFrequency (&freq);
+	QueryPerformanceCounter (&count);
+
+	return (double) count.QuadPart / (double) freq.QuadPart;
+}
+
+
 /*
 ==============================================================================
 
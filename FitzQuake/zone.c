@@ -578,6 +578,9 @@ cache_system_t *Cache_TryAlloc (int size, qboolean nobottom);
 
 cache_system_t	cache_head;
 
+// mh - everything Cache_Alloc has given out, for the load profiler
+int		cache_allocated;
+
 /*
 ===========
 Cache_Move
@@ -906,6 +909,7 @@ void *Cache_Alloc (cache_user_t *c, int size, char *name)
 			strncpy (cs->name, name, sizeof(cs->name)-1);
 			c->data = (void *)(cs+1);
 			cs->user = c;
+			cache_allocated += size;
 			break;
 		}
 
@@ -126,6 +126,9 @@ void CL_Disconnect (void)
 
 	cls.demoplayback = cls.timedemo = false;
 	cls.signon = 0;
+
+	// mh - a map load that was stopped by an error
+	CL_EndPrefetch ();
 }
 
 void CL_Disconnect_f (void)
@@ -198,6 +201,7 @@ Con_DPrintf ("CL_SignonReply: %i\n", cls.signon);
 		break;
 		
 	case 3:	
+		MD5_CommitLoads ();		// mh - switch in the MD5s that were built on the loader thread
 		MSG_WriteByte (&cls.message, clc_stringcmd);
 		MSG_WriteString (&cls.message, "begin");
 		Cache_Report ();		// print remaining memory
@@ -744,6 +748,8 @@ void CL_Init (void)
 	Cvar_RegisterVariable (&m_yaw);
 	Cvar_RegisterVariable (&m_forward);
 	Cvar_RegisterVariable (&m_side);
+	Cvar_RegisterVariable (&cl_prefetch); // mh
+	Cvar_RegisterVariable (&cl_prefetchspeeds); // mh
 
 //	Cvar_RegisterVariable (&cl_autofire);
 	
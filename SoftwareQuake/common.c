@@ -903,22 +903,23 @@ void COM_DefaultExtension (char *path, char *extension)
 
 /*
 ==============
-COM_Parse
+COM_ParseBuf
 
-Parse a token out of a string
+COM_Parse into a caller's buffer of size chars instead of com_token, so that it can be used off the main thread;
+tokens that don't fit are cut short
 ==============
 */
-char *COM_Parse (char *data)
+char *COM_ParseBuf (char *data, char *token, int size)
 {
 	int             c;
 	int             len;
-	
+
 	len = 0;
-	com_token[0] = 0;
-	
+	token[0] = 0;
+
 	if (!data)
 		return NULL;
-		
+
 // skip whitespace
 skipwhite:
 	while ( (c = *data) <= ' ')
@@ -927,7 +928,7 @@ skipwhite:
 			return NULL;                    // end of file;
 		data++;
 	}
-	
+
 // skip // comments
 	if (c=='/' && data[1] == '/')
 	{
@@ -935,7 +936,7 @@ skipwhite:
 			data++;
 		goto skipwhite;
 	}
-	
+
 
 // handle quoted strings specially
 	if (c == '\"')
@@ -946,99 +947,118 @@ skipwhite:
 			c = *data++;
 			if (c=='\"' || !c)
 			{
-				com_token[len] = 0;
+				token[len] = 0;
 				return data;
 			}
-			com_token[len] = c;
-			len++;
+			if (len < size - 1)
+				token[len++] = c;
 		}
 	}
 
 // parse single characters
 	if (c=='{' || c=='}'|| c==')'|| c=='(' || c=='\'' || c==':')
 	{
-		com_token[len] = c;
+		token[len] = c;
 		len++;
-		com_token[len] = 0;
+		token[len] = 0;
 		return data+1;
 	}
 
 // parse a regular word
 	do
 	{
-		com_token[len] = c;
+		if (len < size - 1)
+			token[len++] = c;
 		data++;
-		len++;
 		c = *data;
 	if (c=='{' || c=='}'|| c==')'|| c=='(' || c=='\'' || c==':')
 			break;
 	} while (c>32);
-	
-	com_token[len] = 0;
+
+	token[len] = 0;
 	return data;
 }
 
 
 /*
 ==============
-COM_ParseLine
+COM_Parse
 
-parse a full line out of a text stream
+Parse a token out of a string
 ==============
 */
-char *COM_ParseLine (char *data)
+char *COM_Parse (char *data)
+{
+	return COM_ParseBuf (data, com_token, sizeof (com_token));
+}
+
+
+/*
+==============
+COM_ParseLineBuf
+
+COM_ParseLine into a caller's buffer of size chars instead of com_token, so that it can be used off the main thread;
+lines that don't fit are cut short
+==============
+*/
+char *COM_ParseLineBuf (char *data, char *token, int size)
 {
 	int i = 0;
 
 	if (!data) return NULL;		// nothing to parse
-	if (!*data) return NULL;	// end of stream
 
-	com_token[0] = 0;
+	token[0] = 0;
 
 	while (1)
 	{
 		if (!*data) break;	// end of stream
 
 		// newline
-		if (*data == '\n')
-		{
-			// skip the line separator
-			data++;
-
-			// handle \n\r
-			if (*data && *data == '\r') data++;
-
-			break;
-		}
-
-		// newline
-		if (*data == '\r')
+		if (*data == '\n' || *data == '\r')
 		{
-			// skip the line separator
-			data++;
+			// skip the line separator, handling \n\r and \r\n
+			if (data[1] && data[1] != data[0] && (data[1] == '\n' || data[1] == '\r'))
+				data += 2;
+			else data++;
 
-			// handle \r\n
-			if (*data && *data == '\n') data++;
+			// skip empty lines
+			if (i == 0) continue;
 
 			break;
 		}
 
 		// copy it over
-		com_token[i++] = *data++;
+		if (i < size - 1)
+			token[i] = *data;
+
+		i++;
+		data++;
 	}
 
-	// skip empty lines
-	if (i == 0)
-		return COM_ParseLine (data);
+	// end of stream
+	if (i == 0) return NULL;
 
 	// NUll-terminate the token
-	com_token[i] = 0;
+	token[(i < size - 1) ? i : size - 1] = 0;
 
 	// and return the new data pointer
 	return data;
 }
 
 
+/*
+==============
+COM_ParseLine
+
+parse a full line out of a text stream
+==============
+*/
+char *COM_ParseLine (char *data)
+{
+	return COM_ParseLineBuf (data, com_token, sizeof (com_token));
+}
+
+
 /*
 ================
 COM_CheckParm
@@ -1107,6 +1127,8 @@ void COM_CheckRegistered (void)
 
 
 void COM_Path_f (void);
+void COM_TimeFindFile_f (void);
+void COM_MissedFiles_f (void);
 
 
 /*
@@ -1211,6 +1233,8 @@ void COM_Init (char *basedir)
 	Cvar_RegisterVariable (&registered);
 	Cvar_RegisterVariable (&cmdline);
 	Cmd_AddCommand ("path", COM_Path_f);
+	Cmd_AddCommand ("timefindfile", COM_TimeFindFile_f); // mh - file index
+	Cmd_AddCommand ("missedfiles", COM_MissedFiles_f); // mh - file index
 
 	COM_InitFilesystem ();
 	COM_CheckRegistered ();
@@ -1277,6 +1301,8 @@ typedef struct pack_s
 	int             handle;
 	int             numfiles;
 	packfile_t      *files;
+	byte            *mapped;        // mh - the whole pak mapped read-only, or NULL
+	int             mappedlen;
 } pack_t;
 
 //
@@ -1329,6 +1355,10 @@ void COM_Path_f (void)
 		else
 			Con_Printf ("%s\n", s->filename);
 	}
+
+	// mh - file index
+	Con_Printf ("%i files indexed, %i lookups and %i not found since the index was built\n", com_numindexed, com_filelookups, com_filemisses);
+	Con_Printf ("%i different files not found, %.2f ms searching for them\n", com_nummissednames, com_filemisstime * 1000.0);
 }
 
 /*
@@ -1355,6 +1385,8 @@ void COM_WriteFile (char *filename, void *data, int len)
 	Sys_Printf ("COM_WriteFile: %s\n", name);
 	Sys_FileWrite (handle, data, len);
 	Sys_FileClose (handle);
+
+	COM_AddFileToIndex (filename); // mh - file index
 }
 
 
@@ -1415,262 +1447,1162 @@ void COM_CopyFile (char *netpath, char *cachepath)
 }
 
 /*
-===========
-COM_FindFile
+==============================================================================
 
-Finds the file in the search path.
-Sets com_filesize and one of handle or file
-===========
-*/
-int COM_FindFile (char *filename, int *handle, FILE **file)
-{
-	searchpath_t    *search;
-	char            netpath[MAX_OSPATH];
-	char            cachepath[MAX_OSPATH];
-	pack_t          *pak;
-	int                     i;
-	int                     findtime, cachetime;
+FILE INDEX
 
-	if (file && handle)
-		Sys_Error ("COM_FindFile: both handle and file set");
-	if (!file && !handle)
-		Sys_Error ("COM_FindFile: neither handle or file set");
-		
-//
-// search through the path, one element at a time
-//
-	search = com_searchpaths;
-	if (proghack)
-	{	// gross hack to use quake 1 progs with quake 2 maps
-		if (!strcmp(filename, "progs.dat"))
-			search = search->next;
-	}
+mh - every file in the search path goes in a hash table so that COM_FindFile
+is one lookup instead of a strcmp against every entry in every pak and an
+fopen in every directory.  the directories are listed when the index is
+built, which is whenever the search path changes and on each map load, and
+files the engine writes in between are added as they're written.  names
+hash without case or slash differences but pak entries still have to match
+exactly, so what's found is the same as searching the path.
 
-	for ( ; search ; search = search->next)
-	{
-	// is the element a pak file?
-		if (search->pack)
-		{
-		// look through all the pak file elements
-			pak = search->pack;
-			for (i=0 ; i<pak->numfiles ; i++)
-				if (!strcmp (pak->files[i].name, filename))
-				{       // found it!
-					Sys_Printf ("PackFile: %s : %s\n",pak->filename, filename);
-					if (handle)
-					{
-						*handle = pak->handle;
-						Sys_FileSeek (pak->handle, pak->files[i].filepos);
-					}
-					else
-					{       // open a new file on the pakfile
-						*file = fopen (pak->filename, "rb");
-						if (*file)
-							fseek (*file, pak->files[i].filepos, SEEK_SET);
-					}
-					com_filesize = pak->files[i].filelen;
-					return com_filesize;
-				}
-		}
-		else
-		{               
-	// check a file in the directory tree
-			if (!static_registered)
-			{       // if not a registered version, don't ever go beyond base
-				if ( strchr (filename, '/') || strchr (filename,'\\'))
-					continue;
-			}
-			
-			sprintf (netpath, "%s/%s",search->filename, filename);
-			
-			findtime = Sys_FileTime (netpath);
-			if (findtime == -1)
-				continue;
-				
-		// see if the file needs to be updated in the cache
-			if (!com_cachedir[0])
-				strcpy (cachepath, netpath);
-			else
-			{	
-#if defined(_WIN32)
-				if ((strlen(netpath) < 2) || (netpath[1] != ':'))
-					sprintf (cachepath,"%s%s", com_cachedir, netpath);
-				else
-					sprintf (cachepath,"%s%s", com_cachedir, netpath+2);
-#else
-				sprintf (cachepath,"%s%s", com_cachedir, netpath);
-#endif
+==============================================================================
+*/
 
-				cachetime = Sys_FileTime (cachepath);
-			
-				if (cachetime < findtime)
-					COM_CopyFile (netpath, cachepath);
-				strcpy (netpath, cachepath);
-			}	
-
-			Sys_Printf ("FindFile: %s\n",netpath);
-			com_filesize = Sys_FileOpenRead (netpath, &i);
-			if (handle)
-				*handle = i;
-			else
-			{
-				Sys_FileClose (i);
-				*file = fopen (netpath, "rb");
-			}
-			return com_filesize;
-		}
-		
-	}
-	
-	Sys_Printf ("FindFile: can't find %s\n", filename);
-	
-	if (handle)
-		*handle = -1;
-	else
-		*file = NULL;
-	com_filesize = -1;
-	return -1;
-}
+#define FILEINDEX_HASHSIZE		8192	// must be a power of two
+#define FILEINDEX_BLOCKSIZE		65536
 
+// a directory with more files than this isn't listed, and is searched as before
+#define MAX_LISTED_FILES		32768
+#define MAX_LISTED_DEPTH		16
+#define MAX_UNLISTED_PATHS		16
 
-/*
-===========
-COM_OpenFile
+typedef struct fileindex_s
+{
+	char				*name;		// the pak entry's name, or the path under the directory
+	searchpath_t		*search;
+	int					order;		// where search is in the search path, 0 first
+	int					filenum;	// the pak entry, -1 for a file in the directory
+	struct fileindex_s	*next;		// the rest of the hash chain, in search path order
+} fileindex_t;
 
-filename never has a leading slash, but may contain directory walks
-returns a handle and a length
-it may actually be inside a pak file
-===========
-*/
-int COM_OpenFile (char *filename, int *handle)
+// a name that was looked for and not found
+typedef struct filemiss_s
 {
-	return COM_FindFile (filename, handle, NULL);
-}
+	char				*name;
+	int					count;		// times it was looked for
+	double				time;		// how long the first search took
+	struct filemiss_s	*next;
+} filemiss_t;
 
-/*
-===========
-COM_FOpenFile
+typedef struct fileindexblock_s
+{
+	struct fileindexblock_s	*next;
+	int						used;
+} fileindexblock_t;
 
-If the requested file is inside a packfile, a new FILE * will be opened
-into the file.
-===========
-*/
-int COM_FOpenFile (char *filename, FILE **file)
+typedef struct
 {
-	return COM_FindFile (filename, NULL, file);
-}
+	searchpath_t	*search;
+	int				order;
+	char			path[MAX_OSPATH];	// the directory being listed, under search->filename
+	int				depth;
+	int				count;
+} filelisting_t;
 
-/*
-============
-COM_CloseFile
+static fileindex_t		*com_fileindex[FILEINDEX_HASHSIZE];
+static fileindexblock_t	*com_fileindexblocks;
+static qboolean			com_indexbuilt;
 
-If it is a pak file handle, don't really close it
-============
-*/
-void COM_CloseFile (int h)
-{
-	searchpath_t    *s;
-	
-	for (s = com_searchpaths ; s ; s=s->next)
-		if (s->pack && s->pack->handle == h)
-			return;
-			
-	Sys_FileClose (h);
-}
+static searchpath_t		*com_unlisted[MAX_UNLISTED_PATHS];
+static int				com_unlistedorder[MAX_UNLISTED_PATHS];
+static int				com_numunlisted;
+
+// mh - names that weren't found aren't searched for again until the index is rebuilt
+static filemiss_t		*com_filemisstable[FILEINDEX_HASHSIZE];
 
+int		com_numindexed;
+int		com_nummissednames;
+
+// since the index was last built, which is the start of each map load
+int		com_filelookups;
+int		com_filemisses;
+double	com_filemisstime;
 
 /*
 ============
-COM_LoadFile
+COM_FileIndexAlloc
 
-Filename are reletive to the quake directory.
-Allways appends a 0 byte.
+everything in the index comes from here and is freed together when it's rebuilt
 ============
 */
-cache_user_t *loadcache;
-byte    *loadbuf;
-int             loadsize;
-byte *COM_LoadFile (char *path, int usehunk)
+static void *COM_FileIndexAlloc (int size)
 {
-	int             h;
-	byte    *buf;
-	char    base[32];
-	int             len;
+	fileindexblock_t	*block = com_fileindexblocks;
+	byte				*buf;
 
-	buf = NULL;     // quiet compiler warning
+	size = (size + 7) & ~7;
 
-// look for it in the filesystem or pack files
-	len = COM_OpenFile (path, &h);
-	if (h == -1)
-		return NULL;
-	
-// extract the filename base name for hunk tag
-	COM_FileBase (path, base);
-	
-	if (usehunk == 1)
-		buf = Hunk_AllocName (len+1, base);
-	else if (usehunk == 2)
-		buf = Hunk_TempAlloc (len+1);
-	else if (usehunk == 0)
-		buf = Z_Malloc (len+1);
-	else if (usehunk == 3)
-		buf = Cache_Alloc (loadcache, len+1, base);
-	else if (usehunk == 4)
+	if (!block || block->used + size > FILEINDEX_BLOCKSIZE)
 	{
-		if (len+1 > loadsize)
-			buf = Hunk_TempAlloc (len+1);
-		else
-			buf = loadbuf;
-	}
-	else if (usehunk == 5)
-		buf = malloc (len + 1);
-	else
-		Sys_Error ("COM_LoadFile: bad usehunk");
+		if ((block = (fileindexblock_t *) malloc (sizeof (fileindexblock_t) + FILEINDEX_BLOCKSIZE)) == NULL)
+			Sys_Error ("COM_FileIndexAlloc: failed on %i bytes", FILEINDEX_BLOCKSIZE);
 
-	if (!buf)
-		Sys_Error ("COM_LoadFile: not enough space for %s", path);
-		
-	((byte *)buf)[len] = 0;
+		block->used = 0;
+		block->next = com_fileindexblocks;
+		com_fileindexblocks = block;
+	}
 
-	Draw_BeginDisc ();
-	Sys_FileRead (h, buf, len);                     
-	COM_CloseFile (h);
-	Draw_EndDisc ();
+	buf = (byte *) (block + 1) + block->used;
+	block->used += size;
 
 	return buf;
 }
 
-byte *COM_LoadMallocFile (char *path)
-{
-	return COM_LoadFile (path, 5);
-}
+/*
+============
+COM_FoldFileChar
 
-byte *COM_LoadHunkFile (char *path)
+how the filesystem compares names; windows ignores case and takes either slash
+============
+*/
+static int COM_FoldFileChar (int c)
 {
-	return COM_LoadFile (path, 1);
+	if (c == '\\')
+		return '/';
+	if (c >= 'A' && c <= 'Z')
+		return c + ('a' - 'A');
+
+	return c;
 }
 
-byte *COM_LoadTempFile (char *path)
+static unsigned COM_HashFileName (char *name)
 {
-	return COM_LoadFile (path, 2);
+	unsigned	hash = 0;
+
+	while (*name)
+		hash = hash * 31 + COM_FoldFileChar (*name++);
+
+	return hash & (FILEINDEX_HASHSIZE - 1);
 }
 
-void COM_LoadCacheFile (char *path, struct cache_user_s *cu)
+static qboolean COM_SameLooseName (char *s1, char *s2)
 {
-	loadcache = cu;
-	COM_LoadFile (path, 3);
+#ifdef _WIN32
+	for (; COM_FoldFileChar (*s1) == COM_FoldFileChar (*s2); s1++, s2++)
+		if (!*s1)
+			return true;
+
+	return false;
+#else
+	return !strcmp (s1, s2);
+#endif
 }
 
-// uses temp hunk if larger than bufsize
-byte *COM_LoadStackFile (char *path, void *buffer, int bufsize)
+/*
+============
+COM_CanIndexName
+
+names that walk out of the directory or are absolute can't be in the index
+============
+*/
+static qboolean COM_CanIndexName (char *filename)
 {
-	byte    *buf;
-	
-	loadbuf = (byte *)buffer;
-	loadsize = bufsize;
-	buf = COM_LoadFile (path, 4);
-	
-	return buf;
+	if (filename[0] == '/' || filename[0] == '\\' || strchr (filename, ':'))
+		return false;
+	if (strstr (filename, "..") || strstr (filename, "./") || strstr (filename, ".\\") || strstr (filename, "//"))
+		return false;
+
+	return true;
+}
+
+/*
+============
+COM_IndexFile
+
+name has to stay around as long as the index; a file that's already in the index for search is left alone, which
+keeps the first of two pak entries with the same name, the same as searching the pak
+============
+*/
+static void COM_IndexFile (char *name, searchpath_t *search, int order, int filenum)
+{
+	fileindex_t	*entry, **link;
+
+	for (link = &com_fileindex[COM_HashFileName (name)] ; *link && (*link)->order <= order ; link = &(*link)->next)
+		if ((*link)->search == search && !strcmp ((*link)->name, name))
+			return;
+
+	entry = (fileindex_t *) COM_FileIndexAlloc (sizeof (fileindex_t));
+	entry->name = name;
+	entry->search = search;
+	entry->order = order;
+	entry->filenum = filenum;
+	entry->next = *link;
+	*link = entry;
+
+	com_numindexed++;
+}
+
+/*
+============
+COM_UnindexSearchPath
+
+============
+*/
+static void COM_UnindexSearchPath (searchpath_t *search)
+{
+	fileindex_t	**link;
+	int			i;
+
+	for (i = 0 ; i < FILEINDEX_HASHSIZE ; i++)
+	{
+		for (link = &com_fileindex[i] ; *link ; )
+		{
+			if ((*link)->search == search)
+			{
+				*link = (*link)->next;
+				com_numindexed--;
+			}
+			else link = &(*link)->next;
+		}
+	}
+}
+
+/*
+============
+COM_IndexListedFile
+
+called by Sys_ListDirectory for everything in the directory being listed
+============
+*/
+static void COM_IndexListedFile (char *name, qboolean isdir, void *param)
+{
+	filelisting_t	*listing = (filelisting_t *) param;
+	char			relative[MAX_OSPATH];
+	char			*copy;
+
+	if (listing->count > MAX_LISTED_FILES)
+		return;
+
+	if (strlen (listing->path) + strlen (name) + 2 > MAX_OSPATH)
+		return;
+
+	if (listing->path[0])
+		sprintf (relative, "%s/%s", listing->path, name);
+	else
+		strcpy (relative, name);
+
+	if (isdir)
+	{
+		char	full[MAX_OSPATH * 2];
+		char	parent[MAX_OSPATH];
+
+		// too deep to list is the same as too big
+		if (listing->depth >= MAX_LISTED_DEPTH)
+		{
+			listing->count = MAX_LISTED_FILES + 1;
+			return;
+		}
+
+		strcpy (parent, listing->path);
+		strcpy (listing->path, relative);
+		listing->depth++;
+
+		sprintf (full, "%s/%s", listing->search->filename, relative);
+		Sys_ListDirectory (full, COM_IndexListedFile, listing);
+
+		listing->depth--;
+		strcpy (listing->path, parent);
+		return;
+	}
+
+	copy = (char *) COM_FileIndexAlloc (strlen (relative) + 1);
+	strcpy (copy, relative);
+
+	COM_IndexFile (copy, listing->search, listing->order, -1);
+	listing->count++;
+}
+
+/*
+============
+COM_FreeFileIndex
+
+============
+*/
+static void COM_FreeFileIndex (void)
+{
+	fileindexblock_t	*block;
+
+	while ((block = com_fileindexblocks) != NULL)
+	{
+		com_fileindexblocks = block->next;
+		free (block);
+	}
+
+	memset (com_fileindex, 0, sizeof (com_fileindex));
+	memset (com_filemisstable, 0, sizeof (com_filemisstable));
+	com_numindexed = 0;
+	com_nummissednames = 0;
+	com_numunlisted = 0;
+	com_indexbuilt = false;
+}
+
+/*
+============
+COM_FindMiss
+
+names are matched exactly, as a name that only differs in case can be in a pak when the one that was looked for isn't
+============
+*/
+static filemiss_t *COM_FindMiss (char *filename)
+{
+	filemiss_t	*miss;
+
+	for (miss = com_filemisstable[COM_HashFileName (filename)] ; miss ; miss = miss->next)
+		if (!strcmp (miss->name, filename))
+			return miss;
+
+	return NULL;
+}
+
+/*
+============
+COM_AddMiss
+
+============
+*/
+static void COM_AddMiss (char *filename, double time)
+{
+	filemiss_t	*miss;
+	unsigned	hash = COM_HashFileName (filename);
+
+	miss = (filemiss_t *) COM_FileIndexAlloc (sizeof (filemiss_t) + strlen (filename) + 1);
+	miss->name = (char *) (miss + 1);
+	strcpy (miss->name, filename);
+	miss->count = 1;
+	miss->time = time;
+	miss->next = com_filemisstable[hash];
+	com_filemisstable[hash] = miss;
+
+	com_nummissednames++;
+}
+
+/*
+============
+COM_ForgetMiss
+
+============
+*/
+static void COM_ForgetMiss (char *filename)
+{
+	filemiss_t	**link;
+
+	for (link = &com_filemisstable[COM_HashFileName (filename)] ; *link ; link = &(*link)->next)
+	{
+		if (!strcmp ((*link)->name, filename))
+		{
+			*link = (*link)->next;
+			com_nummissednames--;
+			return;
+		}
+	}
+}
+
+/*
+============
+COM_BuildFileIndex
+
+has to be called whenever the search path changes; it also lists the directories again and starts the lookup counts
+============
+*/
+void COM_BuildFileIndex (void)
+{
+	searchpath_t	*search;
+	filelisting_t	listing;
+	double			time1 = Sys_FloatTime ();
+	int				i, order;
+
+	COM_FreeFileIndex ();
+
+	com_filelookups = 0;
+	com_filemisses = 0;
+	com_filemisstime = 0;
+
+	for (search = com_searchpaths, order = 0 ; search ; search = search->next, order++)
+	{
+		if (search->pack)
+		{
+			for (i = 0 ; i < search->pack->numfiles ; i++)
+				COM_IndexFile (search->pack->files[i].name, search, order, i);
+
+			continue;
+		}
+
+		memset (&listing, 0, sizeof (listing));
+		listing.search = search;
+		listing.order = order;
+
+		// a directory that isn't there has nothing in it
+		Sys_ListDirectory (search->filename, COM_IndexListedFile, &listing);
+
+		if (listing.count > MAX_LISTED_FILES)
+		{
+			if (com_numunlisted == MAX_UNLISTED_PATHS)
+			{
+				Con_DPrintf ("Too many large directories in the search path; not indexing files\n");
+				COM_FreeFileIndex ();
+				return;
+			}
+
+			Con_DPrintf ("%s has too many files to index\n", search->filename);
+			COM_UnindexSearchPath (search);
+
+			com_unlisted[com_numunlisted] = search;
+			com_unlistedorder[com_numunlisted] = order;
+			com_numunlisted++;
+		}
+	}
+
+	com_indexbuilt = true;
+
+	Con_DPrintf ("Indexed %i files in %.1f ms\n", com_numindexed, (Sys_FloatTime () - time1) * 1000.0);
+}
+
+/*
+============
+COM_AddFileToIndex
+
+for a file the engine has just written to the game directory, so that it can be found before the index is next built
+============
+*/
+void COM_AddFileToIndex (char *filename)
+{
+	searchpath_t	*search;
+	char			*copy;
+	int				i, order;
+
+	// it's there now even if it wasn't before
+	COM_ForgetMiss (filename);
+
+	if (!com_indexbuilt || !COM_CanIndexName (filename))
+		return;
+
+	for (search = com_searchpaths, order = 0 ; search ; search = search->next, order++)
+		if (!search->pack && !strcmp (search->filename, com_gamedir))
+			break;
+
+	// not in the search path at all, or it's searched without the index anyway
+	if (!search)
+		return;
+
+	for (i = 0 ; i < com_numunlisted ; i++)
+		if (com_unlisted[i] == search)
+			return;
+
+	copy = (char *) COM_FileIndexAlloc (strlen (filename) + 1);
+	strcpy (copy, filename);
+
+	COM_IndexFile (copy, search, order, -1);
+}
+
+static int COM_CompareMisses (const void *a, const void *b)
+{
+	filemiss_t	*m1 = *(filemiss_t **) a;
+	filemiss_t	*m2 = *(filemiss_t **) b;
+
+	if (m1->count != m2->count)
+		return m2->count - m1->count;
+
+	return strcmp (m1->name, m2->name);
+}
+
+/*
+============
+COM_MissedFiles_f
+
+lists the files that have been looked for and not found since the index was built, most looked for first
+============
+*/
+void COM_MissedFiles_f (void)
+{
+	filemiss_t	**list, *miss;
+	int			i, count, listed = 0;
+
+	count = (Cmd_Argc () > 1) ? Q_atoi (Cmd_Argv (1)) : 20;
+
+	if (!com_nummissednames)
+	{
+		Con_Printf ("No missing files since the index was built\n");
+		return;
+	}
+
+	if ((list = (filemiss_t **) malloc (com_nummissednames * sizeof (filemiss_t *))) == NULL)
+		return;
+
+	for (i = 0 ; i < FILEINDEX_HASHSIZE ; i++)
+		for (miss = com_filemisstable[i] ; miss ; miss = miss->next)
+			list[listed++] = miss;
+
+	qsort (list, listed, sizeof (filemiss_t *), COM_CompareMisses);
+
+	if (count < 1 || count > listed)
+		count = listed;
+
+	Con_Printf ("  times      ms  name\n");
+
+	for (i = 0 ; i < count ; i++)
+		Con_Printf ("%7i %7.3f  %s\n", list[i]->count, list[i]->time * 1000.0, list[i]->name);
+
+	Con_Printf ("%i different files not found %i times in %i lookups, %.2f ms searching for them\n",
+		listed, com_filemisses, com_filelookups, com_filemisstime * 1000.0);
+
+	free (list);
+}
+
+/*
+============
+COM_FindIndexed
+
+returns the search path the file is first in, with the pak entry in filenum, or NULL if it isn't anywhere
+============
+*/
+static searchpath_t *COM_FindIndexed (char *filename, int *filenum)
+{
+	fileindex_t		*entry;
+	searchpath_t	*skip = NULL;
+	qboolean		baseonly = false;
+	char			netpath[MAX_OSPATH];
+	int				i;
+
+	if (proghack && !strcmp (filename, "progs.dat"))
+		skip = com_searchpaths;	// gross hack to use quake 1 progs with quake 2 maps
+
+	if (!static_registered && (strchr (filename, '/') || strchr (filename, '\\')))
+		baseonly = true;		// if not a registered version, don't ever go beyond base
+
+	for (entry = com_fileindex[COM_HashFileName (filename)] ; entry ; entry = entry->next)
+	{
+		if (entry->search == skip)
+			continue;
+
+		if (entry->filenum >= 0)
+		{
+			if (!strcmp (entry->name, filename))
+				break;
+		}
+		else if (!baseonly && COM_SameLooseName (entry->name, filename))
+			break;
+	}
+
+	// directories too big to list still have to be looked in if they come first
+	for (i = 0 ; i < com_numunlisted ; i++)
+	{
+		if (entry && com_unlistedorder[i] > entry->order)
+			break;
+
+		if (com_unlisted[i] == skip || baseonly)
+			continue;
+
+		sprintf (netpath, "%s/%s", com_unlisted[i]->filename, filename);
+
+		if (Sys_FileTime (netpath) != -1)
+		{
+			*filenum = -1;
+			return com_unlisted[i];
+		}
+	}
+
+	if (!entry)
+		return NULL;
+
+	*filenum = entry->filenum;
+	return entry->search;
+}
+
+/*
+============
+COM_FindInPath
+
+searches the path one element at a time, for when there's no index
+============
+*/
+static searchpath_t *COM_FindInPath (char *filename, int *filenum)
+{
+	searchpath_t    *search;
+	char            netpath[MAX_OSPATH];
+	pack_t          *pak;
+	int                     i;
+
+	search = com_searchpaths;
+	if (proghack)
+	{	// gross hack to use quake 1 progs with quake 2 maps
+		if (!strcmp(filename, "progs.dat"))
+			search = search->next;
+	}
+
+	for ( ; search ; search = search->next)
+	{
+	// is the element a pak file?
+		if (search->pack)
+		{
+		// look through all the pak file elements
+			pak = search->pack;
+			for (i=0 ; i<pak->numfiles ; i++)
+				if (!strcmp (pak->files[i].name, filename))
+				{       // found it!
+					*filenum = i;
+					return search;
+				}
+		}
+		else
+		{
+	// check a file in the directory tree
+			if (!static_registered)
+			{       // if not a registered version, don't ever go beyond base
+				if ( strchr (filename, '/') || strchr (filename,'\\'))
+					continue;
+			}
+
+			sprintf (netpath, "%s/%s",search->filename, filename);
+
+			if (Sys_FileTime (netpath) == -1)
+				continue;
+
+			*filenum = -1;
+			return search;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+============
+COM_TimeFindFile_f
+
+compares lookups through the index with searching the path, for every indexed file and the same number of names
+that aren't anywhere
+============
+*/
+void COM_TimeFindFile_f (void)
+{
+	char			**names, *missnames;
+	fileindex_t		*entry;
+	double			time1, time2, time3, time4, time5;
+	int				i, j, filenum, numnames = 0, iterations = 4, mismatches = 0, found = 0;
+
+	if (!com_indexbuilt)
+	{
+		Con_Printf ("There's no file index\n");
+		return;
+	}
+
+	if (Cmd_Argc () > 1 && (iterations = Q_atoi (Cmd_Argv (1))) < 1)
+		iterations = 1;
+
+	names = (char **) malloc (com_numindexed * sizeof (char *));
+	missnames = (char *) malloc (com_numindexed * MAX_OSPATH);
+
+	if (!names || !missnames)
+	{
+		Con_Printf ("Not enough memory\n");
+		if (names) free (names);
+		if (missnames) free (missnames);
+		return;
+	}
+
+	// a miss looks like a skin frame that isn't there
+	for (i = 0 ; i < FILEINDEX_HASHSIZE ; i++)
+	{
+		for (entry = com_fileindex[i] ; entry ; entry = entry->next, numnames++)
+		{
+			names[numnames] = entry->name;
+			COM_StripExtension (entry->name, &missnames[numnames * MAX_OSPATH]);
+			strcat (&missnames[numnames * MAX_OSPATH], "_ff_ff.lmp");
+		}
+	}
+
+	time1 = Sys_FloatTime ();
+
+	for (i = 0 ; i < iterations ; i++)
+		for (j = 0 ; j < numnames ; j++)
+			if (COM_FindIndexed (names[j], &filenum)) found++;
+
+	time2 = Sys_FloatTime ();
+
+	for (i = 0 ; i < iterations ; i++)
+		for (j = 0 ; j < numnames ; j++)
+			if (COM_FindIndexed (&missnames[j * MAX_OSPATH], &filenum)) found++;
+
+	time3 = Sys_FloatTime ();
+
+	for (i = 0 ; i < iterations ; i++)
+		for (j = 0 ; j < numnames ; j++)
+			if (COM_FindInPath (names[j], &filenum)) found++;
+
+	time4 = Sys_FloatTime ();
+
+	for (i = 0 ; i < iterations ; i++)
+		for (j = 0 ; j < numnames ; j++)
+			if (COM_FindInPath (&missnames[j * MAX_OSPATH], &filenum)) found++;
+
+	time5 = Sys_FloatTime ();
+
+	// both ways have to find every file in the same place
+	for (j = 0 ; j < numnames ; j++)
+	{
+		int		indexednum = -1, pathnum = -1;
+
+		if (COM_FindIndexed (names[j], &indexednum) != COM_FindInPath (names[j], &pathnum) || indexednum != pathnum)
+			mismatches++;
+		if (COM_FindIndexed (&missnames[j * MAX_OSPATH], &indexednum) != COM_FindInPath (&missnames[j * MAX_OSPATH], &pathnum))
+			mismatches++;
+	}
+
+	Con_Printf ("%i files indexed, %i lookups of each, %i found\n", numnames, iterations * 2, found);
+	Con_Printf ("          hits/sec  misses/sec\n");
+	Con_Printf ("index  %11.0f %11.0f\n", numnames * iterations / (time2 - time1 + 0.000001), numnames * iterations / (time3 - time2 + 0.000001));
+	Con_Printf ("path   %11.0f %11.0f\n", numnames * iterations / (time4 - time3 + 0.000001), numnames * iterations / (time5 - time4 + 0.000001));
+
+	if (mismatches)
+		Con_Printf ("%i lookups found a different file\n", mismatches);
+
+	free (names);
+	free (missnames);
+}
+
+/*
+============
+COM_OpenFoundFile
+
+opens what COM_FindIndexed or COM_FindInPath found.  sets com_filesize and one of handle or file
+============
+*/
+static int COM_OpenFoundFile (char *filename, searchpath_t *search, int filenum, int *handle, FILE **file)
+{
+	char            netpath[MAX_OSPATH];
+	char            cachepath[MAX_OSPATH];
+	pack_t          *pak;
+	int                     i;
+	int                     findtime, cachetime;
+
+	if (search->pack)
+	{
+		pak = search->pack;
+		Sys_Printf ("PackFile: %s : %s\n",pak->filename, filename);
+		if (handle)
+		{
+			*handle = pak->handle;
+			Sys_FileSeek (pak->handle, pak->files[filenum].filepos);
+		}
+		else
+		{       // open a new file on the pakfile
+			*file = fopen (pak->filename, "rb");
+			if (*file)
+				fseek (*file, pak->files[filenum].filepos, SEEK_SET);
+		}
+		com_filesize = pak->files[filenum].filelen;
+		return com_filesize;
+	}
+
+	sprintf (netpath, "%s/%s",search->filename, filename);
+
+// see if the file needs to be updated in the cache
+	if (!com_cachedir[0])
+		strcpy (cachepath, netpath);
+	else
+	{
+#if defined(_WIN32)
+		if ((strlen(netpath) < 2) || (netpath[1] != ':'))
+			sprintf (cachepath,"%s%s", com_cachedir, netpath);
+		else
+			sprintf (cachepath,"%s%s", com_cachedir, netpath+2);
+#else
+		sprintf (cachepath,"%s%s", com_cachedir, netpath);
+#endif
+
+		findtime = Sys_FileTime (netpath);
+		cachetime = Sys_FileTime (cachepath);
+
+		if (cachetime < findtime)
+			COM_CopyFile (netpath, cachepath);
+		strcpy (netpath, cachepath);
+	}
+
+	Sys_Printf ("FindFile: %s\n",netpath);
+	com_filesize = Sys_FileOpenRead (netpath, &i);
+	if (handle)
+		*handle = i;
+	else
+	{
+		Sys_FileClose (i);
+		*file = fopen (netpath, "rb");
+	}
+	return com_filesize;
+}
+
+/*
+===========
+COM_LocateFile
+
+returns the search path the file is in, with the pak entry in filenum, or NULL if it isn't anywhere
+===========
+*/
+static searchpath_t *COM_LocateFile (char *filename, int *filenum)
+{
+	searchpath_t    *search;
+	filemiss_t		*miss;
+	double			time1;
+	int				load;
+
+	com_filelookups++;
+
+	// mh - it wasn't there last time
+	if ((miss = COM_FindMiss (filename)) != NULL)
+	{
+		miss->count++;
+		com_filemisses++;
+		return NULL;
+	}
+
+	load = Prof_Begin (PROF_FINDFILE, filename);
+	time1 = Sys_FloatTime ();
+
+	if (com_indexbuilt && COM_CanIndexName (filename))
+		search = COM_FindIndexed (filename, filenum);
+	else
+		search = COM_FindInPath (filename, filenum);
+
+	if (!search)
+	{
+		time1 = Sys_FloatTime () - time1;
+
+		com_filemisses++;
+		com_filemisstime += time1;
+		COM_AddMiss (filename, time1);
+
+		Sys_Printf ("FindFile: can't find %s\n", filename);
+	}
+
+	Prof_End (load);
+
+	return search;
+}
+
+/*
+===========
+COM_FindFile
+
+Finds the file in the search path.
+Sets com_filesize and one of handle or file
+===========
+*/
+int COM_FindFile (char *filename, int *handle, FILE **file)
+{
+	searchpath_t    *search;
+	int                     filenum;
+
+	if (file && handle)
+		Sys_Error ("COM_FindFile: both handle and file set");
+	if (!file && !handle)
+		Sys_Error ("COM_FindFile: neither handle or file set");
+
+	if ((search = COM_LocateFile (filename, &filenum)) != NULL)
+		return COM_OpenFoundFile (filename, search, filenum, handle, file);
+
+	if (handle)
+		*handle = -1;
+	else
+		*file = NULL;
+	com_filesize = -1;
+	return -1;
+}
+
+
+/*
+===========
+COM_OpenFile
+
+filename never has a leading slash, but may contain directory walks
+returns a handle and a length
+it may actually be inside a pak file
+===========
+*/
+int COM_OpenFile (char *filename, int *handle)
+{
+	return COM_FindFile (filename, handle, NULL);
+}
+
+/*
+===========
+COM_FOpenFile
+
+If the requested file is inside a packfile, a new FILE * will be opened
+into the file.
+===========
+*/
+int COM_FOpenFile (char *filename, FILE **file)
+{
+	return COM_FindFile (filename, NULL, file);
+}
+
+/*
+============
+COM_CloseFile
+
+If it is a pak file handle, don't really close it
+============
+*/
+void COM_CloseFile (int h)
+{
+	searchpath_t    *s;
+	
+	for (s = com_searchpaths ; s ; s=s->next)
+		if (s->pack && s->pack->handle == h)
+			return;
+			
+	Sys_FileClose (h);
+}
+
+
+/*
+============
+COM_LoadFile
+
+Filename are reletive to the quake directory.
+Allways appends a 0 byte.
+============
+*/
+cache_user_t *loadcache;
+byte    *loadbuf;
+int             loadsize;
+byte *COM_LoadFile (char *path, int usehunk)
+{
+	int             h;
+	byte    *buf;
+	char    base[32];
+	int             len;
+	int				load;
+
+	buf = NULL;     // quiet compiler warning
+
+	load = Prof_Begin (PROF_LOADFILE, path);
+
+// look for it in the filesystem or pack files
+	len = COM_OpenFile (path, &h);
+	if (h == -1)
+	{
+		Prof_End (load);
+		return NULL;
+	}
+	
+// extract the filename base name for hunk tag
+	COM_FileBase (path, base);
+	
+	if (usehunk == 1)
+		buf = Hunk_AllocName (len+1, base);
+	else if (usehunk == 2)
+		buf = Hunk_TempAlloc (len+1);
+	else if (usehunk == 0)
+		buf = Z_Malloc (len+1);
+	else if (usehunk == 3)
+		buf = Cache_Alloc (loadcache, len+1, base);
+	else if (usehunk == 4)
+	{
+		if (len+1 > loadsize)
+			buf = Hunk_TempAlloc (len+1);
+		else
+			buf = loadbuf;
+	}
+	else if (usehunk == 5)
+		buf = malloc (len + 1);
+	else
+		Sys_Error ("COM_LoadFile: bad usehunk");
+
+	if (!buf)
+		Sys_Error ("COM_LoadFile: not enough space for %s", path);
+		
+	((byte *)buf)[len] = 0;
+
+	Draw_BeginDisc ();
+	Sys_FileRead (h, buf, len);                     
+	COM_CloseFile (h);
+	Draw_EndDisc ();
+
+	Prof_Read (len);
+	Prof_End (load);
+
+	return buf;
+}
+
+byte *COM_LoadMallocFile (char *path)
+{
+	return COM_LoadFile (path, 5);
+}
+
+byte *COM_LoadHunkFile (char *path)
+{
+	return COM_LoadFile (path, 1);
+}
+
+byte *COM_LoadTempFile (char *path)
+{
+	return COM_LoadFile (path, 2);
+}
+
+void COM_LoadCacheFile (char *path, struct cache_user_s *cu)
+{
+	loadcache = cu;
+	COM_LoadFile (path, 3);
+}
+
+// uses temp hunk if larger than bufsize
+byte *COM_LoadStackFile (char *path, void *buffer, int bufsize)
+{
+	byte    *buf;
+	
+	loadbuf = (byte *)buffer;
+	loadsize = bufsize;
+	buf = COM_LoadFile (path, 4);
+	
+	return buf;
+}
+
+// mh - files from COM_MapFile that have to be unmapped or freed
+typedef struct
+{
+	byte	*data;
+	int		len;
+	qboolean	mapped;		// false if it was read
+} mappedfile_t;
+
+#define MAX_MAPPED_FILES	32
+
+static mappedfile_t	com_mappedfiles[MAX_MAPPED_FILES];
+
+/*
+============
+COM_MapOrReadFile
+
+does the work for COM_MapFile
+============
+*/
+static const byte *COM_MapOrReadFile (char *filename, int *len)
+{
+	searchpath_t    *search;
+	mappedfile_t    *map = NULL;
+	pack_t          *pak;
+	char            netpath[MAX_OSPATH];
+	int                     i, h, filenum;
+
+	*len = -1;
+
+	if ((search = COM_LocateFile (filename, &filenum)) == NULL)
+	{
+		com_filesize = -1;
+		return NULL;
+	}
+
+	if ((pak = search->pack) != NULL && pak->mapped)
+	{
+		if (pak->files[filenum].filepos >= 0 && pak->files[filenum].filelen >= 0 &&
+			pak->files[filenum].filepos + pak->files[filenum].filelen <= pak->mappedlen)
+		{
+			Sys_Printf ("PackFile: %s : %s\n", pak->filename, filename);
+			*len = com_filesize = pak->files[filenum].filelen;
+			return pak->mapped + pak->files[filenum].filepos;
+		}
+	}
+
+	for (i = 0 ; i < MAX_MAPPED_FILES ; i++)
+	{
+		if (!com_mappedfiles[i].data)
+		{
+			map = &com_mappedfiles[i];
+			break;
+		}
+	}
+
+	if (!map)
+		Sys_Error ("COM_MapFile: too many files mapped at once");
+
+	// the cache directory has to go through COM_FindFile to be updated
+	if (!pak && !com_cachedir[0])
+	{
+		sprintf (netpath, "%s/%s", search->filename, filename);
+
+		if ((map->data = (byte *) Sys_MapFile (netpath, &map->len)) != NULL)
+		{
+			Sys_Printf ("FindFile: %s\n", netpath);
+			map->mapped = true;
+			*len = com_filesize = map->len;
+			return map->data;
+		}
+	}
+
+	// read it the same as COM_LoadFile
+	map->len = COM_OpenFoundFile (filename, search, filenum, &h, NULL);
+
+	if (h == -1)
+		return NULL;
+
+	if ((map->data = (byte *) malloc (map->len + 1)) == NULL)
+		Sys_Error ("COM_MapFile: not enough space for %s", filename);
+
+	map->data[map->len] = 0;
+	map->mapped = false;
+
+	Sys_FileRead (h, map->data, map->len);
+	COM_CloseFile (h);
+
+	*len = com_filesize = map->len;
+	return map->data;
+}
+
+/*
+============
+COM_MapFile
+
+mh - a read-only view of the whole file with nothing copied, for loaders that only read what they're given.  a file in
+a pak points straight into the pak's mapping and a loose file is mapped on its own.  the data isn't 0 terminated.
+returns NULL if the file isn't found, and anything else has to go back to COM_UnmapFile.  a file that can't be mapped
+is read into memory instead, so this always works.
+============
+*/
+const byte *COM_MapFile (char *filename, int *len)
+{
+	const byte	*data;
+	int			load = Prof_Begin (PROF_LOADFILE, filename);
+
+	data = COM_MapOrReadFile (filename, len);
+
+	Prof_Read (*len);
+	Prof_End (load);
+
+	return data;
+}
+
+/*
+============
+COM_UnmapFile
+
+============
+*/
+void COM_UnmapFile (const byte *data)
+{
+	int		i;
+
+	if (!data)
+		return;
+
+	for (i = 0 ; i < MAX_MAPPED_FILES ; i++)
+	{
+		if (com_mappedfiles[i].data == data)
+		{
+			if (com_mappedfiles[i].mapped)
+				Sys_UnmapFile (com_mappedfiles[i].data, com_mappedfiles[i].len);
+			else
+				free (com_mappedfiles[i].data);
+
+			com_mappedfiles[i].data = NULL;
+			return;
+		}
+	}
+
+	// otherwise it's in a pak's mapping, which stays until the pak is closed
 }
 
 /*
@@ -1739,6 +2671,10 @@ pack_t *COM_LoadPackFile (char *packfile)
 	pack->handle = packhandle;
 	pack->numfiles = numpackfiles;
 	pack->files = newfiles;
+
+	// mh - so that COM_MapFile can point straight into it
+	if (!COM_CheckParm ("-nopakmap"))
+		pack->mapped = (byte *) Sys_MapFile (packfile, &pack->mappedlen);
 	
 	Con_Printf ("Added packfile %s (%i files)\n", packfile, numpackfiles);
 	return pack;
@@ -1889,6 +2825,8 @@ void COM_InitFilesystem (void)
 
 	if (COM_CheckParm ("-proghack"))
 		proghack = true;
+
+	COM_BuildFileIndex (); // mh - file index
 }
 
 
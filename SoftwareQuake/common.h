@@ -143,6 +143,8 @@ extern	qboolean	com_eof;
 
 char *COM_Parse (char *data);
 char *COM_ParseLine (char *data);
+char *COM_ParseBuf (char *data, char *token, int size);
+char *COM_ParseLineBuf (char *data, char *token, int size);
 
 extern	int		com_argc;
 extern	char	**com_argv;
@@ -168,6 +170,7 @@ struct cache_user_s;
 extern	char	com_gamedir[MAX_OSPATH];
 
 void COM_WriteFile (char *filename, void *data, int len);
+void COM_CreatePath (char *path);
 int COM_OpenFile (char *filename, int *hndl);
 int COM_FOpenFile (char *filename, FILE **file);
 void COM_CloseFile (int h);
@@ -178,6 +181,20 @@ byte *COM_LoadHunkFile (char *path);
 void COM_LoadCacheFile (char *path, struct cache_user_s *cu);
 byte *COM_LoadMallocFile (char *path);
 
+// mh - file index
+extern int com_numindexed;
+extern int com_nummissednames;
+extern int com_filelookups;
+extern int com_filemisses;
+extern double com_filemisstime;
+
+void COM_BuildFileIndex (void);
+void COM_AddFileToIndex (char *filename);
+
+// mh - read-only files with no copy
+const byte *COM_MapFile (char *filename, int *len);
+void COM_UnmapFile (const byte *data);
+
 
 extern	struct cvar_s	registered;
 
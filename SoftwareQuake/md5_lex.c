@@ -0,0 +1,508 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// md5_lex.c -- tokenizer for the MD5 text formats; this file is common to the GL and software renderers
+
+// the .md5mesh and .md5anim files are read a token at a time, with the loader switching on the keyword that starts
+// each statement and then asking for exactly the numbers, strings and brackets that it expects to follow.  tokens
+// point into the file and are never copied, nothing is allocated, and all of the state is in the lexer so any number
+// of them can run at once on different threads.  numbers are converted here rather than with the C library, which
+// is both faster and doesn't depend on the locale.
+//
+// the first thing that isn't what was expected stops the lexer with an error that gives the file and line; it's kept
+// in the lexer for the caller to print, as the lexer can be running somewhere that can't.
+
+#include "quakedef.h"
+#include <limits.h>
+
+// exact powers of ten; a double holds all of these without rounding
+static const double md5_powersoften[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MD5_MAX_EXACTDIGITS	15
+#define MD5_MAX_EXACTPLACES	22
+
+// digits kept from a longer number; more than this can't change a float
+#define MD5_MAX_DIGITS		19
+
+// far past where anything is 0 or infinite, even with 19 digits in front
+#define MD5_MAX_EXPONENT	400
+
+// the most of a bad token that's quoted in an error; a token can be as long as the file
+#define MD5_MAX_ECHO		32
+
+#ifdef _MSC_VER
+#define vsnprintf _vsnprintf
+#endif
+
+
+/*
+==================
+MD5_LexInit
+
+line is the line that data starts on
+==================
+*/
+void MD5_LexInit (md5lexer_t *lex, char *filename, char *data, int line)
+{
+	memset (lex, 0, sizeof (md5lexer_t));
+
+	lex->filename = filename;
+	lex->data = data;
+	lex->line = line;
+}
+
+
+/*
+==================
+MD5_EchoLen
+
+how much of the current token to quote in an error
+==================
+*/
+static int MD5_EchoLen (md5lexer_t *lex)
+{
+	return (lex->tokenlen < MD5_MAX_ECHO) ? lex->tokenlen : MD5_MAX_ECHO;
+}
+
+
+/*
+==================
+MD5_LexError
+
+only the first error is kept
+==================
+*/
+void MD5_LexError (md5lexer_t *lex, char *fmt, ...)
+{
+	va_list argptr;
+	char msg[256];
+
+	if (lex->error) return;
+
+	va_start (argptr, fmt);
+	vsnprintf (msg, sizeof (msg), fmt, argptr);
+	va_end (argptr);
+
+	// _vsnprintf doesn't terminate a string that's cut off
+	msg[sizeof (msg) - 1] = 0;
+
+	lex->error = true;
+	sprintf (lex->errormsg, "%s:%i: ", lex->filename, lex->tokenline ? lex->tokenline : lex->line);
+	strncat (lex->errormsg, msg, sizeof (lex->errormsg) - strlen (lex->errormsg) - 1);
+}
+
+
+/*
+==================
+MD5_LexNext
+
+moves on to the next token, skipping whitespace and // comments; returns false at the end of the file or after an
+error.  a token is a quoted string (without the quotes), one of { } ( ) or anything else up to whitespace or one of
+those.
+==================
+*/
+qboolean MD5_LexNext (md5lexer_t *lex)
+{
+	char *data = lex->data;
+
+	if (lex->error) return false;
+
+	for (;;)
+	{
+		// skip whitespace
+		while (*data && *data <= ' ')
+		{
+			if (*data == '\n') lex->line++;
+			data++;
+		}
+
+		// skip // comments
+		if (data[0] == '/' && data[1] == '/')
+		{
+			while (*data && *data != '\n')
+				data++;
+
+			continue;
+		}
+
+		break;
+	}
+
+	lex->data = data;
+	lex->tokenline = lex->line;
+	lex->quoted = false;
+
+	if (!*data)
+	{
+		lex->token = data;
+		lex->tokenlen = 0;
+		return false;
+	}
+
+	if (*data == '\"')
+	{
+		lex->token = ++data;
+
+		while (*data && *data != '\"' && *data != '\n')
+			data++;
+
+		if (*data != '\"')
+		{
+			MD5_LexError (lex, "unterminated string");
+			return false;
+		}
+
+		lex->tokenlen = data - lex->token;
+		lex->quoted = true;
+		lex->data = data + 1;
+
+		return true;
+	}
+
+	lex->token = data;
+
+	if (*data == '{' || *data == '}' || *data == '(' || *data == ')')
+		data++;
+	else
+	{
+		while (*data > ' ' && *data != '{' && *data != '}' && *data != '(' && *data != ')' && *data != '\"')
+			data++;
+	}
+
+	lex->tokenlen = data - lex->token;
+	lex->data = data;
+
+	return true;
+}
+
+
+/*
+==================
+MD5_LexIs
+
+true if the current token is word; quoted strings are never keywords
+==================
+*/
+qboolean MD5_LexIs (md5lexer_t *lex, char *word)
+{
+	int len = strlen (word);
+
+	if (lex->quoted) return false;
+
+	return lex->tokenlen == len && !memcmp (lex->token, word, len);
+}
+
+
+/*
+==================
+MD5_LexSkipLine
+
+skips whatever is left of the line the current token is on, for statements the loader doesn't use
+==================
+*/
+void MD5_LexSkipLine (md5lexer_t *lex)
+{
+	char *data = lex->data;
+
+	while (*data && *data != '\n')
+		data++;
+
+	lex->data = data;
+}
+
+
+/*
+==================
+MD5_LexSkipBlock
+
+skips up to and including the } that closes a block that has just been opened, without looking at what's in it;
+the block can't contain any other braces.
+==================
+*/
+qboolean MD5_LexSkipBlock (md5lexer_t *lex)
+{
+	char *data = lex->data;
+
+	if (lex->error) return false;
+
+	while (*data && *data != '}')
+	{
+		if (*data == '\n') lex->line++;
+		data++;
+	}
+
+	lex->data = data;
+
+	if (!*data)
+	{
+		MD5_LexError (lex, "unexpected end of file looking for }");
+		return false;
+	}
+
+	lex->data++;
+
+	return true;
+}
+
+
+/*
+==================
+MD5_LexExpect
+
+the next token must be word
+==================
+*/
+qboolean MD5_LexExpect (md5lexer_t *lex, char *word)
+{
+	if (!MD5_LexNext (lex))
+	{
+		MD5_LexError (lex, "unexpected end of file looking for %s", word);
+		return false;
+	}
+
+	if (!MD5_LexIs (lex, word))
+	{
+		MD5_LexError (lex, "expected %s, found \"%.*s\"", word, MD5_EchoLen (lex), lex->token);
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+==================
+MD5_LexInt
+
+==================
+*/
+qboolean MD5_LexInt (md5lexer_t *lex, int *value)
+{
+	char *s, *end;
+	int sign = 1, v = 0;
+
+	if (!MD5_LexNext (lex))
+	{
+		MD5_LexError (lex, "unexpected end of file looking for a number");
+		return false;
+	}
+
+	s = lex->token;
+	end = s + lex->tokenlen;
+
+	if (s < end && (*s == '-' || *s == '+'))
+	{
+		if (*s == '-') sign = -1;
+		s++;
+	}
+
+	if (s == end || lex->quoted)
+	{
+		MD5_LexError (lex, "expected an integer, found \"%.*s\"", MD5_EchoLen (lex), lex->token);
+		return false;
+	}
+
+	for (; s < end; s++)
+	{
+		if (*s < '0' || *s > '9')
+		{
+			MD5_LexError (lex, "expected an integer, found \"%.*s\"", MD5_EchoLen (lex), lex->token);
+			return false;
+		}
+
+		if (v > (INT_MAX - (*s - '0')) / 10)
+		{
+			MD5_LexError (lex, "\"%.*s\" is too big", MD5_EchoLen (lex), lex->token);
+			return false;
+		}
+
+		v = v * 10 + (*s - '0');
+	}
+
+	*value = v * sign;
+
+	return true;
+}
+
+
+/*
+==================
+MD5_LexFloat
+
+[-+]digits[.digits][e[-+]digits], with at least one digit in front of the exponent.
+
+up to 15 significant digits scaled by up to 22 powers of ten, which is everything the exporters write, are converted
+exactly: the digits are collected in a double, where they fit without rounding, and then multiplied or divided by an
+exact power of ten, so the only rounding is in that one step.  that gives the same double as atof, and so the same
+float.  anything else keeps its first 19 digits and is scaled a step at a time, which is within a few units of the
+last place of a double, far below what a float can hold.  none of this depends on the locale.
+==================
+*/
+qboolean MD5_LexFloat (md5lexer_t *lex, float *value)
+{
+	char *s, *end;
+	double v = 0;
+	int digits = 0, sigdigits = 0, scale = 0, exponent = 0;
+	qboolean negative = false, point = false;
+
+	if (!MD5_LexNext (lex))
+	{
+		MD5_LexError (lex, "unexpected end of file looking for a number");
+		return false;
+	}
+
+	s = lex->token;
+	end = s + lex->tokenlen;
+
+	if (s < end && (*s == '-' || *s == '+'))
+	{
+		if (*s == '-') negative = true;
+		s++;
+	}
+
+	for (; s < end; s++)
+	{
+		if (*s >= '0' && *s <= '9')
+		{
+			digits++;
+
+			// leading zeros aren't significant
+			if (v > 0 || *s != '0') sigdigits++;
+
+			if (sigdigits <= MD5_MAX_DIGITS)
+			{
+				v = v * 10 + (*s - '0');
+				if (point) scale--;
+			}
+			else if (!point) scale++;
+		}
+		else if (*s == '.' && !point)
+			point = true;
+		else break;
+	}
+
+	if (digits && s < end && (*s == 'e' || *s == 'E'))
+	{
+		int expsign = 1, expdigits = 0;
+
+		if (++s < end && (*s == '-' || *s == '+'))
+		{
+			if (*s == '-') expsign = -1;
+			s++;
+		}
+
+		for (; s < end && *s >= '0' && *s <= '9'; s++, expdigits++)
+		{
+			// anything bigger is 0 or infinite
+			if (exponent < MD5_MAX_EXPONENT)
+				exponent = exponent * 10 + (*s - '0');
+		}
+
+		if (!expdigits) digits = 0;
+
+		scale += exponent * expsign;
+	}
+
+	if (!digits || s != end || lex->quoted)
+	{
+		MD5_LexError (lex, "expected a number, found \"%.*s\"", MD5_EchoLen (lex), lex->token);
+		return false;
+	}
+
+	if (v == 0)
+		;
+	else if (sigdigits <= MD5_MAX_EXACTDIGITS && scale >= -MD5_MAX_EXACTPLACES && scale <= MD5_MAX_EXACTPLACES)
+	{
+		if (scale < 0)
+			v /= md5_powersoften[-scale];
+		else v *= md5_powersoften[scale];
+	}
+	else
+	{
+		if (scale < -MD5_MAX_EXPONENT) scale = -MD5_MAX_EXPONENT;
+		if (scale > MD5_MAX_EXPONENT) scale = MD5_MAX_EXPONENT;
+
+		for (; scale < -MD5_MAX_EXACTPLACES; scale += MD5_MAX_EXACTPLACES)
+			v /= md5_powersoften[MD5_MAX_EXACTPLACES];
+
+		for (; scale > MD5_MAX_EXACTPLACES; scale -= MD5_MAX_EXACTPLACES)
+			v *= md5_powersoften[MD5_MAX_EXACTPLACES];
+
+		if (scale < 0)
+			v /= md5_powersoften[-scale];
+		else v *= md5_powersoften[scale];
+	}
+
+	*value = (float) (negative ? -v : v);
+
+	return true;
+}
+
+
+/*
+==================
+MD5_LexVector
+
+( v0 v1 ... )
+==================
+*/
+qboolean MD5_LexVector (md5lexer_t *lex, float *v, int count)
+{
+	int i;
+
+	if (!MD5_LexExpect (lex, "(")) return false;
+
+	for (i = 0; i < count; i++)
+		if (!MD5_LexFloat (lex, &v[i])) return false;
+
+	return MD5_LexExpect (lex, ")");
+}
+
+
+/*
+==================
+MD5_LexString
+
+copies the next token, which is usually quoted, to out
+==================
+*/
+qboolean MD5_LexString (md5lexer_t *lex, char *out, int size)
+{
+	if (!MD5_LexNext (lex))
+	{
+		MD5_LexError (lex, "unexpected end of file looking for a string");
+		return false;
+	}
+
+	if (lex->tokenlen >= size)
+	{
+		MD5_LexError (lex, "\"%.*s\" is too long", MD5_EchoLen (lex), lex->token);
+		return false;
+	}
+
+	memcpy (out, lex->token, lex->tokenlen);
+	out[lex->tokenlen] = 0;
+
+	return true;
+}
@@ -0,0 +1,895 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// md5_skin.c -- matrix-palette skinning for MD5 models; this file is common to the GL and software renderers
+
+// the interpolated skeleton is converted to a 3x4 matrix per joint once per draw, then every vertex is skinned from a
+// structure-of-arrays stream that was built at load time, MD5_SKIN_LANES vertexes at a time.  the stream holds each vertex
+// in bind-pose space with at most MD5_MAX_INFLUENCES quantized weights, so the per-joint matrices also take out the bind
+// pose.  a quaternion version is kept as the reference path and can be selected (or compared against) with cvars.
+
+#include "quakedef.h"
+
+#if defined (_M_IX86) || defined (_M_X64) || defined (__SSE__)
+#include <xmmintrin.h>
+#define MD5_SKIN_SSE	1
+#else
+#define MD5_SKIN_SSE	0
+#endif
+
+cvar_t	r_md5skin = {"r_md5skin", "1"};				// 0 = reference quaternion path, 1 = matrix palette, 2 = matrix palette without SSE
+cvar_t	r_md5skincheck = {"r_md5skincheck", "0"};	// compare the palette path against the reference path every draw
+
+// positions and normals from the reference path, only used by r_md5skincheck
+static float md5_checkpositions[MAX_MD5_VERTEXES][3];
+static float md5_checknormals[MAX_MD5_VERTEXES][3];
+
+// max error that r_md5skincheck will tolerate before complaining
+#define MD5_SKINCHECK_EPSILON	0.01f
+
+
+/*
+==================
+MD5_JointMatrix
+
+builds a 3x4 matrix from a position and a unit quaternion; this is the same rotation as Quat_rotatePoint does
+==================
+*/
+static void MD5_JointMatrix (const float *pos, const float *q, float m[3][4])
+{
+	float xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+	float xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+	float wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+
+	m[0][0] = 1.0f - 2.0f * (yy + zz);
+	m[0][1] = 2.0f * (xy - wz);
+	m[0][2] = 2.0f * (xz + wy);
+	m[0][3] = pos[0];
+
+	m[1][0] = 2.0f * (xy + wz);
+	m[1][1] = 1.0f - 2.0f * (xx + zz);
+	m[1][2] = 2.0f * (yz - wx);
+	m[1][3] = pos[1];
+
+	m[2][0] = 2.0f * (xz - wy);
+	m[2][1] = 2.0f * (yz + wx);
+	m[2][2] = 1.0f - 2.0f * (xx + yy);
+	m[2][3] = pos[2];
+}
+
+
+/*
+==================
+MD5_BuildInverseBindPose
+
+the bind pose is rigid so the inverse is just the transposed rotation and the rotated, negated translation
+==================
+*/
+static void MD5_BuildInverseBindPose (struct md5_model_t *mdl)
+{
+	int i, r;
+
+	mdl->invbind = (md5_jointmat_t *) MD5_HunkAlloc (mdl->num_joints * sizeof (md5_jointmat_t));
+
+	for (i = 0; i < mdl->num_joints; i++)
+	{
+		float m[3][4];
+		float *inv = mdl->invbind[i][0];
+
+		MD5_JointMatrix (mdl->baseSkel[i].pos, mdl->baseSkel[i].orient, m);
+
+		for (r = 0; r < 3; r++, inv += 4)
+		{
+			inv[0] = m[0][r];
+			inv[1] = m[1][r];
+			inv[2] = m[2][r];
+			inv[3] = -(m[0][r] * m[0][3] + m[1][r] * m[1][3] + m[2][r] * m[2][3]);
+		}
+	}
+}
+
+
+/*
+==================
+MD5_QuantizeWeights
+
+picks the MD5_MAX_INFLUENCES heaviest weights of a vertex and renormalizes them to 16-bit biases that add up to exactly
+MD5_BIAS_ONE; returns the number of influences kept
+==================
+*/
+static int MD5_QuantizeWeights (const struct md5_weight_t *weights, int count, byte *joints, unsigned short *biases)
+{
+	const struct md5_weight_t *keep[MD5_MAX_INFLUENCES];
+	int numkeep = 0;
+	int i, j, total;
+	float sum = 0;
+
+	// insertion sort the heaviest weights into keep
+	for (i = 0; i < count; i++)
+	{
+		for (j = numkeep; j > 0 && keep[j - 1]->bias < weights[i].bias; j--)
+			if (j < MD5_MAX_INFLUENCES) keep[j] = keep[j - 1];
+
+		if (j < MD5_MAX_INFLUENCES)
+		{
+			keep[j] = &weights[i];
+			if (numkeep < MD5_MAX_INFLUENCES) numkeep++;
+		}
+	}
+
+	for (i = 0; i < numkeep; i++)
+		sum += keep[i]->bias;
+
+	// a vertex with no weight stays at the origin like it always did
+	if (sum <= 0) return 0;
+
+	for (i = 0, total = 0; i < numkeep; i++)
+	{
+		joints[i] = keep[i]->joint;
+		biases[i] = (unsigned short) (keep[i]->bias / sum * MD5_BIAS_ONE + 0.5f);
+		total += biases[i];
+	}
+
+	// rounding error goes to the heaviest weight
+	biases[0] += MD5_BIAS_ONE - total;
+
+	return numkeep;
+}
+
+
+/*
+==================
+MD5_BuildSkinStream
+
+converts the mesh weights to the fixed layout used by the palette skinning kernels.  vertexes are taken in groups of
+MD5_SKIN_LANES and stored in bind-pose space together with their bind-pose normals; each vertex keeps its
+MD5_MAX_INFLUENCES heaviest weights, renormalized and quantized to 16 bits, and unused slots are left as a zero bias on
+joint 0 so that they contribute nothing.  the raw weights aren't needed after this so the caller can throw them away.
+this relies on all weights of a vertex agreeing on where it is in the bind pose, which is how exporters write them;
+the error measured here also catches files where they don't.  returns the number of vertexes that had weights dropped
+and the worst position error over all frames of anim.
+==================
+*/
+int MD5_BuildSkinStream (struct md5_model_t *mdl, struct md5_mesh_t *mesh, const struct md5_anim_t *anim, const vertexnormals_t *vnorms, float *maxerror)
+{
+	int b, f, i, j, k;
+	int numdropped = 0;
+	md5_jointmat_t *palette;
+
+	MD5_BuildInverseBindPose (mdl);
+
+	mesh->num_skinblocks = (mesh->num_verts + MD5_SKIN_LANES - 1) / MD5_SKIN_LANES;
+	mesh->skinblocks = (struct md5_skinblock_t *) MD5_HunkAlloc (mesh->num_skinblocks * sizeof (struct md5_skinblock_t));
+
+	// MD5_HunkAlloc gives us zero-filled memory so the padding lanes and slots are already joint 0 with a bias of 0
+	for (b = 0; b < mesh->num_skinblocks; b++)
+	{
+		struct md5_skinblock_t *block = &mesh->skinblocks[b];
+
+		for (k = 0; k < MD5_SKIN_LANES; k++)
+		{
+			const struct md5_weight_t *weights;
+			byte joints[MD5_MAX_INFLUENCES];
+			unsigned short biases[MD5_MAX_INFLUENCES];
+			int numkeep;
+
+			if ((i = b * MD5_SKIN_LANES + k) >= mesh->num_verts) break;
+
+			weights = &mesh->weights[mesh->vertices[i].start];
+
+			// the bind-pose position uses every weight so that the base frame is exact
+			for (j = 0; j < mesh->vertices[i].count; j++)
+			{
+				const struct md5_joint_t *joint = &mdl->baseSkel[weights[j].joint];
+				vec3_t wv;
+
+				Quat_rotatePoint (joint->orient, weights[j].pos, wv);
+
+				block->pos[0][k] += (joint->pos[0] + wv[0]) * weights[j].bias;
+				block->pos[1][k] += (joint->pos[1] + wv[1]) * weights[j].bias;
+				block->pos[2][k] += (joint->pos[2] + wv[2]) * weights[j].bias;
+			}
+
+			block->normal[0][k] = vnorms[i].normal[0];
+			block->normal[1][k] = vnorms[i].normal[1];
+			block->normal[2][k] = vnorms[i].normal[2];
+
+			numkeep = MD5_QuantizeWeights (weights, mesh->vertices[i].count, joints, biases);
+
+			for (j = 0; j < numkeep; j++)
+			{
+				block->joint[j][k] = joints[j];
+				block->bias[j][k] = biases[j];
+			}
+
+			if (numkeep > block->numslots) block->numslots = numkeep;
+			if (mesh->vertices[i].count > MD5_MAX_INFLUENCES) numdropped++;
+		}
+	}
+
+	// measure how far the quantized stream strays from the original weights over the whole animation
+	*maxerror = 0;
+	palette = (md5_jointmat_t *) malloc (mdl->num_joints * sizeof (md5_jointmat_t));
+
+	for (f = 0; f < anim->num_frames; f++)
+	{
+		const struct md5_pose_t *skeleton = anim->skelFrames[f];
+
+		MD5_BuildJointMatrices (skeleton, mdl->invbind, mdl->num_joints, palette);
+
+		for (i = 0; i < mesh->num_verts; i++)
+		{
+			const struct md5_skinblock_t *block = &mesh->skinblocks[i / MD5_SKIN_LANES];
+			vec3_t exact = {0.0f, 0.0f, 0.0f};
+			vec3_t quant = {0.0f, 0.0f, 0.0f};
+			float error;
+
+			k = i % MD5_SKIN_LANES;
+
+			for (j = 0; j < mesh->vertices[i].count; j++)
+			{
+				const struct md5_weight_t *weight = &mesh->weights[mesh->vertices[i].start + j];
+				const struct md5_pose_t *joint = &skeleton[weight->joint];
+				vec3_t wv;
+
+				Quat_rotatePoint (joint->orient, weight->pos, wv);
+
+				exact[0] += (joint->pos[0] + wv[0]) * weight->bias;
+				exact[1] += (joint->pos[1] + wv[1]) * weight->bias;
+				exact[2] += (joint->pos[2] + wv[2]) * weight->bias;
+			}
+
+			for (j = 0; j < block->numslots; j++)
+			{
+				const float (*m)[4] = palette[block->joint[j][k]];
+				float bias = block->bias[j][k] * (1.0f / MD5_BIAS_ONE);
+
+				quant[0] += (m[0][0] * block->pos[0][k] + m[0][1] * block->pos[1][k] + m[0][2] * block->pos[2][k] + m[0][3]) * bias;
+				quant[1] += (m[1][0] * block->pos[0][k] + m[1][1] * block->pos[1][k] + m[1][2] * block->pos[2][k] + m[1][3]) * bias;
+				quant[2] += (m[2][0] * block->pos[0][k] + m[2][1] * block->pos[1][k] + m[2][2] * block->pos[2][k] + m[2][3]) * bias;
+			}
+
+			VectorSubtract (exact, quant, exact);
+
+			if ((error = Length (exact)) > *maxerror)
+				*maxerror = error;
+		}
+	}
+
+	free (palette);
+
+	return numdropped;
+}
+
+
+/*
+==================
+MD5_BuildJointMatrices
+
+converts a skeleton to a palette of 3x4 matrices that take a vertex from bind-pose space to the skeleton's pose
+==================
+*/
+void MD5_BuildJointMatrices (const struct md5_pose_t *skeleton, const md5_jointmat_t *invbind, int num_joints, md5_jointmat_t *palette)
+{
+	int i, r;
+
+	for (i = 0; i < num_joints; i++)
+	{
+		float m[3][4];
+		const float (*inv)[4] = invbind[i];
+
+		MD5_JointMatrix (skeleton[i].pos, skeleton[i].orient, m);
+
+		for (r = 0; r < 3; r++)
+		{
+			palette[i][r][0] = m[r][0] * inv[0][0] + m[r][1] * inv[1][0] + m[r][2] * inv[2][0];
+			palette[i][r][1] = m[r][0] * inv[0][1] + m[r][1] * inv[1][1] + m[r][2] * inv[2][1];
+			palette[i][r][2] = m[r][0] * inv[0][2] + m[r][1] * inv[1][2] + m[r][2] * inv[2][2];
+			palette[i][r][3] = m[r][0] * inv[0][3] + m[r][1] * inv[1][3] + m[r][2] * inv[2][3] + m[r][3];
+		}
+	}
+}
+
+
+/*
+==============================================================================
+
+SKELETON INTERPOLATION
+
+the orientations are nlerped, which is all that's needed for the small steps between poses, and the blend factor is
+corrected towards slerp once the angle between them gets large.  the correction is a polynomial fit in the cosine of
+the angle and the blend factor, so there's no trig and no branching and 4 joints can be done at a time.
+
+==============================================================================
+*/
+
+cvar_t	r_md5lerp = {"r_md5lerp", "1"};	// 0 = exact Quat_slerp per joint, 1 = batched nlerp with slerp correction
+
+// closer than this (cosine of the half angle) and a plain nlerp is indistinguishable from slerp
+#define MD5_NLERP_COSINE	0.9995f
+
+
+/*
+==================
+MD5_SlerpBlend
+
+corrects the nlerp blend factor so that nlerp follows slerp; d is the absolute cosine between the quaternions
+==================
+*/
+static float MD5_SlerpBlend (float d, float t)
+{
+	float a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+	float b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+	float k = a * (t - 0.5f) * (t - 0.5f) + b;
+
+	return t + t * (t - 0.5f) * (t - 1.0f) * k;
+}
+
+
+/*
+==================
+MD5_LerpQuat
+
+==================
+*/
+static void MD5_LerpQuat (const float *qa, const float *qb, float t, float *out)
+{
+	float d = Quat_dotProduct (qa, qb);
+	float sign = (d < 0) ? -1.0f : 1.0f;
+	float k0, k1, len;
+	int i;
+
+	// take the short way round
+	d *= sign;
+
+	if (d < MD5_NLERP_COSINE)
+		t = MD5_SlerpBlend (d, t);
+
+	k0 = 1.0f - t;
+	k1 = t * sign;
+
+	for (i = 0; i < 4; i++)
+		out[i] = qa[i] * k0 + qb[i] * k1;
+
+	len = 1.0f / sqrt (out[0] * out[0] + out[1] * out[1] + out[2] * out[2] + out[3] * out[3]);
+
+	for (i = 0; i < 4; i++)
+		out[i] *= len;
+}
+
+
+#if MD5_SKIN_SSE
+/*
+==================
+MD5_InterpolateSkeletons_SSE
+
+4 joints at a time; the orientations are transposed so that each register holds the same component for all 4.
+positions go one joint at a time, with the pad along for the ride.
+==================
+*/
+static int MD5_InterpolateSkeletons_SSE (const struct md5_pose_t *skelA, const struct md5_pose_t *skelB, int num_joints, float interp, struct md5_pose_t *out)
+{
+	const __m128 t = _mm_set1_ps (interp);
+	const __m128 one = _mm_set1_ps (1.0f);
+	const __m128 half = _mm_set1_ps (0.5f);
+	const __m128 three = _mm_set1_ps (3.0f);
+	const __m128 signbit = _mm_set1_ps (-0.0f);
+	const __m128 nlerpcos = _mm_set1_ps (MD5_NLERP_COSINE);
+
+	// the parts of the slerp correction that only depend on t
+	const __m128 th2 = _mm_set1_ps ((interp - 0.5f) * (interp - 0.5f));
+	const __m128 tc = _mm_set1_ps (interp * (interp - 0.5f) * (interp - 1.0f));
+	int i, j;
+
+	for (i = 0; i + 4 <= num_joints; i += 4)
+	{
+		__m128 ax = _mm_loadu_ps (skelA[i + 0].orient);
+		__m128 ay = _mm_loadu_ps (skelA[i + 1].orient);
+		__m128 az = _mm_loadu_ps (skelA[i + 2].orient);
+		__m128 aw = _mm_loadu_ps (skelA[i + 3].orient);
+		__m128 bx = _mm_loadu_ps (skelB[i + 0].orient);
+		__m128 by = _mm_loadu_ps (skelB[i + 1].orient);
+		__m128 bz = _mm_loadu_ps (skelB[i + 2].orient);
+		__m128 bw = _mm_loadu_ps (skelB[i + 3].orient);
+		__m128 d, sign, a, b, k, blend, mask, k0, len, rlen;
+
+		_MM_TRANSPOSE4_PS (ax, ay, az, aw);
+		_MM_TRANSPOSE4_PS (bx, by, bz, bw);
+
+		d = _mm_add_ps (_mm_add_ps (_mm_mul_ps (ax, bx), _mm_mul_ps (ay, by)), _mm_add_ps (_mm_mul_ps (az, bz), _mm_mul_ps (aw, bw)));
+
+		// take the short way round by flipping b to the same hemisphere as a
+		sign = _mm_and_ps (d, signbit);
+		d = _mm_xor_ps (d, sign);
+
+		bx = _mm_xor_ps (bx, sign);
+		by = _mm_xor_ps (by, sign);
+		bz = _mm_xor_ps (bz, sign);
+		bw = _mm_xor_ps (bw, sign);
+
+		// MD5_SlerpBlend, only used where the angle is large enough to need it
+		a = _mm_add_ps (_mm_set1_ps (1.0904f), _mm_mul_ps (d, _mm_add_ps (_mm_set1_ps (-3.2452f), _mm_mul_ps (d, _mm_sub_ps (_mm_set1_ps (3.55645f), _mm_mul_ps (d, _mm_set1_ps (1.43519f)))))));
+		b = _mm_add_ps (_mm_set1_ps (0.848013f), _mm_mul_ps (d, _mm_add_ps (_mm_set1_ps (-1.06021f), _mm_mul_ps (d, _mm_set1_ps (0.215638f)))));
+		k = _mm_add_ps (_mm_mul_ps (a, th2), b);
+		blend = _mm_add_ps (t, _mm_mul_ps (tc, k));
+
+		mask = _mm_cmpgt_ps (d, nlerpcos);
+		blend = _mm_or_ps (_mm_and_ps (mask, t), _mm_andnot_ps (mask, blend));
+		k0 = _mm_sub_ps (one, blend);
+
+		ax = _mm_add_ps (_mm_mul_ps (ax, k0), _mm_mul_ps (bx, blend));
+		ay = _mm_add_ps (_mm_mul_ps (ay, k0), _mm_mul_ps (by, blend));
+		az = _mm_add_ps (_mm_mul_ps (az, k0), _mm_mul_ps (bz, blend));
+		aw = _mm_add_ps (_mm_mul_ps (aw, k0), _mm_mul_ps (bw, blend));
+
+		// normalize with one newton-raphson step on the estimate
+		len = _mm_add_ps (_mm_add_ps (_mm_mul_ps (ax, ax), _mm_mul_ps (ay, ay)), _mm_add_ps (_mm_mul_ps (az, az), _mm_mul_ps (aw, aw)));
+		rlen = _mm_rsqrt_ps (len);
+		rlen = _mm_mul_ps (_mm_mul_ps (half, rlen), _mm_sub_ps (three, _mm_mul_ps (_mm_mul_ps (len, rlen), rlen)));
+
+		ax = _mm_mul_ps (ax, rlen);
+		ay = _mm_mul_ps (ay, rlen);
+		az = _mm_mul_ps (az, rlen);
+		aw = _mm_mul_ps (aw, rlen);
+
+		_MM_TRANSPOSE4_PS (ax, ay, az, aw);
+
+		_mm_storeu_ps (out[i + 0].orient, ax);
+		_mm_storeu_ps (out[i + 1].orient, ay);
+		_mm_storeu_ps (out[i + 2].orient, az);
+		_mm_storeu_ps (out[i + 3].orient, aw);
+
+		for (j = i; j < i + 4; j++)
+		{
+			__m128 pa = _mm_loadu_ps (skelA[j].pos);
+			__m128 pb = _mm_loadu_ps (skelB[j].pos);
+
+			_mm_storeu_ps (out[j].pos, _mm_add_ps (pa, _mm_mul_ps (t, _mm_sub_ps (pb, pa))));
+		}
+	}
+
+	// the caller does the rest
+	return i;
+}
+#endif
+
+
+/*
+==================
+MD5_InterpolateSkeletons_Exact
+
+==================
+*/
+static void MD5_InterpolateSkeletons_Exact (const struct md5_pose_t *skelA, const struct md5_pose_t *skelB, int num_joints, float interp, struct md5_pose_t *out)
+{
+	int i;
+
+	for (i = 0; i < num_joints; ++i)
+	{
+		// Linear interpolation for position
+		out[i].pos[0] = skelA[i].pos[0] + interp * (skelB[i].pos[0] - skelA[i].pos[0]);
+		out[i].pos[1] = skelA[i].pos[1] + interp * (skelB[i].pos[1] - skelA[i].pos[1]);
+		out[i].pos[2] = skelA[i].pos[2] + interp * (skelB[i].pos[2] - skelA[i].pos[2]);
+
+		// Spherical linear interpolation for orientation
+		Quat_slerp (skelA[i].orient, skelB[i].orient, interp, out[i].orient);
+	}
+}
+
+
+/*
+==================
+MD5_InterpolateSkeletons_Fast
+
+==================
+*/
+static void MD5_InterpolateSkeletons_Fast (const struct md5_pose_t *skelA, const struct md5_pose_t *skelB, int num_joints, float interp, struct md5_pose_t *out)
+{
+	int i = 0;
+
+#if MD5_SKIN_SSE
+	if (r_md5skin.value != 2)
+		i = MD5_InterpolateSkeletons_SSE (skelA, skelB, num_joints, interp, out);
+#endif
+
+	for (; i < num_joints; i++)
+	{
+		out[i].pos[0] = skelA[i].pos[0] + interp * (skelB[i].pos[0] - skelA[i].pos[0]);
+		out[i].pos[1] = skelA[i].pos[1] + interp * (skelB[i].pos[1] - skelA[i].pos[1]);
+		out[i].pos[2] = skelA[i].pos[2] + interp * (skelB[i].pos[2] - skelA[i].pos[2]);
+
+		MD5_LerpQuat (skelA[i].orient, skelB[i].orient, interp, out[i].orient);
+	}
+}
+
+
+/*
+==================
+MD5_InterpolateSkeletons
+
+==================
+*/
+void MD5_InterpolateSkeletons (const struct md5_pose_t *skelA, const struct md5_pose_t *skelB, int num_joints, float interp, struct md5_pose_t *out)
+{
+	if (r_md5lerp.value)
+		MD5_InterpolateSkeletons_Fast (skelA, skelB, num_joints, interp, out);
+	else MD5_InterpolateSkeletons_Exact (skelA, skelB, num_joints, interp, out);
+}
+
+
+/*
+==================
+MD5_QuatAngle
+
+angle in degrees between the rotations of two quaternions; Quat_slerp doesn't normalize very close ones
+==================
+*/
+static double MD5_QuatAngle (const float *qa, const float *qb)
+{
+	double la = sqrt (qa[0] * qa[0] + qa[1] * qa[1] + qa[2] * qa[2] + qa[3] * qa[3]);
+	double lb = sqrt (qb[0] * qb[0] + qb[1] * qb[1] + qb[2] * qb[2] + qb[3] * qb[3]);
+	double sign = (qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] + qa[3] * qb[3] < 0) ? -1.0 : 1.0;
+	double chord = 0;
+	int i;
+
+	// from the chord rather than acos of the dot product, which has no precision left for small angles
+	for (i = 0; i < 4; i++)
+		chord += (qa[i] / la - sign * qb[i] / lb) * (qa[i] / la - sign * qb[i] / lb);
+
+	return 4.0 * asin (sqrt (chord) * 0.5) * (180.0 / M_PI);
+}
+
+
+/*
+==================
+MD5_TimeLerp_f
+
+compares the fast interpolation against Quat_slerp on random skeletons, reporting the time per joint and the worst
+angular error for small steps (the usual case between poses) and for the full range
+==================
+*/
+void MD5_TimeLerp_f (void)
+{
+	static struct md5_pose_t skelA[MAX_MD5_JOINTS], skelB[MAX_MD5_JOINTS], exact[MAX_MD5_JOINTS], fast[MAX_MD5_JOINTS];
+	double exacttime = 0, fasttime = 0, maxerror[2] = {0, 0};
+	unsigned int seed = 1;
+	int pass, range, i, j;
+
+	for (range = 0; range < 2; range++)
+	{
+		for (pass = 0; pass < 256; pass++)
+		{
+			float interp;
+			double time1, time2, time3;
+
+			// small steps are up to about 20 degrees apart, the full range is anything
+			for (i = 0; i < MAX_MD5_JOINTS; i++)
+			{
+				for (j = 0; j < 4; j++)
+				{
+					seed = seed * 1103515245 + 12345;
+					skelA[i].orient[j] = (float) ((seed >> 8) & 0xffff) / 32767.5f - 1.0f;
+					seed = seed * 1103515245 + 12345;
+					skelB[i].orient[j] = (float) ((seed >> 8) & 0xffff) / 32767.5f - 1.0f;
+
+					if (!range) skelB[i].orient[j] = skelA[i].orient[j] * 5.0f + skelB[i].orient[j] * 0.4f;
+				}
+
+				for (j = 0; j < 3; j++)
+				{
+					seed = seed * 1103515245 + 12345;
+					skelA[i].pos[j] = skelB[i].pos[j] = (float) ((seed >> 8) & 0xff);
+				}
+
+				Quat_normalize (skelA[i].orient);
+				Quat_normalize (skelB[i].orient);
+
+				// and sometimes in opposite hemispheres
+				if (i & 1)
+					for (j = 0; j < 4; j++) skelB[i].orient[j] = -skelB[i].orient[j];
+			}
+
+			seed = seed * 1103515245 + 12345;
+			interp = (float) ((seed >> 8) & 0xffff) / 65536.0f;
+
+			time1 = Sys_FloatTime ();
+			MD5_InterpolateSkeletons_Exact (skelA, skelB, MAX_MD5_JOINTS, interp, exact);
+			time2 = Sys_FloatTime ();
+			MD5_InterpolateSkeletons_Fast (skelA, skelB, MAX_MD5_JOINTS, interp, fast);
+			time3 = Sys_FloatTime ();
+
+			exacttime += time2 - time1;
+			fasttime += time3 - time2;
+
+			for (i = 0; i < MAX_MD5_JOINTS; i++)
+			{
+				double error = MD5_QuatAngle (exact[i].orient, fast[i].orient);
+
+				if (error > maxerror[range]) maxerror[range] = error;
+			}
+		}
+	}
+
+	Con_Printf ("Quat_slerp %.1f ns/joint, fast %.1f ns/joint\n", exacttime * 1e9 / (2 * 256 * MAX_MD5_JOINTS), fasttime * 1e9 / (2 * 256 * MAX_MD5_JOINTS));
+	Con_Printf ("max error %f degrees for small steps, %f degrees over the full range\n", maxerror[0], maxerror[1]);
+}
+
+
+/*
+==================
+MD5_SkinMesh_Reference
+
+skins the stream with quaternions, taking each vertex back to joint-local space through the bind pose; slow but this
+is what the other paths are checked against
+==================
+*/
+void MD5_SkinMesh_Reference (const struct md5_model_t *mdl, const struct md5_mesh_t *mesh, const struct md5_pose_t *skeleton, float *xyz, int xyzstride, float *norm, int normstride)
+{
+	int i, j, k;
+
+	for (i = 0; i < mesh->num_verts; i++, xyz += xyzstride, norm += normstride)
+	{
+		const struct md5_skinblock_t *block = &mesh->skinblocks[i / MD5_SKIN_LANES];
+		vec3_t finalVertex = {0.0f, 0.0f, 0.0f};
+		vec3_t finalNormal = {0.0f, 0.0f, 0.0f};
+
+		k = i % MD5_SKIN_LANES;
+
+		for (j = 0; j < block->numslots; j++)
+		{
+			const struct md5_joint_t *bind = &mdl->baseSkel[block->joint[j][k]];
+			const struct md5_pose_t *joint = &skeleton[block->joint[j][k]];
+			float bias = block->bias[j][k] * (1.0f / MD5_BIAS_ONE);
+			vec3_t local, wv;
+
+			// bind-pose space to joint-local space
+			local[0] = block->pos[0][k] - bind->pos[0];
+			local[1] = block->pos[1][k] - bind->pos[1];
+			local[2] = block->pos[2][k] - bind->pos[2];
+			Quat_inverseRotatePoint (bind->orient, local, local);
+
+			// and out to the pose
+			Quat_rotatePoint (joint->orient, local, wv);
+
+			finalVertex[0] += (joint->pos[0] + wv[0]) * bias;
+			finalVertex[1] += (joint->pos[1] + wv[1]) * bias;
+			finalVertex[2] += (joint->pos[2] + wv[2]) * bias;
+
+			// same for the normal without the translation
+			local[0] = block->normal[0][k];
+			local[1] = block->normal[1][k];
+			local[2] = block->normal[2][k];
+			Quat_inverseRotatePoint (bind->orient, local, local);
+			Quat_rotatePoint (joint->orient, local, wv);
+
+			finalNormal[0] += wv[0] * bias;
+			finalNormal[1] += wv[1] * bias;
+			finalNormal[2] += wv[2] * bias;
+		}
+
+		VectorCopy (finalVertex, xyz);
+		VectorCopy (finalNormal, norm);
+	}
+}
+
+
+/*
+==================
+MD5_StoreSkinBlock
+
+writes out the valid lanes of a skinned block
+==================
+*/
+static void MD5_StoreSkinBlock (float out[6][MD5_SKIN_LANES], int numlanes, float *xyz, int xyzstride, float *norm, int normstride)
+{
+	int k;
+
+	// the last block may be only partially filled
+	if (numlanes > MD5_SKIN_LANES) numlanes = MD5_SKIN_LANES;
+
+	for (k = 0; k < numlanes; k++, xyz += xyzstride, norm += normstride)
+	{
+		xyz[0] = out[0][k];
+		xyz[1] = out[1][k];
+		xyz[2] = out[2][k];
+
+		norm[0] = out[3][k];
+		norm[1] = out[4][k];
+		norm[2] = out[5][k];
+	}
+}
+
+
+#if MD5_SKIN_SSE
+/*
+==================
+MD5_SkinMesh_SSE
+
+skins MD5_SKIN_LANES vertexes per iteration.  for each slot the rows of the 4 joint matrices are loaded and transposed so
+that each register holds the same matrix element for all 4 vertexes, and the weighted matrices are summed; the blended
+matrix is then applied once to the position and normal.  there are at most MD5_MAX_INFLUENCES slots per block.
+==================
+*/
+static void MD5_SkinMesh_SSE (const struct md5_mesh_t *mesh, const md5_jointmat_t *palette, float *xyz, int xyzstride, float *norm, int normstride)
+{
+	int b, s, r;
+	float out[6][MD5_SKIN_LANES];
+	const __m128 biasscale = _mm_set1_ps (1.0f / MD5_BIAS_ONE);
+
+	for (b = 0; b < mesh->num_skinblocks; b++, xyz += xyzstride * MD5_SKIN_LANES, norm += normstride * MD5_SKIN_LANES)
+	{
+		const struct md5_skinblock_t *block = &mesh->skinblocks[b];
+		__m128 acc[3][4];
+
+		for (r = 0; r < 3; r++)
+			acc[r][0] = acc[r][1] = acc[r][2] = acc[r][3] = _mm_setzero_ps ();
+
+		for (s = 0; s < block->numslots; s++)
+		{
+			const byte *joint = block->joint[s];
+			const unsigned short *qbias = block->bias[s];
+			__m128 bias = _mm_mul_ps (_mm_setr_ps (qbias[0], qbias[1], qbias[2], qbias[3]), biasscale);
+
+			for (r = 0; r < 3; r++)
+			{
+				__m128 m0 = _mm_loadu_ps (palette[joint[0]][r]);
+				__m128 m1 = _mm_loadu_ps (palette[joint[1]][r]);
+				__m128 m2 = _mm_loadu_ps (palette[joint[2]][r]);
+				__m128 m3 = _mm_loadu_ps (palette[joint[3]][r]);
+
+				// m0..m3 now hold element 0..3 of this row for each of the 4 vertexes
+				_MM_TRANSPOSE4_PS (m0, m1, m2, m3);
+
+				acc[r][0] = _mm_add_ps (acc[r][0], _mm_mul_ps (m0, bias));
+				acc[r][1] = _mm_add_ps (acc[r][1], _mm_mul_ps (m1, bias));
+				acc[r][2] = _mm_add_ps (acc[r][2], _mm_mul_ps (m2, bias));
+				acc[r][3] = _mm_add_ps (acc[r][3], _mm_mul_ps (m3, bias));
+			}
+		}
+
+		{
+			__m128 px = _mm_loadu_ps (block->pos[0]);
+			__m128 py = _mm_loadu_ps (block->pos[1]);
+			__m128 pz = _mm_loadu_ps (block->pos[2]);
+			__m128 nx = _mm_loadu_ps (block->normal[0]);
+			__m128 ny = _mm_loadu_ps (block->normal[1]);
+			__m128 nz = _mm_loadu_ps (block->normal[2]);
+
+			for (r = 0; r < 3; r++)
+			{
+				__m128 p = _mm_add_ps (_mm_add_ps (_mm_mul_ps (acc[r][0], px), _mm_mul_ps (acc[r][1], py)), _mm_add_ps (_mm_mul_ps (acc[r][2], pz), acc[r][3]));
+				__m128 n = _mm_add_ps (_mm_add_ps (_mm_mul_ps (acc[r][0], nx), _mm_mul_ps (acc[r][1], ny)), _mm_mul_ps (acc[r][2], nz));
+
+				_mm_storeu_ps (out[r], p);
+				_mm_storeu_ps (out[r + 3], n);
+			}
+		}
+
+		MD5_StoreSkinBlock (out, mesh->num_verts - b * MD5_SKIN_LANES, xyz, xyzstride, norm, normstride);
+	}
+}
+#endif
+
+
+/*
+==================
+MD5_SkinMesh_C
+
+portable version of the palette kernel, for compilers without SSE intrinsics
+==================
+*/
+static void MD5_SkinMesh_C (const struct md5_mesh_t *mesh, const md5_jointmat_t *palette, float *xyz, int xyzstride, float *norm, int normstride)
+{
+	int b, s, r, k;
+	float out[6][MD5_SKIN_LANES];
+
+	for (b = 0; b < mesh->num_skinblocks; b++, xyz += xyzstride * MD5_SKIN_LANES, norm += normstride * MD5_SKIN_LANES)
+	{
+		const struct md5_skinblock_t *block = &mesh->skinblocks[b];
+
+		for (k = 0; k < MD5_SKIN_LANES; k++)
+		{
+			float m[3][4];
+
+			// blend the matrices for this vertex
+			memset (m, 0, sizeof (m));
+
+			for (s = 0; s < block->numslots; s++)
+			{
+				const float (*jm)[4] = palette[block->joint[s][k]];
+				float bias = block->bias[s][k] * (1.0f / MD5_BIAS_ONE);
+
+				for (r = 0; r < 3; r++)
+				{
+					m[r][0] += jm[r][0] * bias;
+					m[r][1] += jm[r][1] * bias;
+					m[r][2] += jm[r][2] * bias;
+					m[r][3] += jm[r][3] * bias;
+				}
+			}
+
+			for (r = 0; r < 3; r++)
+			{
+				out[r][k] = m[r][0] * block->pos[0][k] + m[r][1] * block->pos[1][k] + m[r][2] * block->pos[2][k] + m[r][3];
+				out[r + 3][k] = m[r][0] * block->normal[0][k] + m[r][1] * block->normal[1][k] + m[r][2] * block->normal[2][k];
+			}
+		}
+
+		MD5_StoreSkinBlock (out, mesh->num_verts - b * MD5_SKIN_LANES, xyz, xyzstride, norm, normstride);
+	}
+}
+
+
+/*
+==================
+MD5_CheckSkinning
+
+compares the palette output against the reference path; r_md5skincheck 1
+==================
+*/
+static void MD5_CheckSkinning (const struct md5_model_t *mdl, const struct md5_mesh_t *mesh, const struct md5_pose_t *skeleton, const float *xyz, int xyzstride, const float *norm, int normstride)
+{
+	int i, j;
+	float maxerror = 0;
+
+	MD5_SkinMesh_Reference (mdl, mesh, skeleton, md5_checkpositions[0], 3, md5_checknormals[0], 3);
+
+	for (i = 0; i < mesh->num_verts; i++, xyz += xyzstride, norm += normstride)
+	{
+		for (j = 0; j < 3; j++)
+		{
+			if (fabs (xyz[j] - md5_checkpositions[i][j]) > maxerror) maxerror = fabs (xyz[j] - md5_checkpositions[i][j]);
+			if (fabs (norm[j] - md5_checknormals[i][j]) > maxerror) maxerror = fabs (norm[j] - md5_checknormals[i][j]);
+		}
+	}
+
+	if (maxerror > MD5_SKINCHECK_EPSILON)
+		Con_Printf ("MD5_CheckSkinning : palette skinning is off by %f\n", maxerror);
+}
+
+
+/*
+==================
+MD5_SkinMesh
+
+skins a mesh of mdl from the given skeleton, writing positions and normals out with the given strides (in floats).
+palette is scratch space for mdl->num_joints matrices.
+==================
+*/
+void MD5_SkinMesh (const struct md5_model_t *mdl, const struct md5_mesh_t *mesh, const struct md5_pose_t *skeleton, md5_jointmat_t *palette, float *xyz, int xyzstride, float *norm, int normstride)
+{
+	if (!r_md5skin.value)
+	{
+		MD5_SkinMesh_Reference (mdl, mesh, skeleton, xyz, xyzstride, norm, normstride);
+		return;
+	}
+
+	MD5_BuildJointMatrices (skeleton, mdl->invbind, mdl->num_joints, palette);
+
+#if MD5_SKIN_SSE
+	if (r_md5skin.value != 2)
+		MD5_SkinMesh_SSE (mesh, palette, xyz, xyzstride, norm, normstride);
+	else
+#endif
+	MD5_SkinMesh_C (mesh, palette, xyz, xyzstride, norm, normstride);
+
+	if (r_md5skincheck.value)
+		MD5_CheckSkinning (mdl, mesh, skeleton, xyz, xyzstride, norm, normstride);
+}
@@ -0,0 +1,395 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// md5_vcache.c -- load-time vertex cache ordering of MD5 meshes; this file is common to the GL and software renderers
+
+// MD5s are exported with their triangles in whatever order the modelling package had them, which is rarely kind to the
+// post-transform vertex cache.  at load time the triangles of each submesh are reordered with Tom Forsyth's linear-speed
+// vertex cache optimisation, then the vertexes of each submesh are renumbered in the order that the new triangle order
+// first uses them, and the weights are moved to follow their vertexes.  skinning then walks the vertexes and weights
+// straight through memory, and so does the vertex fetch when they're drawn.  the submesh ranges don't change.
+
+#include "quakedef.h"
+
+// the cache modelled while ordering; the scores work well for any real cache at least this size or smaller
+#define MD5_VCACHE_SIZE		32
+
+// the cache used for reporting; a plain FIFO, which is about the worst case for hardware of this age
+#define MD5_VCACHE_FIFO		16
+
+// valence scores are tabled up to here and computed past it
+#define MD5_VCACHE_VALENCE	64
+
+static float md5_cachescores[MD5_VCACHE_SIZE];
+static float md5_valencescores[MD5_VCACHE_VALENCE];
+static qboolean md5_vcacheinit = false;
+
+
+/*
+==================
+MD5_VertexCacheInit
+
+==================
+*/
+static void MD5_VertexCacheInit (void)
+{
+	int i;
+
+	if (md5_vcacheinit) return;
+
+	// the last triangle's vertexes all score the same so that there's no preference for which way round it went;
+	// after that the score falls off with the position in the cache
+	for (i = 0; i < MD5_VCACHE_SIZE; i++)
+	{
+		if (i < 3)
+			md5_cachescores[i] = 0.75f;
+		else md5_cachescores[i] = pow (1.0f - (float) (i - 3) / (MD5_VCACHE_SIZE - 3), 1.5f);
+	}
+
+	// boost vertexes with few triangles left so that lone triangles get picked up before they're stranded
+	for (i = 1; i < MD5_VCACHE_VALENCE; i++)
+		md5_valencescores[i] = 2.0f * pow (i, -0.5f);
+
+	md5_valencescores[0] = 0;
+	md5_vcacheinit = true;
+}
+
+
+/*
+==================
+MD5_VertexScore
+
+==================
+*/
+static float MD5_VertexScore (int cachepos, int remaining)
+{
+	float score;
+
+	// no triangles left to use it, so it doesn't matter
+	if (!remaining) return -1.0f;
+
+	score = (cachepos < 0) ? 0 : md5_cachescores[cachepos];
+
+	if (remaining < MD5_VCACHE_VALENCE)
+		return score + md5_valencescores[remaining];
+	else return score + 2.0f * pow (remaining, -0.5f);
+}
+
+
+/*
+==================
+MD5_VertexCacheACMR
+
+the average number of vertexes transformed per triangle through a FIFO cache, counting a vertex as cached if fewer
+than MD5_VCACHE_FIFO misses have happened since it went in
+==================
+*/
+float MD5_VertexCacheACMR (const int *indexes, int numtris, int numverts)
+{
+	int *stamps;
+	int i, misses = 0;
+
+	if (numtris < 1) return 0;
+	if ((stamps = (int *) malloc (numverts * sizeof (int))) == NULL) return 0;
+
+	for (i = 0; i < numverts; i++)
+		stamps[i] = -MD5_VCACHE_FIFO - 1;
+
+	for (i = 0; i < numtris * 3; i++)
+	{
+		if (misses - stamps[indexes[i]] > MD5_VCACHE_FIFO)
+			stamps[indexes[i]] = misses++;
+	}
+
+	free (stamps);
+
+	return (float) misses / numtris;
+}
+
+
+/*
+==================
+MD5_OrderTriangles
+
+Forsyth's greedy ordering over a modelled LRU cache; indexes are numbered from 0 to numverts - 1 and order gets the
+old triangle for each new one.  the order is left as it was if there's no memory.
+==================
+*/
+static void MD5_OrderTriangles (const int *indexes, int numtris, int numverts, int *order)
+{
+	int cache[MD5_VCACHE_SIZE + 3], newcache[MD5_VCACHE_SIZE + 3];
+	int cachecount = 0, newcount;
+	int *adjstart, *adj, *live, *cachepos;
+	float *vscores, *tscores;
+	byte *added;
+	int i, j, k, n, best, cursor = 0;
+
+	for (i = 0; i < numtris; i++)
+		order[i] = i;
+
+	if (numtris < 2) return;
+
+	adjstart = (int *) malloc ((numverts + 1) * sizeof (int));
+	adj = (int *) malloc (numtris * 3 * sizeof (int));
+	live = (int *) calloc (numverts, sizeof (int));
+	cachepos = (int *) malloc (numverts * sizeof (int));
+	vscores = (float *) malloc (numverts * sizeof (float));
+	tscores = (float *) malloc (numtris * sizeof (float));
+	added = (byte *) calloc (numtris, 1);
+
+	if (!adjstart || !adj || !live || !cachepos || !vscores || !tscores || !added)
+		goto done;
+
+	MD5_VertexCacheInit ();
+
+	// build the triangle lists for each vertex; live is the number not yet added, which are kept at the front
+	for (i = 0; i < numtris * 3; i++)
+		live[indexes[i]]++;
+
+	for (i = 0, adjstart[0] = 0; i < numverts; i++)
+		adjstart[i + 1] = adjstart[i] + live[i];
+
+	memset (live, 0, numverts * sizeof (int));
+
+	for (i = 0; i < numtris * 3; i++)
+	{
+		int v = indexes[i];
+		adj[adjstart[v] + live[v]++] = i / 3;
+	}
+
+	for (i = 0; i < numverts; i++)
+	{
+		cachepos[i] = -1;
+		vscores[i] = MD5_VertexScore (-1, live[i]);
+	}
+
+	for (i = 0, best = 0; i < numtris; i++)
+	{
+		tscores[i] = vscores[indexes[i * 3 + 0]] + vscores[indexes[i * 3 + 1]] + vscores[indexes[i * 3 + 2]];
+		if (tscores[i] > tscores[best]) best = i;
+	}
+
+	for (n = 0; n < numtris; n++)
+	{
+		const int *tri;
+
+		// nothing in the cache has any triangles left so start again from the best of the rest
+		if (best < 0)
+		{
+			while (added[cursor]) cursor++;
+
+			for (i = cursor, best = cursor; i < numtris; i++)
+				if (!added[i] && tscores[i] > tscores[best]) best = i;
+		}
+
+		order[n] = best;
+		added[best] = 1;
+		tri = &indexes[best * 3];
+
+		// take it out of it's vertexes' lists
+		for (k = 0; k < 3; k++)
+		{
+			int v = tri[k];
+			int *list = &adj[adjstart[v]];
+
+			for (i = 0; i < live[v]; i++)
+			{
+				if (list[i] != best) continue;
+
+				list[i] = list[live[v] - 1];
+				live[v]--;
+				break;
+			}
+		}
+
+		// its vertexes go to the front of the cache and everything else moves down
+		for (k = 0, newcount = 0; k < 3; k++)
+		{
+			for (i = 0; i < newcount; i++)
+				if (newcache[i] == tri[k]) break;
+
+			if (i == newcount) newcache[newcount++] = tri[k];
+		}
+
+		for (i = 0; i < cachecount; i++)
+		{
+			if (cache[i] == tri[0] || cache[i] == tri[1] || cache[i] == tri[2]) continue;
+			newcache[newcount++] = cache[i];
+		}
+
+		// rescore everything that was touched, including the ones that fell out the end
+		for (i = 0; i < newcount; i++)
+		{
+			int v = newcache[i];
+
+			cachepos[v] = (i < MD5_VCACHE_SIZE) ? i : -1;
+			vscores[v] = MD5_VertexScore (cachepos[v], live[v]);
+		}
+
+		// and the triangles that use them, picking the next one from these
+		for (i = 0, best = -1; i < newcount; i++)
+		{
+			int v = newcache[i];
+
+			for (j = 0; j < live[v]; j++)
+			{
+				int t = adj[adjstart[v] + j];
+				const int *other = &indexes[t * 3];
+
+				tscores[t] = vscores[other[0]] + vscores[other[1]] + vscores[other[2]];
+
+				if (best < 0 || tscores[t] > tscores[best]) best = t;
+			}
+		}
+
+		cachecount = (newcount < MD5_VCACHE_SIZE) ? newcount : MD5_VCACHE_SIZE;
+		memcpy (cache, newcache, cachecount * sizeof (int));
+	}
+
+done:;
+	if (adjstart) free (adjstart);
+	if (adj) free (adj);
+	if (live) free (live);
+	if (cachepos) free (cachepos);
+	if (vscores) free (vscores);
+	if (tscores) free (tscores);
+	if (added) free (added);
+}
+
+
+/*
+==================
+MD5_OptimizeMesh
+
+indexes are the mesh's triangles as ints, and are rewritten in the new order with the new vertex numbers.  triorder
+gets the old triangle for each new one so that the caller can move anything else it keeps per triangle, and remap
+gets the new number for each old vertex.  the mesh's vertexes are reordered in place.  its weights must be from malloc:
+they're freed and replaced by a new block from malloc in the new order, holding only the weights the vertexes use,
+which the caller owns and frees the same as before.  acmr gets the average cache miss ratio before and after.  returns
+false and changes nothing if the submeshes don't cover the mesh or there's no memory.
+==================
+*/
+qboolean MD5_OptimizeMesh (struct md5_mesh_t *mesh, const struct md5_submesh_t *submeshes, int num_submeshes, int *indexes, int *triorder, int *remap, float *acmr)
+{
+	struct md5_vertex_t *vertices;
+	struct md5_weight_t *weights;
+	int *oldindexes, *local;
+	int i, j, k, s, numverts = 0, numtris = 0, num_weights = 0;
+
+	// every triangle must use only the vertexes of it's own submesh, which must be the whole mesh between them
+	for (s = 0; s < num_submeshes; s++)
+	{
+		const struct md5_submesh_t *sm = &submeshes[s];
+
+		if (sm->firstvert != numverts || sm->firsttri != numtris) return false;
+
+		for (i = sm->firsttri * 3; i < (sm->firsttri + sm->numtris) * 3; i++)
+			if (indexes[i] < sm->firstvert || indexes[i] >= sm->firstvert + sm->numverts) return false;
+
+		numverts += sm->numverts;
+		numtris += sm->numtris;
+	}
+
+	if (numverts != mesh->num_verts || numtris != mesh->num_tris) return false;
+
+	for (i = 0; i < mesh->num_verts; i++)
+		num_weights += mesh->vertices[i].count;
+
+	oldindexes = (int *) malloc (mesh->num_tris * 3 * sizeof (int));
+	local = (int *) malloc (mesh->num_tris * 3 * sizeof (int));
+	vertices = (struct md5_vertex_t *) malloc (mesh->num_verts * sizeof (struct md5_vertex_t));
+	weights = (struct md5_weight_t *) malloc ((num_weights + 1) * sizeof (struct md5_weight_t));
+
+	if (!oldindexes || !local || !vertices || !weights)
+	{
+		if (oldindexes) free (oldindexes);
+		if (local) free (local);
+		if (vertices) free (vertices);
+		if (weights) free (weights);
+
+		return false;
+	}
+
+	acmr[0] = MD5_VertexCacheACMR (indexes, mesh->num_tris, mesh->num_verts);
+	memcpy (oldindexes, indexes, mesh->num_tris * 3 * sizeof (int));
+
+	for (s = 0; s < num_submeshes; s++)
+	{
+		const struct md5_submesh_t *sm = &submeshes[s];
+		int next = sm->firstvert;
+
+		// order the triangles
+		for (i = 0; i < sm->numtris * 3; i++)
+			local[i] = oldindexes[sm->firsttri * 3 + i] - sm->firstvert;
+
+		MD5_OrderTriangles (local, sm->numtris, sm->numverts, &triorder[sm->firsttri]);
+
+		for (i = sm->firsttri; i < sm->firsttri + sm->numtris; i++)
+			triorder[i] += sm->firsttri;
+
+		// then number the vertexes in the order they're first used, with any unused ones at the end
+		for (i = sm->firstvert; i < sm->firstvert + sm->numverts; i++)
+			remap[i] = -1;
+
+		for (i = sm->firsttri; i < sm->firsttri + sm->numtris; i++)
+		{
+			for (k = 0; k < 3; k++)
+			{
+				int v = oldindexes[triorder[i] * 3 + k];
+				if (remap[v] < 0) remap[v] = next++;
+			}
+		}
+
+		for (i = sm->firstvert; i < sm->firstvert + sm->numverts; i++)
+			if (remap[i] < 0) remap[i] = next++;
+	}
+
+	for (i = 0; i < mesh->num_tris; i++)
+		for (k = 0; k < 3; k++)
+			indexes[i * 3 + k] = remap[oldindexes[triorder[i] * 3 + k]];
+
+	for (i = 0; i < mesh->num_verts; i++)
+		vertices[remap[i]] = mesh->vertices[i];
+
+	// the weights follow the vertexes
+	for (i = 0, num_weights = 0; i < mesh->num_verts; i++)
+	{
+		for (j = 0; j < vertices[i].count; j++)
+			weights[num_weights + j] = mesh->weights[vertices[i].start + j];
+
+		vertices[i].start = num_weights;
+		num_weights += vertices[i].count;
+	}
+
+	memcpy (mesh->vertices, vertices, mesh->num_verts * sizeof (struct md5_vertex_t));
+
+	free (mesh->weights);
+	mesh->weights = weights;
+	mesh->num_weights = num_weights;
+
+	acmr[1] = MD5_VertexCacheACMR (indexes, mesh->num_tris, mesh->num_verts);
+
+	free (oldindexes);
+	free (local);
+	free (vertices);
+
+	return true;
+}
+
@@ -0,0 +1,392 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// md5_weld.c -- welding of MD5 vertex normals by position; this file is common to the GL and software renderers
+
+// vertexes that share a position get the same normal so that the seams where a mesh is split for texturing don't show
+// in the lighting.  positions are hashed into a grid so that each vertex is only compared against the ones near it
+// instead of against every other vertex.  the welding itself is done the same way as the original all-pairs version,
+// one vertex at a time against every later vertex that matches it and in the same order, so with no tolerance the
+// normals come out bit-identical to it.
+
+#include "quakedef.h"
+
+// positions closer than this are welded; 0 = exact match only.  this is a load-time setting.
+cvar_t	r_md5weldtolerance = {"r_md5weldtolerance", "0"};
+
+// keeps the grid coords in range for positions that are huge compared to the tolerance
+#define MD5_WELD_MAXCELL	(1 << 30)
+
+
+/*
+==================
+MD5_WeldMatch
+
+==================
+*/
+static qboolean MD5_WeldMatch (const float *a, const float *b, float tolerance)
+{
+	vec3_t delta;
+
+	// exact compares must stay exact so that the results match the all-pairs weld
+	if (!(tolerance > 0))
+		return (a[0] == b[0] && a[1] == b[1] && a[2] == b[2]);
+
+	VectorSubtract (a, b, delta);
+
+	return (DotProduct (delta, delta) <= tolerance * tolerance);
+}
+
+
+/*
+==================
+MD5_WeldHashPosition
+
+for exact welding; -0 and 0 compare equal so they must hash the same too
+==================
+*/
+static unsigned int MD5_WeldHashPosition (const float *pos)
+{
+	unsigned int hash = 0;
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		unsigned int bits;
+
+		memcpy (&bits, &pos[i], sizeof (bits));
+
+		if (bits == 0x80000000) bits = 0;
+
+		hash = (hash ^ bits) * 16777619;
+	}
+
+	return hash ^ (hash >> 15);
+}
+
+
+/*
+==================
+MD5_WeldHashCell
+
+for welding with a tolerance, where the grid cells are the size of the tolerance
+==================
+*/
+static unsigned int MD5_WeldHashCell (const int *cell)
+{
+	return ((unsigned int) cell[0] * 73856093) ^ ((unsigned int) cell[1] * 19349663) ^ ((unsigned int) cell[2] * 83492791);
+}
+
+
+/*
+==================
+MD5_WeldCell
+
+==================
+*/
+static void MD5_WeldCell (const float *pos, float tolerance, int *cell)
+{
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		double c = floor (pos[i] / tolerance);
+
+		if (c < -MD5_WELD_MAXCELL) c = -MD5_WELD_MAXCELL;
+		if (c > MD5_WELD_MAXCELL) c = MD5_WELD_MAXCELL;
+
+		cell[i] = (int) c;
+	}
+}
+
+
+/*
+==================
+MD5_WeldMatches
+
+gives every vertex in the list the averaged normal of them all; the list must be in vertex order
+==================
+*/
+static void MD5_WeldMatches (vertexnormals_t *vnorms, const int *matches, int nummatches)
+{
+	vec3_t newnormal = {0.0f, 0.0f, 0.0f};
+	int i;
+
+	if (nummatches < 2) return;
+
+	for (i = 0; i < nummatches; i++)
+		VectorAdd (newnormal, vnorms[matches[i]].normal, newnormal);
+
+	VectorNormalize (newnormal);
+
+	for (i = 0; i < nummatches; i++)
+		VectorCopy (newnormal, vnorms[matches[i]].normal);
+}
+
+
+/*
+==================
+MD5_WeldNormals_Reference
+
+the original all-pairs weld; kept for timemd5weld and as the fallback if there's no memory for the grid
+==================
+*/
+void MD5_WeldNormals_Reference (const float *positions, int stride, vertexnormals_t *vnorms, int numverts, float tolerance)
+{
+	int *matches = (int *) malloc (sizeof (int) * numverts);
+	int v, w, nummatches;
+
+	if (!matches) return;
+
+	for (v = 0; v < numverts; v++)
+	{
+		// compute new normal
+		for (w = v, nummatches = 0; w < numverts; w++)
+		{
+			if (MD5_WeldMatch (positions + w * stride, positions + v * stride, tolerance))
+				matches[nummatches++] = w;
+		}
+
+		MD5_WeldMatches (vnorms, matches, nummatches);
+	}
+
+	free (matches);
+}
+
+
+/*
+==================
+MD5_WeldNormals
+
+welds normals for vertexes at the same position, or within tolerance of each other.  positions is the first vertex
+position and stride is in floats.
+==================
+*/
+void MD5_WeldNormals (const float *positions, int stride, vertexnormals_t *vnorms, int numverts, float tolerance)
+{
+	int *heads, *next, *matches;
+	int numbuckets, v, w;
+
+	if (numverts < 2) return;
+
+	// keep the chains short
+	for (numbuckets = 64; numbuckets < numverts * 2; numbuckets <<= 1);
+
+	heads = (int *) malloc (sizeof (int) * numbuckets);
+	next = (int *) malloc (sizeof (int) * numverts);
+	matches = (int *) malloc (sizeof (int) * numverts);
+
+	if (!heads || !next || !matches)
+	{
+		if (heads) free (heads);
+		if (next) free (next);
+		if (matches) free (matches);
+
+		MD5_WeldNormals_Reference (positions, stride, vnorms, numverts, tolerance);
+		return;
+	}
+
+	memset (heads, 0xff, sizeof (int) * numbuckets);
+
+	// link in reverse so that every chain is in vertex order
+	for (v = numverts - 1; v >= 0; v--)
+	{
+		const float *pos = positions + v * stride;
+		unsigned int hash;
+
+		if (tolerance > 0)
+		{
+			int cell[3];
+
+			MD5_WeldCell (pos, tolerance, cell);
+			hash = MD5_WeldHashCell (cell);
+		}
+		else hash = MD5_WeldHashPosition (pos);
+
+		next[v] = heads[hash & (numbuckets - 1)];
+		heads[hash & (numbuckets - 1)] = v;
+	}
+
+	for (v = 0; v < numverts; v++)
+	{
+		const float *pos = positions + v * stride;
+		int nummatches = 0;
+
+		if (tolerance > 0)
+		{
+			int buckets[27], numsearched = 0;
+			int cell[3], search[3];
+			int x, y, z, i, j;
+
+			MD5_WeldCell (pos, tolerance, cell);
+
+			// neighbouring cells may share a bucket so each one is only searched once
+			for (x = -1; x <= 1; x++)
+			{
+				for (y = -1; y <= 1; y++)
+				{
+					for (z = -1; z <= 1; z++)
+					{
+						int bucket;
+
+						search[0] = cell[0] + x;
+						search[1] = cell[1] + y;
+						search[2] = cell[2] + z;
+
+						bucket = MD5_WeldHashCell (search) & (numbuckets - 1);
+
+						for (i = 0; i < numsearched; i++)
+							if (buckets[i] == bucket) break;
+
+						if (i < numsearched) continue;
+
+						buckets[numsearched++] = bucket;
+
+						for (w = heads[bucket]; w != -1; w = next[w])
+						{
+							if (w < v) continue;
+							if (MD5_WeldMatch (positions + w * stride, pos, tolerance)) matches[nummatches++] = w;
+						}
+					}
+				}
+			}
+
+			// put them back in vertex order; there are only ever a few of them
+			for (i = 1; i < nummatches; i++)
+			{
+				int m = matches[i];
+
+				for (j = i; j > 0 && matches[j - 1] > m; j--)
+					matches[j] = matches[j - 1];
+
+				matches[j] = m;
+			}
+		}
+		else
+		{
+			for (w = heads[MD5_WeldHashPosition (pos) & (numbuckets - 1)]; w != -1; w = next[w])
+			{
+				if (w < v) continue;
+				if (MD5_WeldMatch (positions + w * stride, pos, 0)) matches[nummatches++] = w;
+			}
+		}
+
+		MD5_WeldMatches (vnorms, matches, nummatches);
+	}
+
+	free (heads);
+	free (next);
+	free (matches);
+}
+
+
+/*
+==================
+MD5_TimeWeld_f
+
+times the grid weld against the all-pairs weld on a synthetic mesh and checks that they give the same normals
+==================
+*/
+void MD5_TimeWeld_f (void)
+{
+	int numverts = (Cmd_Argc () > 1) ? atoi (Cmd_Argv (1)) : 60000;
+	float tolerance = (Cmd_Argc () > 2) ? atof (Cmd_Argv (2)) : 0;
+	float (*positions)[3];
+	vertexnormals_t *vnorms, *refnorms;
+	double time1, time2, time3;
+	unsigned int seed = 1;
+	int i, j, numdiffs = 0;
+
+	if (numverts < 2)
+	{
+		Con_Printf ("usage : timemd5weld [numverts] [tolerance]\n");
+		return;
+	}
+
+	positions = (float (*)[3]) malloc (sizeof (float) * 3 * numverts);
+	vnorms = (vertexnormals_t *) malloc (sizeof (vertexnormals_t) * numverts);
+	refnorms = (vertexnormals_t *) malloc (sizeof (vertexnormals_t) * numverts);
+
+	if (!positions || !vnorms || !refnorms)
+	{
+		Con_Printf ("timemd5weld : out of memory\n");
+
+		if (positions) free (positions);
+		if (vnorms) free (vnorms);
+		if (refnorms) free (refnorms);
+
+		return;
+	}
+
+	// a third of the vertexes are unique positions and the rest are scattered copies of them, the same as a mesh with
+	// a lot of texture seams; with a tolerance the copies are jittered by up to a quarter of it
+	for (i = 0; i < numverts; i++)
+	{
+		if (i < numverts / 3 || i < 1)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				seed = seed * 1103515245 + 12345;
+				positions[i][j] = (float) ((seed >> 8) & 0xffff) * (1.0f / 64.0f) - 512.0f;
+			}
+		}
+		else
+		{
+			seed = seed * 1103515245 + 12345;
+			VectorCopy (positions[(seed >> 8) % (numverts / 3 > 0 ? numverts / 3 : 1)], positions[i]);
+
+			for (j = 0; j < 3 && tolerance > 0; j++)
+			{
+				seed = seed * 1103515245 + 12345;
+				positions[i][j] += ((float) ((seed >> 8) & 0xffff) / 65535.0f - 0.5f) * tolerance * 0.25f;
+			}
+		}
+
+		for (j = 0; j < 3; j++)
+		{
+			seed = seed * 1103515245 + 12345;
+			vnorms[i].normal[j] = (float) ((seed >> 8) & 0xffff) / 32767.5f - 1.0f;
+		}
+
+		VectorNormalize (vnorms[i].normal);
+		vnorms[i].numnormals = 1;
+	}
+
+	memcpy (refnorms, vnorms, sizeof (vertexnormals_t) * numverts);
+
+	Con_Printf ("welding %i vertexes, tolerance %g...\n", numverts, tolerance);
+
+	time1 = Sys_FloatTime ();
+	MD5_WeldNormals_Reference (positions[0], 3, refnorms, numverts, tolerance);
+	time2 = Sys_FloatTime ();
+	MD5_WeldNormals (positions[0], 3, vnorms, numverts, tolerance);
+	time3 = Sys_FloatTime ();
+
+	for (i = 0; i < numverts; i++)
+		if (memcmp (vnorms[i].normal, refnorms[i].normal, sizeof (vnorms[i].normal))) numdiffs++;
+
+	Con_Printf ("all pairs %.2f ms, grid %.2f ms (%.1fx), %i normals differ\n", (time2 - time1) * 1000.0, (time3 - time2) * 1000.0,
+		(time3 > time2) ? (time2 - time1) / (time3 - time2) : 0.0, numdiffs);
+
+	free (positions);
+	free (vnorms);
+	free (refnorms);
+}
+
@@ -27,7 +27,55 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 extern model_t *loadmodel;
 
-#define _alloca16(x) ((void *) ((((int) _alloca ((x) + 15)) + 15) & ~15))
+cvar_t r_md5cache = {"r_md5cache", "1"};
+cvar_t r_md5animcompress = {"r_md5animcompress", "0"};
+
+extern cvar_t r_md5weldtolerance;
+
+#define _alloca16(x) ((void *) ((((size_t) _alloca ((x) + 15)) + 15) & ~(size_t) 15))
+
+// time spent in each stage of loading from the source files, added to on every load; benchmd5 clears and reports them
+typedef enum {MD5_STAGE_READ, MD5_STAGE_PARSE, MD5_STAGE_PACK, MD5_STAGE_VCACHE, MD5_STAGE_CULLBOXES, MD5_STAGE_NORMALS, MD5_STAGE_SKINSTREAM, MD5_STAGE_LODS, MD5_NUM_STAGES} md5stage_t;
+
+static double md5_stagetimes[MD5_NUM_STAGES];
+
+// size of the source files that were parsed, for the parse rate
+static int md5_sourcebytes;
+static char *md5_stagenames[MD5_NUM_STAGES] = {"file read + crc", "parsing", "packing", "vertex cache", "cullboxes", "normals + weld", "skin stream", "levels of detail"};
+
+
+/*
+==================
+MD5_StageTime
+
+loads on the loader thread aren't timed, as Sys_FloatTime isn't safe to call from there
+==================
+*/
+static double MD5_StageTime (void)
+{
+	return MD5_OnLoaderThread () ? 0 : Sys_FloatTime ();
+}
+
+
+/*
+==================
+MD5_EndStage
+
+adds the time since start to a load stage and returns the time now, which is the start of the next stage
+==================
+*/
+static double MD5_EndStage (md5stage_t stage, double start)
+{
+	double now;
+
+	if (MD5_OnLoaderThread ()) return 0;
+
+	now = Sys_FloatTime ();
+
+	md5_stagetimes[stage] += now - start;
+
+	return now;
+}
 
 
 static qboolean R_FaceNegativePolarity (struct md5_mesh_t *mesh, int trinum)
@@ -103,12 +151,12 @@ static void	R_DuplicateMirroredVertexes (struct md5_mesh_t *mesh)
 	}
 
 	// these are unused in the current implementation and we could save some memory by just not setting them up
-	mesh->mirrored_vertices = (int *) Hunk_Alloc (mesh->num_mirrored_verts * sizeof (int));
+	mesh->mirrored_vertices = (int *) MD5_HunkAlloc (mesh->num_mirrored_verts * sizeof (int));
 
 	// this leaks the original mesh->vertices; since they're on hunk, Host_ClearMemory will free the leaked memory between maps anyway, but a more robust
 	// implementation might allocate mesh->vertices in temporary memory and memcpy it over above if addtional verts are not needed.
 	oldverts = mesh->vertices;
-	mesh->vertices = (struct md5_vertex_t *) Hunk_Alloc (totalVerts * sizeof (struct md5_vertex_t));
+	mesh->vertices = (struct md5_vertex_t *) MD5_HunkAlloc (totalVerts * sizeof (struct md5_vertex_t));
 	memcpy (mesh->vertices, oldverts, mesh->num_verts * sizeof (struct md5_vertex_t));
 
 	// create the duplicates
@@ -157,10 +205,10 @@ MD5_BuildBaseNormals
 void MD5_BuildBaseNormals (md5header_t *hdr, struct md5_mesh_t *mesh)
 {
 	// allocate memory for vertexes
-	md5polyvert_t *vertexes = (md5polyvert_t *) Hunk_Alloc (sizeof (md5polyvert_t) * mesh->num_verts);
+	md5polyvert_t *vertexes = (md5polyvert_t *) MD5_HunkAlloc (sizeof (md5polyvert_t) * mesh->num_verts);
 
 	// allocate memory for normals
-	vertexnormals_t *vnorms = (vertexnormals_t *) Hunk_Alloc (sizeof (vertexnormals_t) * mesh->num_verts);
+	vertexnormals_t *vnorms = (vertexnormals_t *) MD5_HunkAlloc (sizeof (vertexnormals_t) * mesh->num_verts);
 
 	// get rhe rest of the data we need
 	const struct md5_joint_t *skeleton = hdr->md5mesh.baseSkel;
@@ -236,11 +284,9 @@ void MD5_BuildBaseNormals (md5header_t *hdr, struct md5_mesh_t *mesh)
 		}
 	}
 
-	// calculate final normals
+	// calculate final normals; these stay in object space for the base frame, which is the space the skin stream works in
 	for (i = 0; i < mesh->num_verts; i++)
 	{
-		vec3_t finalNormal = {0.0f, 0.0f, 0.0f};
-
 		// numnormals was checked for > 0 in modelgen.c so we shouldn't need to do it again 
 		// here but we do anyway just in case a rogue modder has used a bad modelling tool
 		if (vnorms[i].numnormals > 0)
@@ -253,27 +299,6 @@ void MD5_BuildBaseNormals (md5header_t *hdr, struct md5_mesh_t *mesh)
 			vnorms[i].normal[0] = vnorms[i].normal[1] = 0;
 			vnorms[i].normal[2] = 1;
 		}
-
-		// this normal is now in object space for the base frame so rotate it back to joint-local space
-		for (j = 0; j < mesh->vertices[i].count; j++)
-		{
-			const struct md5_weight_t *weight = &mesh->weights[mesh->vertices[i].start + j];
-			const struct md5_joint_t *joint = &skeleton[weight->joint];
-
-			// Calculate transformed normal for this weight - inverse rotate it back to joint-local space
-			vec3_t wv;
-			Quat_inverseRotatePoint (joint->orient, vnorms[i].normal, wv);
-
-			// The sum of all weight->bias should be 1.0
-			finalNormal[0] += wv[0] * weight->bias;
-			finalNormal[1] += wv[1] * weight->bias;
-			finalNormal[2] += wv[2] * weight->bias;
-		}
-
-		// store out the final normal in joint-local space
-		vnorms[i].normal[0] = finalNormal[0];
-		vnorms[i].normal[1] = finalNormal[1];
-		vnorms[i].normal[2] = finalNormal[2];
 	}
 
 	// store the vertexes and normals out in the MD5 header now
@@ -282,55 +307,201 @@ void MD5_BuildBaseNormals (md5header_t *hdr, struct md5_mesh_t *mesh)
 }
 
 
-void MD5_WeldNormals (md5header_t *hdr)
+/*
+==================
+MD5_WeldBaseNormals
+
+==================
+*/
+static void MD5_WeldBaseNormals (md5header_t *hdr, float tolerance)
+{
+	MD5_WeldNormals (hdr->vertexes[0].position, sizeof (md5polyvert_t) / sizeof (float), hdr->vnorms, hdr->md5mesh.meshes[0].num_verts, tolerance);
+}
+
+
+/*
+==================
+MD5_ReadMesh
+
+reads a mesh { } block once the { has been read
+==================
+*/
+static qboolean MD5_ReadMesh (md5lexer_t *lex, struct md5_mesh_t *mesh, int num_joints)
 {
-	md5polyvert_t
-		* pervert
-	,	* vert
-		;
-	int
-		v
-	,	w
-	,	numverts
-	,	numnormals
-		;
+	int index, idata[3];
+	int i;
 
-	// weld all normals per vertex position
-	numverts = hdr->md5mesh.meshes[0].num_verts;
-	for (pervert = hdr->vertexes, v = 0 ; v < numverts ; v++, pervert++)
+	// numweights comes after the verts, so the vert that goes furthest into the weights is checked at the end
+	int endweight = 0, endweightvert = -1, endweightline = 0;
+
+	while (MD5_LexNext (lex))
 	{
-		vec3_t
-			newnormal = {0.0f, 0.0f, 0.0f}
-			;
-		numnormals = 0;
+		if (MD5_LexIs (lex, "}"))
+		{
+			if (endweight > mesh->num_weights)
+			{
+				struct md5_vertex_t *vert = &mesh->vertices[endweightvert];
+
+				// report it on the vert's line
+				lex->tokenline = endweightline;
+				MD5_LexError (lex, "vert %i uses weights %i to %i, but there are only %i", endweightvert, vert->start,
+					vert->start + vert->count - 1, mesh->num_weights);
+				return false;
+			}
+
+			return true;
+		}
+		else if (MD5_LexIs (lex, "shader"))
+		{
+			if (!MD5_LexString (lex, mesh->shader, sizeof (mesh->shader))) return false;
+		}
+		else if (MD5_LexIs (lex, "numverts"))
+		{
+			if (!MD5_LexInt (lex, &mesh->num_verts)) return false;
 
-		// compute new normal
-		for (vert = pervert, w = v ; w < numverts ; w++, vert++)
+			// any verts that were read before are gone
+			endweight = 0;
+			endweightvert = -1;
+
+			if (mesh->num_verts < 0)
+			{
+				MD5_LexError (lex, "bad numverts %i", mesh->num_verts);
+				return false;
+			}
+			else if (mesh->num_verts > 0)
+			{
+				// Allocate memory for vertices
+				mesh->vertices = (struct md5_vertex_t *) MD5_HunkAlloc (sizeof (struct md5_vertex_t) * mesh->num_verts);
+			}
+		}
+		else if (MD5_LexIs (lex, "numtris"))
+		{
+			if (!MD5_LexInt (lex, &mesh->num_tris)) return false;
+
+			if (mesh->num_tris < 0)
+			{
+				MD5_LexError (lex, "bad numtris %i", mesh->num_tris);
+				return false;
+			}
+			else if (mesh->num_tris > 0)
+			{
+				// Allocate memory for triangles
+				mesh->triangles = (mtriangle_t *) MD5_HunkAlloc (sizeof (mtriangle_t) * mesh->num_tris);
+			}
+		}
+		else if (MD5_LexIs (lex, "numweights"))
+		{
+			if (!MD5_LexInt (lex, &mesh->num_weights)) return false;
+
+			if (mesh->num_weights < 0)
+			{
+				MD5_LexError (lex, "bad numweights %i", mesh->num_weights);
+				return false;
+			}
+			else if (mesh->num_weights > 0)
+			{
+				// Allocate memory for vertex weights
+				mesh->weights = (struct md5_weight_t *) MD5_HunkAlloc (sizeof (struct md5_weight_t) * mesh->num_weights);
+			}
+		}
+		else if (MD5_LexIs (lex, "vert"))
 		{
-			if (vert->position[0] == pervert->position[0] &&
-				vert->position[1] == pervert->position[1] &&
-				vert->position[2] == pervert->position[2])
+			struct md5_vertex_t *vert;
+
+			if (!MD5_LexInt (lex, &index)) return false;
+
+			if (index < 0 || index >= mesh->num_verts)
+			{
+				MD5_LexError (lex, "vert %i is out of range", index);
+				return false;
+			}
+
+			// Copy vertex data
+			vert = &mesh->vertices[index];
+
+			if (!MD5_LexVector (lex, vert->st, 2)) return false;
+			if (!MD5_LexInt (lex, &vert->start)) return false;
+
+			if (vert->start < 0)
+			{
+				MD5_LexError (lex, "vert %i starts at weight %i, which is out of range", index, vert->start);
+				return false;
+			}
+
+			if (!MD5_LexInt (lex, &vert->count)) return false;
+
+			if (vert->count < 0 || vert->count > 0x7fffffff - vert->start)
+			{
+				MD5_LexError (lex, "vert %i has a bad weight count %i", index, vert->count);
+				return false;
+			}
+
+			if (vert->start + vert->count > endweight)
 			{
-				VectorAdd (newnormal, hdr->vnorms[w].normal, newnormal);
-				numnormals++;
+				endweight = vert->start + vert->count;
+				endweightvert = index;
+				endweightline = lex->tokenline;
 			}
 		}
-		if (numnormals > 1)
+		else if (MD5_LexIs (lex, "tri"))
 		{
-			VectorNormalize (newnormal);
+			if (!MD5_LexInt (lex, &index)) return false;
+
+			if (index < 0 || index >= mesh->num_tris)
+			{
+				MD5_LexError (lex, "tri %i is out of range", index);
+				return false;
+			}
 
-			// iterate again, applying the new normal to all corresponding vertices
-			for (vert = pervert, w = v ; w < numverts ; w++, vert++)
+			for (i = 0; i < 3; i++)
 			{
-				if (vert->position[0] == pervert->position[0] &&
-					vert->position[1] == pervert->position[1] &&
-					vert->position[2] == pervert->position[2])
+				if (!MD5_LexInt (lex, &idata[i])) return false;
+
+				if (idata[i] < 0 || idata[i] >= mesh->num_verts)
 				{
-					VectorCopy (newnormal, hdr->vnorms[w].normal);
+					MD5_LexError (lex, "tri %i uses vert %i, which is out of range", index, idata[i]);
+					return false;
 				}
 			}
+
+			// Copy triangle data
+			mesh->triangles[index].vertindex[0] = idata[0];
+			mesh->triangles[index].vertindex[1] = idata[1];
+			mesh->triangles[index].vertindex[2] = idata[2];
+			mesh->triangles[index].facesfront = 0; // always for MD5s
+		}
+		else if (MD5_LexIs (lex, "weight"))
+		{
+			struct md5_weight_t *weight;
+
+			if (!MD5_LexInt (lex, &index)) return false;
+
+			if (index < 0 || index >= mesh->num_weights)
+			{
+				MD5_LexError (lex, "weight %i is out of range", index);
+				return false;
+			}
+
+			// Copy weight data
+			weight = &mesh->weights[index];
+
+			if (!MD5_LexInt (lex, &weight->joint)) return false;
+
+			if (weight->joint < 0 || weight->joint >= num_joints)
+			{
+				MD5_LexError (lex, "weight %i uses joint %i, which is out of range", index, weight->joint);
+				return false;
+			}
+
+			if (!MD5_LexFloat (lex, &weight->bias)) return false;
+			if (!MD5_LexVector (lex, weight->pos, 3)) return false;
 		}
+		else MD5_LexSkipLine (lex);
 	}
+
+	MD5_LexError (lex, "unexpected end of file in mesh");
+
+	return false;
 }
 
 
@@ -338,157 +509,110 @@ void MD5_WeldNormals (md5header_t *hdr)
 ==================
 MD5_ReadMeshFile
 
+statements that aren't used are skipped, and anything that doesn't parse fails the load with an error giving the line
 ==================
 */
-static int MD5_ReadMeshFile (char *filename, struct md5_model_t *mdl)
+static int MD5_ReadMeshFile (char *filename, char *data, struct md5_model_t *mdl)
 {
+	md5lexer_t lex;
 	int version;
 	int curr_mesh = 0;
 	int i;
 
-	// we need to preserve the base pointer so we can free it properly after loading
-	char *basedata = (char *) COM_LoadMallocFile (filename);
-	char *data = basedata;
-
-	if (!data)
-	{
-		Con_DPrintf ("MD5_ReadMeshFile : couldn't open \"%s\"!\n", filename);
-		return 0;
-	}
+	MD5_LexInit (&lex, filename, data, 1);
 
-	// Read whole line
-	while ((data = COM_ParseLine (data)) != NULL)
+	while (MD5_LexNext (&lex))
 	{
-		if (sscanf (com_token, " MD5Version %d", &version) == 1)
+		if (MD5_LexIs (&lex, "MD5Version"))
 		{
+			if (!MD5_LexInt (&lex, &version)) break;
+
 			if (version != 10)
 			{
 				// Bad version
-				Con_DPrintf ("MD5_ReadMeshFile : bad model version for \"%s\"\n", filename);
-				free (basedata);
-				return 0;
+				MD5_LexError (&lex, "bad model version %i", version);
+				break;
 			}
 		}
-		else if (sscanf (com_token, " numJoints %d", &mdl->num_joints) == 1)
+		else if (MD5_LexIs (&lex, "numJoints"))
 		{
-			if (mdl->num_joints > 0)
+			if (!MD5_LexInt (&lex, &mdl->num_joints)) break;
+
+			if (mdl->num_joints < 0 || mdl->num_joints > MAX_MD5_JOINTS)
+			{
+				// the skin stream stores joint indexes as bytes
+				MD5_LexError (&lex, "%i joints, the most is %i", mdl->num_joints, MAX_MD5_JOINTS);
+				break;
+			}
+			else if (mdl->num_joints > 0)
 			{
 				// Allocate memory for base skeleton joints
-				mdl->baseSkel = (struct md5_joint_t *) Hunk_Alloc (mdl->num_joints * sizeof (struct md5_joint_t));
+				mdl->baseSkel = (struct md5_joint_t *) MD5_HunkAlloc (mdl->num_joints * sizeof (struct md5_joint_t));
 			}
 		}
-		else if (sscanf (com_token, " numMeshes %d", &mdl->num_meshes) == 1)
+		else if (MD5_LexIs (&lex, "numMeshes"))
 		{
-			if (mdl->num_meshes > 0)
+			if (!MD5_LexInt (&lex, &mdl->num_meshes)) break;
+
+			if (mdl->num_meshes < 0)
+			{
+				MD5_LexError (&lex, "bad numMeshes %i", mdl->num_meshes);
+				break;
+			}
+			else if (mdl->num_meshes > 0)
 			{
 				// Allocate memory for meshes
-				mdl->meshes = (struct md5_mesh_t *) Hunk_Alloc (mdl->num_meshes * sizeof (struct md5_mesh_t));
+				mdl->meshes = (struct md5_mesh_t *) MD5_HunkAlloc (mdl->num_meshes * sizeof (struct md5_mesh_t));
 			}
 		}
-		else if (strncmp (com_token, "joints {", 8) == 0)
+		else if (MD5_LexIs (&lex, "joints"))
 		{
+			if (!MD5_LexExpect (&lex, "{")) break;
+
 			// Read each joint
 			for (i = 0; i < mdl->num_joints; i++)
 			{
 				struct md5_joint_t *joint = &mdl->baseSkel[i];
 
-				// Read whole line
-				if ((data = COM_ParseLine (data)) == NULL) { free (basedata); return 0; }
+				if (!MD5_LexString (&lex, joint->name, sizeof (joint->name))) break;
+				if (!MD5_LexInt (&lex, &joint->parent)) break;
+				if (!MD5_LexVector (&lex, joint->pos, 3)) break;
+				if (!MD5_LexVector (&lex, joint->orient, 3)) break;
 
-				if (sscanf (com_token, "%s %d ( %f %f %f ) ( %f %f %f )", joint->name, &joint->parent, &joint->pos[0], &joint->pos[1], &joint->pos[2], &joint->orient[0], &joint->orient[1], &joint->orient[2]) == 8)
+				if (joint->parent < -1 || joint->parent >= mdl->num_joints)
 				{
-					// Compute the w component
-					Quat_computeW (joint->orient);
+					MD5_LexError (&lex, "joint %i has parent %i, which is out of range", i, joint->parent);
+					break;
 				}
+
+				// Compute the w component
+				Quat_computeW (joint->orient);
 			}
+
+			if (!MD5_LexExpect (&lex, "}")) break;
 		}
-		else if (strncmp (com_token, "mesh {", 6) == 0)
+		else if (MD5_LexIs (&lex, "mesh"))
 		{
-			struct md5_mesh_t *mesh = &mdl->meshes[curr_mesh];
-			int vert_index = 0;
-			int tri_index = 0;
-			int weight_index = 0;
-			float fdata[4];
-			int idata[3];
-
-			while (com_token[0] != '}')
+			if (curr_mesh >= mdl->num_meshes)
 			{
-				// Read whole line
-				if ((data = COM_ParseLine (data)) == NULL) break;
-
-				if (strstr (com_token, "shader "))
-				{
-					int quote = 0, j = 0;
-
-					// Copy the shader name whithout the quote marks
-					for (i = 0; i < strlen (com_token) && (quote < 2); i++)
-					{
-						if (com_token[i] == '\"')
-							quote++;
-
-						if ((quote == 1) && (com_token[i] != '\"'))
-						{
-							mesh->shader[j] = com_token[i];
-							j++;
-						}
-					}
-				}
-				else if (sscanf (com_token, " numverts %d", &mesh->num_verts) == 1)
-				{
-					if (mesh->num_verts > 0)
-					{
-						// Allocate memory for vertices
-						mesh->vertices = (struct md5_vertex_t *) Hunk_Alloc (sizeof (struct md5_vertex_t) * mesh->num_verts);
-					}
-				}
-				else if (sscanf (com_token, " numtris %d", &mesh->num_tris) == 1)
-				{
-					if (mesh->num_tris > 0)
-					{
-						// Allocate memory for triangles
-						mesh->triangles = (mtriangle_t *) Hunk_Alloc (sizeof (mtriangle_t) * mesh->num_tris);
-					}
-				}
-				else if (sscanf (com_token, " numweights %d", &mesh->num_weights) == 1)
-				{
-					if (mesh->num_weights > 0)
-					{
-						// Allocate memory for vertex weights
-						mesh->weights = (struct md5_weight_t *) Hunk_Alloc (sizeof (struct md5_weight_t) * mesh->num_weights);
-					}
-				}
-				else if (sscanf (com_token, " vert %d ( %f %f ) %d %d", &vert_index, &fdata[0], &fdata[1], &idata[0], &idata[1]) == 5)
-				{
-					// Copy vertex data
-					mesh->vertices[vert_index].st[0] = fdata[0];
-					mesh->vertices[vert_index].st[1] = fdata[1];
-					mesh->vertices[vert_index].start = idata[0];
-					mesh->vertices[vert_index].count = idata[1];
-				}
-				else if (sscanf (com_token, " tri %d %d %d %d", &tri_index, &idata[0], &idata[1], &idata[2]) == 4)
-				{
-					// Copy triangle data
-					mesh->triangles[tri_index].vertindex[0] = idata[0];
-					mesh->triangles[tri_index].vertindex[1] = idata[1];
-					mesh->triangles[tri_index].vertindex[2] = idata[2];
-					mesh->triangles[tri_index].facesfront = 0; // always for MD5s
-				}
-				else if (sscanf (com_token, " weight %d %d %f ( %f %f %f )", &weight_index, &idata[0], &fdata[3], &fdata[0], &fdata[1], &fdata[2]) == 6)
-				{
-					// Copy vertex data
-					mesh->weights[weight_index].joint = idata[0];
-					mesh->weights[weight_index].bias = fdata[3];
-					mesh->weights[weight_index].pos[0] = fdata[0];
-					mesh->weights[weight_index].pos[1] = fdata[1];
-					mesh->weights[weight_index].pos[2] = fdata[2];
-				}
+				MD5_LexError (&lex, "more meshes than numMeshes");
+				break;
 			}
 
+			if (!MD5_LexExpect (&lex, "{")) break;
+			if (!MD5_ReadMesh (&lex, &mdl->meshes[curr_mesh], mdl->num_joints)) break;
+
 			curr_mesh++;
 		}
+		else MD5_LexSkipLine (&lex);
+	}
+
+	if (lex.error)
+	{
+		MD5_DPrintf ("MD5_ReadMeshFile : %s\n", lex.errormsg);
+		return 0;
 	}
 
-	free (basedata);
 	return 1;
 }
 
@@ -500,7 +624,7 @@ MD5_BuildFrameSkeleton
 Build skeleton for a given frame data.
 ==================
 */
-static void MD5_BuildFrameSkeleton (const struct joint_info_t *jointInfos, const struct baseframe_joint_t *baseFrame, const float *animFrameData, struct md5_joint_t *skelFrame, int num_joints)
+static void MD5_BuildFrameSkeleton (const struct joint_info_t *jointInfos, const struct baseframe_joint_t *baseFrame, const float *animFrameData, struct md5_pose_t *skelFrame, int num_joints)
 {
 	int i;
 
@@ -555,21 +679,20 @@ static void MD5_BuildFrameSkeleton (const struct joint_info_t *jointInfos, const
 
 		// NOTE: we assume that this joint's parent has already been calculated, i.e. joint's ID should never be smaller than its parent ID.
 		{
-		struct md5_joint_t *thisJoint = &skelFrame[i];
+		struct md5_pose_t *thisJoint = &skelFrame[i];
 
+		// the name and parent stay in the hierarchy
 		int parent = jointInfos[i].parent;
-		thisJoint->parent = parent;
-		strcpy (thisJoint->name, jointInfos[i].name);
 
 		// Has parent?
-		if (thisJoint->parent < 0)
+		if (parent < 0)
 		{
 			memcpy (thisJoint->pos, animatedPos, sizeof (vec3_t));
 			memcpy (thisJoint->orient, animatedOrient, sizeof (quat4_t));
 		}
 		else
 		{
-			struct md5_joint_t *parentJoint = &skelFrame[parent];
+			struct md5_pose_t *parentJoint = &skelFrame[parent];
 			vec3_t rpos; // Rotated position
 
 			// Add positions
@@ -587,163 +710,645 @@ static void MD5_BuildFrameSkeleton (const struct joint_info_t *jointInfos, const
 }
 
 
+typedef struct md5animparse_s
+{
+	struct md5_anim_t *anim;
+	const struct baseframe_joint_t *baseFrame;
+	char *filename;
+
+	// the start of each frame's components in the file and the line it's on, or NULL for frames that weren't in it
+	char **frameblocks;
+	int *framelines;
+
+	// components for every frame
+	float *framedata;
+
+	// set if a frame didn't parse; nothing is printed from the parse threads
+	volatile int failed;
+	qboolean report;
+} md5animparse_t;
+
+
+/*
+==================
+MD5_ParseAnimFrames
+
+parses the animated components of a range of frames and builds their skeletons; run by MD5_RunSplit
+==================
+*/
+static void MD5_ParseAnimFrames (void *data, int first, int count)
+{
+	md5animparse_t *parse = (md5animparse_t *) data;
+	struct md5_anim_t *anim = parse->anim;
+	md5lexer_t lex;
+	int frame_index;
+	int i;
+
+	for (frame_index = first; frame_index < first + count; frame_index++)
+	{
+		float *animFrameData = parse->framedata + frame_index * anim->num_components;
+
+		if (!parse->frameblocks[frame_index]) continue;
+
+		MD5_LexInit (&lex, parse->filename, parse->frameblocks[frame_index], parse->framelines[frame_index]);
+
+		// Read frame data
+		for (i = 0; i < anim->num_components; i++)
+		{
+			if (!MD5_LexFloat (&lex, &animFrameData[i]))
+			{
+				if (parse->report) MD5_DPrintf ("MD5_ReadAnimFile : %s\n", lex.errormsg);
+
+				parse->failed = 1;
+				return;
+			}
+		}
+
+		if (!MD5_LexExpect (&lex, "}"))
+		{
+			if (parse->report) MD5_DPrintf ("MD5_ReadAnimFile : %s\n", lex.errormsg);
+
+			parse->failed = 1;
+			return;
+		}
+
+		// Build frame skeleton from the collected data
+		MD5_BuildFrameSkeleton (anim->hierarchy, parse->baseFrame, animFrameData, anim->skelFrames[frame_index], anim->num_joints);
+	}
+}
+
+
 /*
 ==================
 MD5_ReadAnimFile
 
-Load an MD5 animation from file.
+Load an MD5 animation from file.  if rawframes is given the frame skeletons are built in temp memory and the animated
+components for all frames are kept there for MD5_PackAnimation; the caller frees both.
+
+frames are independent of each other once the hierarchy and baseframe are known, so the file is read in two passes:
+the first just finds where each frame block starts, and the second parses them and builds their skeletons spread over
+the parse threads.  each frame is parsed from the same text and built the same way as it would be in order.
 ==================
 */
-static int MD5_ReadAnimFile (char *filename, struct md5_anim_t *anim)
+static int MD5_ReadAnimFile (char *filename, char *data, struct md5_anim_t *anim, float **rawframes)
 {
+	md5animparse_t parse;
+	md5lexer_t lex;
 	struct joint_info_t *jointInfos = NULL;
 	struct baseframe_joint_t *baseFrame = NULL;
-	float *animFrameData = NULL;
 	int version;
-	int numAnimatedComponents;
 	int frame_index;
 	int i;
 
-	// we need to preserve the base pointer so we can free it properly after loading
-	char *basedata = (char *) COM_LoadMallocFile (filename);
-	char *data = basedata;
-
-	if (!data)
-	{
-		Con_DPrintf ("error: couldn't open \"%s\"!\n", filename);
-		return 0;
-	}
+	memset (&parse, 0, sizeof (parse));
+	MD5_LexInit (&lex, filename, data, 1);
 
-	// Read whole line
-	while ((data = COM_ParseLine (data)) != NULL)
+	while (MD5_LexNext (&lex))
 	{
-		if (sscanf (com_token, " MD5Version %d", &version) == 1)
+		if (MD5_LexIs (&lex, "MD5Version"))
 		{
+			if (!MD5_LexInt (&lex, &version)) break;
+
 			if (version != 10)
 			{
 				// Bad version
-				Con_DPrintf ("Error: bad animation version for \"%s\"\n", filename);
-				free (basedata);
-				return 0;
+				MD5_LexError (&lex, "bad animation version %i", version);
+				break;
 			}
 		}
-		else if (sscanf (com_token, " numFrames %d", &anim->num_frames) == 1)
+		else if (MD5_LexIs (&lex, "numFrames"))
 		{
+			if (!MD5_LexInt (&lex, &anim->num_frames)) break;
+
+			if (anim->num_frames < 0 || parse.frameblocks)
+			{
+				MD5_LexError (&lex, "bad numFrames %i", anim->num_frames);
+				break;
+			}
+
 			// Allocate memory for skeleton frames and bounding boxes
 			if (anim->num_frames > 0)
 			{
-				anim->skelFrames = (struct md5_joint_t **) Hunk_Alloc (sizeof (struct md5_joint_t *) * anim->num_frames);
-				anim->bboxes = (struct md5_bbox_t *) Hunk_Alloc (sizeof (struct md5_bbox_t) * anim->num_frames);
+				if (rawframes)
+					anim->skelFrames = (struct md5_pose_t **) calloc (anim->num_frames, sizeof (struct md5_pose_t *));
+				else anim->skelFrames = (struct md5_pose_t **) MD5_HunkAlloc (sizeof (struct md5_pose_t *) * anim->num_frames);
+
+				anim->bboxes = (struct md5_bbox_t *) MD5_HunkAlloc (sizeof (struct md5_bbox_t) * anim->num_frames);
+
+				parse.frameblocks = (char **) calloc (anim->num_frames, sizeof (char *));
+				parse.framelines = (int *) calloc (anim->num_frames, sizeof (int));
 			}
 		}
-		else if (sscanf (com_token, " numJoints %d", &anim->num_joints) == 1)
+		else if (MD5_LexIs (&lex, "numJoints"))
 		{
-			if (anim->num_joints > 0)
+			if (!MD5_LexInt (&lex, &anim->num_joints)) break;
+
+			if (anim->num_joints < 0 || anim->hierarchy)
+			{
+				MD5_LexError (&lex, "bad numJoints %i", anim->num_joints);
+				break;
+			}
+
+			if (anim->num_joints > 0 && rawframes)
+			{
+				// all frames go in a single block of temp memory
+				if (anim->num_frames > 0)
+					anim->skelFrames[0] = (struct md5_pose_t *) malloc (sizeof (struct md5_pose_t) * anim->num_joints * anim->num_frames);
+
+				for (i = 1; i < anim->num_frames; i++)
+					anim->skelFrames[i] = anim->skelFrames[0] + i * anim->num_joints;
+			}
+			else if (anim->num_joints > 0)
 			{
 				for (i = 0; i < anim->num_frames; i++)
 				{
 					// Allocate memory for joints of each frame
-					anim->skelFrames[i] = (struct md5_joint_t *) Hunk_Alloc (sizeof (struct md5_joint_t) * anim->num_joints);
+					anim->skelFrames[i] = (struct md5_pose_t *) MD5_HunkAlloc (sizeof (struct md5_pose_t) * anim->num_joints);
 				}
+			}
+
+			if (anim->num_joints > 0)
+			{
+				// the joint infos are kept as the hierarchy for all frames
+				jointInfos = anim->hierarchy = (struct joint_info_t *) MD5_HunkAlloc (sizeof (struct joint_info_t) * anim->num_joints);
 
 				// Allocate temporary memory for building skeleton frames
-				jointInfos = (struct joint_info_t *) Hunk_Alloc (sizeof (struct joint_info_t) * anim->num_joints);
-				baseFrame = (struct baseframe_joint_t *) Hunk_Alloc (sizeof (struct baseframe_joint_t) * anim->num_joints);
+				baseFrame = (struct baseframe_joint_t *) MD5_HunkAlloc (sizeof (struct baseframe_joint_t) * anim->num_joints);
 			}
 		}
-		else if (sscanf (com_token, " frameRate %d", &anim->frameRate) == 1)
-			; // unused in this code
-		else if (sscanf (com_token, " numAnimatedComponents %d", &numAnimatedComponents) == 1)
+		else if (MD5_LexIs (&lex, "frameRate"))
+		{
+			// unused in this code
+			if (!MD5_LexInt (&lex, &anim->frameRate)) break;
+		}
+		else if (MD5_LexIs (&lex, "numAnimatedComponents"))
 		{
-			if (numAnimatedComponents > 0)
+			if (!MD5_LexInt (&lex, &anim->num_components)) break;
+
+			// a joint animates at most 6 components, which is all a packed frame is unpacked into
+			if (anim->num_components < 0 || anim->num_components > MAX_MD5_JOINTS * 6)
 			{
-				// Allocate memory for animation frame data
-				animFrameData = (float *) Hunk_Alloc (sizeof (float) * numAnimatedComponents);
+				MD5_LexError (&lex, "bad numAnimatedComponents %i", anim->num_components);
+				break;
 			}
 		}
-		else if (strncmp (com_token, "hierarchy {", 11) == 0)
+		else if (MD5_LexIs (&lex, "hierarchy"))
 		{
+			if (!MD5_LexExpect (&lex, "{")) break;
+
 			for (i = 0; i < anim->num_joints; i++)
 			{
-				// Read whole line
-				if ((data = COM_ParseLine (data)) == NULL) { free (basedata); return 0; }
-
 				// Read joint info
-				sscanf (com_token, " %s %d %d %d", jointInfos[i].name, &jointInfos[i].parent, &jointInfos[i].flags, &jointInfos[i].startIndex);
+				if (!MD5_LexString (&lex, jointInfos[i].name, sizeof (jointInfos[i].name))) break;
+				if (!MD5_LexInt (&lex, &jointInfos[i].parent)) break;
+				if (!MD5_LexInt (&lex, &jointInfos[i].flags)) break;
+				if (!MD5_LexInt (&lex, &jointInfos[i].startIndex)) break;
+
+				// joints are built after their parents
+				if (jointInfos[i].parent < -1 || jointInfos[i].parent >= i)
+					MD5_LexError (&lex, "joint %i has parent %i, which is out of range", i, jointInfos[i].parent);
 			}
+
+			if (!MD5_LexExpect (&lex, "}")) break;
 		}
-		else if (strncmp (com_token, "bounds {", 8) == 0)
+		else if (MD5_LexIs (&lex, "bounds"))
 		{
+			if (!MD5_LexExpect (&lex, "{")) break;
+
 			for (i = 0; i < anim->num_frames; i++)
 			{
-				// Read whole line
-				if ((data = COM_ParseLine (data)) == NULL) { free (basedata); return 0; }
-
 				// Read bounding box
-				sscanf (com_token, " ( %f %f %f ) ( %f %f %f )", &anim->bboxes[i].min[0], &anim->bboxes[i].min[1], &anim->bboxes[i].min[2], &anim->bboxes[i].max[0], &anim->bboxes[i].max[1], &anim->bboxes[i].max[2]);
+				if (!MD5_LexVector (&lex, anim->bboxes[i].min, 3)) break;
+				if (!MD5_LexVector (&lex, anim->bboxes[i].max, 3)) break;
 			}
+
+			if (!MD5_LexExpect (&lex, "}")) break;
 		}
-		else if (strncmp (com_token, "baseframe {", 10) == 0)
+		else if (MD5_LexIs (&lex, "baseframe"))
 		{
+			if (!MD5_LexExpect (&lex, "{")) break;
+
 			for (i = 0; i < anim->num_joints; i++)
 			{
-				// Read whole line
-				if ((data = COM_ParseLine (data)) == NULL) { free (basedata); return 0; }
-
 				// Read base frame joint
-				if (sscanf (com_token, " ( %f %f %f ) ( %f %f %f )", &baseFrame[i].pos[0], &baseFrame[i].pos[1], &baseFrame[i].pos[2], &baseFrame[i].orient[0], &baseFrame[i].orient[1], &baseFrame[i].orient[2]) == 6)
-				{
-					// Compute the w component
-					Quat_computeW (baseFrame[i].orient);
-				}
+				if (!MD5_LexVector (&lex, baseFrame[i].pos, 3)) break;
+				if (!MD5_LexVector (&lex, baseFrame[i].orient, 3)) break;
+
+				// Compute the w component
+				Quat_computeW (baseFrame[i].orient);
 			}
+
+			if (!MD5_LexExpect (&lex, "}")) break;
 		}
-		else if (sscanf (com_token, " frame %d", &frame_index) == 1)
+		else if (MD5_LexIs (&lex, "frame"))
 		{
-			// Read frame data
-			for (i = 0; i < numAnimatedComponents; i++)
+			if (!MD5_LexInt (&lex, &frame_index)) break;
+
+			if (frame_index < 0 || frame_index >= anim->num_frames || !anim->skelFrames[frame_index])
 			{
-				// parse a single token
-				if ((data = COM_Parse (data)) == NULL) { free (basedata); return 0; }
-				animFrameData[i] = atof (com_token);
+				MD5_LexError (&lex, "frame %i is out of range", frame_index);
+				break;
 			}
 
-			// Build frame skeleton from the collected data
-			MD5_BuildFrameSkeleton (jointInfos, baseFrame, animFrameData, anim->skelFrames[frame_index], anim->num_joints);
+			if (!MD5_LexExpect (&lex, "{")) break;
+
+			// a later block for the same frame replaces it, the same as if they were built in order
+			parse.frameblocks[frame_index] = lex.data;
+			parse.framelines[frame_index] = lex.line;
+
+			// numbers don't have braces in them so the next one is the end of the block
+			if (!MD5_LexSkipBlock (&lex)) break;
 		}
+		else MD5_LexSkipLine (&lex);
 	}
 
-	// free the base data properly
-	free (basedata);
+	if (lex.error)
+	{
+		MD5_DPrintf ("MD5_ReadAnimFile : %s\n", lex.errormsg);
+		goto anim_bad;
+	}
 
-	return 1;
-}
+	// every joint's components have to be in the frame
+	for (i = 0; i < anim->num_joints; i++)
+	{
+		int flags = jointInfos[i].flags & 63, numcomponents = 0;
 
+		for (; flags; flags >>= 1)
+			numcomponents += (flags & 1);
 
-/*
-==================
-MD5_CullboxForFrame
+		if (numcomponents && (jointInfos[i].startIndex < 0 || jointInfos[i].startIndex + numcomponents > anim->num_components))
+		{
+			MD5_DPrintf ("MD5_ReadAnimFile : %s: joint %i has components past numAnimatedComponents\n", filename, i);
+			goto anim_bad;
+		}
+	}
 
-==================
-*/
-static void MD5_CullboxForFrame (const struct md5_mesh_t *mesh, const struct md5_joint_t *skeleton, struct md5_bbox_t *cullbox)
-{
-	int i, j;
+	if (anim->num_frames > 0 && anim->num_components > 0)
+	{
+		parse.anim = anim;
+		parse.baseFrame = baseFrame;
+		parse.filename = filename;
 
-	// init this cullbox
-	cullbox->min[0] = cullbox->min[1] = cullbox->min[2] = 999999;
-	cullbox->max[0] = cullbox->max[1] = cullbox->max[2] = -999999;
+		// keep the data for every frame so that it can be packed, otherwise it's only needed until the skeletons are built
+		if ((parse.framedata = (float *) malloc (sizeof (float) * anim->num_components * anim->num_frames)) == NULL)
+			goto anim_bad;
+
+		if (rawframes)
+			*rawframes = parse.framedata;
+
+		// a few frames at a time so that the threads aren't fighting over the batches
+		MD5_RunSplit (MD5_ParseAnimFrames, &parse, anim->num_frames, 8);
+
+		if (parse.failed)
+		{
+			// find the first frame that went wrong again, here where it can be reported
+			parse.failed = 0;
+			parse.report = true;
+			MD5_ParseAnimFrames (&parse, 0, anim->num_frames);
+
+			goto anim_bad;
+		}
+	}
+	else if (anim->num_frames > 0)
+	{
+		// no animated components so every frame is the baseframe
+		for (i = 0; i < anim->num_frames; i++)
+			if (parse.frameblocks[i])
+				MD5_BuildFrameSkeleton (jointInfos, baseFrame, NULL, anim->skelFrames[i], anim->num_joints);
+	}
+
+	// the baseframe is needed to unpack frames
+	if (rawframes)
+	{
+		anim->packed = (struct md5_packedanim_t *) MD5_HunkAlloc (sizeof (struct md5_packedanim_t));
+		anim->packed->baseFrame = baseFrame;
+	}
+
+	if (parse.frameblocks) free (parse.frameblocks);
+	if (parse.framelines) free (parse.framelines);
+	if (parse.framedata && !rawframes) free (parse.framedata);
+
+	return 1;
+
+anim_bad:;
+	if (parse.frameblocks) free (parse.frameblocks);
+	if (parse.framelines) free (parse.framelines);
+	if (parse.framedata && !rawframes) free (parse.framedata);
+
+	return 0;
+}
+
+
+// 15 bits over +/- 1/sqrt(2)
+#define MD5_QUAT_SCALE	(16383.0f * 1.41421356f)
+
+/*
+==================
+MD5_PackQuat
+
+smallest-three; the largest component is dropped and rebuilt from the other three, which are all within +/- 1/sqrt(2)
+and are stored in 15 bits each.  the index of the dropped component goes in the low bits of the first two.
+==================
+*/
+static void MD5_PackQuat (const quat4_t q, short *out)
+{
+	int i, j, largest = 0;
+	float sign;
+
+	for (i = 1; i < 4; i++)
+		if (fabs (q[i]) > fabs (q[largest])) largest = i;
+
+	// q and -q are the same rotation so the dropped component can always be positive
+	sign = (q[largest] < 0) ? -1.0f : 1.0f;
+
+	for (i = 0, j = 0; i < 4; i++)
+	{
+		if (i == largest) continue;
+
+		out[j] = (short) floor (q[i] * sign * MD5_QUAT_SCALE + 0.5f) * 2;
+		j++;
+	}
+
+	out[0] |= (largest & 1);
+	out[1] |= (largest >> 1);
+}
+
+
+/*
+==================
+MD5_UnpackQuat
+
+==================
+*/
+static void MD5_UnpackQuat (const short *in, quat4_t q)
+{
+	int i, j, largest = (in[0] & 1) | ((in[1] & 1) << 1);
+	float sum = 0;
+
+	for (i = 0, j = 0; i < 4; i++)
+	{
+		if (i == largest) continue;
+
+		q[i] = ((in[j] - (in[j] & 1)) / 2) * (1.0f / MD5_QUAT_SCALE);
+		sum += q[i] * q[i];
+		j++;
+	}
+
+	q[largest] = (sum < 1.0f) ? sqrt (1.0f - sum) : 0.0f;
+
+	// the MD5 format always has a negative w, see Quat_computeW
+	if (q[3] > 0)
+	{
+		for (i = 0; i < 4; i++)
+			q[i] = -q[i];
+	}
+}
+
+
+/*
+==================
+MD5_PackAnimation
+
+quantizes the animated components of all frames; anim->packed was set up by MD5_ReadAnimFile
+==================
+*/
+static void MD5_PackAnimation (struct md5_anim_t *anim, const float *rawframes)
+{
+	struct md5_packedanim_t *packed = anim->packed;
+	const struct joint_info_t *jointInfos = anim->hierarchy;
+	const struct baseframe_joint_t *baseFrame = packed->baseFrame;
+	short *out;
+	int f, i, j, k;
+
+	packed->posscale = (float *) MD5_HunkAlloc (sizeof (float) * anim->num_joints);
+	packed->framesize = 0;
+
+	// find the frame size and the largest position offset from the baseframe for each joint
+	for (i = 0; i < anim->num_joints; i++)
+	{
+		int flags = jointInfos[i].flags;
+		float maxofs = 0;
+
+		for (f = 0; f < anim->num_frames; f++)
+		{
+			const float *comp = rawframes + f * anim->num_components + jointInfos[i].startIndex;
+
+			for (k = 0, j = 0; k < 3; k++)
+			{
+				if (!(flags & (1 << k))) continue;
+				if (fabs (comp[j] - baseFrame[i].pos[k]) > maxofs) maxofs = fabs (comp[j] - baseFrame[i].pos[k]);
+				j++;
+			}
+		}
+
+		packed->posscale[i] = maxofs / 32767.0f;
+
+		for (k = 0; k < 3; k++)
+			if (flags & (1 << k)) packed->framesize++;
+
+		if (flags & (8 | 16 | 32)) packed->framesize += 3;
+	}
+
+	packed->frames = out = (short *) MD5_HunkAlloc (sizeof (short) * packed->framesize * anim->num_frames);
+
+	for (f = 0; f < anim->num_frames; f++)
+	{
+		for (i = 0; i < anim->num_joints; i++)
+		{
+			const float *comp = rawframes + f * anim->num_components + jointInfos[i].startIndex;
+			int flags = jointInfos[i].flags;
+
+			for (k = 0, j = 0; k < 3; k++)
+			{
+				if (!(flags & (1 << k))) continue;
+
+				if (packed->posscale[i] > 0)
+					*out++ = (short) floor ((comp[j] - baseFrame[i].pos[k]) / packed->posscale[i] + 0.5f);
+				else *out++ = 0;
+
+				j++;
+			}
+
+			if (flags & (8 | 16 | 32))
+			{
+				quat4_t q;
+
+				// the whole orientation is packed, including any components that come from the baseframe
+				memcpy (q, baseFrame[i].orient, sizeof (quat4_t));
+
+				for (k = 0; k < 3; k++)
+					if (flags & (8 << k)) q[k] = comp[j++];
+
+				Quat_computeW (q);
+				MD5_PackQuat (q, out);
+				out += 3;
+			}
+		}
+	}
+}
+
+
+/*
+==================
+MD5_UnpackFrameSkeleton
+
+rebuilds the animated components of a packed frame and builds the skeleton from them
+==================
+*/
+static void MD5_UnpackFrameSkeleton (const struct md5_anim_t *anim, int frame, struct md5_pose_t *skelFrame)
+{
+	const struct md5_packedanim_t *packed = anim->packed;
+	const struct joint_info_t *jointInfos = anim->hierarchy;
+	const short *in = packed->frames + frame * packed->framesize;
+	float animFrameData[MAX_MD5_JOINTS * 6];
+	int i, j, k;
+
+	for (i = 0; i < anim->num_joints; i++)
+	{
+		float *comp = animFrameData + jointInfos[i].startIndex;
+		int flags = jointInfos[i].flags;
+
+		for (k = 0, j = 0; k < 3; k++)
+		{
+			if (!(flags & (1 << k))) continue;
+			comp[j++] = packed->baseFrame[i].pos[k] + *in++ * packed->posscale[i];
+		}
+
+		if (flags & (8 | 16 | 32))
+		{
+			quat4_t q;
+
+			MD5_UnpackQuat (in, q);
+			in += 3;
+
+			for (k = 0; k < 3; k++)
+				if (flags & (8 << k)) comp[j++] = q[k];
+		}
+	}
+
+	MD5_BuildFrameSkeleton (jointInfos, packed->baseFrame, animFrameData, skelFrame, anim->num_joints);
+}
+
+
+// packed frames that have been unpacked recently
+#define MD5_POSECACHE_SIZE	128
+
+typedef struct md5posecache_s
+{
+	const struct md5_anim_t *anim;
+	int frame;
+	int lastframe;
+
+	struct md5_pose_t *poses;
+	int maxjoints;
+} md5posecache_t;
+
+static md5posecache_t md5_posecache[MD5_POSECACHE_SIZE];
+
+
+/*
+==================
+MD5_FramePose
+
+returns the skeleton for a frame.  packed frames are unpacked on demand into a small LRU cache; slots that were handed
+out this frame aren't reused because the skinning threads may still be reading them, and if they're all in use the
+frame is unpacked into scratch instead.  this must only be called from the main thread.
+==================
+*/
+const struct md5_pose_t *MD5_FramePose (const struct md5_anim_t *anim, int frame, struct md5_pose_t *scratch)
+{
+	md5posecache_t *slot, *best = NULL;
+	int i;
+
+	if (!anim->packed)
+		return anim->skelFrames[frame];
+
+	for (i = 0, slot = md5_posecache; i < MD5_POSECACHE_SIZE; i++, slot++)
+	{
+		if (slot->anim == anim && slot->frame == frame)
+		{
+			slot->lastframe = r_framecount;
+			return slot->poses;
+		}
+
+		if (slot->anim && slot->lastframe == r_framecount) continue;
+		if (!best || !slot->anim || (best->anim && slot->lastframe < best->lastframe)) best = slot;
+	}
+
+	if (best && best->maxjoints < anim->num_joints)
+	{
+		if (best->poses) free (best->poses);
+
+		best->anim = NULL;
+		best->maxjoints = 0;
+
+		if ((best->poses = (struct md5_pose_t *) malloc (sizeof (struct md5_pose_t) * anim->num_joints)) == NULL)
+			best = NULL;
+		else best->maxjoints = anim->num_joints;
+	}
+
+	if (!best)
+	{
+		MD5_UnpackFrameSkeleton (anim, frame, scratch);
+		return scratch;
+	}
+
+	MD5_UnpackFrameSkeleton (anim, frame, best->poses);
+
+	best->anim = anim;
+	best->frame = frame;
+	best->lastframe = r_framecount;
+
+	return best->poses;
+}
+
+
+/*
+==================
+MD5_FlushPoseCache
+
+the cache is keyed on model memory so it must be flushed whenever models may have been freed
+==================
+*/
+void MD5_FlushPoseCache (void)
+{
+	int i;
+
+	for (i = 0; i < MD5_POSECACHE_SIZE; i++)
+		md5_posecache[i].anim = NULL;
+}
+
+
+/*
+==================
+MD5_CullboxForFrame
+
+the box is around the skinned vertexes and the sphere is around the centre of the box, which is usually a good deal
+tighter than the box corners.  positions is scratch space for the vertexes.
+==================
+*/
+static void MD5_CullboxForFrame (const struct md5_mesh_t *mesh, const struct md5_pose_t *skeleton, float (*positions)[3], struct md5_bbox_t *cullbox)
+{
+	vec3_t center;
+	float radius = 0;
+	int i, j;
+
+	// init this cullbox
+	cullbox->min[0] = cullbox->min[1] = cullbox->min[2] = 999999;
+	cullbox->max[0] = cullbox->max[1] = cullbox->max[2] = -999999;
 
 	// Setup vertices
 	for (i = 0; i < mesh->num_verts; i++)
 	{
-		vec3_t finalVertex = {0.0f, 0.0f, 0.0f};
+		float *finalVertex = positions[i];
+
+		finalVertex[0] = finalVertex[1] = finalVertex[2] = 0.0f;
 
 		// Calculate final vertex to draw with weights
 		for (j = 0; j < mesh->vertices[i].count; j++)
 		{
 			const struct md5_weight_t *weight = &mesh->weights[mesh->vertices[i].start + j];
-			const struct md5_joint_t *joint = &skeleton[weight->joint];
+			const struct md5_pose_t *joint = &skeleton[weight->joint];
 
 			// Calculate transformed vertex for this weight
 			vec3_t wv;
@@ -763,12 +1368,30 @@ static void MD5_CullboxForFrame (const struct md5_mesh_t *mesh, const struct md5
 		}
 	}
 
+	// now the sphere
+	for (j = 0; j < 3; j++)
+		center[j] = (cullbox->min[j] + cullbox->max[j]) * 0.5f;
+
+	for (i = 0; i < mesh->num_verts; i++)
+	{
+		vec3_t delta;
+		float dist;
+
+		VectorSubtract (positions[i], center, delta);
+
+		if ((dist = DotProduct (delta, delta)) > radius)
+			radius = dist;
+	}
+
 	// spread the mins and maxs by 0.5 to ensure we never have zero in any dimension
 	for (j = 0; j < 3; j++)
 	{
 		cullbox->min[j] -= 0.5f;
 		cullbox->max[j] += 0.5f;
 	}
+
+	// and the radius to match
+	cullbox->radius = sqrt (radius) + 0.5f;
 }
 
 
@@ -780,13 +1403,238 @@ MD5_MakeCullboxes
 */
 static void MD5_MakeCullboxes (md5header_t *hdr, struct md5_mesh_t *mesh, struct md5_anim_t *anim)
 {
+	float (*positions)[3] = (float (*)[3]) malloc (sizeof (float) * 3 * mesh->num_verts);
 	int f;
 
+	if (!positions) Sys_Error ("MD5_MakeCullboxes : out of memory");
+
 	for (f = 0; f < anim->num_frames; f++)
 	{
 		// calc the cullbox for this frame
-		MD5_CullboxForFrame (mesh, anim->skelFrames[f], &anim->bboxes[f]);
+		MD5_CullboxForFrame (mesh, anim->skelFrames[f], positions, &anim->bboxes[f]);
+	}
+
+	free (positions);
+}
+
+
+/*
+==================
+MD5_CullBounds
+
+returns true if the entity is entirely outside the planes, which are normal and dist with the inside in front.  the
+spheres decide most entities on their own; anything they don't is tested against the frame boxes turned to the entity
+angles, so rotated models are neither wrongly culled nor need padded boxes.
+==================
+*/
+qboolean MD5_CullBounds (const struct md5_anim_t *anim, int pose1, int pose2, float blend, vec3_t origin, vec3_t angles, float planes[][4], int numplanes)
+{
+	const struct md5_bbox_t *box1 = &anim->bboxes[pose1];
+	const struct md5_bbox_t *box2 = &anim->bboxes[pose2];
+	vec3_t center, extents, axis[3], modelangles, worldcenter;
+	float radius = box1->radius + (box2->radius - box1->radius) * blend;
+	qboolean inside = true;
+	int i;
+
+	for (i = 0; i < 3; i++)
+	{
+		float mins = box1->min[i] + (box2->min[i] - box1->min[i]) * blend;
+		float maxs = box1->max[i] + (box2->max[i] - box1->max[i]) * blend;
+
+		center[i] = (mins + maxs) * 0.5f;
+		extents[i] = (maxs - mins) * 0.5f;
+	}
+
+	// models are drawn with the pitch flipped (see R_RotateForEntity) and with y going left
+	modelangles[0] = -angles[0];
+	modelangles[1] = angles[1];
+	modelangles[2] = angles[2];
+
+	AngleVectors (modelangles, axis[0], axis[1], axis[2]);
+	VectorScale (axis[1], -1, axis[1]);
+
+	for (i = 0; i < 3; i++)
+		worldcenter[i] = origin[i] + axis[0][i] * center[0] + axis[1][i] * center[1] + axis[2][i] * center[2];
+
+	// spheres
+	for (i = 0; i < numplanes; i++)
+	{
+		float d = DotProduct (planes[i], worldcenter) - planes[i][3];
+
+		if (d < -radius) return true;
+		if (d < radius) inside = false;
+	}
+
+	if (inside) return false;
+
+	// oriented boxes
+	for (i = 0; i < numplanes; i++)
+	{
+		float d = DotProduct (planes[i], worldcenter) - planes[i][3];
+		float r = fabs (DotProduct (planes[i], axis[0])) * extents[0] +
+			fabs (DotProduct (planes[i], axis[1])) * extents[1] +
+			fabs (DotProduct (planes[i], axis[2])) * extents[2];
+
+		if (d < -r) return true;
+	}
+
+	return false;
+}
+
+
+/*
+==================
+MD5_PackMeshes
+
+packs all meshes into a single vertex, triangle and weight range so that the whole model can be skinned in one go
+and drawn with as few calls as possible.  meshes that share a shader are packed next to each other and become a
+single submesh.  the source meshes are thrown away by freeing back to mark, so nothing else can have been put on
+the hunk after the mesh file was read.  the packed weights are only needed until the skin stream is built so they
+go in temp memory, which MD5_LoadGeometry frees.  mirrored seam verts are duplicated in each mesh before packing so that every
+submesh keeps a contiguous vertex range for it's own texcoords.
+==================
+*/
+static qboolean MD5_PackMeshes (md5header_t *hdr, int mark)
+{
+	struct md5_model_t *mdl = &hdr->md5mesh;
+	struct md5_mesh_t *mesh;
+	struct md5_joint_t *baseSkel;
+	struct md5_submesh_t *submeshes;
+	struct md5_vertex_t *vertices;
+	mtriangle_t *triangles;
+	struct md5_weight_t *weights;
+	int *mirrored;
+	int *order;
+	int i, j, k, num_submeshes = 0, num_verts = 0, num_tris = 0, num_weights = 0, num_mirrored = 0;
+
+	if (mdl->num_meshes < 1) return false;
+
+	// fix up mirror seam verts
+	for (i = 0; i < mdl->num_meshes; i++)
+		R_DuplicateMirroredVertexes (&mdl->meshes[i]);
+
+	// order the meshes so that each shader is contiguous, keeping the first mesh first
+	order = (int *) malloc (mdl->num_meshes * sizeof (int));
+
+	for (i = 0, k = 0; i < mdl->num_meshes; i++)
+	{
+		for (j = 0; j < k; j++)
+			if (order[j] == i) break;
+
+		if (j < k) continue;
+
+		for (j = i; j < mdl->num_meshes; j++)
+			if (!strcmp (mdl->meshes[j].shader, mdl->meshes[i].shader))
+				order[k++] = j;
+
+		num_submeshes++;
+	}
+
+	for (i = 0; i < mdl->num_meshes; i++)
+	{
+		num_verts += mdl->meshes[i].num_verts;
+		num_tris += mdl->meshes[i].num_tris;
+		num_weights += mdl->meshes[i].num_weights;
+		num_mirrored += mdl->meshes[i].num_mirrored_verts;
+	}
+
+	// don't load MD5s that are too big
+	if (num_verts > MAX_MD5_VERTEXES)
+	{
+		free (order);
+		return false;
+	}
+
+	// build the packed model in temp memory
+	baseSkel = (struct md5_joint_t *) malloc (mdl->num_joints * sizeof (struct md5_joint_t));
+	submeshes = (struct md5_submesh_t *) calloc (num_submeshes, sizeof (struct md5_submesh_t));
+	vertices = (struct md5_vertex_t *) malloc (num_verts * sizeof (struct md5_vertex_t));
+	triangles = (mtriangle_t *) malloc (num_tris * sizeof (mtriangle_t));
+	weights = (struct md5_weight_t *) malloc (num_weights * sizeof (struct md5_weight_t));
+	mirrored = (int *) malloc ((num_mirrored + 1) * sizeof (int));
+
+	memcpy (baseSkel, mdl->baseSkel, mdl->num_joints * sizeof (struct md5_joint_t));
+	num_submeshes = num_verts = num_tris = num_weights = num_mirrored = 0;
+
+	for (i = 0; i < mdl->num_meshes; i++)
+	{
+		struct md5_mesh_t *src = &mdl->meshes[order[i]];
+		struct md5_submesh_t *submesh;
+
+		// start a new submesh when the shader changes
+		if (!i || strcmp (src->shader, mdl->meshes[order[i - 1]].shader))
+		{
+			submesh = &submeshes[num_submeshes++];
+			strcpy (submesh->shader, src->shader);
+			submesh->firstvert = num_verts;
+			submesh->firsttri = num_tris;
+		}
+		else submesh = &submeshes[num_submeshes - 1];
+
+		for (j = 0; j < src->num_verts; j++)
+		{
+			vertices[num_verts + j] = src->vertices[j];
+			vertices[num_verts + j].start += num_weights;
+		}
+
+		for (j = 0; j < src->num_tris; j++)
+		{
+			triangles[num_tris + j].facesfront = src->triangles[j].facesfront;
+
+			for (k = 0; k < 3; k++)
+				triangles[num_tris + j].vertindex[k] = src->triangles[j].vertindex[k] + num_verts;
+		}
+
+		for (j = 0; j < src->num_mirrored_verts; j++)
+			mirrored[num_mirrored + j] = src->mirrored_vertices[j] + num_verts;
+
+		memcpy (&weights[num_weights], src->weights, src->num_weights * sizeof (struct md5_weight_t));
+
+		submesh->numverts += src->num_verts;
+		submesh->numtris += src->num_tris;
+
+		num_verts += src->num_verts;
+		num_tris += src->num_tris;
+		num_weights += src->num_weights;
+		num_mirrored += src->num_mirrored_verts;
 	}
+
+	// throw away the source meshes and put the packed one in their place
+	MD5_HunkFreeToLowMark (mark);
+
+	mdl->baseSkel = (struct md5_joint_t *) MD5_HunkAlloc (mdl->num_joints * sizeof (struct md5_joint_t));
+	mdl->meshes = mesh = (struct md5_mesh_t *) MD5_HunkAlloc (sizeof (struct md5_mesh_t));
+	mdl->num_meshes = 1;
+
+	mesh->vertices = (struct md5_vertex_t *) MD5_HunkAlloc (num_verts * sizeof (struct md5_vertex_t));
+	mesh->triangles = (mtriangle_t *) MD5_HunkAlloc (num_tris * sizeof (mtriangle_t));
+	mesh->weights = weights;
+	mesh->num_verts = num_verts;
+	mesh->num_tris = num_tris;
+	mesh->num_weights = num_weights;
+	mesh->num_mirrored_verts = num_mirrored;
+	mesh->mirrored_vertices = num_mirrored ? (int *) MD5_HunkAlloc (num_mirrored * sizeof (int)) : NULL;
+	strcpy (mesh->shader, submeshes[0].shader);
+
+	hdr->submeshes = (struct md5_submesh_t *) MD5_HunkAlloc (num_submeshes * sizeof (struct md5_submesh_t));
+	hdr->num_submeshes = num_submeshes;
+
+	memcpy (mdl->baseSkel, baseSkel, mdl->num_joints * sizeof (struct md5_joint_t));
+	memcpy (mesh->vertices, vertices, num_verts * sizeof (struct md5_vertex_t));
+	memcpy (mesh->triangles, triangles, num_tris * sizeof (mtriangle_t));
+	memcpy (hdr->submeshes, submeshes, num_submeshes * sizeof (struct md5_submesh_t));
+
+	if (num_mirrored)
+		memcpy (mesh->mirrored_vertices, mirrored, num_mirrored * sizeof (int));
+
+	free (mirrored);
+	free (triangles);
+	free (vertices);
+	free (submeshes);
+	free (baseSkel);
+	free (order);
+
+	return true;
 }
 
 
@@ -796,15 +1644,16 @@ MD5_LoadSkins
 
 ==================
 */
-static void MD5_LoadSkins (md5header_t *hdr, char *shader)
+static void MD5_LoadSkins (struct md5_submesh_t *submesh)
 {
 	// this just needs to be arbitrarily large enough
 	// protocol specifies byte data for U_SKIN so this will do us just fine
 	md5skin_t allskins[256];
+	char *shader = submesh->shader;
 	int i, j;
 
 	// no skins to begin with
-	hdr->numskins = 0;
+	submesh->numskins = 0;
 
 	// load skins
 	for (i = 0; i < 256; i++)
@@ -846,62 +1695,1142 @@ static void MD5_LoadSkins (md5header_t *hdr, char *shader)
 		if (numskins > 0)
 		{
 			// store it out
-			allskins[hdr->numskins].images = (qpic_t **) Hunk_Alloc (numskins * sizeof (qpic_t *));
-			memcpy (allskins[hdr->numskins].images, images, numskins * sizeof (qpic_t *));
+			allskins[submesh->numskins].images = (qpic_t **) Hunk_Alloc (numskins * sizeof (qpic_t *));
+			memcpy (allskins[submesh->numskins].images, images, numskins * sizeof (qpic_t *));
 
 			// copy off the number of skins too...
-			allskins[hdr->numskins].numskins = numskins;
+			allskins[submesh->numskins].numskins = numskins;
 
 			// go to the next skin
-			hdr->numskins++;
+			submesh->numskins++;
 		}
 		else break;
 	}
 
 	// see did we get any skins
-	if (hdr->numskins > 0)
+	if (submesh->numskins > 0)
 	{
 		// store it out
-		hdr->skins = (md5skin_t *) Hunk_Alloc (hdr->numskins * sizeof (md5skin_t));
-		memcpy (hdr->skins, allskins, hdr->numskins * sizeof (md5skin_t));
+		submesh->skins = (md5skin_t *) Hunk_Alloc (submesh->numskins * sizeof (md5skin_t));
+		memcpy (submesh->skins, allskins, submesh->numskins * sizeof (md5skin_t));
 	}
 	else Sys_Error ("MD5_LoadSkins : no skins loaded for \"%s\"", shader);
 }
 
 
 /*
-==================
-Mod_LoadMD5Model
+==============================================================================
+
+MD5 CACHE
+
+the fully built geometry and animation for an MD5 is written out as a single .md5c file after the first successful
+load, so that subsequent loads are a single file read and some pointer fix-ups rather than parsing the text and
+rebuilding cullboxes and normals.  the cache is in native byte order and struct layout, and is only valid for the
+same engine that wrote it; a CRC and length of each source file invalidates it when the MD5 is changed.
+
+==============================================================================
+*/
+
+#define MD5C_IDENT		(('C'<<24)+('5'<<16)+('D'<<8)+'M')
+#define MD5C_VERSION	8
+
+typedef struct md5cache_s
+{
+	int ident;
+	int version;
+	int filelen;
+
+	// the GL and software renderers store triangles differently so caches from one can't be used by the other
+	int trisize;
+
+	// source files this was built from
+	int meshlen, animlen;
+	unsigned short meshcrc, animcrc;
+
+	// the normals depend on r_md5weldtolerance
+	float weldtolerance;
+
+	char shader[256];
+
+	int num_joints;
+	int num_frames;
+	int frameRate;
+	int num_components;
+
+	// nonzero if the animation is stored packed (r_md5animcompress)
+	int animpacked;
+	int framesize;
+
+	int num_verts;
+	int num_tris;
+	int num_skinblocks;
+	int num_mirrored_verts;
+	int num_submeshes;
+	int num_lods;
+	int num_lodtris;
+	int lodnumtris[MD5_MAX_LODS];
+
+	// offsets from the start of the file; all lumps are 16-byte aligned
+	int ofs_baseskel;
+	int ofs_hierarchy;
+	int ofs_poses;
+	int ofs_baseframe;
+	int ofs_posscale;
+	int ofs_packedframes;
+	int ofs_bboxes;
+	int ofs_vertices;
+	int ofs_triangles;
+	int ofs_invbind;
+	int ofs_skinblocks;
+	int ofs_mirrored;
+	int ofs_submeshes;
+	int ofs_lodtriangles;
+} md5cache_t;
+
+
+/*
+==================
+MD5_CRCBlock
+
+==================
+*/
+static unsigned short MD5_CRCBlock (byte *data, int len)
+{
+	unsigned short crc;
+
+	CRC_Init (&crc);
+
+	while (len-- > 0)
+		CRC_ProcessByte (&crc, *data++);
+
+	return CRC_Value (crc);
+}
+
+
+/*
+==================
+MD5_CacheLump
+
+reserves space for a lump and returns it's offset
+==================
+*/
+static int MD5_CacheLump (int *filelen, int size)
+{
+	int ofs = *filelen;
+
+	*filelen = (*filelen + size + 15) & ~15;
+
+	return ofs;
+}
+
+
+/*
+==================
+MD5_BuildCache
+
+lays out and fills in the cache for a freshly built MD5 in a single malloc'd block of src->filelen bytes; this is
+also how models built on the loader thread are handed back to the main thread
+==================
+*/
+static byte *MD5_BuildCache (md5header_t *hdr, md5cache_t *src)
+{
+	struct md5_mesh_t *mesh = &hdr->md5mesh.meshes[0];
+	struct md5_anim_t *anim = &hdr->md5anim;
+	md5cache_t *cache;
+	byte *data;
+	int filelen = (sizeof (md5cache_t) + 15) & ~15;
+	int f;
+
+	// lay out the file
+	src->ofs_baseskel = MD5_CacheLump (&filelen, hdr->md5mesh.num_joints * sizeof (struct md5_joint_t));
+	src->ofs_hierarchy = MD5_CacheLump (&filelen, anim->num_joints * sizeof (struct joint_info_t));
+
+	if (anim->packed)
+	{
+		src->ofs_poses = 0;
+		src->ofs_baseframe = MD5_CacheLump (&filelen, anim->num_joints * sizeof (struct baseframe_joint_t));
+		src->ofs_posscale = MD5_CacheLump (&filelen, anim->num_joints * sizeof (float));
+		src->ofs_packedframes = MD5_CacheLump (&filelen, anim->num_frames * anim->packed->framesize * sizeof (short));
+	}
+	else
+	{
+		src->ofs_poses = MD5_CacheLump (&filelen, anim->num_frames * anim->num_joints * sizeof (struct md5_pose_t));
+		src->ofs_baseframe = src->ofs_posscale = src->ofs_packedframes = 0;
+	}
+
+	src->ofs_bboxes = MD5_CacheLump (&filelen, anim->num_frames * sizeof (struct md5_bbox_t));
+	src->ofs_vertices = MD5_CacheLump (&filelen, mesh->num_verts * sizeof (struct md5_vertex_t));
+	src->ofs_triangles = MD5_CacheLump (&filelen, mesh->num_tris * sizeof (mtriangle_t));
+	src->ofs_invbind = MD5_CacheLump (&filelen, hdr->md5mesh.num_joints * sizeof (md5_jointmat_t));
+	src->ofs_skinblocks = MD5_CacheLump (&filelen, mesh->num_skinblocks * sizeof (struct md5_skinblock_t));
+	src->ofs_mirrored = MD5_CacheLump (&filelen, mesh->num_mirrored_verts * sizeof (int));
+	src->ofs_submeshes = MD5_CacheLump (&filelen, hdr->num_submeshes * sizeof (struct md5_submesh_t));
+	src->ofs_lodtriangles = MD5_CacheLump (&filelen, hdr->num_lodtris * sizeof (mtriangle_t));
+
+	// fill in the header
+	src->ident = MD5C_IDENT;
+	src->version = MD5C_VERSION;
+	src->filelen = filelen;
+	src->trisize = sizeof (mtriangle_t);
+
+	strcpy (src->shader, mesh->shader);
+
+	src->num_joints = anim->num_joints;
+	src->num_frames = anim->num_frames;
+	src->frameRate = anim->frameRate;
+	src->num_components = anim->num_components;
+	src->animpacked = anim->packed ? 1 : 0;
+	src->framesize = anim->packed ? anim->packed->framesize : 0;
+
+	src->num_verts = mesh->num_verts;
+	src->num_tris = mesh->num_tris;
+	src->num_skinblocks = mesh->num_skinblocks;
+	src->num_mirrored_verts = mesh->num_mirrored_verts;
+	src->num_submeshes = hdr->num_submeshes;
+	src->num_lods = hdr->num_lods;
+	src->num_lodtris = hdr->num_lodtris;
+	memcpy (src->lodnumtris, hdr->lodnumtris, sizeof (src->lodnumtris));
+
+	// and build it
+	if ((data = (byte *) calloc (filelen, 1)) == NULL)
+		return NULL;
+
+	cache = (md5cache_t *) data;
+	memcpy (cache, src, sizeof (md5cache_t));
+
+	memcpy (data + cache->ofs_baseskel, hdr->md5mesh.baseSkel, hdr->md5mesh.num_joints * sizeof (struct md5_joint_t));
+	memcpy (data + cache->ofs_hierarchy, anim->hierarchy, anim->num_joints * sizeof (struct joint_info_t));
+
+	if (anim->packed)
+	{
+		memcpy (data + cache->ofs_baseframe, anim->packed->baseFrame, anim->num_joints * sizeof (struct baseframe_joint_t));
+		memcpy (data + cache->ofs_posscale, anim->packed->posscale, anim->num_joints * sizeof (float));
+		memcpy (data + cache->ofs_packedframes, anim->packed->frames, anim->num_frames * anim->packed->framesize * sizeof (short));
+	}
+	else
+	{
+		for (f = 0; f < anim->num_frames; f++)
+			memcpy (data + cache->ofs_poses + f * anim->num_joints * sizeof (struct md5_pose_t), anim->skelFrames[f], anim->num_joints * sizeof (struct md5_pose_t));
+	}
+
+	memcpy (data + cache->ofs_bboxes, anim->bboxes, anim->num_frames * sizeof (struct md5_bbox_t));
+	memcpy (data + cache->ofs_vertices, mesh->vertices, mesh->num_verts * sizeof (struct md5_vertex_t));
+	memcpy (data + cache->ofs_triangles, mesh->triangles, mesh->num_tris * sizeof (mtriangle_t));
+	memcpy (data + cache->ofs_invbind, hdr->md5mesh.invbind, hdr->md5mesh.num_joints * sizeof (md5_jointmat_t));
+	memcpy (data + cache->ofs_skinblocks, mesh->skinblocks, mesh->num_skinblocks * sizeof (struct md5_skinblock_t));
+
+	if (mesh->num_mirrored_verts)
+		memcpy (data + cache->ofs_mirrored, mesh->mirrored_vertices, mesh->num_mirrored_verts * sizeof (int));
+
+	// skins aren't loaded yet so there's no need to clear them out
+	memcpy (data + cache->ofs_submeshes, hdr->submeshes, hdr->num_submeshes * sizeof (struct md5_submesh_t));
+
+	if (hdr->num_lodtris)
+		memcpy (data + cache->ofs_lodtriangles, hdr->lodtriangles, hdr->num_lodtris * sizeof (mtriangle_t));
+
+	return data;
+}
+
+
+/*
+==================
+MD5_WriteCache
+
+==================
+*/
+static void MD5_WriteCache (char *cachename, byte *data)
+{
+	char path[MAX_OSPATH];
+
+	// gamedir may not have a progs directory yet
+	sprintf (path, "%s/%s", com_gamedir, cachename);
+	COM_CreatePath (path);
+	COM_WriteFile (cachename, data, ((md5cache_t *) data)->filelen);
+}
+
+
+/*
+==================
+MD5_PointIntoCache
+
+fixes up the model to point into a whole cache that's on the hunk
+==================
+*/
+static void MD5_PointIntoCache (md5header_t *hdr, byte *data)
+{
+	md5cache_t *cache = (md5cache_t *) data;
+	struct md5_mesh_t *mesh;
+	struct md5_pose_t *poses;
+	int f;
+
+	// fix up the mesh
+	hdr->md5mesh.num_joints = cache->num_joints;
+	hdr->md5mesh.num_meshes = 1;
+	hdr->md5mesh.baseSkel = (struct md5_joint_t *) (data + cache->ofs_baseskel);
+	hdr->md5mesh.meshes = mesh = (struct md5_mesh_t *) Hunk_Alloc (sizeof (struct md5_mesh_t));
+
+	strcpy (mesh->shader, cache->shader);
+
+	mesh->num_verts = cache->num_verts;
+	mesh->num_tris = cache->num_tris;
+	mesh->num_skinblocks = cache->num_skinblocks;
+	mesh->num_mirrored_verts = cache->num_mirrored_verts;
+
+	mesh->vertices = (struct md5_vertex_t *) (data + cache->ofs_vertices);
+	mesh->triangles = (mtriangle_t *) (data + cache->ofs_triangles);
+	mesh->skinblocks = (struct md5_skinblock_t *) (data + cache->ofs_skinblocks);
+	mesh->mirrored_vertices = cache->num_mirrored_verts ? (int *) (data + cache->ofs_mirrored) : NULL;
+
+	// the weights and normals are all in the skin stream now
+	hdr->md5mesh.invbind = (md5_jointmat_t *) (data + cache->ofs_invbind);
+
+	// the vertexes are rebuilt each frame so they just need to be allocated
+	hdr->vertexes = (md5polyvert_t *) Hunk_Alloc (sizeof (md5polyvert_t) * mesh->num_verts);
+
+	// skins are loaded after this so they'll be filled in then
+	hdr->submeshes = (struct md5_submesh_t *) (data + cache->ofs_submeshes);
+	hdr->num_submeshes = cache->num_submeshes;
+
+	hdr->num_lods = cache->num_lods;
+	hdr->num_lodtris = cache->num_lodtris;
+	hdr->lodtriangles = cache->num_lodtris ? (mtriangle_t *) (data + cache->ofs_lodtriangles) : NULL;
+	memcpy (hdr->lodnumtris, cache->lodnumtris, sizeof (hdr->lodnumtris));
+
+	// fix up the animation
+	hdr->md5anim.num_joints = cache->num_joints;
+	hdr->md5anim.num_frames = cache->num_frames;
+	hdr->md5anim.frameRate = cache->frameRate;
+	hdr->md5anim.num_components = cache->num_components;
+	hdr->md5anim.hierarchy = (struct joint_info_t *) (data + cache->ofs_hierarchy);
+	hdr->md5anim.bboxes = (struct md5_bbox_t *) (data + cache->ofs_bboxes);
+
+	if (cache->animpacked)
+	{
+		struct md5_packedanim_t *packed = hdr->md5anim.packed = (struct md5_packedanim_t *) Hunk_Alloc (sizeof (struct md5_packedanim_t));
+
+		packed->baseFrame = (struct baseframe_joint_t *) (data + cache->ofs_baseframe);
+		packed->posscale = (float *) (data + cache->ofs_posscale);
+		packed->frames = (short *) (data + cache->ofs_packedframes);
+		packed->framesize = cache->framesize;
+		return;
+	}
+
+	hdr->md5anim.skelFrames = (struct md5_pose_t **) Hunk_Alloc (cache->num_frames * sizeof (struct md5_pose_t *));
+
+	for (f = 0, poses = (struct md5_pose_t *) (data + cache->ofs_poses); f < cache->num_frames; f++, poses += cache->num_joints)
+		hdr->md5anim.skelFrames[f] = poses;
+}
+
+
+/*
+==================
+MD5_CacheLumpFits
+
+count items of size bytes at ofs must be inside the file; an empty lump only has to point into it
+==================
+*/
+static qboolean MD5_CacheLumpFits (const md5cache_t *cache, int ofs, int count, int size)
+{
+	if (ofs < 0 || ofs > cache->filelen || count < 0 || size < 0) return false;
+
+	if (!count || !size) return true;
+
+	if (ofs < (int) sizeof (md5cache_t) || (ofs & 15)) return false;
+
+	return count <= (cache->filelen - ofs) / size;
+}
+
+
+/*
+==================
+MD5_CheckCacheTriangles
+
+==================
+*/
+static qboolean MD5_CheckCacheTriangles (const mtriangle_t *triangles, int num_tris, int num_verts)
+{
+	int i, k;
+
+	for (i = 0; i < num_tris; i++)
+		for (k = 0; k < 3; k++)
+			if (triangles[i].vertindex[k] < 0 || triangles[i].vertindex[k] >= num_verts) return false;
+
+	return true;
+}
+
+
+/*
+==================
+MD5_CheckCache
+
+a cache that matches its source files can still have been cut short or damaged since it was written, so every count
+and offset is checked against the file, and everything the model indexes with is checked against what it indexes,
+before anything points into it
+==================
+*/
+static qboolean MD5_CheckCache (byte *data)
+{
+	md5cache_t *cache = (md5cache_t *) data;
+	const struct md5_joint_t *baseskel;
+	const struct joint_info_t *hierarchy;
+	const struct md5_skinblock_t *skinblocks;
+	const struct md5_submesh_t *submeshes;
+	int i, j, k;
+
+	if (!memchr (cache->shader, 0, sizeof (cache->shader))) return false;
+
+	if (cache->num_joints < 0 || cache->num_joints > MAX_MD5_JOINTS) return false;
+	if (cache->num_components < 0 || cache->num_components > MAX_MD5_JOINTS * 6) return false;
+	if (cache->animpacked && (cache->framesize < 0 || cache->framesize > cache->num_joints * 6)) return false;
+	if (cache->num_lods < 0 || cache->num_lods > MD5_MAX_LODS || cache->num_lodtris < 0) return false;
+
+	for (i = 0, j = 0; i < cache->num_lods; i++)
+	{
+		if (cache->lodnumtris[i] < 0 || cache->lodnumtris[i] > cache->num_lodtris - j) return false;
+		j += cache->lodnumtris[i];
+	}
+
+	if (j != cache->num_lodtris) return false;
+
+	// every lump is inside the file, which also limits all of the counts
+	if (!MD5_CacheLumpFits (cache, cache->ofs_baseskel, cache->num_joints, sizeof (struct md5_joint_t)) ||
+		!MD5_CacheLumpFits (cache, cache->ofs_hierarchy, cache->num_joints, sizeof (struct joint_info_t)) ||
+		!MD5_CacheLumpFits (cache, cache->ofs_bboxes, cache->num_frames, sizeof (struct md5_bbox_t)) ||
+		!MD5_CacheLumpFits (cache, cache->ofs_vertices, cache->num_verts, sizeof (struct md5_vertex_t)) ||
+		!MD5_CacheLumpFits (cache, cache->ofs_triangles, cache->num_tris, sizeof (mtriangle_t)) ||
+		!MD5_CacheLumpFits (cache, cache->ofs_invbind, cache->num_joints, sizeof (md5_jointmat_t)) ||
+		!MD5_CacheLumpFits (cache, cache->ofs_skinblocks, cache->num_skinblocks, sizeof (struct md5_skinblock_t)) ||
+		!MD5_CacheLumpFits (cache, cache->ofs_submeshes, cache->num_submeshes, sizeof (struct md5_submesh_t)) ||
+		!MD5_CacheLumpFits (cache, cache->ofs_mirrored, cache->num_mirrored_verts, sizeof (int)) ||
+		!MD5_CacheLumpFits (cache, cache->ofs_lodtriangles, cache->num_lodtris, sizeof (mtriangle_t)))
+		return false;
+
+	if (cache->animpacked)
+	{
+		if (!MD5_CacheLumpFits (cache, cache->ofs_baseframe, cache->num_joints, sizeof (struct baseframe_joint_t)) ||
+			!MD5_CacheLumpFits (cache, cache->ofs_posscale, cache->num_joints, sizeof (float)) ||
+			!MD5_CacheLumpFits (cache, cache->ofs_packedframes, cache->num_frames, cache->framesize * sizeof (short)))
+			return false;
+	}
+	else if (!MD5_CacheLumpFits (cache, cache->ofs_poses, cache->num_frames, cache->num_joints * sizeof (struct md5_pose_t)))
+		return false;
+
+	if (cache->num_skinblocks != (cache->num_verts + MD5_SKIN_LANES - 1) / MD5_SKIN_LANES) return false;
+
+	// the model is set up from the first submesh, and everything it's drawn through holds MAX_MD5_VERTEXES
+	if (cache->num_submeshes < 1 || cache->num_verts > MAX_MD5_VERTEXES) return false;
+
+	// what the lumps index with
+	if (!MD5_CheckCacheTriangles ((mtriangle_t *) (data + cache->ofs_triangles), cache->num_tris, cache->num_verts) ||
+		!MD5_CheckCacheTriangles ((mtriangle_t *) (data + cache->ofs_lodtriangles), cache->num_lodtris, cache->num_verts))
+		return false;
+
+	for (i = 0; i < cache->num_mirrored_verts; i++)
+	{
+		int v = ((int *) (data + cache->ofs_mirrored))[i];
+
+		if (v < 0 || v >= cache->num_verts) return false;
+	}
+
+	baseskel = (const struct md5_joint_t *) (data + cache->ofs_baseskel);
+	hierarchy = (const struct joint_info_t *) (data + cache->ofs_hierarchy);
+
+	for (i = 0; i < cache->num_joints; i++)
+	{
+		int flags = hierarchy[i].flags & 63, numcomponents = 0;
+
+		for (; flags; flags >>= 1)
+			numcomponents += (flags & 1);
+
+		if (baseskel[i].parent < -1 || baseskel[i].parent >= cache->num_joints) return false;
+		if (hierarchy[i].parent < -1 || hierarchy[i].parent >= cache->num_joints) return false;
+
+		if (numcomponents && (hierarchy[i].startIndex < 0 || hierarchy[i].startIndex > cache->num_components - numcomponents))
+			return false;
+	}
+
+	skinblocks = (const struct md5_skinblock_t *) (data + cache->ofs_skinblocks);
+
+	for (i = 0; i < cache->num_skinblocks; i++)
+	{
+		if (skinblocks[i].numslots < 0 || skinblocks[i].numslots > MD5_MAX_INFLUENCES) return false;
+
+		for (j = 0; j < MD5_MAX_INFLUENCES; j++)
+			for (k = 0; k < MD5_SKIN_LANES; k++)
+				if (skinblocks[i].joint[j][k] >= cache->num_joints) return false;
+	}
+
+	submeshes = (const struct md5_submesh_t *) (data + cache->ofs_submeshes);
+
+	for (i = 0; i < cache->num_submeshes; i++)
+	{
+		const struct md5_submesh_t *sm = &submeshes[i];
+
+		if (!memchr (sm->shader, 0, sizeof (sm->shader))) return false;
+
+		if (sm->firstvert < 0 || sm->numverts < 0 || sm->firstvert > cache->num_verts - sm->numverts) return false;
+		if (sm->firsttri < 0 || sm->numtris < 0 || sm->firsttri > cache->num_tris - sm->numtris) return false;
+
+		for (j = 0; j < cache->num_lods; j++)
+		{
+			if (sm->lodfirsttri[j] < 0 || sm->lodnumtris[j] < 0 || sm->lodfirsttri[j] > cache->num_lodtris - sm->lodnumtris[j])
+				return false;
+		}
+	}
+
+	for (j = 0; j < cache->num_lods; j++)
+		if (submeshes[0].lodfirsttri[j] > cache->num_lodtris - cache->lodnumtris[j]) return false;
+
+	return true;
+}
+
+
+/*
+==================
+MD5_LoadCache
+
+the whole file is read onto the hunk and the model points straight into it
+==================
+*/
+static qboolean MD5_LoadCache (md5header_t *hdr, char *cachename, md5cache_t *src)
+{
+	int mark = Hunk_LowMark ();
+	byte *data = COM_LoadHunkFile (cachename);
+	md5cache_t *cache = (md5cache_t *) data;
+
+	if (!data) return false;
+
+	// validate it
+	if (com_filesize < sizeof (md5cache_t) ||
+		cache->ident != MD5C_IDENT ||
+		cache->version != MD5C_VERSION ||
+		cache->filelen != com_filesize ||
+		cache->trisize != sizeof (mtriangle_t) ||
+		cache->meshlen != src->meshlen ||
+		cache->animlen != src->animlen ||
+		cache->meshcrc != src->meshcrc ||
+		cache->animcrc != src->animcrc ||
+		cache->animpacked != src->animpacked ||
+		cache->weldtolerance != src->weldtolerance)
+	{
+		Con_DPrintf ("MD5_LoadCache : \"%s\" is out of date\n", cachename);
+		Hunk_FreeToLowMark (mark);
+		return false;
+	}
+
+	if (!MD5_CheckCache (data))
+	{
+		Con_DPrintf ("MD5_LoadCache : \"%s\" is damaged\n", cachename);
+		Hunk_FreeToLowMark (mark);
+		return false;
+	}
+
+	MD5_PointIntoCache (hdr, data);
+
+	return true;
+}
+
+
+/*
+==================
+MD5_PackedAnimationError
+
+compares unpacked joints against the full skeletons, which are still around while loading
+==================
+*/
+static float MD5_PackedAnimationError (const struct md5_anim_t *anim)
+{
+	struct md5_pose_t *skeleton = (struct md5_pose_t *) malloc (sizeof (struct md5_pose_t) * anim->num_joints);
+	float maxerror = 0;
+	int f, i;
+
+	if (!skeleton) return 0;
+
+	for (f = 0; f < anim->num_frames; f++)
+	{
+		MD5_UnpackFrameSkeleton (anim, f, skeleton);
+
+		for (i = 0; i < anim->num_joints; i++)
+		{
+			vec3_t delta;
+			float error;
+
+			VectorSubtract (skeleton[i].pos, anim->skelFrames[f][i].pos, delta);
+
+			if ((error = Length (delta)) > maxerror)
+				maxerror = error;
+		}
+	}
+
+	free (skeleton);
+
+	return maxerror;
+}
+
+
+/*
+==================
+MD5_OptimizeVertexCache
+
+reorders the packed mesh for the vertex cache before anything is built from it; see md5_vcache.c
+==================
+*/
+static void MD5_OptimizeVertexCache (md5header_t *hdr, char *copyname)
+{
+	struct md5_mesh_t *mesh = &hdr->md5mesh.meshes[0];
+	int *indexes = (int *) malloc (mesh->num_tris * 3 * sizeof (int));
+	int *triorder = (int *) malloc (mesh->num_tris * sizeof (int));
+	int *remap = (int *) malloc (mesh->num_verts * sizeof (int));
+	mtriangle_t *oldtris = (mtriangle_t *) malloc (mesh->num_tris * sizeof (mtriangle_t));
+	float acmr[2];
+	int i, k;
+
+	if (indexes && triorder && remap && oldtris)
+	{
+		for (i = 0; i < mesh->num_tris; i++)
+			for (k = 0; k < 3; k++)
+				indexes[i * 3 + k] = mesh->triangles[i].vertindex[k];
+
+		if (MD5_OptimizeMesh (mesh, hdr->submeshes, hdr->num_submeshes, indexes, triorder, remap, acmr))
+		{
+			memcpy (oldtris, mesh->triangles, mesh->num_tris * sizeof (mtriangle_t));
+
+			// facesfront goes with the triangle
+			for (i = 0; i < mesh->num_tris; i++)
+			{
+				mesh->triangles[i].facesfront = oldtris[triorder[i]].facesfront;
+
+				for (k = 0; k < 3; k++)
+					mesh->triangles[i].vertindex[k] = indexes[i * 3 + k];
+			}
+
+			// and the mirrored seam verts are numbered the same as everything else
+			for (i = 0; i < mesh->num_mirrored_verts; i++)
+				mesh->mirrored_vertices[i] = remap[mesh->mirrored_vertices[i]];
+
+			MD5_DPrintf ("%s : vertex cache ACMR %.3f before, %.3f after\n", copyname, acmr[0], acmr[1]);
+		}
+	}
+
+	if (indexes) free (indexes);
+	if (triorder) free (triorder);
+	if (remap) free (remap);
+	if (oldtris) free (oldtris);
+}
+
+
+/*
+==================
+MD5_BuildMeshLODs
+
+simplifies the packed mesh into it's levels of detail; see md5_lod.c
+==================
+*/
+static void MD5_BuildMeshLODs (md5header_t *hdr, char *copyname)
+{
+	struct md5_mesh_t *mesh = &hdr->md5mesh.meshes[0];
+	int *indexes = (int *) malloc (mesh->num_tris * 3 * sizeof (int));
+	int *lodindexes = (int *) malloc (mesh->num_tris * 3 * MD5_MAX_LODS * sizeof (int));
+	int *lodsource = (int *) malloc (mesh->num_tris * MD5_MAX_LODS * sizeof (int));
+	int i, k;
+
+	hdr->num_lods = hdr->num_lodtris = 0;
+	hdr->lodtriangles = NULL;
+
+	if (indexes && lodindexes && lodsource)
+	{
+		for (i = 0; i < mesh->num_tris; i++)
+			for (k = 0; k < 3; k++)
+				indexes[i * 3 + k] = mesh->triangles[i].vertindex[k];
+
+		hdr->num_lods = MD5_BuildLODs (mesh, hdr->submeshes, hdr->num_submeshes, indexes, lodindexes, lodsource, hdr->lodnumtris);
+
+		for (i = 0; i < hdr->num_lods; i++)
+			hdr->num_lodtris += hdr->lodnumtris[i];
+
+		if (hdr->num_lodtris)
+			hdr->lodtriangles = (mtriangle_t *) MD5_HunkAlloc (hdr->num_lodtris * sizeof (mtriangle_t));
+
+		for (i = 0; i < hdr->num_lodtris; i++)
+		{
+			// facesfront goes with the triangle each one came from
+			hdr->lodtriangles[i].facesfront = mesh->triangles[lodsource[i]].facesfront;
+
+			for (k = 0; k < 3; k++)
+				hdr->lodtriangles[i].vertindex[k] = lodindexes[i * 3 + k];
+		}
+
+		MD5_DPrintf ("%s : %i triangles, %i levels of detail with %i, %i and %i\n", copyname, mesh->num_tris, hdr->num_lods,
+			hdr->lodnumtris[0], hdr->lodnumtris[1], hdr->lodnumtris[2]);
+	}
+
+	if (indexes) free (indexes);
+	if (lodindexes) free (lodindexes);
+	if (lodsource) free (lodsource);
+}
+
+
+/*
+==================
+MD5_BuildGeometry
+
+builds everything derived from freshly read mesh and animation files
+==================
+*/
+static qboolean MD5_BuildGeometry (md5header_t *hdr, char *copyname, float weldtolerance)
+{
+	int numdropped;
+	float maxerror;
+	double time;
+
+	if (hdr->md5anim.num_joints != hdr->md5mesh.num_joints)
+	{
+		MD5_DPrintf ("MD5_BuildGeometry : \"%s\" mesh and animation have different joints\n", copyname);
+		return false;
+	}
+
+	time = MD5_StageTime ();
+
+	// the vertex order is final after this
+	MD5_OptimizeVertexCache (hdr, copyname);
+	time = MD5_EndStage (MD5_STAGE_VCACHE, time);
+
+	// load the cullboxes
+	// some of the source MD5s were exported with bad cullboxes, so we must regenerate them correctly
+	MD5_MakeCullboxes (hdr, hdr->md5mesh.meshes, &hdr->md5anim);
+	time = MD5_EndStage (MD5_STAGE_CULLBOXES, time);
+
+	// build the baseframe normals
+	MD5_BuildBaseNormals (hdr, &hdr->md5mesh.meshes[0]);
+	MD5_WeldBaseNormals (hdr, weldtolerance);
+	time = MD5_EndStage (MD5_STAGE_NORMALS, time);
+
+	// and the weight stream for skinning, which needs the final normals
+	numdropped = MD5_BuildSkinStream (&hdr->md5mesh, &hdr->md5mesh.meshes[0], &hdr->md5anim, hdr->vnorms, &maxerror);
+	time = MD5_EndStage (MD5_STAGE_SKINSTREAM, time);
+
+	if (numdropped)
+		MD5_DPrintf ("%s : dropped weights from %i vertexes with more than %i\n", copyname, numdropped, MD5_MAX_INFLUENCES);
+
+	MD5_DPrintf ("%s : max skinning position error %f\n", copyname, maxerror);
+
+	// the levels of detail are simplified from the bind-pose positions and weights in the skin stream
+	MD5_BuildMeshLODs (hdr, copyname);
+	MD5_EndStage (MD5_STAGE_LODS, time);
+
+	if (hdr->md5anim.packed)
+		MD5_DPrintf ("%s : max packed joint position error %f\n", copyname, MD5_PackedAnimationError (&hdr->md5anim));
+
+	return true;
+}
+
+
+/*
+==================
+MD5_LoadSources
+
+maps the mesh and animation, and fills in what the cache is validated against from them.  nothing is copied, so when
+the cache is good the text is only ever read to check it; MD5_CopySource makes something that can be parsed.  both
+have to go back to COM_UnmapFile.
+==================
+*/
+static qboolean MD5_LoadSources (char *copyname, const byte **meshfile, const byte **animfile, md5cache_t *cache, qboolean packanim)
+{
+	char filename[MAX_OSPATH];
+
+	sprintf (filename, "%s.md5mesh", copyname);
+
+	if ((*meshfile = COM_MapFile (filename, &cache->meshlen)) == NULL)
+		return false;
+
+	sprintf (filename, "%s.md5anim", copyname);
+
+	if ((*animfile = COM_MapFile (filename, &cache->animlen)) == NULL)
+	{
+		COM_UnmapFile (*meshfile);
+		*meshfile = NULL;
+		return false;
+	}
+
+	cache->meshcrc = MD5_CRCBlock ((byte *) *meshfile, cache->meshlen);
+	cache->animcrc = MD5_CRCBlock ((byte *) *animfile, cache->animlen);
+	cache->animpacked = packanim ? 1 : 0;
+	cache->weldtolerance = (r_md5weldtolerance.value > 0) ? r_md5weldtolerance.value : 0;
+
+	return true;
+}
+
+
+/*
+==================
+MD5_CopySource
+
+the lexer needs the text 0 terminated, which a mapping isn't, and the loader thread needs it to stay around after the
+mapping has gone, so it's parsed from a copy
+==================
+*/
+static char *MD5_CopySource (const byte *file, int len)
+{
+	char *data = (char *) malloc (len + 1);
+
+	if (!data) Sys_Error ("MD5_CopySource : out of memory");
+
+	memcpy (data, file, len);
+	data[len] = 0;
+
+	return data;
+}
+
+
+/*
+==================
+MD5_BuildFromSource
+
+parses the mesh and animation and builds everything derived from them.  this runs on the loader thread for
+r_md5async so it only allocates with MD5_HunkAlloc and doesn't touch cvars, the filesystem or com_token; the
+settings to build with come from cache.
+==================
+*/
+static qboolean MD5_BuildFromSource (md5header_t *hdr, char *copyname, char *meshdata, char *animdata, md5cache_t *cache)
+{
+	struct md5_mesh_t *mesh;
+	struct md5_anim_t *anim = &hdr->md5anim;
+	float *rawframes = NULL;
+	qboolean packanim = cache->animpacked;
+	qboolean loaded = false;
+	char filename[MAX_OSPATH];
+	int mark = MD5_HunkLowMark ();
+	double time = MD5_StageTime ();
+
+	sprintf (filename, "%s.md5mesh", copyname);
+
+	if (!MD5_ReadMeshFile (filename, meshdata, &hdr->md5mesh))
+		return false;
+
+	time = MD5_EndStage (MD5_STAGE_PARSE, time);
+
+	if (!MD5_PackMeshes (hdr, mark))
+		return false;
+
+	time = MD5_EndStage (MD5_STAGE_PACK, time);
+
+	mesh = &hdr->md5mesh.meshes[0];
+	sprintf (filename, "%s.md5anim", copyname);
+
+	if (MD5_ReadAnimFile (filename, animdata, anim, packanim ? &rawframes : NULL))
+	{
+		time = MD5_EndStage (MD5_STAGE_PARSE, time);
+
+		if (packanim)
+			MD5_PackAnimation (anim, rawframes);
+
+		MD5_EndStage (MD5_STAGE_PACK, time);
+
+		loaded = MD5_BuildGeometry (hdr, copyname, cache->weldtolerance);
+	}
+
+	// the raw weights are only needed to build the skin stream
+	free (mesh->weights);
+	mesh->weights = NULL;
+	mesh->num_weights = 0;
+
+	// and a packed animation only needed the full skeletons while loading
+	if (packanim)
+	{
+		if (anim->skelFrames)
+		{
+			if (anim->skelFrames[0]) free (anim->skelFrames[0]);
+			free (anim->skelFrames);
+		}
+
+		if (rawframes) free (rawframes);
+
+		anim->skelFrames = NULL;
+	}
+
+	return loaded;
+}
+
+
+/*
+==================
+MD5_SaveCache
+
+==================
+*/
+static void MD5_SaveCache (md5header_t *hdr, char *cachename, md5cache_t *src)
+{
+	byte *data = MD5_BuildCache (hdr, src);
+
+	if (data)
+	{
+		MD5_WriteCache (cachename, data);
+		free (data);
+	}
+}
+
+
+/*
+==================
+MD5_LoadGeometry
+
+loads the mesh and animation and builds everything derived from them, using the cache if allowed
+==================
+*/
+static qboolean MD5_LoadGeometry (md5header_t *hdr, char *copyname, qboolean usecache, qboolean packanim)
+{
+	md5cache_t cache;
+	const byte *meshfile, *animfile;
+	char *meshdata, *animdata;
+	char cachename[MAX_OSPATH];
+	qboolean loaded = false;
+	double time = Sys_FloatTime ();
+
+	// the source files are always loaded so that the cache can be validated against them
+	if (!MD5_LoadSources (copyname, &meshfile, &animfile, &cache, packanim))
+		return false;
+
+	MD5_EndStage (MD5_STAGE_READ, time);
+
+	md5_sourcebytes += cache.meshlen + cache.animlen;
+
+	sprintf (cachename, "%s.md5c", copyname);
+
+	if (usecache && MD5_LoadCache (hdr, cachename, &cache))
+		loaded = true;
+	else
+	{
+		time = Sys_FloatTime ();
+
+		meshdata = MD5_CopySource (meshfile, cache.meshlen);
+		animdata = MD5_CopySource (animfile, cache.animlen);
+
+		MD5_EndStage (MD5_STAGE_READ, time);
+
+		if ((loaded = MD5_BuildFromSource (hdr, copyname, meshdata, animdata, &cache)) != false && usecache)
+			MD5_SaveCache (hdr, cachename, &cache); // so that we don't need to do it again
+
+		free (meshdata);
+		free (animdata);
+	}
+
+	COM_UnmapFile (meshfile);
+	COM_UnmapFile (animfile);
+
+	return loaded;
+}
+
+
+/*
+==============================================================================
+
+MD5 LOADER THREAD
+
+an MD5 that isn't in the cache is built on the loader thread (see md5_async.c) while the map is loading and the MDL
+it replaces stands in for it in the meantime.  the finished model comes back in the cache layout, which the main thread
+copies onto the hunk and points into the same as a cache file when the client signs on, then switches the model over.
+everything goes on the hunk before the game starts the same as when it's loaded without the thread, and the MDL takes
+the MD5's bounds when it's loaded so that the server sizes entities the same whichever is in place.
+
+==============================================================================
+*/
+
+typedef struct md5load_s
+{
+	// must be first; the loader thread only sees this
+	md5job_t job;
+
+	struct md5load_s *next;
+
+	// the MDL that's standing in; it's slot can be reused for something else by the time this is done
+	model_t *mod;
+	char name[MAX_QPATH];
+	char copyname[MAX_QPATH];
+
+	// copied off the MDL for MD5_FinishModel
+	int mdlframes;
+	int mdlflags;
+	int mdlsynctype;
+
+	// the MDL's own bounds, which it gets back if the MD5 can't be used
+	vec3_t mdlmins;
+	vec3_t mdlmaxs;
+
+	// the sources are owned by the loader thread until it's done
+	char *meshdata;
+	char *animdata;
+
+	// the settings it's built with, and the finished model in the cache layout, or NULL if it couldn't be built
+	md5cache_t settings;
+	byte *data;
+
+	// the map changed before it was done
+	qboolean cancelled;
+} md5load_t;
+
+// loads that haven't been committed yet; main thread only
+static md5load_t *md5_loads = NULL;
+
+
+/*
+==================
+MD5_BuildLoad
+
+runs on the loader thread
+==================
+*/
+static void MD5_BuildLoad (md5job_t *job)
+{
+	md5load_t *load = (md5load_t *) job;
+	md5header_t *hdr = (md5header_t *) MD5_HunkAlloc (sizeof (md5header_t));
+
+	if (MD5_BuildFromSource (hdr, load->copyname, load->meshdata, load->animdata, &load->settings))
+		load->data = MD5_BuildCache (hdr, &load->settings);
+
+	free (load->meshdata);
+	free (load->animdata);
+
+	load->meshdata = load->animdata = NULL;
+}
+
+
+/*
+==================
+MD5_QueueLoad
+
+returns true if the MD5 is being built on the loader thread, in which case it takes the sources and the caller
+should load the MDL instead
+==================
+*/
+static qboolean MD5_QueueLoad (model_t *mod, char *copyname, char *meshdata, char *animdata, md5cache_t *settings, int mdlframes, int mdlflags, int mdlsynctype)
+{
+	md5load_t *load;
+
+	// nothing would commit it on a dedicated server, or after the map's loaded
+	if (cls.state == ca_dedicated) return false;
+	if (!(sv.active && sv.state == ss_loading) && !(cls.state == ca_connected && cls.signon < SIGNONS)) return false;
+
+	if ((load = (md5load_t *) calloc (1, sizeof (md5load_t))) == NULL) return false;
+
+	load->job.build = MD5_BuildLoad;
+	load->mod = mod;
+	strcpy (load->name, mod->name);
+	strcpy (load->copyname, copyname);
+	load->mdlframes = mdlframes;
+	load->mdlflags = mdlflags;
+	load->mdlsynctype = mdlsynctype;
+	load->meshdata = meshdata;
+	load->animdata = animdata;
+	load->settings = *settings;
+
+	if (!MD5_QueueJob (&load->job))
+	{
+		free (load);
+		return false;
+	}
+
+	load->next = md5_loads;
+	md5_loads = load;
+
+	return true;
+}
+
+
+/*
+==================
+MD5_PendingLoad
+
+the load mod is waiting for the loader thread on, if any
+==================
+*/
+static md5load_t *MD5_PendingLoad (model_t *mod)
+{
+	md5load_t *load;
+
+	for (load = md5_loads; load; load = load->next)
+		if (load->mod == mod && !load->cancelled && !strcmp (load->name, mod->name))
+			return load;
+
+	return NULL;
+}
+
+
+/*
+==================
+MD5_SetMDLProperties
+
+==================
+*/
+static void MD5_SetMDLProperties (model_t *mod, int mdlflags, int mdlsynctype)
+{
+	// mh - using certain properties the same as the source MDL
+	// don't change the physics cullboxes; instead we'll use the per-frame cullboxes stored in the MD5 itself.
+	mod->mins[0] = mod->mins[1] = mod->mins[2] = -16;
+	mod->maxs[0] = mod->maxs[1] = mod->maxs[2] = 16;
+
+	// copy these over as well
+	mod->flags = mdlflags;
+	mod->synctype = mdlsynctype;
+}
+
 
+/*
+==================
+MD5_StandIn
+
+called once the MDL is loaded; if it's standing in for an MD5 on the loader thread it takes the MD5's bounds, flags
+and synctype now, so that only what's drawn changes when the MD5 is switched in
 ==================
 */
-qboolean Mod_LoadMD5Model (model_t *mod, void *buffer)
+void MD5_StandIn (model_t *mod)
 {
-	// retain a pointer to the original MDL so that we can copy over and validate some data
-	mdl_t *pinmodel = (mdl_t *) buffer;
+	md5load_t *load = MD5_PendingLoad (mod);
 
-	// copy these off for use and validation
-	int mdlframes = LittleLong (pinmodel->numframes);
-	int mdlflags = LittleLong (pinmodel->flags);
-	int mdlsynctype = LittleLong (pinmodel->synctype);
+	if (!load) return;
 
-	// we can't change the original model name so we must copy it off for loading
-	char copyname[64];
+	VectorCopy (mod->mins, load->mdlmins);
+	VectorCopy (mod->maxs, load->mdlmaxs);
 
-	// everything after this is freed if the load fails
-	int mark = Hunk_LowMark ();
+	MD5_SetMDLProperties (mod, load->mdlflags, load->mdlsynctype);
+}
 
-	// alloc header space
-	md5header_t *hdr = (md5header_t *) Hunk_Alloc (sizeof (md5header_t));
 
-	// get the baseline name
-	COM_StripExtension (mod->name, copyname);
+/*
+==================
+MD5_CancelLoads
+
+called when all models are cleared; whatever's still on the loader thread is thrown away when it's done
+==================
+*/
+void MD5_CancelLoads (void)
+{
+	md5load_t *load;
+
+	for (load = md5_loads; load; load = load->next)
+	{
+		model_t *mod = load->mod;
+
+		if (load->cancelled) continue;
+
+		load->cancelled = true;
+
+		// flush the MDL that was standing in so that it's loaded again, and the MD5 queued again, if it's still used
+		if (mod->type == mod_alias && !strcmp (load->name, mod->name) && Cache_Check (&mod->cache))
+			Cache_Free (&mod->cache);
+	}
+}
 
-	// look for a mesh
-	if (!MD5_ReadMeshFile (va ("%s.md5mesh", copyname), &hdr->md5mesh)) goto md5_bad;
 
-	// look for an animation
-	if (!MD5_ReadAnimFile (va ("%s.md5anim", copyname), &hdr->md5anim)) goto md5_bad;
+/*
+==================
+MD5_FinishModel
+
+everything after the geometry, which is the same however it was loaded; frees back to mark if it fails
+==================
+*/
+static qboolean MD5_FinishModel (model_t *mod, md5header_t *hdr, char *copyname, int mdlframes, int mdlflags, int mdlsynctype, int mark)
+{
+	int i;
 
 	// validate the frames
 	if (hdr->md5anim.num_frames == 2 && mdlframes == 1)
@@ -911,38 +2840,31 @@ qboolean Mod_LoadMD5Model (model_t *mod, void *buffer)
 	else if (hdr->md5anim.num_frames > 65536)
 		goto md5_bad; // exceeds protocol maximum
 
-	// the MD5 spec allows for more than 1 mesh but we don't need to support it for Quake21 content
-	if (hdr->md5mesh.num_meshes > 1) goto md5_bad;
-
-	// load the cullboxes
-	// some of the source MD5s were exported with bad cullboxes, so we must regenerate them correctly
-	MD5_MakeCullboxes (hdr, hdr->md5mesh.meshes, &hdr->md5anim);
-
-	// allocate memory for the animated skeleton
-	hdr->skeleton = (struct md5_joint_t *) Hunk_Alloc (sizeof (struct md5_joint_t) * hdr->md5anim.num_joints);
+	// the MDL was standing in while this was on the loader thread
+	if (mod->type == mod_alias && Cache_Check (&mod->cache))
+		Cache_Free (&mod->cache);
 
-	// fix up mirron seam verts
-	R_DuplicateMirroredVertexes (&hdr->md5mesh.meshes[0]);
+	// allocate memory for the animated skeleton and the joint matrices it's converted to for skinning
+	hdr->skeleton = (struct md5_pose_t *) Hunk_Alloc (sizeof (struct md5_pose_t) * hdr->md5anim.num_joints);
+	hdr->palette = (md5_jointmat_t *) Hunk_Alloc (sizeof (md5_jointmat_t) * hdr->md5anim.num_joints);
 
-	// build the baseframe normals
-	MD5_BuildBaseNormals (hdr, &hdr->md5mesh.meshes[0]);
-	MD5_WeldNormals (hdr);
+	// load textures from .lmp files for each submesh
+	for (i = 0; i < hdr->num_submeshes; i++)
+		MD5_LoadSkins (&hdr->submeshes[i]);
 
-	// load textures from .lmp files
-	MD5_LoadSkins (hdr, hdr->md5mesh.meshes[0].shader);
+	// report what the poses save over storing a full named joint per frame (and for the animated skeleton)
+	if (hdr->md5anim.packed)
+		Con_DPrintf ("%s : %i bytes of hunk (animation packed to %i of %i bytes)\n", copyname, Hunk_LowMark () - mark,
+			hdr->md5anim.num_frames * hdr->md5anim.packed->framesize * (int) sizeof (short),
+			hdr->md5anim.num_frames * hdr->md5anim.num_joints * (int) sizeof (struct md5_pose_t));
+	else Con_DPrintf ("%s : %i bytes of hunk (was %i with named joints)\n", copyname, Hunk_LowMark () - mark,
+		Hunk_LowMark () - mark + (hdr->md5anim.num_frames + 1) * hdr->md5anim.num_joints * (int) (sizeof (struct md5_joint_t) - sizeof (struct md5_pose_t)));
 
 	// and done
 	mod->cache.data = hdr;
 	mod->type = mod_md5;
 
-	// mh - using certain properties the same as the source MDL
-	// don't change the physics cullboxes; instead we'll use the per-frame cullboxes stored in the MD5 itself.
-	mod->mins[0] = mod->mins[1] = mod->mins[2] = -16;
-	mod->maxs[0] = mod->maxs[1] = mod->maxs[2] = 16;
-
-	// copy these over as well
-	mod->flags = mdlflags;
-	mod->synctype = mdlsynctype;
+	MD5_SetMDLProperties (mod, mdlflags, mdlsynctype);
 
 	// and done
 	return true;
@@ -956,3 +2878,409 @@ md5_bad:;
 	return false;
 }
 
+
+/*
+==================
+MD5_CommitLoad
+
+==================
+*/
+static void MD5_CommitLoad (md5load_t *load)
+{
+	model_t *mod = load->mod;
+	md5header_t *hdr;
+	byte *data;
+	char cachename[MAX_OSPATH];
+	int mark;
+
+	// the MDL isn't what it was queued for any more
+	if (load->cancelled) return;
+	if (mod->type != mod_alias || strcmp (load->name, mod->name)) return;
+
+	// it couldn't be built, so the MDL stays with it's own bounds
+	if (!load->data)
+	{
+		VectorCopy (load->mdlmins, mod->mins);
+		VectorCopy (load->mdlmaxs, mod->maxs);
+		return;
+	}
+
+	// it's just as good as one read from disk, so save it the same
+	if (r_md5cache.value)
+	{
+		sprintf (cachename, "%s.md5c", load->copyname);
+		MD5_WriteCache (cachename, load->data);
+	}
+
+	// everything after this is freed if the load fails
+	mark = Hunk_LowMark ();
+
+	hdr = (md5header_t *) Hunk_Alloc (sizeof (md5header_t));
+	data = (byte *) Hunk_Alloc (((md5cache_t *) load->data)->filelen);
+
+	memcpy (data, load->data, ((md5cache_t *) load->data)->filelen);
+	MD5_PointIntoCache (hdr, data);
+
+	if (MD5_FinishModel (mod, hdr, load->copyname, load->mdlframes, load->mdlflags, load->mdlsynctype, mark))
+		Con_DPrintf ("%s : switched to the MD5\n", load->copyname);
+	else
+	{
+		VectorCopy (load->mdlmins, mod->mins);
+		VectorCopy (load->mdlmaxs, mod->maxs);
+	}
+}
+
+
+/*
+==================
+MD5_CommitLoads
+
+called by the client as it signs on to wait for the MD5s the map uses to finish on the loader thread and switch them in
+==================
+*/
+void MD5_CommitLoads (void)
+{
+	md5load_t **prev = &md5_loads;
+	md5load_t *load;
+
+	while ((load = *prev) != NULL)
+	{
+		// cancelled loads are thrown away whenever they happen to be done
+		if (load->cancelled && !MD5_JobDone (&load->job))
+		{
+			prev = &load->next;
+			continue;
+		}
+
+		MD5_WaitJob (&load->job);
+
+		*prev = load->next;
+
+		MD5_ReleaseJob (&load->job);
+		MD5_CommitLoad (load);
+
+		if (load->data) free (load->data);
+		free (load);
+	}
+}
+
+
+/*
+==================
+MD5_TimeLoad_f
+
+compares load times for all currently loaded MD5s with and without the cache
+==================
+*/
+void MD5_TimeLoad_f (void)
+{
+	extern model_t	mod_known[];
+	extern int		mod_numknown;
+
+	double textime = 0, cachetime = 0;
+	int i, nummd5s = 0;
+
+	Con_Printf ("model                              text ms  cache ms\n");
+
+	for (i = 0; i < mod_numknown; i++)
+	{
+		model_t *mod = &mod_known[i];
+		int mark = Hunk_LowMark ();
+		double time1, time2, time3;
+		char copyname[64];
+
+		if (mod->type != mod_md5) continue;
+
+		COM_StripExtension (mod->name, copyname);
+
+		// everything is thrown away after each load
+		time1 = Sys_FloatTime ();
+		MD5_LoadGeometry ((md5header_t *) Hunk_Alloc (sizeof (md5header_t)), copyname, false, r_md5animcompress.value);
+		Hunk_FreeToLowMark (mark);
+
+		time2 = Sys_FloatTime ();
+		MD5_LoadGeometry ((md5header_t *) Hunk_Alloc (sizeof (md5header_t)), copyname, true, r_md5animcompress.value);
+		Hunk_FreeToLowMark (mark);
+
+		time3 = Sys_FloatTime ();
+
+		Con_Printf ("%-32s %9.2f %9.2f\n", mod->name, (time2 - time1) * 1000.0, (time3 - time2) * 1000.0);
+
+		textime += time2 - time1;
+		cachetime += time3 - time2;
+		nummd5s++;
+	}
+
+	Con_Printf ("%i MD5s, %.2f ms from text, %.2f ms from cache\n", nummd5s, textime * 1000.0, cachetime * 1000.0);
+}
+
+
+/*
+==================
+MD5_TimeAnim_f
+
+compares memory use and decode cost of packed animations for all currently loaded MD5s
+==================
+*/
+void MD5_TimeAnim_f (void)
+{
+	extern model_t	mod_known[];
+	extern int		mod_numknown;
+
+	int fullbytes = 0, packedbytes = 0;
+	int i, nummd5s = 0;
+
+	Con_Printf ("model                            frames joints  full KB packed KB  us/pose\n");
+
+	for (i = 0; i < mod_numknown; i++)
+	{
+		model_t *mod = &mod_known[i];
+		int mark = Hunk_LowMark ();
+		md5header_t *hdr;
+		struct md5_anim_t *anim;
+		struct md5_pose_t *skeleton;
+		double time1, time2;
+		int full, packed, f, pass;
+		char copyname[64];
+
+		if (mod->type != mod_md5) continue;
+
+		COM_StripExtension (mod->name, copyname);
+
+		// load it fresh and packed whatever r_md5animcompress is; everything is thrown away after
+		hdr = (md5header_t *) Hunk_Alloc (sizeof (md5header_t));
+
+		if (!MD5_LoadGeometry (hdr, copyname, false, true))
+		{
+			Hunk_FreeToLowMark (mark);
+			continue;
+		}
+
+		anim = &hdr->md5anim;
+		skeleton = (struct md5_pose_t *) Hunk_Alloc (sizeof (struct md5_pose_t) * anim->num_joints);
+
+		full = anim->num_frames * anim->num_joints * sizeof (struct md5_pose_t);
+		packed = anim->num_frames * anim->packed->framesize * sizeof (short) + anim->num_joints * (sizeof (struct baseframe_joint_t) + sizeof (float));
+
+		// decode every frame enough times to get a stable timing
+		time1 = Sys_FloatTime ();
+
+		for (pass = 0; pass < 16; pass++)
+			for (f = 0; f < anim->num_frames; f++)
+				MD5_UnpackFrameSkeleton (anim, f, skeleton);
+
+		time2 = Sys_FloatTime ();
+
+		Con_Printf ("%-32s %6i %6i %8.1f %9.1f %8.2f\n", mod->name, anim->num_frames, anim->num_joints, full / 1024.0, packed / 1024.0,
+			(time2 - time1) * 1000000.0 / (16 * anim->num_frames));
+
+		fullbytes += full;
+		packedbytes += packed;
+		nummd5s++;
+
+		Hunk_FreeToLowMark (mark);
+	}
+
+	// nothing cached can point into the freed hunk
+	MD5_FlushPoseCache ();
+
+	Con_Printf ("%i MD5s, %i KB full, %i KB packed\n", nummd5s, fullbytes / 1024, packedbytes / 1024);
+}
+
+
+/*
+==================
+MD5_Benchmark
+
+loads an MD5 from it's source files and reports the time taken by each stage of the load, then skins every pair of
+neighbouring frames at numblends evenly spaced blends (starting from 0, which skins straight from the first frame) for
+the given number of iterations and reports the throughput.  everything is thrown away after.
+returns the number of vertexes skinned, or 0 if it couldn't be loaded.
+==================
+*/
+double MD5_Benchmark (char *copyname, int iterations, int numblends)
+{
+	int mark = Hunk_LowMark ();
+	md5header_t *hdr = (md5header_t *) Hunk_Alloc (sizeof (md5header_t));
+	struct md5_anim_t *anim = &hdr->md5anim;
+	struct md5_mesh_t *mesh;
+	struct md5_pose_t *skeleton, *scratch;
+	double time1, time2, numskinned = 0;
+	int i, f, b, hunkbytes;
+
+	memset (md5_stagetimes, 0, sizeof (md5_stagetimes));
+	md5_sourcebytes = 0;
+
+	time1 = Sys_FloatTime ();
+
+	if (!MD5_LoadGeometry (hdr, copyname, false, r_md5animcompress.value))
+	{
+		Con_Printf ("benchmd5 : couldn't load \"%s\"\n", copyname);
+		Hunk_FreeToLowMark (mark);
+		return 0;
+	}
+
+	time2 = Sys_FloatTime ();
+	hunkbytes = Hunk_LowMark () - mark;
+	mesh = &hdr->md5mesh.meshes[0];
+
+	Con_Printf ("%s : %i vertexes, %i triangles, %i submeshes, %i joints, %i frames, %i levels of detail\n", copyname,
+		mesh->num_verts, mesh->num_tris, hdr->num_submeshes, anim->num_joints, anim->num_frames, hdr->num_lods);
+
+	for (i = 0; i < MD5_NUM_STAGES; i++)
+	{
+		if (i == MD5_STAGE_PARSE && md5_stagetimes[i] > 0)
+			Con_Printf ("  %-18s %9.2f ms, %.1f MB/s of text\n", md5_stagenames[i], md5_stagetimes[i] * 1000.0, md5_sourcebytes / (md5_stagetimes[i] * 1024.0 * 1024.0));
+		else Con_Printf ("  %-18s %9.2f ms\n", md5_stagenames[i], md5_stagetimes[i] * 1000.0);
+	}
+
+	Con_Printf ("  %-18s %9.2f ms, %i KB of hunk\n", "total", (time2 - time1) * 1000.0, hunkbytes / 1024);
+
+	// the interpolated skeleton and space for unpacking the frames of a packed animation
+	skeleton = (struct md5_pose_t *) Hunk_Alloc (sizeof (struct md5_pose_t) * anim->num_joints);
+	scratch = (struct md5_pose_t *) Hunk_Alloc (sizeof (struct md5_pose_t) * anim->num_joints * 2);
+	hdr->palette = (md5_jointmat_t *) Hunk_Alloc (sizeof (md5_jointmat_t) * anim->num_joints);
+
+	time1 = Sys_FloatTime ();
+
+	for (i = 0; i < iterations; i++)
+	{
+		for (f = 0; f < anim->num_frames; f++)
+		{
+			const struct md5_pose_t *skel1 = MD5_FramePose (anim, f, scratch);
+			const struct md5_pose_t *skel2 = MD5_FramePose (anim, (f + 1) % anim->num_frames, scratch + anim->num_joints);
+
+			for (b = 0; b < numblends; b++)
+			{
+				if (b)
+				{
+					MD5_InterpolateSkeletons (skel1, skel2, anim->num_joints, (float) b / numblends, skeleton);
+					MD5_SkinMesh (&hdr->md5mesh, mesh, skeleton, hdr->palette, hdr->vertexes->position, sizeof (md5polyvert_t) / sizeof (float),
+						hdr->vertexes->normal, sizeof (md5polyvert_t) / sizeof (float));
+				}
+				else MD5_SkinMesh (&hdr->md5mesh, mesh, skel1, hdr->palette, hdr->vertexes->position, sizeof (md5polyvert_t) / sizeof (float),
+					hdr->vertexes->normal, sizeof (md5polyvert_t) / sizeof (float));
+
+				numskinned += mesh->num_verts;
+			}
+		}
+	}
+
+	time2 = Sys_FloatTime ();
+
+	if (numskinned > 0 && time2 > time1)
+	{
+		Con_Printf ("  skinned %i poses (%i frame pairs x %i blends x %i iterations)\n", anim->num_frames * numblends * iterations,
+			anim->num_frames, numblends, iterations);
+		Con_Printf ("  %.2f ms, %.0f vertexes/sec, %.2f ns/vertex\n", (time2 - time1) * 1000.0, numskinned / (time2 - time1),
+			(time2 - time1) * 1000000000.0 / numskinned);
+	}
+
+	// nothing cached can point into the freed hunk
+	MD5_FlushPoseCache ();
+	Hunk_FreeToLowMark (mark);
+
+	return numskinned;
+}
+
+
+/*
+==================
+MD5_Benchmark_f
+
+==================
+*/
+void MD5_Benchmark_f (void)
+{
+	int iterations = (Cmd_Argc () > 2) ? atoi (Cmd_Argv (2)) : 16;
+	int numblends = (Cmd_Argc () > 3) ? atoi (Cmd_Argv (3)) : 4;
+	char copyname[64];
+
+	if (Cmd_Argc () < 2 || iterations < 1 || numblends < 1)
+	{
+		Con_Printf ("usage : benchmd5 <model> [iterations] [blends]\n");
+		return;
+	}
+
+	COM_StripExtension (Cmd_Argv (1), copyname);
+	MD5_Benchmark (copyname, iterations, numblends);
+}
+
+
+/*
+==================
+Mod_LoadMD5Model
+
+==================
+*/
+qboolean Mod_LoadMD5Model (model_t *mod, void *buffer)
+{
+	// retain a pointer to the original MDL so that we can copy over and validate some data
+	mdl_t *pinmodel = (mdl_t *) buffer;
+
+	// copy these off for use and validation
+	int mdlframes = LittleLong (pinmodel->numframes);
+	int mdlflags = LittleLong (pinmodel->flags);
+	int mdlsynctype = LittleLong (pinmodel->synctype);
+
+	// we can't change the original model name so we must copy it off for loading
+	char copyname[64];
+	char cachename[MAX_OSPATH];
+	md5cache_t cache;
+	const byte *meshfile, *animfile;
+	char *meshdata, *animdata;
+	qboolean loaded = false;
+	md5header_t *hdr;
+
+	// everything after this is freed if the load fails
+	int mark = Hunk_LowMark ();
+
+	// get the baseline name
+	COM_StripExtension (mod->name, copyname);
+
+	// the MDL is used until the loader thread is done with it
+	if (MD5_PendingLoad (mod)) return false;
+
+	// the source files are always loaded so that the cache can be validated against them
+	if (!MD5_LoadSources (copyname, &meshfile, &animfile, &cache, r_md5animcompress.value)) return false;
+
+	sprintf (cachename, "%s.md5c", copyname);
+
+	// alloc header space
+	hdr = (md5header_t *) Hunk_Alloc (sizeof (md5header_t));
+
+	// load the mesh and animation
+	if (r_md5cache.value && MD5_LoadCache (hdr, cachename, &cache))
+		loaded = true;
+	else
+	{
+		meshdata = MD5_CopySource (meshfile, cache.meshlen);
+		animdata = MD5_CopySource (animfile, cache.animlen);
+
+		if (MD5_QueueLoad (mod, copyname, meshdata, animdata, &cache, mdlframes, mdlflags, mdlsynctype))
+		{
+			// the loader thread has the sources now and MD5_CommitLoads switches the model over when it's done
+			COM_UnmapFile (meshfile);
+			COM_UnmapFile (animfile);
+			Hunk_FreeToLowMark (mark);
+			return false;
+		}
+
+		if ((loaded = MD5_BuildFromSource (hdr, copyname, meshdata, animdata, &cache)) != false && r_md5cache.value)
+			MD5_SaveCache (hdr, cachename, &cache);
+
+		free (meshdata);
+		free (animdata);
+	}
+
+	COM_UnmapFile (meshfile);
+	COM_UnmapFile (animfile);
+
+	if (!loaded)
+	{
+		Hunk_FreeToLowMark (mark);
+		return false;
+	}
+
+	return MD5_FinishModel (mod, hdr, copyname, mdlframes, mdlflags, mdlsynctype, mark);
+}
@@ -45,6 +45,19 @@ int		mod_numknown;
 #define NL_NEEDS_LOADED	1
 #define NL_UNREFERENCED	2
 
+extern cvar_t r_md5cache;
+extern cvar_t r_md5animcompress;
+void MD5_TimeLoad_f (void);
+void MD5_TimeAnim_f (void);
+
+extern cvar_t r_md5weldtolerance;
+void MD5_TimeWeld_f (void);
+
+void MD5_Benchmark_f (void);
+
+extern cvar_t r_md5async;
+extern cvar_t r_md5parsethreads;
+
 /*
 ===============
 Mod_Init
@@ -53,6 +66,27 @@ Mod_Init
 void Mod_Init (void)
 {
 	memset (mod_novis, 0xff, sizeof(mod_novis));
+
+	// mh - MD5 cache
+	Cvar_RegisterVariable (&r_md5cache);
+	Cmd_AddCommand ("timemd5load", MD5_TimeLoad_f);
+
+	// mh - packed MD5 animations
+	Cvar_RegisterVariable (&r_md5animcompress);
+	Cmd_AddCommand ("timemd5anim", MD5_TimeAnim_f);
+
+	// mh - MD5 normal welding
+	Cvar_RegisterVariable (&r_md5weldtolerance);
+	Cmd_AddCommand ("timemd5weld", MD5_TimeWeld_f);
+
+	// mh - MD5 load and skinning benchmark; also built standalone as md5bench
+	Cmd_AddCommand ("benchmd5", MD5_Benchmark_f);
+
+	// mh - MD5 loader thread
+	Cvar_RegisterVariable (&r_md5async);
+
+	// mh - MD5 parse threads
+	Cvar_RegisterVariable (&r_md5parsethreads);
 }
 
 /*
@@ -170,6 +204,8 @@ void Mod_ClearAll (void)
 	int		i;
 	model_t	*mod;
 
+	// mh - nothing still on the MD5 loader thread can be switched in after this
+	MD5_CancelLoads ();
 
 	for (i=0 , mod=mod_known ; i<mod_numknown ; i++, mod++) {
 		mod->needload = NL_UNREFERENCED;
@@ -241,7 +277,7 @@ void Mod_TouchModel (char *name)
 	model_t	*mod;
 	
 	mod = Mod_FindName (name);
-	
+
 	if (mod->needload == NL_PRESENT)
 	{
 		if (mod->type == mod_alias)
@@ -249,6 +285,25 @@ void Mod_TouchModel (char *name)
 	}
 }
 
+/*
+==================
+Mod_IsLoaded
+
+mh - false if Mod_ForName will have to load the model from disk
+==================
+*/
+qboolean Mod_IsLoaded (char *name)
+{
+	model_t	*mod;
+
+	mod = Mod_FindName (name);
+
+	if (mod->type == mod_alias)
+		return Cache_Check (&mod->cache) != NULL;
+
+	return mod->needload == NL_PRESENT;
+}
+
 /*
 ==================
 Mod_LoadModel
@@ -260,6 +315,9 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 {
 	unsigned *buf;
 	byte	stackbuf[1024];		// avoid dirtying the cache heap
+	const byte	*mapped; // mh
+	int		len;
+	int		load; // mh
 
 	if (mod->type == mod_alias)
 	{
@@ -282,13 +340,28 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 //
 // load the file
 //
-	buf = (unsigned *)COM_LoadStackFile (mod->name, stackbuf, sizeof(stackbuf));
-	if (!buf)
+	load = Prof_Begin (PROF_MODEL, mod->name);
+
+	// mh - a brush model is read straight from the file; the others are byte-swapped in place so they get a copy
+	if ((mapped = COM_MapFile (mod->name, &len)) == NULL)
 	{
+		Prof_End (load);
 		if (crash)
 			Sys_Error ("Mod_NumForName: %s not found", mod->name);
 		return NULL;
 	}
+
+	if (len < 4 || LittleLong (*(unsigned *)mapped) == IDPOLYHEADER || LittleLong (*(unsigned *)mapped) == IDSPRITEHEADER)
+	{
+		buf = (len + 1 > sizeof(stackbuf)) ? (unsigned *)Hunk_TempAlloc (len + 1) : (unsigned *)stackbuf;
+		memcpy (buf, mapped, len);
+		((byte *)buf)[len] = 0;
+
+		COM_UnmapFile (mapped);
+		mapped = NULL;
+	}
+	else
+		buf = (unsigned *)mapped;
 	
 //
 // allocate a new model
@@ -307,19 +380,31 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 	switch (LittleLong(*(unsigned *)buf))
 	{
 	case IDPOLYHEADER:
-		if (!Mod_LoadMD5Model (mod, buf))
+		if (Mod_LoadMD5Model (mod, buf))
+			Prof_SetType (load, PROF_MD5MODEL);
+		else
+		{
+			Prof_SetType (load, PROF_ALIASMODEL);
 			Mod_LoadAliasModel (mod, buf);
+			MD5_StandIn (mod);
+		}
 		break;
 		
 	case IDSPRITEHEADER:
+		Prof_SetType (load, PROF_SPRITEMODEL);
 		Mod_LoadSpriteModel (mod, buf);
 		break;
 	
 	default:
+		Prof_SetType (load, PROF_BRUSHMODEL);
 		Mod_LoadBrushModel (mod, buf);
 		break;
 	}
 
+	COM_UnmapFile (mapped);
+
+	Prof_End (load);
+
 	return mod;
 }
 
@@ -364,6 +449,7 @@ void Mod_LoadTextures (lump_t *l)
 	texture_t	*anims[10];
 	texture_t	*altanims[10];
 	dmiptexlump_t *m;
+	int		nummiptex, dataofs, width, height; // mh
 
 	if (!l->filelen)
 	{
@@ -372,33 +458,31 @@ void Mod_LoadTextures (lump_t *l)
 	}
 	m = (dmiptexlump_t *)(mod_base + l->fileofs);
 	
-	m->nummiptex = LittleLong (m->nummiptex);
+	nummiptex = LittleLong (m->nummiptex); // mh - the bsp is read-only now, so nothing in it is swapped in place
 	
-	loadmodel->numtextures = m->nummiptex;
-	loadmodel->textures = Hunk_AllocName (m->nummiptex * sizeof(*loadmodel->textures) , loadname);
+	loadmodel->numtextures = nummiptex;
+	loadmodel->textures = Hunk_AllocName (nummiptex * sizeof(*loadmodel->textures) , loadname);
 
-	for (i=0 ; i<m->nummiptex ; i++)
+	for (i=0 ; i<nummiptex ; i++)
 	{
-		m->dataofs[i] = LittleLong(m->dataofs[i]);
-		if (m->dataofs[i] == -1)
+		dataofs = LittleLong (m->dataofs[i]);
+		if (dataofs == -1)
 			continue;
-		mt = (miptex_t *)((byte *)m + m->dataofs[i]);
-		mt->width = LittleLong (mt->width);
-		mt->height = LittleLong (mt->height);
-		for (j=0 ; j<MIPLEVELS ; j++)
-			mt->offsets[j] = LittleLong (mt->offsets[j]);
+		mt = (miptex_t *)((byte *)m + dataofs);
+		width = LittleLong (mt->width);
+		height = LittleLong (mt->height);
 		
-		if ( (mt->width & 15) || (mt->height & 15) )
+		if ( (width & 15) || (height & 15) )
 			Sys_Error ("Texture %s is not 16 aligned", mt->name);
-		pixels = mt->width*mt->height/64*85;
+		pixels = width*height/64*85;
 		tx = Hunk_AllocName (sizeof(texture_t) +pixels, loadname );
 		loadmodel->textures[i] = tx;
 
 		memcpy (tx->name, mt->name, sizeof(tx->name));
-		tx->width = mt->width;
-		tx->height = mt->height;
+		tx->width = width;
+		tx->height = height;
 		for (j=0 ; j<MIPLEVELS ; j++)
-			tx->offsets[j] = mt->offsets[j] + sizeof(texture_t) - sizeof(miptex_t);
+			tx->offsets[j] = LittleLong (mt->offsets[j]) + sizeof(texture_t) - sizeof(miptex_t);
 		// the pixels immediately follow the structures
 		memcpy ( tx+1, mt+1, pixels);
 		
@@ -409,7 +493,7 @@ void Mod_LoadTextures (lump_t *l)
 //
 // sequence the animations
 //
-	for (i=0 ; i<m->nummiptex ; i++)
+	for (i=0 ; i<nummiptex ; i++)
 	{
 		tx = loadmodel->textures[i];
 		if (!tx || tx->name[0] != '+')
@@ -442,7 +526,7 @@ void Mod_LoadTextures (lump_t *l)
 		else
 			Sys_Error ("Bad animating texture %s", tx->name);
 
-		for (j=i+1 ; j<m->nummiptex ; j++)
+		for (j=i+1 ; j<nummiptex ; j++)
 		{
 			tx2 = loadmodel->textures[j];
 			if (!tx2 || tx2->name[0] != '+')
@@ -1148,6 +1232,7 @@ void Mod_LoadBrushModel (model_t *mod, void *buffer)
 {
 	int			i, j;
 	dheader_t	*header;
+	dheader_t	swapped; // mh
 	dmodel_t 	*bm;
 	
 	loadmodel->type = mod_brush;
@@ -1161,6 +1246,10 @@ void Mod_LoadBrushModel (model_t *mod, void *buffer)
 // swap all the lumps
 	mod_base = (byte *)header;
 
+	// mh - into a copy, as the file is read-only now
+	swapped = *header;
+	header = &swapped;
+
 	for (i=0 ; i<sizeof(dheader_t)/4 ; i++)
 		((int *)header)[i] = LittleLong ( ((int *)header)[i]);
 
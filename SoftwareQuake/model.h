@@ -314,6 +314,15 @@ struct md5_joint_t
 	quat4_t orient;
 };
 
+// Pose joint; animated skeletons only need the position and orientation so the names and parents are kept once in md5_anim_t::hierarchy
+struct md5_pose_t
+{
+	vec3_t pos;
+	float pad; // keeps orient 16-byte aligned and the struct at 32 bytes
+
+	quat4_t orient;
+};
+
 // Vertex
 struct md5_vertex_t
 {
@@ -337,13 +346,42 @@ struct md5_bbox_t
 {
 	vec3_t min;
 	vec3_t max;
+	float radius; // bounding sphere around the centre of the box
+};
+
+// number of vertexes skinned together by the palette skinning kernels
+#define MD5_SKIN_LANES	4
+
+// most joints that can move a single vertex; lighter weights are dropped at load time
+#define MD5_MAX_INFLUENCES	4
+
+// quantized biases are fractions of this
+#define MD5_BIAS_ONE	65535
+
+// joint indexes in the skin stream are bytes
+#define MAX_MD5_JOINTS	256
+
+// joint matrix for palette skinning
+typedef float md5_jointmat_t[3][4];
+
+// a group of MD5_SKIN_LANES vertexes in bind-pose space and up to MD5_MAX_INFLUENCES weights for each, stored as
+// structure-of-arrays for the skinning kernels
+struct md5_skinblock_t
+{
+	float pos[3][MD5_SKIN_LANES];
+	float normal[3][MD5_SKIN_LANES];
+
+	unsigned short bias[MD5_MAX_INFLUENCES][MD5_SKIN_LANES];
+	byte joint[MD5_MAX_INFLUENCES][MD5_SKIN_LANES];
+
+	int numslots; // most influences used by any vertex in the block
 };
 
 // MD5 mesh
 struct md5_mesh_t
 {
 	struct md5_vertex_t *vertices;
-	struct md5_weight_t *weights;
+	struct md5_weight_t *weights; // only kept while loading
 
 	// needs to mirror mtriangle_t for alias models so that they can use the same drawing routines
 	mtriangle_t *triangles;
@@ -352,6 +390,10 @@ struct md5_mesh_t
 	int num_tris;
 	int num_weights;
 
+	// weight stream for the palette skinning kernels
+	struct md5_skinblock_t *skinblocks;
+	int num_skinblocks;
+
 	int num_mirrored_verts;
 	int *mirrored_vertices;
 
@@ -364,19 +406,39 @@ struct md5_model_t
 	struct md5_joint_t *baseSkel;
 	struct md5_mesh_t *meshes;
 
+	// inverse of baseSkel for the palette, built with the skin stream
+	md5_jointmat_t *invbind;
+
 	int num_joints;
 	int num_meshes;
 };
 
+// quantized animated components, kept instead of full skeletons when r_md5animcompress is set at load time; positions
+// are 16-bit offsets from the baseframe and orientations are smallest-three quaternions in 3 shorts
+struct md5_packedanim_t
+{
+	struct baseframe_joint_t *baseFrame;
+	float *posscale; // per joint, from a 16-bit offset to units
+
+	short *frames;
+	int framesize; // shorts per frame
+};
+
 // Animation data
 struct md5_anim_t
 {
 	int num_frames;
 	int num_joints;
 	int frameRate;
+	int num_components; // animated components per frame
 
-	struct md5_joint_t **skelFrames;
+	struct md5_pose_t **skelFrames; // NULL when packed; use MD5_FramePose to get at a frame
 	struct md5_bbox_t *bboxes;
+
+	// names, parents and animated components for each joint, shared by all frames
+	struct joint_info_t *hierarchy;
+
+	struct md5_packedanim_t *packed;
 };
 
 
@@ -403,11 +465,52 @@ typedef struct vertexnormals_s
 	float normal[3];
 } vertexnormals_t;
 
+// mod_md5.c
+const struct md5_pose_t *MD5_FramePose (const struct md5_anim_t *anim, int frame, struct md5_pose_t *scratch);
+void MD5_FlushPoseCache (void);
+void MD5_CommitLoads (void);
+void MD5_CancelLoads (void);
+double MD5_Benchmark (char *copyname, int iterations, int numblends);
+qboolean MD5_CullBounds (const struct md5_anim_t *anim, int pose1, int pose2, float blend, vec3_t origin, vec3_t angles, float planes[][4], int numplanes);
+
+// md5_weld.c
+void MD5_WeldNormals_Reference (const float *positions, int stride, vertexnormals_t *vnorms, int numverts, float tolerance);
+void MD5_WeldNormals (const float *positions, int stride, vertexnormals_t *vnorms, int numverts, float tolerance);
+
+// md5_skin.c
+int MD5_BuildSkinStream (struct md5_model_t *mdl, struct md5_mesh_t *mesh, const struct md5_anim_t *anim, const vertexnormals_t *vnorms, float *maxerror);
+void MD5_BuildJointMatrices (const struct md5_pose_t *skeleton, const md5_jointmat_t *invbind, int num_joints, md5_jointmat_t *palette);
+void MD5_InterpolateSkeletons (const struct md5_pose_t *skelA, const struct md5_pose_t *skelB, int num_joints, float interp, struct md5_pose_t *out);
+void MD5_SkinMesh_Reference (const struct md5_model_t *mdl, const struct md5_mesh_t *mesh, const struct md5_pose_t *skeleton, float *xyz, int xyzstride, float *norm, int normstride);
+void MD5_SkinMesh (const struct md5_model_t *mdl, const struct md5_mesh_t *mesh, const struct md5_pose_t *skeleton, md5_jointmat_t *palette, float *xyz, int xyzstride, float *norm, int normstride);
+
 typedef struct md5skin_s {
 	qpic_t **images;
 	int numskins;
 } md5skin_t;
 
+// simplified levels of detail built for each MD5 at load time
+#define MD5_MAX_LODS	3
+
+// all meshes in an MD5 are packed into md5mesh.meshes[0] at load time so that they share one vertex, triangle and
+// weight range; a submesh is the range of triangles and vertexes using each shader
+struct md5_submesh_t
+{
+	char shader[256];
+
+	int firstvert;
+	int numverts;
+	int firsttri;
+	int numtris;
+
+	// range in md5header_t::lodtriangles for each level of detail
+	int lodfirsttri[MD5_MAX_LODS];
+	int lodnumtris[MD5_MAX_LODS];
+
+	md5skin_t *skins;
+	int numskins;
+};
+
 typedef struct md5polyvert_s
 {
 	float position[3];
@@ -420,14 +523,105 @@ typedef struct md5header_s
 	struct md5_model_t md5mesh;
 	struct md5_anim_t md5anim;
 
+	struct md5_submesh_t *submeshes;
+	int num_submeshes;
+
 	md5polyvert_t *vertexes;
 	vertexnormals_t *vnorms;
-	struct md5_joint_t *skeleton;
+	struct md5_pose_t *skeleton;
+	md5_jointmat_t *palette;
 
-	md5skin_t *skins;
-	int numskins;
+	// what was last skinned into vertexes; skinnedpose is the pose plus one so that 0 means nothing has been
+	int skinnedpose;
+
+	// simplified triangles for every level of detail, each level in submesh order and using the full mesh's vertexes
+	mtriangle_t *lodtriangles;
+	int lodnumtris[MD5_MAX_LODS];
+	int num_lodtris;
+	int num_lods;
 } md5header_t;
 
+// md5_vcache.c
+float MD5_VertexCacheACMR (const int *indexes, int numtris, int numverts);
+qboolean MD5_OptimizeMesh (struct md5_mesh_t *mesh, const struct md5_submesh_t *submeshes, int num_submeshes, int *indexes, int *triorder, int *remap, float *acmr);
+
+// md5_lod.c
+int MD5_BuildLODs (const struct md5_mesh_t *mesh, struct md5_submesh_t *submeshes, int num_submeshes, const int *indexes, int *lodindexes, int *lodsource, int *numtris);
+float MD5_ScreenSize (const struct md5_bbox_t *bbox, const vec3_t origin);
+int MD5_SelectLOD (int num_lods, float size);
+int MD5_AnimLODFrames (float size);
+
+// md5_lex.c
+typedef struct md5lexer_s
+{
+	char *filename;
+
+	// where the next token is looked for from, and the line that's on
+	char *data;
+	int line;
+
+	// the current token; it points into the file so it isn't terminated
+	char *token;
+	int tokenlen;
+	int tokenline;
+	qboolean quoted;
+
+	// the first error, with the file and line it was on
+	qboolean error;
+	char errormsg[256];
+} md5lexer_t;
+
+void MD5_LexInit (md5lexer_t *lex, char *filename, char *data, int line);
+void MD5_LexError (md5lexer_t *lex, char *fmt, ...);
+qboolean MD5_LexNext (md5lexer_t *lex);
+qboolean MD5_LexIs (md5lexer_t *lex, char *word);
+void MD5_LexSkipLine (md5lexer_t *lex);
+qboolean MD5_LexSkipBlock (md5lexer_t *lex);
+qboolean MD5_LexExpect (md5lexer_t *lex, char *word);
+qboolean MD5_LexInt (md5lexer_t *lex, int *value);
+qboolean MD5_LexFloat (md5lexer_t *lex, float *value);
+qboolean MD5_LexVector (md5lexer_t *lex, float *v, int count);
+qboolean MD5_LexString (md5lexer_t *lex, char *out, int size);
+
+// md5_async.c
+typedef struct md5job_s
+{
+	// runs on the loader thread; anything it allocates with MD5_HunkAlloc is freed when it returns
+	void (*build) (struct md5job_s *job);
+
+	sysjob_t sysjob;
+
+	// the cvars build goes by, copied when it's queued as the loader thread mustn't read them
+	qboolean developer;
+	int parsethreads;
+
+	struct md5arenachunk_s *arena;
+
+	// MD5_DPrintf output from build, printed by MD5_ReleaseJob
+	char *log;
+	int loglen;
+	int logsize;
+} md5job_t;
+
+void *MD5_HunkAlloc (int size);
+int MD5_HunkLowMark (void);
+void MD5_HunkFreeToLowMark (int mark);
+void MD5_DPrintf (char *fmt, ...);
+qboolean MD5_OnLoaderThread (void);
+qboolean MD5_QueueJob (md5job_t *job);
+qboolean MD5_JobDone (md5job_t *job);
+void MD5_WaitJob (md5job_t *job);
+void MD5_ReleaseJob (md5job_t *job);
+
+// does pieces first to first + count - 1 of whatever data is
+typedef jobfunc_t md5splitfunc_t;
+
+void MD5_RunSplit (md5splitfunc_t func, void *data, int count, int batch);
+
+
+// this should be arbitrarily large enough to hold our largest MD5, counting all of it's meshes
+#define MAX_MD5_VERTEXES	65536
+
 
 //===================================================================
 
@@ -524,8 +718,12 @@ void	Mod_ClearAll (void);
 model_t *Mod_ForName (char *name, qboolean crash);
 void	*Mod_Extradata (model_t *mod);	// handles caching
 void	Mod_TouchModel (char *name);
+qboolean	Mod_IsLoaded (char *name);
 
 mleaf_t *Mod_PointInLeaf (float *p, model_t *model);
 byte	*Mod_LeafPVS (mleaf_t *leaf, model_t *model);
 
+// mh - mod_md5.c
+void MD5_StandIn (model_t *mod);
+
 #endif	// __MODEL__
@@ -0,0 +1,461 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// prof.c -- map load profiler; this file is common to the GL and software renderers
+
+// the loaders mark where each asset starts and finishes, and every load since the last Host_ClearMemory is kept: what
+// it was, how long it took, how many bytes of file it was given and how much hunk and cache it took.  loads nest, so a
+// model's time includes finding and reading its file and uploading its skins, and each load's own time is everything
+// that wasn't in a load inside it.  "loadprof" prints the loads by cost and "loadtrace" writes them as a chrome trace
+// (chrome://tracing or ui.perfetto.dev), where the nesting shows as a flame graph.
+//
+// only the main thread is recorded; work done on other threads is timed by whatever waits for it.  with cl_prefetch
+// the files are opened ahead of their loaders under "prefetch", and a model's loader asks for its file again.
+
+#include "quakedef.h"
+
+#ifdef _MSC_VER
+#define PROF_THREADLOCAL	__declspec (thread)
+#else
+#define PROF_THREADLOCAL	__thread
+#endif
+
+#define MAX_PROF_LOADS		16384
+#define MAX_PROF_DEPTH		32
+
+typedef struct
+{
+	char		name[MAX_QPATH];
+	proftype_t	type;
+	int			depth;
+	double		start, end;		// end is -1 until it's finished
+	double		childtime;		// in the loads inside this one
+	int			bytesread;		// the counters at the start, then what was used by the end
+	int			hunk;
+} profload_t;
+
+typedef struct
+{
+	char		*name;
+	proftype_t	type;
+	int			count;
+	double		total, self;
+	int			bytesread;
+	int			hunk;
+} profrow_t;
+
+static profload_t	prof_loads[MAX_PROF_LOADS];
+static int			prof_numloads;
+static int			prof_numdropped;
+
+static int			prof_stack[MAX_PROF_DEPTH];
+static int			prof_depth;
+
+static int			prof_bytesread;
+static double		prof_starttime;
+
+static PROF_THREADLOCAL qboolean prof_mainthread = false;
+
+static char *prof_typenames[PROF_NUMTYPES] =
+{
+	"find", "load", "prefetch", "model", "brush", "alias", "md5", "sprite", "sound", "texture", "lightmaps"
+};
+
+
+/*
+==================
+Prof_HunkUsed
+
+everything that's been allocated from the hunk and the cache
+==================
+*/
+static int Prof_HunkUsed (void)
+{
+	return Hunk_LowMark () + cache_allocated;
+}
+
+
+/*
+==================
+Prof_Begin
+
+==================
+*/
+int Prof_Begin (proftype_t type, char *name)
+{
+	profload_t *load;
+
+	if (!prof_mainthread) return -1;
+
+	if (prof_numloads == MAX_PROF_LOADS || prof_depth == MAX_PROF_DEPTH)
+	{
+		prof_numdropped++;
+		return -1;
+	}
+
+	load = &prof_loads[prof_numloads];
+
+	strncpy (load->name, name, sizeof (load->name) - 1);
+	load->name[sizeof (load->name) - 1] = 0;
+
+	load->type = type;
+	load->depth = prof_depth;
+	load->childtime = 0;
+	load->bytesread = prof_bytesread;
+	load->hunk = Prof_HunkUsed ();
+	load->end = -1;
+	load->start = Sys_FloatTime ();
+
+	prof_stack[prof_depth++] = prof_numloads;
+
+	return prof_numloads++;
+}
+
+
+/*
+==================
+Prof_End
+
+anything still open inside the load ends with it, for loaders that give up without saying so
+==================
+*/
+void Prof_End (int load)
+{
+	double time;
+	int i;
+
+	if (load < 0 || !prof_mainthread) return;
+
+	// it's gone if the loads were reset while it was open
+	for (i = prof_depth - 1; i >= 0; i--)
+		if (prof_stack[i] == load) break;
+
+	if (i < 0) return;
+
+	time = Sys_FloatTime ();
+
+	while (prof_depth > i)
+	{
+		profload_t *l = &prof_loads[prof_stack[--prof_depth]];
+
+		l->end = time;
+		l->bytesread = prof_bytesread - l->bytesread;
+		l->hunk = Prof_HunkUsed () - l->hunk;
+
+		if (prof_depth > 0)
+			prof_loads[prof_stack[prof_depth - 1]].childtime += l->end - l->start;
+	}
+}
+
+
+/*
+==================
+Prof_SetType
+
+==================
+*/
+void Prof_SetType (int load, proftype_t type)
+{
+	if (load < 0 || load >= prof_numloads) return;
+
+	prof_loads[load].type = type;
+}
+
+
+/*
+==================
+Prof_Read
+
+==================
+*/
+void Prof_Read (int bytes)
+{
+	if (prof_mainthread && bytes > 0)
+		prof_bytesread += bytes;
+}
+
+
+/*
+==================
+Prof_Reset
+
+called from Host_ClearMemory, so the loads are for the map being loaded
+==================
+*/
+void Prof_Reset (void)
+{
+	prof_numloads = 0;
+	prof_numdropped = 0;
+	prof_depth = 0;
+	prof_starttime = Sys_FloatTime ();
+}
+
+
+/*
+==================
+Prof_CompareNames
+
+==================
+*/
+static int Prof_CompareNames (const void *a, const void *b)
+{
+	profload_t *la = &prof_loads[*(int *) a];
+	profload_t *lb = &prof_loads[*(int *) b];
+
+	if (la->type != lb->type)
+		return la->type - lb->type;
+
+	return strcmp (la->name, lb->name);
+}
+
+
+/*
+==================
+Prof_CompareCost
+
+most expensive first
+==================
+*/
+static int Prof_CompareCost (const void *a, const void *b)
+{
+	profrow_t *ra = (profrow_t *) a;
+	profrow_t *rb = (profrow_t *) b;
+
+	if (ra->total > rb->total) return -1;
+	if (ra->total < rb->total) return 1;
+
+	return ra->count - rb->count;
+}
+
+
+/*
+==================
+Prof_LoadProf_f
+
+loadprof [count]
+
+each asset's loads are added together, and the assets are listed by their total time
+==================
+*/
+void Prof_LoadProf_f (void)
+{
+	profrow_t	*rows;
+	int			*order;
+	int			i, count, numrows = 0, numfinished = 0;
+	double		typeself[PROF_NUMTYPES];
+	int			typecount[PROF_NUMTYPES];
+	double		total = 0, last = prof_starttime;
+	int			bytesread = 0, hunk = 0;
+
+	count = (Cmd_Argc () > 1) ? Q_atoi (Cmd_Argv (1)) : 20;
+
+	order = (int *) malloc (prof_numloads * sizeof (int) + 1);
+	rows = (profrow_t *) malloc (prof_numloads * sizeof (profrow_t) + 1);
+
+	if (!order || !rows)
+	{
+		free (order);
+		free (rows);
+		Con_Printf ("loadprof: not enough memory\n");
+		return;
+	}
+
+	for (i = 0; i < PROF_NUMTYPES; i++)
+	{
+		typeself[i] = 0;
+		typecount[i] = 0;
+	}
+
+	for (i = 0; i < prof_numloads; i++)
+	{
+		profload_t *load = &prof_loads[i];
+
+		if (load->end < 0) continue;
+
+		order[numfinished++] = i;
+
+		typeself[load->type] += (load->end - load->start) - load->childtime;
+		typecount[load->type]++;
+
+		if (load->type == PROF_LOADFILE)
+			bytesread += load->bytesread;
+
+		if (load->depth == 0)
+		{
+			total += load->end - load->start;
+			hunk += load->hunk;
+		}
+
+		if (load->end > last) last = load->end;
+	}
+
+	// the same asset is next to itself
+	qsort (order, numfinished, sizeof (int), Prof_CompareNames);
+
+	for (i = 0; i < numfinished; i++)
+	{
+		profload_t *load = &prof_loads[order[i]];
+		profrow_t *row = numrows ? &rows[numrows - 1] : NULL;
+
+		if (!row || row->type != load->type || strcmp (row->name, load->name))
+		{
+			row = &rows[numrows++];
+			memset (row, 0, sizeof (profrow_t));
+
+			row->name = load->name;
+			row->type = load->type;
+		}
+
+		row->count++;
+		row->total += load->end - load->start;
+		row->self += (load->end - load->start) - load->childtime;
+		row->bytesread += load->bytesread;
+		row->hunk += load->hunk;
+	}
+
+	qsort (rows, numrows, sizeof (profrow_t), Prof_CompareCost);
+
+	if (count <= 0 || count > numrows) count = numrows;
+
+	Con_Printf ("   total     self  read KB  hunk KB    n  type       name\n");
+
+	for (i = 0; i < count; i++)
+	{
+		profrow_t *row = &rows[i];
+
+		Con_Printf ("%8.2f %8.2f %8i %8i %4i  %-9s  %s\n", row->total * 1000.0, row->self * 1000.0,
+			row->bytesread / 1024, row->hunk / 1024, row->count, prof_typenames[row->type], row->name);
+	}
+
+	Con_Printf ("\n");
+
+	for (i = 0; i < PROF_NUMTYPES; i++)
+	{
+		if (!typecount[i]) continue;
+
+		Con_Printf ("%-9s %5i loads, %8.2f ms of their own\n", prof_typenames[i], typecount[i], typeself[i] * 1000.0);
+	}
+
+	Con_Printf ("%i assets, %.1f ms in loads of %.1f ms since the map started, %i KB read, %i KB of hunk\n",
+		numrows, total * 1000.0, (last - prof_starttime) * 1000.0, bytesread / 1024, hunk / 1024);
+
+	if (prof_numdropped)
+		Con_Printf ("%i loads weren't recorded\n", prof_numdropped);
+
+	free (order);
+	free (rows);
+}
+
+
+/*
+==================
+Prof_WriteName
+
+a json string
+==================
+*/
+static void Prof_WriteName (FILE *f, char *name)
+{
+	fputc ('\"', f);
+
+	for (; *name; name++)
+	{
+		if (*name == '\"' || *name == '\\')
+			fprintf (f, "\\%c", *name);
+		else if ((unsigned char) *name < ' ')
+			fprintf (f, "\\u%04x", (unsigned char) *name);
+		else fputc (*name, f);
+	}
+
+	fputc ('\"', f);
+}
+
+
+/*
+==================
+Prof_LoadTrace_f
+
+loadtrace [filename]
+
+the trace event format wants microseconds, from the start of the map
+==================
+*/
+void Prof_LoadTrace_f (void)
+{
+	char	name[MAX_OSPATH];
+	FILE	*f;
+	int		i, numwritten = 0;
+
+	if (Cmd_Argc () > 1 && strstr (Cmd_Argv (1), ".."))
+	{
+		Con_Printf ("Relative pathnames are not allowed.\n");
+		return;
+	}
+
+	sprintf (name, "%s/%s", com_gamedir, (Cmd_Argc () > 1) ? Cmd_Argv (1) : "loadtrace");
+	COM_DefaultExtension (name, ".json");
+
+	if ((f = fopen (name, "w")) == NULL)
+	{
+		Con_Printf ("ERROR: couldn't open %s\n", name);
+		return;
+	}
+
+	fprintf (f, "{\"traceEvents\":[\n");
+	fprintf (f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}");
+
+	for (i = 0; i < prof_numloads; i++)
+	{
+		profload_t *load = &prof_loads[i];
+
+		if (load->end < 0) continue;
+
+		fprintf (f, ",\n{\"name\":");
+		Prof_WriteName (f, load->name);
+		fprintf (f, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"read\":%i,\"hunk\":%i}}",
+			prof_typenames[load->type], (load->start - prof_starttime) * 1000000.0, (load->end - load->start) * 1000000.0,
+			load->bytesread, load->hunk);
+
+		numwritten++;
+	}
+
+	fprintf (f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose (f);
+
+	Con_Printf ("Wrote %i loads to %s\n", numwritten, name);
+}
+
+
+/*
+==================
+Prof_Init
+
+must be called on the main thread
+==================
+*/
+void Prof_Init (void)
+{
+	prof_mainthread = true;
+
+	Prof_Reset ();
+
+	Cmd_AddCommand ("loadprof", Prof_LoadProf_f);
+	Cmd_AddCommand ("loadtrace", Prof_LoadTrace_f);
+}
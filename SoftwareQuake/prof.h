@@ -0,0 +1,49 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// prof.h -- map load profiler
+
+// mh - what each load is; models start as PROF_MODEL and become their type once it's known
+typedef enum
+{
+	PROF_FINDFILE,
+	PROF_LOADFILE,
+	PROF_PREFETCH,
+	PROF_MODEL,
+	PROF_BRUSHMODEL,
+	PROF_ALIASMODEL,
+	PROF_MD5MODEL,
+	PROF_SPRITEMODEL,
+	PROF_SOUND,
+	PROF_TEXTURE,
+	PROF_LIGHTMAPS,
+	PROF_NUMTYPES
+} proftype_t;
+
+void Prof_Init (void);
+void Prof_Reset (void);
+
+// returns the load to give to Prof_End, or -1 if it isn't being recorded
+int Prof_Begin (proftype_t type, char *name);
+void Prof_End (int load);
+void Prof_SetType (int load, proftype_t type);
+
+// file data handed to a loader
+void Prof_Read (int bytes);
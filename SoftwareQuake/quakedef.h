@@ -214,6 +214,7 @@ void	VID_UnlockBuffer (void);
 #include "vid.h"
 #include "sys.h"
 #include "zone.h"
+#include "prof.h"
 #include "mathlib.h"
 
 typedef struct
@@ -137,6 +137,16 @@ cvar_t	r_numedges = {"r_numedges", "0"};
 cvar_t	r_aliastransbase = {"r_aliastransbase", "200"};
 cvar_t	r_aliastransadj = {"r_aliastransadj", "100"};
 
+// mh - MD5 skinning
+extern cvar_t	r_md5skin;
+extern cvar_t	r_md5skincheck;
+extern cvar_t	r_md5lerp;
+extern cvar_t	r_md5lod;
+extern cvar_t	r_md5lodsize;
+extern cvar_t	r_md5animlod;
+extern cvar_t	r_md5animlodframes;
+void MD5_TimeLerp_f (void);
+
 extern cvar_t	scr_fov;
 
 void CreatePassages (void);
@@ -213,6 +223,14 @@ void R_Init (void)
 	Cvar_RegisterVariable (&r_numedges);
 	Cvar_RegisterVariable (&r_aliastransbase);
 	Cvar_RegisterVariable (&r_aliastransadj);
+	Cvar_RegisterVariable (&r_md5skin);
+	Cvar_RegisterVariable (&r_md5skincheck);
+	Cvar_RegisterVariable (&r_md5lerp);
+	Cvar_RegisterVariable (&r_md5lod);
+	Cvar_RegisterVariable (&r_md5lodsize);
+	Cvar_RegisterVariable (&r_md5animlod);
+	Cvar_RegisterVariable (&r_md5animlodframes);
+	Cmd_AddCommand ("timemd5lerp", MD5_TimeLerp_f);
 
 	Cvar_SetValue ("r_maxedges", (float)NUMSTACKEDGES);
 	Cvar_SetValue ("r_maxsurfs", (float)NUMSTACKSURFACES);
@@ -296,6 +314,8 @@ void R_NewMap (void)
 
 	r_dowarpold = false;
 	r_viewchanged = false;
+
+	MD5_FlushPoseCache (); // mh - models may have been freed
 #ifdef PASSAGES
 CreatePassages ();
 #endif
@@ -629,6 +649,7 @@ void R_DrawEntitiesOnList (void)
 
 				R_MD5DrawModel (&lighting);
 			}
+			else r_md5models_culled++;
 
 			break;
 
@@ -45,6 +45,13 @@ static vec3_t		md5_forward, md5_right, md5_up;
 
 int				r_md5numverts;
 
+// level of detail for the entity being drawn; 0 is the full mesh
+static int			md5_lod;
+
+// MD5s can have many more vertexes than MDLs so they don't use the stack for these
+static finalvert_t	r_md5finalverts[MAX_MD5_VERTEXES + ((CACHE_SIZE - 1) / sizeof (finalvert_t)) + 1];
+static auxvert_t	r_md5auxverts[MAX_MD5_VERTEXES];
+
 float	md5transform[3][4];
 
 typedef struct {
@@ -53,6 +60,8 @@ typedef struct {
 } md5edge_t;
 
 // these are exactly the same as aedges in r_alias.c
+int				r_md5models_drawn, r_md5models_culled;
+
 static md5edge_t	md5edges[12] = {
 {0, 1}, {1, 2}, {2, 3}, {3, 0},
 {4, 5}, {5, 6}, {6, 7}, {7, 4},
@@ -64,6 +73,30 @@ void R_MD5SetUpTransform (int trivial_accept);
 void R_MD5TransformVector (vec3_t in, vec3_t out);
 void R_MD5TransformFinalVert (finalvert_t *fv, auxvert_t *av, md5polyvert_t *pverts);
 void R_MD5ProjectFinalVert (finalvert_t *fv, auxvert_t *av);
+void R_MD5SetupSkin (struct md5_submesh_t *submesh);
+qpic_t *R_MD5SubmeshSkin (struct md5_submesh_t *submesh);
+
+
+/*
+================
+R_MD5SubmeshTriangles
+
+the triangles of a submesh at the current level of detail
+================
+*/
+static mtriangle_t *R_MD5SubmeshTriangles (md5header_t *hdr, int s, int *numtris)
+{
+	struct md5_submesh_t *submesh = &hdr->submeshes[s];
+
+	if (md5_lod)
+	{
+		*numtris = submesh->lodnumtris[md5_lod - 1];
+		return hdr->lodtriangles + submesh->lodfirsttri[md5_lod - 1];
+	}
+
+	*numtris = submesh->numtris;
+	return hdr->md5mesh.meshes[0].triangles + submesh->firsttri;
+}
 
 
 /*
@@ -76,7 +109,7 @@ qboolean R_MD5CheckBBox (void)
 	int					i, flags, frame, numv;
 	md5header_t			*hdr;
 	struct md5_bbox_t	*bbox;
-	float				zi, basepts[8][3], v0, v1, frac;
+	float				zi, basepts[8][3], v0, v1, frac, planes[4][4];
 	finalvert_t			*pv0, *pv1, viewpts[16];
 	auxvert_t			*pa0, *pa1, viewaux[16];
 	qboolean			zclipped, zfullyclipped;
@@ -100,6 +133,16 @@ qboolean R_MD5CheckBBox (void)
 		frame = 0;
 	}
 
+	// reject with the sphere and the rotated box against the frustum before doing any projection
+	for (i = 0; i < 4; i++)
+	{
+		VectorCopy (view_clipplanes[i].normal, planes[i]);
+		planes[i][3] = view_clipplanes[i].dist;
+	}
+
+	if (MD5_CullBounds (&hdr->md5anim, frame, frame, 0, currententity->origin, currententity->angles, planes, 4))
+		return false;
+
 	bbox = &hdr->md5anim.bboxes[frame];
 
 	// x worldspace coordinates
@@ -254,6 +297,7 @@ void R_MD5PreparePoints (md5header_t *hdr)
 	mtriangle_t	*ptri;
 	int			numtris;
 	finalvert_t	*pfv[3];
+	int			s;
 
 	r_md5numverts = hdr->md5mesh.meshes[0].num_verts;
  	fv = pfinalverts;
@@ -280,32 +324,36 @@ void R_MD5PreparePoints (md5header_t *hdr)
 		}
 	}
 
-	// clip and draw all triangles
+	// clip and draw all triangles, one submesh at a time for it's skin
 	r_affinetridesc.numtriangles = 1;
 
-	ptri = hdr->md5mesh.meshes[0].triangles;
-	numtris = hdr->md5mesh.meshes[0].num_tris;
-
-	for (i = 0; i < numtris; i++, ptri++)
+	for (s = 0; s < hdr->num_submeshes; s++)
 	{
-		pfv[0] = &pfinalverts[ptri->vertindex[0]];
-		pfv[1] = &pfinalverts[ptri->vertindex[1]];
-		pfv[2] = &pfinalverts[ptri->vertindex[2]];
+		R_MD5SetupSkin (&hdr->submeshes[s]);
 
-		if (pfv[0]->flags & pfv[1]->flags & pfv[2]->flags & (ALIAS_XY_CLIP_MASK | ALIAS_Z_CLIP))
-			continue;		// completely clipped
+		ptri = R_MD5SubmeshTriangles (hdr, s, &numtris);
 
-		if (!((pfv[0]->flags | pfv[1]->flags | pfv[2]->flags) & (ALIAS_XY_CLIP_MASK | ALIAS_Z_CLIP)))
-		{
-			// totally unclipped
-			r_affinetridesc.pfinalverts = pfinalverts;
-			r_affinetridesc.ptriangles = ptri;
-			D_PolysetDraw ();
-		}
-		else		
+		for (i = 0; i < numtris; i++, ptri++)
 		{
-			// partially clipped
-			R_AliasClipTriangle (ptri);
+			pfv[0] = &pfinalverts[ptri->vertindex[0]];
+			pfv[1] = &pfinalverts[ptri->vertindex[1]];
+			pfv[2] = &pfinalverts[ptri->vertindex[2]];
+
+			if (pfv[0]->flags & pfv[1]->flags & pfv[2]->flags & (ALIAS_XY_CLIP_MASK | ALIAS_Z_CLIP))
+				continue;		// completely clipped
+
+			if (!((pfv[0]->flags | pfv[1]->flags | pfv[2]->flags) & (ALIAS_XY_CLIP_MASK | ALIAS_Z_CLIP)))
+			{
+				// totally unclipped
+				r_affinetridesc.pfinalverts = pfinalverts;
+				r_affinetridesc.ptriangles = ptri;
+				D_PolysetDraw ();
+			}
+			else		
+			{
+				// partially clipped
+				R_AliasClipTriangle (ptri);
+			}
 		}
 	}
 }
@@ -491,44 +539,63 @@ R_MD5PrepareUnclippedPoints
 */
 void R_MD5PrepareUnclippedPoints (md5header_t *hdr)
 {
+	int s;
+
 	r_md5numverts = hdr->md5mesh.meshes[0].num_verts;
 
 	R_MD5TransformAndProjectFinalVerts_C (pfinalverts);
 
-	if (r_affinetridesc.drawtype)
-		D_PolysetDrawFinalVerts (pfinalverts, r_md5numverts);
+	// draw each submesh with it's own skin
+	for (s = 0; s < hdr->num_submeshes; s++)
+	{
+		struct md5_submesh_t *submesh = &hdr->submeshes[s];
+
+		R_MD5SetupSkin (submesh);
 
-	r_affinetridesc.pfinalverts = pfinalverts;
-	r_affinetridesc.ptriangles = hdr->md5mesh.meshes[0].triangles;
-	r_affinetridesc.numtriangles = hdr->md5mesh.meshes[0].num_tris;
+		if (r_affinetridesc.drawtype)
+			D_PolysetDrawFinalVerts (pfinalverts + submesh->firstvert, submesh->numverts);
 
-	D_PolysetDraw ();
+		r_affinetridesc.pfinalverts = pfinalverts;
+		r_affinetridesc.ptriangles = R_MD5SubmeshTriangles (hdr, s, &r_affinetridesc.numtriangles);
+
+		D_PolysetDraw ();
+	}
 }
 
 
 /*
 ===============
-R_AliasSetupSkin
+R_MD5SubmeshSkin
 ===============
 */
-void R_MD5SetupSkin (md5header_t *hdr)
+qpic_t *R_MD5SubmeshSkin (struct md5_submesh_t *submesh)
 {
 	int					skinnum;
-	int					numskins;
 	md5skin_t			*skin;
-	qpic_t				*image;
 
 	skinnum = currententity->skinnum;
 
-	if ((skinnum >= hdr->numskins) || (skinnum < 0))
+	if ((skinnum >= submesh->numskins) || (skinnum < 0))
 	{
-		Con_DPrintf ("R_AliasSetupSkin: no such skin # %d\n", skinnum);
+		Con_DPrintf ("R_MD5SubmeshSkin: no such skin # %d\n", skinnum);
 		skinnum = 0;
 	}
 
 	// skin selection and auto-animation
-	skin = &hdr->skins[skinnum % hdr->numskins];
-	image = skin->images[(int) ((cl.time + currententity->syncbase) * 10) % skin->numskins];
+	skin = &submesh->skins[skinnum % submesh->numskins];
+
+	return skin->images[(int) ((cl.time + currententity->syncbase) * 10) % skin->numskins];
+}
+
+
+/*
+===============
+R_MD5SetupSkin
+===============
+*/
+void R_MD5SetupSkin (struct md5_submesh_t *submesh)
+{
+	qpic_t				*image = R_MD5SubmeshSkin (submesh);
 
 	a_skinwidth = image->width;
 
@@ -537,6 +604,10 @@ void R_MD5SetupSkin (md5header_t *hdr)
 	r_affinetridesc.skinwidth = a_skinwidth;
 	r_affinetridesc.seamfixupX16 = 0;//(a_skinwidth >> 1) << 16;
 	r_affinetridesc.skinheight = image->height;
+
+	// the texel lookup table is per-skin
+	if (r_affinetridesc.drawtype)
+		D_PolysetUpdateTables ();
 }
 
 
@@ -575,85 +646,56 @@ void R_MD5SetupLighting (alight_t *plighting)
 
 /*
 ==================
-MD5_InterpolateSkeletons
+MD5_PrepareMesh
 
+skeleton may be NULL if the vertexes were already skinned to it
 ==================
 */
-static void MD5_InterpolateSkeletons (const struct md5_joint_t *skelA, const struct md5_joint_t *skelB, int num_joints, float interp, struct md5_joint_t *out)
+static void MD5_PrepareMesh (md5header_t *hdr, const struct md5_pose_t *skeleton, md5polyvert_t *vertexes)
 {
-	int i;
+	const struct md5_mesh_t *mesh = &hdr->md5mesh.meshes[0];
+	int i, s;
 
-	for (i = 0; i < num_joints; ++i)
-	{
-		// Copy parent index
-		out[i].parent = skelA[i].parent;
+	// skin positions and normals straight into the vertex array
+	if (skeleton)
+		MD5_SkinMesh (&hdr->md5mesh, mesh, skeleton, hdr->palette, vertexes->position, sizeof (md5polyvert_t) / sizeof (float), vertexes->normal, sizeof (md5polyvert_t) / sizeof (float));
 
-		// Linear interpolation for position
-		out[i].pos[0] = skelA[i].pos[0] + interp * (skelB[i].pos[0] - skelA[i].pos[0]);
-		out[i].pos[1] = skelA[i].pos[1] + interp * (skelB[i].pos[1] - skelA[i].pos[1]);
-		out[i].pos[2] = skelA[i].pos[2] + interp * (skelB[i].pos[2] - skelA[i].pos[2]);
+	for (s = 0; s < hdr->num_submeshes; s++)
+	{
+		struct md5_submesh_t *submesh = &hdr->submeshes[s];
+		qpic_t *image = R_MD5SubmeshSkin (submesh);
 
-		// Spherical linear interpolation for orientation
-		Quat_slerp (skelA[i].orient, skelB[i].orient, interp, out[i].orient);
+		for (i = submesh->firstvert; i < submesh->firstvert + submesh->numverts; i++)
+		{
+			// store out texcoords - this needs the same calculation as setup of stverts in Mod_LoadAliasModel, including scaling the skin up to
+			// an unnormalized range.  in theory each MD5 skin can be a different size so it's deferred to here.
+			vertexes[i].texcoord[0] = (int) (mesh->vertices[i].st[0] * image->width) << 16;
+			vertexes[i].texcoord[1] = (int) (mesh->vertices[i].st[1] * image->height) << 16;
+		}
 	}
 }
 
 
+// space for unpacking frames of a packed animation that aren't in the pose cache
+static struct md5_pose_t r_md5posescratch[2][MAX_MD5_JOINTS];
+
+
 /*
 ==================
-MD5_PrepareMesh
+MD5_PrepareMeshPose
 
+animates from a single skeleton; every entity of a model shares it's vertex array, so this is skipped if the last
+entity drawn with the model was on the same pose
 ==================
 */
-static void MD5_PrepareMesh (const struct md5_mesh_t *mesh, const struct md5_joint_t *skeleton, md5polyvert_t *vertexes, vertexnormals_t *vnorms)
+static void MD5_PrepareMeshPose (md5header_t *hdr, int pose)
 {
-	int i, j;
-
-	// Setup vertices
-	for (i = 0; i < mesh->num_verts; i++)
+	if (hdr->skinnedpose == pose + 1)
+		MD5_PrepareMesh (hdr, NULL, hdr->vertexes);
+	else
 	{
-		vec3_t finalVertex = {0.0f, 0.0f, 0.0f};
-		vec3_t finalNormal = {0.0f, 0.0f, 0.0f};
-		float Angle;
-
-		// Calculate final vertex to draw with weights
-		for (j = 0; j < mesh->vertices[i].count; j++)
-		{
-			const struct md5_weight_t *weight = &mesh->weights[mesh->vertices[i].start + j];
-			const struct md5_joint_t *joint = &skeleton[weight->joint];
-
-			// Calculate transformed vertex for this weight
-			vec3_t wv;
-			Quat_rotatePoint (joint->orient, weight->pos, wv);
-
-			// The sum of all weight->bias should be 1.0
-			finalVertex[0] += (joint->pos[0] + wv[0]) * weight->bias;
-			finalVertex[1] += (joint->pos[1] + wv[1]) * weight->bias;
-			finalVertex[2] += (joint->pos[2] + wv[2]) * weight->bias;
-
-			// Calculate transformed normal for this weight
-			Quat_rotatePoint (joint->orient, vnorms[i].normal, wv);
-
-			// The sum of all weight->bias should be 1.0
-			finalNormal[0] += wv[0] * weight->bias;
-			finalNormal[1] += wv[1] * weight->bias;
-			finalNormal[2] += wv[2] * weight->bias;
-		}
-
-		// store out position
-		vertexes[i].position[0] = finalVertex[0];
-		vertexes[i].position[1] = finalVertex[1];
-		vertexes[i].position[2] = finalVertex[2];
-
-		// store out normal
-		vertexes[i].normal[0] = finalNormal[0];
-		vertexes[i].normal[1] = finalNormal[1];
-		vertexes[i].normal[2] = finalNormal[2];
-
-		// store out texcoords - this needs the same calculation as setup of stverts in Mod_LoadAliasModel, including scaling the skin up to
-		// an unnormalized range.  in theory each MD5 skin can be a different size so it's deferred to here.
-		vertexes[i].texcoord[0] = (int) (mesh->vertices[i].st[0] * r_affinetridesc.skinwidth) << 16;
-		vertexes[i].texcoord[1] = (int) (mesh->vertices[i].st[1] * r_affinetridesc.skinheight) << 16;
+		MD5_PrepareMesh (hdr, MD5_FramePose (&hdr->md5anim, pose, r_md5posescratch[0]), hdr->vertexes);
+		hdr->skinnedpose = pose + 1;
 	}
 }
 
@@ -666,29 +708,35 @@ R_InterpolateMD5Model
 */
 void R_InterpolateMD5Model (md5header_t *hdr, int pose1, int pose2, float lerpfrac)
 {
+	struct md5_anim_t *anim = &hdr->md5anim;
+
 	// optimize the non-interpolated cases
 	if (pose1 == pose2)
 	{
 		// case #1 - not lerping, just animate from a single skeleton
-		MD5_PrepareMesh (&hdr->md5mesh.meshes[0], hdr->md5anim.skelFrames[pose1], hdr->vertexes, hdr->vnorms);
+		MD5_PrepareMeshPose (hdr, pose1);
 	}
 	else if (!(lerpfrac > 0))
 	{
 		// case #2 : lerpblend is 0 so just animate from one frame
-		MD5_PrepareMesh (&hdr->md5mesh.meshes[0], hdr->md5anim.skelFrames[pose1], hdr->vertexes, hdr->vnorms);
+		MD5_PrepareMeshPose (hdr, pose1);
 	}
 	else if (!(lerpfrac < 1))
 	{
 		// case #3 : lerpblend is 1 so just animate from one frame
-		MD5_PrepareMesh (&hdr->md5mesh.meshes[0], hdr->md5anim.skelFrames[pose2], hdr->vertexes, hdr->vnorms);
+		MD5_PrepareMeshPose (hdr, pose2);
 	}
 	else
 	{
 		// case #4 : full interpolation - run the skeletal animation
-		MD5_InterpolateSkeletons (hdr->md5anim.skelFrames[pose1], hdr->md5anim.skelFrames[pose2], hdr->md5anim.num_joints, lerpfrac, hdr->skeleton);
+		const struct md5_pose_t *skel1 = MD5_FramePose (anim, pose1, r_md5posescratch[0]);
+		const struct md5_pose_t *skel2 = MD5_FramePose (anim, pose2, r_md5posescratch[1]);
+
+		MD5_InterpolateSkeletons (skel1, skel2, anim->num_joints, lerpfrac, hdr->skeleton);
 
-		// and set up the vertex array
-		MD5_PrepareMesh (&hdr->md5mesh.meshes[0], hdr->skeleton, hdr->vertexes, hdr->vnorms);
+		// and set up the vertex array, which isn't on any one pose now
+		MD5_PrepareMesh (hdr, hdr->skeleton, hdr->vertexes);
+		hdr->skinnedpose = 0;
 	}
 }
 
@@ -697,14 +745,15 @@ void R_InterpolateMD5Model (md5header_t *hdr, int pose1, int pose2, float lerpfr
 =================
 R_MD5SetupFrame
 
-set r_apverts
+set r_apverts, and pick the level of detail
 =================
 */
 void R_MD5SetupFrame (md5header_t *hdr)
 {
-	int		frame;
+	int		frame, holdframes;
+	entity_t *e = currententity;
 
-	frame = currententity->frame;
+	frame = e->frame;
 
 	if ((frame >= hdr->md5anim.num_frames) || (frame < 0))
 	{
@@ -712,6 +761,34 @@ void R_MD5SetupFrame (md5header_t *hdr)
 		frame = 0;
 	}
 
+	// how big it is on screen picks the level of detail and how often it moves to a new pose; the viewmodel is
+	// always drawn in full
+	if (e != &cl.viewent)
+	{
+		float size = MD5_ScreenSize (&hdr->md5anim.bboxes[frame], e->origin);
+
+		md5_lod = MD5_SelectLOD (hdr->num_lods, size);
+		holdframes = MD5_AnimLODFrames (size);
+	}
+	else
+	{
+		md5_lod = 0;
+		holdframes = 1;
+	}
+
+	// small entities stay on the pose they were last put on for a few frames, so that they're more likely to find
+	// it already skinned
+	if (frame + 1 != e->md5holdpose)
+	{
+		if (e->md5holdpose > 0 && e->md5holdpose <= hdr->md5anim.num_frames && r_framecount - e->md5holdframe < holdframes)
+			frame = e->md5holdpose - 1;
+		else
+		{
+			e->md5holdpose = frame + 1;
+			e->md5holdframe = r_framecount;
+		}
+	}
+
 	// animate the skeleton into hdr->vertexes
 	// this code isn't doing frame interpolation; in an interpolated case there would be two different poses here and a non-0 (or non-1) interpolation fraction
 	R_InterpolateMD5Model (hdr, frame, frame, 0);
@@ -730,17 +807,13 @@ void R_MD5DrawModel (alight_t *plighting)
 {
 	md5header_t *hdr = (md5header_t *) currententity->model->cache.data;
 
-	// to do - this can reuse the same structs as alias drawing for there, but is the vertex count enough????
-	finalvert_t		finalverts[MAXALIASVERTS + ((CACHE_SIZE - 1) / sizeof (finalvert_t)) + 1];
-	auxvert_t		auxverts[MAXALIASVERTS];
-
 	r_amodels_drawn++;
+	r_md5models_drawn++;
 
 	// cache align
-	pfinalverts = (finalvert_t *) (((long) &finalverts[0] + CACHE_SIZE - 1) & ~(CACHE_SIZE - 1));
-	pauxverts = &auxverts[0];
+	pfinalverts = (finalvert_t *) (((long) &r_md5finalverts[0] + CACHE_SIZE - 1) & ~(CACHE_SIZE - 1));
+	pauxverts = &r_md5auxverts[0];
 
-	R_MD5SetupSkin (hdr);
 	R_MD5SetUpTransform (currententity->trivial_accept);
 	R_MD5SetupLighting (plighting);
 	R_MD5SetupFrame (hdr);
@@ -750,12 +823,9 @@ void R_MD5DrawModel (alight_t *plighting)
 
 	r_affinetridesc.drawtype = (currententity->trivial_accept == 3) && r_recursiveaffinetriangles;
 
-	if (r_affinetridesc.drawtype)
-	{
-		D_PolysetUpdateTables ();		// FIXME: precalc...
-	}
-	else
+	if (!r_affinetridesc.drawtype)
 	{
+		// the skin tables are updated for each submesh in R_MD5SetupSkin
 #if	id386
 		D_Aff8Patch (currententity->colormap);
 #endif
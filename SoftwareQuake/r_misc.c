@@ -239,6 +239,7 @@ R_PrintAliasStats
 void R_PrintAliasStats (void)
 {
 	Con_Printf ("%3i polygon model drawn\n", r_amodels_drawn);
+	Con_Printf ("%3i MD5 models drawn, %3i culled\n", r_md5models_drawn, r_md5models_culled);
 }
 
 
@@ -515,6 +516,7 @@ r_refdef.viewangles[2]=    0;
 	r_drawnpolycount = 0;
 	r_wholepolycount = 0;
 	r_amodels_drawn = 0;
+	r_md5models_drawn = r_md5models_culled = 0;
 	r_outofsurfaces = 0;
 	r_outofedges = 0;
 
@@ -67,6 +67,9 @@ typedef struct entity_s
 	struct mnode_s			*topnode;		// for bmodels, first world node
 											//  that splits bmodel, or NULL if
 											//  not split
+
+	int						md5holdpose;	// mh - MD5 pose it's being held on plus one, 0 if none
+	int						md5holdframe;	// mh - r_framecount when it went on it
 } entity_t;
 
 // !!! if this is changed, it must be changed in asm_draw.h too !!!
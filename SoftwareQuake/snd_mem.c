@@ -25,23 +25,22 @@ int			cache_full_cycle;
 
 byte *S_Alloc (int size);
 
+static char *ParseWavinfo (byte *wav, int wavlength, wavinfo_t *out);
+
 /*
 ================
-ResampleSfx
+ResampleSfxCache
+
+mh - the work of ResampleSfx, on an sfxcache_t that doesn't have to be in the cache
 ================
 */
-void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
+static void ResampleSfxCache (sfxcache_t *sc, int inrate, int inwidth, byte *data)
 {
 	int		outcount;
 	int		srcsample;
 	float	stepscale;
 	int		i;
 	int		sample, samplefrac, fracstep;
-	sfxcache_t	*sc;
-	
-	sc = Cache_Check (&sfx->cache);
-	if (!sc)
-		return;
 
 	stepscale = (float)inrate / shm->speed;	// this is usually 0.5, 1, or 2
 
@@ -87,6 +86,22 @@ void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
 	}
 }
 
+/*
+================
+ResampleSfx
+================
+*/
+void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
+{
+	sfxcache_t	*sc;
+
+	sc = Cache_Check (&sfx->cache);
+	if (!sc)
+		return;
+
+	ResampleSfxCache (sc, inrate, inwidth, data);
+}
+
 //=============================================================================
 
 /*
@@ -97,12 +112,13 @@ S_LoadSound
 sfxcache_t *S_LoadSound (sfx_t *s)
 {
     char	namebuffer[256];
-	byte	*data;
+	const byte	*data;
+	int		filelen;
 	wavinfo_t	info;
 	int		len;
 	float	stepscale;
 	sfxcache_t	*sc;
-	byte	stackbuf[1*1024];		// avoid dirtying the cache heap
+	int		load; // mh
 
 // see if still in memory
 	sc = Cache_Check (&s->cache);
@@ -116,21 +132,34 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 
 //	Con_Printf ("loading %s\n",namebuffer);
 
-	data = COM_LoadStackFile(namebuffer, stackbuf, sizeof(stackbuf));
+	load = Prof_Begin (PROF_SOUND, s->name);
+
+	// mh - read in place, with no copy
+	data = COM_MapFile (namebuffer, &filelen);
 
 	if (!data)
 	{
 		Con_Printf ("Couldn't load %s\n", namebuffer);
+		Prof_End (load);
 		return NULL;
 	}
 
-	info = GetWavinfo (s->name, data, com_filesize);
+	info = GetWavinfo (s->name, (byte *)data, filelen);
 	if (info.channels != 1)
 	{
 		Con_Printf ("%s is a stereo sample\n",s->name);
+		COM_UnmapFile (data);
+		Prof_End (load);
 		return NULL;
 	}
 
+	// mh - a copy used to have room to read past the end of a short file, but the mapping doesn't
+	if (info.width > 0 && info.dataofs + info.samples * info.width > filelen)
+	{
+		Con_DPrintf ("%s is shorter than its header says\n", s->name);
+		info.samples = (filelen > info.dataofs) ? (filelen - info.dataofs) / info.width : 0;
+	}
+
 	stepscale = (float)info.rate / shm->speed;	
 	len = info.samples / stepscale;
 
@@ -138,7 +167,11 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 
 	sc = Cache_Alloc ( &s->cache, len + sizeof(sfxcache_t), s->name);
 	if (!sc)
+	{
+		COM_UnmapFile (data);
+		Prof_End (load);
 		return NULL;
+	}
 	
 	sc->length = info.samples;
 	sc->loopstart = info.loopstart;
@@ -146,7 +179,82 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 	sc->width = info.width;
 	sc->stereo = info.channels;
 
-	ResampleSfx (s, sc->speed, sc->width, data + info.dataofs);
+	ResampleSfx (s, sc->speed, sc->width, (byte *)data + info.dataofs);
+
+	COM_UnmapFile (data);
+
+	Prof_End (load);
+
+	return sc;
+}
+
+/*
+==============
+S_DecodeSound
+
+mh - for the precache prefetch, and safe to call on any thread.  the sound is resampled the same as S_LoadSound
+does, but into a block from malloc, which S_CommitSound copies to the cache.  returns NULL for anything that isn't
+a good mono .wav, which is left for S_LoadSound to report.
+==============
+*/
+sfxcache_t *S_DecodeSound (const byte *data, int filelen, int *size)
+{
+	wavinfo_t	info;
+	int		len;
+	float	stepscale;
+	sfxcache_t	*sc;
+
+	if (ParseWavinfo ((byte *)data, filelen, &info))
+		return NULL;
+
+	if (info.channels != 1 || info.width < 1 || info.dataofs + info.samples * info.width > filelen)
+		return NULL;
+
+	stepscale = (float)info.rate / shm->speed;
+	len = info.samples / stepscale;
+
+	len = len * info.width * info.channels;
+
+	if ((sc = (sfxcache_t *) malloc (len + sizeof(sfxcache_t))) == NULL)
+		return NULL;
+
+	sc->length = info.samples;
+	sc->loopstart = info.loopstart;
+	sc->speed = info.rate;
+	sc->width = info.width;
+	sc->stereo = info.channels;
+
+	ResampleSfxCache (sc, sc->speed, sc->width, (byte *)data + info.dataofs);
+
+	*size = len + sizeof(sfxcache_t);
+
+	return sc;
+}
+
+/*
+==============
+S_CommitSound
+
+mh - puts a sound from S_DecodeSound in the cache; the caller still owns decoded
+==============
+*/
+sfxcache_t *S_CommitSound (sfx_t *s, sfxcache_t *decoded, int size)
+{
+	sfxcache_t	*sc;
+	int		load;
+
+	sc = Cache_Check (&s->cache);
+	if (sc)
+		return sc;
+
+	// the file was read under the prefetch
+	load = Prof_Begin (PROF_SOUND, s->name);
+
+	sc = Cache_Alloc (&s->cache, size, s->name);
+	if (sc)
+		memcpy (sc, decoded, size);
+
+	Prof_End (load);
 
 	return sc;
 }
@@ -162,11 +270,18 @@ WAV loading
 */
 
 
-byte	*data_p;
-byte 	*iff_end;
-byte 	*last_chunk;
-byte 	*iff_data;
-int 	iff_chunk_len;
+// mh - the prefetch threads read sounds as well, so each thread has its own place in the file
+#ifdef _MSC_VER
+#define WAV_THREADLOCAL	__declspec (thread)
+#else
+#define WAV_THREADLOCAL	__thread
+#endif
+
+WAV_THREADLOCAL byte	*data_p;
+WAV_THREADLOCAL byte 	*iff_end;
+WAV_THREADLOCAL byte 	*last_chunk;
+WAV_THREADLOCAL byte 	*iff_data;
+WAV_THREADLOCAL int 	iff_chunk_len;
 
 
 short GetLittleShort(void)
@@ -195,7 +310,8 @@ void FindNextChunk(char *name)
 	{
 		data_p=last_chunk;
 
-		if (data_p >= iff_end)
+		// mh - the file is read straight from it's mapping, so a chunk header that's cut short ends it too
+		if (iff_end - data_p < 8)
 		{	// didn't find the chunk
 			data_p = NULL;
 			return;
@@ -230,22 +346,26 @@ void DumpChunks(void)
 	
 	str[4] = 0;
 	data_p=iff_data;
-	do
+	while (iff_end - data_p >= 8)
 	{
 		memcpy (str, data_p, 4);
 		data_p += 4;
 		iff_chunk_len = GetLittleLong();
 		Con_Printf ("0x%x : %s (%d)\n", (int)(data_p - 4), str, iff_chunk_len);
 		data_p += (iff_chunk_len + 1) & ~1;
-	} while (data_p < iff_end);
+	}
 }
 
+static char wav_badlooplength[] = "bad loop length";
+
 /*
 ============
-GetWavinfo
+ParseWavinfo
+
+mh - GetWavinfo without the messages, so that it can run on any thread; returns what's wrong with the file, or NULL
 ============
 */
-wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength)
+static char *ParseWavinfo (byte *wav, int wavlength, wavinfo_t *out)
 {
 	wavinfo_t	info;
 	int     i;
@@ -253,19 +373,20 @@ wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength)
 	int		samples;
 
 	memset (&info, 0, sizeof(info));
+	*out = info;
 
 	if (!wav)
-		return info;
-		
+		return NULL;
+
 	iff_data = wav;
 	iff_end = wav + wavlength;
 
 // find "RIFF" chunk
 	FindChunk("RIFF");
-	if (!(data_p && !Q_strncmp(data_p+8, "WAVE", 4)))
+	if (!(data_p && iff_end - data_p >= 12 && !Q_strncmp(data_p+8, "WAVE", 4)))
 	{
-		Con_Printf("Missing RIFF/WAVE chunks\n");
-		return info;
+		*out = info;
+		return "Missing RIFF/WAVE chunks";
 	}
 
 // get "fmt " chunk
@@ -273,17 +394,17 @@ wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength)
 // DumpChunks ();
 
 	FindChunk("fmt ");
-	if (!data_p)
+	if (!data_p || iff_end - data_p < 24)
 	{
-		Con_Printf("Missing fmt chunk\n");
-		return info;
+		*out = info;
+		return "Missing fmt chunk";
 	}
 	data_p += 8;
 	format = GetLittleShort();
 	if (format != 1)
 	{
-		Con_Printf("Microsoft PCM format only\n");
-		return info;
+		*out = info;
+		return "Microsoft PCM format only";
 	}
 
 	info.channels = GetLittleShort();
@@ -293,7 +414,7 @@ wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength)
 
 // get cue chunk
 	FindChunk("cue ");
-	if (data_p)
+	if (data_p && iff_end - data_p >= 36)
 	{
 		data_p += 32;
 		info.loopstart = GetLittleLong();
@@ -301,7 +422,7 @@ wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength)
 
 	// if the next chunk is a LIST chunk, look for a cue length marker
 		FindNextChunk ("LIST");
-		if (data_p)
+		if (data_p && iff_end - data_p >= 32)
 		{
 			if (!strncmp (data_p + 28, "mark", 4))
 			{	// this is not a proper parse, but it works with cooledit...
@@ -319,23 +440,54 @@ wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength)
 	FindChunk("data");
 	if (!data_p)
 	{
-		Con_Printf("Missing data chunk\n");
-		return info;
+		*out = info;
+		return "Missing data chunk";
 	}
 
 	data_p += 4;
+
+	if (info.width < 1)
+	{
+		*out = info;
+		return "Bad sample width";
+	}
+
 	samples = GetLittleLong () / info.width;
 
 	if (info.samples)
 	{
 		if (samples < info.samples)
-			Sys_Error ("Sound %s has a bad loop length", name);
+		{
+			*out = info;
+			return wav_badlooplength;
+		}
 	}
 	else
 		info.samples = samples;
 
 	info.dataofs = data_p - wav;
-	
+
+	*out = info;
+	return NULL;
+}
+
+/*
+============
+GetWavinfo
+============
+*/
+wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength)
+{
+	wavinfo_t	info;
+	char	*error;
+
+	error = ParseWavinfo (wav, wavlength, &info);
+
+	if (error == wav_badlooplength)
+		Sys_Error ("Sound %s has a bad loop length", name);
+	else if (error)
+		Con_Printf ("%s\n", error);
+
 	return info;
 }
 
@@ -165,6 +165,9 @@ extern int		snd_blocked;
 
 void S_LocalSound (char *s);
 sfxcache_t *S_LoadSound (sfx_t *s);
+sfxcache_t *S_DecodeSound (const byte *data, int filelen, int *size);
+sfxcache_t *S_CommitSound (sfx_t *s, sfxcache_t *decoded, int size);
+sfx_t *S_PrefetchTarget (char *name);
 
 wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength);
 
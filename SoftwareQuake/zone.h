@@ -125,6 +125,8 @@ void *Cache_Alloc (cache_user_t *c, int size, char *name);
 // Returns NULL if all purgable data was tossed and there still
 // wasn't enough room.
 
+extern int cache_allocated;	// mh - in total, for the load profiler
+
 void Cache_Report (void);
 
 
@@ -0,0 +1,217 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// md5bench.c -- runs the benchmd5 command from the command line, without a renderer
+
+// usage is the same as the engine, with the search path set up from -basedir, -game and -path and commands and cvars
+// given with +, for example:
+//
+//	md5bench -basedir /quake +r_md5animcompress 1 +benchmd5 progs/ogre 16 4 +benchmd5 progs/shambler
+//
+// the MD5 code is the software renderer's, which doesn't need anything from the renderer to load or skin a model.
+
+#include "quakedef.h"
+#include <sys/resource.h>
+
+#define DEFAULT_MEMORY	(256 * 1024 * 1024)
+
+extern cvar_t	developer;
+
+extern cvar_t	r_md5animcompress;
+extern cvar_t	r_md5weldtolerance;
+extern cvar_t	r_md5skin;
+extern cvar_t	r_md5skincheck;
+extern cvar_t	r_md5lerp;
+extern cvar_t	r_md5lod;
+extern cvar_t	r_md5parsethreads;
+
+// so that the filesystem can read pak files
+short	ShortSwap (short l);
+short	ShortNoSwap (short l);
+int		LongSwap (int l);
+int		LongNoSwap (int l);
+float	FloatSwap (float f);
+float	FloatNoSwap (float f);
+
+void COM_InitFilesystem (void);
+void Cmd_SetArgs (int argc, char **argv);
+int Hunk_PeakUsed (void);
+void MD5_Benchmark_f (void);
+void COM_TimeFindFile_f (void);
+void COM_MissedFiles_f (void);
+void Prof_LoadProf_f (void);
+void Prof_LoadTrace_f (void);
+
+
+/*
+==================
+Bench_InitSwap
+
+the same as COM_Init, which can't be used because it also insists on a registered copy for -game and -path
+==================
+*/
+static void Bench_InitSwap (void)
+{
+	byte	swaptest[2] = {1,0};
+
+	if (*(short *)swaptest == 1)
+	{
+		bigendien = false;
+		BigShort = ShortSwap;
+		LittleShort = ShortNoSwap;
+		BigLong = LongSwap;
+		LittleLong = LongNoSwap;
+		BigFloat = FloatSwap;
+		LittleFloat = FloatNoSwap;
+	}
+	else
+	{
+		bigendien = true;
+		BigShort = ShortNoSwap;
+		LittleShort = ShortSwap;
+		BigLong = LongNoSwap;
+		LittleLong = LongSwap;
+		BigFloat = FloatNoSwap;
+		LittleFloat = FloatSwap;
+	}
+}
+
+
+/*
+==================
+Bench_RunCommands
+
+runs each +command on the command line in order; a command's arguments are everything up to the next + or -
+==================
+*/
+static int Bench_RunCommands (void)
+{
+	int		i, j, numruns = 0;
+	cvar_t	*var;
+
+	for (i = 1; i < com_argc; i = j)
+	{
+		for (j = i + 1; j < com_argc; j++)
+			if (com_argv[j][0] == '+' || com_argv[j][0] == '-')
+				break;
+
+		if (com_argv[i][0] != '+')
+			continue;
+
+		// the command name goes in as argv 0, without the +
+		com_argv[i]++;
+		Cmd_SetArgs (j - i, com_argv + i);
+
+		if (!strcmp (Cmd_Argv (0), "benchmd5"))
+		{
+			MD5_Benchmark_f ();
+			numruns++;
+		}
+		else if (!strcmp (Cmd_Argv (0), "timefindfile"))
+		{
+			COM_TimeFindFile_f ();
+			numruns++;
+		}
+		else if (!strcmp (Cmd_Argv (0), "missedfiles"))
+		{
+			COM_MissedFiles_f ();
+			numruns++;
+		}
+		else if (!strcmp (Cmd_Argv (0), "loadprof"))
+		{
+			Prof_LoadProf_f ();
+			numruns++;
+		}
+		else if (!strcmp (Cmd_Argv (0), "loadtrace"))
+		{
+			Prof_LoadTrace_f ();
+			numruns++;
+		}
+		else if ((var = Cvar_FindVar (Cmd_Argv (0))) != NULL)
+		{
+			if (Cmd_Argc () > 1)
+				Cvar_Set (var->name, Cmd_Argv (1));
+
+			Con_Printf ("\"%s\" is \"%s\"\n", var->name, var->string);
+		}
+		else Con_Printf ("Unknown command \"%s\"\n", Cmd_Argv (0));
+	}
+
+	return numruns;
+}
+
+
+/*
+==================
+main
+
+==================
+*/
+int main (int argc, char **argv)
+{
+	struct rusage	usage;
+	int		i;
+
+	COM_InitArgv (argc, argv);
+
+	host_parms.basedir = ".";
+	host_parms.argc = com_argc;
+	host_parms.argv = com_argv;
+
+	host_parms.memsize = DEFAULT_MEMORY;
+
+	if ((i = COM_CheckParm ("-mem")) != 0 && i < com_argc - 1)
+		host_parms.memsize = Q_atoi (com_argv[i + 1]) * 1024 * 1024;
+
+	host_parms.membase = malloc (host_parms.memsize);
+
+	if (!host_parms.membase)
+		Sys_Error ("Not enough memory free; use -mem to make the hunk smaller");
+
+	Memory_Init (host_parms.membase, host_parms.memsize);
+
+	Cvar_RegisterVariable (&developer);
+	Cvar_RegisterVariable (&r_md5animcompress);
+	Cvar_RegisterVariable (&r_md5weldtolerance);
+	Cvar_RegisterVariable (&r_md5skin);
+	Cvar_RegisterVariable (&r_md5skincheck);
+	Cvar_RegisterVariable (&r_md5lerp);
+	Cvar_RegisterVariable (&r_md5lod);
+	Cvar_RegisterVariable (&r_md5parsethreads);
+
+	Bench_InitSwap ();
+	Prof_Init ();
+	COM_InitFilesystem ();
+
+	if (!Bench_RunCommands ())
+	{
+		Con_Printf ("usage : md5bench [-basedir <dir>] [-game <dir>] [-path <dir or pak> ...] [-mem <MB>] [+<cvar> <value> ...]\n");
+		Con_Printf ("                 +benchmd5 <model> [iterations] [blends] [+benchmd5 ...]\n");
+		Con_Printf ("                 +timefindfile [iterations] +missedfiles [count]\n");
+		Con_Printf ("                 +loadprof [count] +loadtrace [file]\n");
+		return 1;
+	}
+
+	getrusage (RUSAGE_SELF, &usage);
+
+	Con_Printf ("peak memory : %i KB of hunk, %li KB resident\n", Hunk_PeakUsed () / 1024, usage.ru_maxrss);
+
+	return 0;
+}
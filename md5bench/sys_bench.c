@@ -0,0 +1,637 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sys_bench.c -- null system interface for md5bench
+
+// just enough of the engine for the MD5 loader and skinning code and the common.c filesystem to run from a console:
+// stdio files, a single hunk with no high end that remembers how much of it was ever used, cvars that are only
+// looked up by name and console output straight to stdout.
+
+#include "quakedef.h"
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+quakeparms_t	host_parms;
+sizebuf_t		net_message;
+
+cvar_t	developer = {"developer", "0"};
+
+// the MD5 code links against these but md5bench never loads a model through them
+model_t	mod_known[1];
+int		mod_numknown;
+int		r_framecount;
+refdef_t	r_refdef;
+client_static_t	cls;
+server_t	sv;
+
+static byte	*hunk_base;
+static int	hunk_size;
+static int	hunk_low_used;
+static int	hunk_peak_used;
+
+static void	*hunk_tempbuf;
+
+cvar_t	*cvar_vars;
+
+// the arguments to the command md5bench is running
+static int		cmd_argc;
+static char		**cmd_argv;
+
+
+/*
+===============================================================================
+
+FILE IO
+
+===============================================================================
+*/
+
+#define MAX_HANDLES		10
+static FILE	*sys_handles[MAX_HANDLES];
+
+static int findhandle (void)
+{
+	int		i;
+
+	for (i=1 ; i<MAX_HANDLES ; i++)
+		if (!sys_handles[i])
+			return i;
+	Sys_Error ("out of handles");
+	return -1;
+}
+
+/*
+================
+filelength
+================
+*/
+static int filelength (FILE *f)
+{
+	int		pos;
+	int		end;
+
+	pos = ftell (f);
+	fseek (f, 0, SEEK_END);
+	end = ftell (f);
+	fseek (f, pos, SEEK_SET);
+
+	return end;
+}
+
+int Sys_FileOpenRead (char *path, int *hndl)
+{
+	FILE	*f;
+	int		i;
+
+	i = findhandle ();
+
+	f = fopen(path, "rb");
+	if (!f)
+	{
+		*hndl = -1;
+		return -1;
+	}
+	sys_handles[i] = f;
+	*hndl = i;
+
+	return filelength(f);
+}
+
+int Sys_FileOpenWrite (char *path)
+{
+	FILE	*f;
+	int		i;
+
+	i = findhandle ();
+
+	f = fopen(path, "wb");
+	if (!f)
+		Sys_Error ("Error opening %s: %s", path,strerror(errno));
+	sys_handles[i] = f;
+
+	return i;
+}
+
+void Sys_FileClose (int handle)
+{
+	fclose (sys_handles[handle]);
+	sys_handles[handle] = NULL;
+}
+
+void Sys_FileSeek (int handle, int position)
+{
+	fseek (sys_handles[handle], position, SEEK_SET);
+}
+
+int Sys_FileRead (int handle, void *dest, int count)
+{
+	return fread (dest, 1, count, sys_handles[handle]);
+}
+
+int Sys_FileWrite (int handle, void *data, int count)
+{
+	return fwrite (data, 1, count, sys_handles[handle]);
+}
+
+int	Sys_FileTime (char *path)
+{
+	FILE	*f;
+
+	f = fopen(path, "rb");
+	if (f)
+	{
+		fclose(f);
+		return 1;
+	}
+
+	return -1;
+}
+
+void Sys_mkdir (char *path)
+{
+	mkdir (path, 0777);
+}
+
+qboolean Sys_ListDirectory (char *path, sysdirfunc_t func, void *param)
+{
+	DIR				*dir;
+	struct dirent	*ent;
+	struct stat		st;
+	char			full[MAX_OSPATH * 2];
+
+	if ((dir = opendir (path)) == NULL)
+		return false;
+
+	while ((ent = readdir (dir)) != NULL)
+	{
+		if (!strcmp (ent->d_name, ".") || !strcmp (ent->d_name, ".."))
+			continue;
+
+		snprintf (full, sizeof (full), "%s/%s", path, ent->d_name);
+
+		if (stat (full, &st))
+			continue;
+
+		func (ent->d_name, S_ISDIR (st.st_mode) ? true : false, param);
+	}
+
+	closedir (dir);
+	return true;
+}
+
+void *Sys_MapFile (char *path, int *length)
+{
+	struct stat	st;
+	void		*data;
+	int			fd;
+
+	if ((fd = open (path, O_RDONLY)) == -1)
+		return NULL;
+
+	if (fstat (fd, &st) || st.st_size <= 0 || st.st_size >= 0x7fffffff)
+	{
+		close (fd);
+		return NULL;
+	}
+
+	data = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+
+	if (data == MAP_FAILED)
+		return NULL;
+
+	*length = (int) st.st_size;
+	return data;
+}
+
+void Sys_UnmapFile (void *data, int length)
+{
+	munmap (data, length);
+}
+
+
+/*
+===============================================================================
+
+SYSTEM IO
+
+===============================================================================
+*/
+
+void Sys_Error (char *error, ...)
+{
+	va_list		argptr;
+
+	printf ("Sys_Error: ");
+	va_start (argptr,error);
+	vprintf (error,argptr);
+	va_end (argptr);
+	printf ("\n");
+
+	exit (1);
+}
+
+// only developer output, the same as the client where it only goes to a dedicated server's console
+void Sys_Printf (char *fmt, ...)
+{
+	va_list		argptr;
+
+	if (!developer.value)
+		return;
+
+	va_start (argptr,fmt);
+	vprintf (fmt,argptr);
+	va_end (argptr);
+}
+
+void Sys_Quit (void)
+{
+	exit (0);
+}
+
+double Sys_FloatTime (void)
+{
+	struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec * 0.000000001;
+}
+
+void Con_Printf (char *fmt, ...)
+{
+	va_list		argptr;
+
+	va_start (argptr,fmt);
+	vprintf (fmt,argptr);
+	va_end (argptr);
+}
+
+void Con_DPrintf (char *fmt, ...)
+{
+	va_list		argptr;
+
+	if (!developer.value)
+		return;
+
+	va_start (argptr,fmt);
+	vprintf (fmt,argptr);
+	va_end (argptr);
+}
+
+// there's no screen to draw a loading disc on
+void Draw_BeginDisc (void)
+{
+}
+
+void Draw_EndDisc (void)
+{
+}
+
+// only needed by MD5_LoadSkins, which md5bench never gets to
+void SwapPic (qpic_t *pic)
+{
+}
+
+
+/*
+===============================================================================
+
+MEMORY
+
+===============================================================================
+*/
+
+/*
+========================
+Memory_Init
+========================
+*/
+void Memory_Init (void *buf, int size)
+{
+	hunk_base = buf;
+	hunk_size = size;
+	hunk_low_used = 0;
+	hunk_peak_used = 0;
+}
+
+/*
+===================
+Hunk_AllocName
+===================
+*/
+void *Hunk_AllocName (int size, char *name)
+{
+	void	*buf;
+
+	if (size < 0)
+		Sys_Error ("Hunk_Alloc: bad size: %i", size);
+
+	size = (size + 15) & ~15;
+
+	if (hunk_size - hunk_low_used < size)
+		Sys_Error ("Hunk_Alloc: failed on %i bytes; use -mem to make the hunk bigger", size);
+
+	buf = hunk_base + hunk_low_used;
+	hunk_low_used += size;
+
+	if (hunk_low_used > hunk_peak_used)
+		hunk_peak_used = hunk_low_used;
+
+	memset (buf, 0, size);
+
+	return buf;
+}
+
+void *Hunk_Alloc (int size)
+{
+	return Hunk_AllocName (size, "unknown");
+}
+
+int	Hunk_LowMark (void)
+{
+	return hunk_low_used;
+}
+
+void Hunk_FreeToLowMark (int mark)
+{
+	if (mark < 0 || mark > hunk_low_used)
+		Sys_Error ("Hunk_FreeToLowMark: bad mark %i", mark);
+	hunk_low_used = mark;
+}
+
+/*
+===================
+Hunk_PeakUsed
+
+the most hunk that was ever in use at once
+===================
+*/
+int Hunk_PeakUsed (void)
+{
+	return hunk_peak_used;
+}
+
+/*
+===================
+Hunk_TempAlloc
+
+only good until the next call, the same as in zone.c
+===================
+*/
+void *Hunk_TempAlloc (int size)
+{
+	if (hunk_tempbuf)
+		free (hunk_tempbuf);
+
+	hunk_tempbuf = calloc (1, size);
+
+	if (!hunk_tempbuf)
+		Sys_Error ("Hunk_TempAlloc: failed on %i bytes", size);
+
+	return hunk_tempbuf;
+}
+
+void *Z_Malloc (int size)
+{
+	void	*buf;
+
+	buf = calloc (1, size);
+	if (!buf)
+		Sys_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+
+	return buf;
+}
+
+// there's no cache; COM_LoadFile errors out on anything that asks for it
+int cache_allocated;
+
+void *Cache_Alloc (cache_user_t *c, int size, char *name)
+{
+	return NULL;
+}
+
+void *Cache_Check (cache_user_t *c)
+{
+	return NULL;
+}
+
+void Cache_Free (cache_user_t *c)
+{
+}
+
+
+/*
+===============================================================================
+
+THREADS
+
+===============================================================================
+*/
+
+typedef struct systhread_s
+{
+	threadfunc_t	func;
+	void			*param;
+} systhread_t;
+
+
+static void *Sys_ThreadProc (void *param)
+{
+	systhread_t thread = *(systhread_t *) param;
+
+	free (param);
+	thread.func (thread.param);
+
+	return NULL;
+}
+
+
+int Sys_NumProcessors (void)
+{
+	long	count = sysconf (_SC_NPROCESSORS_ONLN);
+
+	return count > 0 ? (int) count : 1;
+}
+
+
+qboolean Sys_CreateThread (threadfunc_t func, void *param)
+{
+	systhread_t	*thread = (systhread_t *) malloc (sizeof (systhread_t));
+	pthread_t	tid;
+
+	if (!thread) return false;
+
+	thread->func = func;
+	thread->param = param;
+
+	if (pthread_create (&tid, NULL, Sys_ThreadProc, thread))
+	{
+		free (thread);
+		return false;
+	}
+
+	pthread_detach (tid);
+
+	return true;
+}
+
+
+// maxcount is only a limit on Windows
+void *Sys_CreateSemaphore (int maxcount)
+{
+	sem_t	*sem = (sem_t *) malloc (sizeof (sem_t));
+
+	if (sem && sem_init (sem, 0, 0))
+	{
+		free (sem);
+		return NULL;
+	}
+
+	return sem;
+}
+
+
+void Sys_SemaphoreWait (void *sem)
+{
+	while (sem_wait ((sem_t *) sem) && errno == EINTR);
+}
+
+
+void Sys_SemaphoreRelease (void *sem, int count)
+{
+	while (count-- > 0)
+		sem_post ((sem_t *) sem);
+}
+
+
+int Sys_AtomicIncrement (volatile int *value)
+{
+	return __sync_add_and_fetch (value, 1);
+}
+
+
+int Sys_AtomicDecrement (volatile int *value)
+{
+	return __sync_sub_and_fetch (value, 1);
+}
+
+
+double Sys_ThreadTime (void)
+{
+	return Sys_FloatTime ();
+}
+
+
+void Sys_Sleep (void)
+{
+	usleep (1000);
+}
+
+
+/*
+===============================================================================
+
+CVARS AND COMMANDS
+
+===============================================================================
+*/
+
+cvar_t *Cvar_FindVar (char *var_name)
+{
+	cvar_t	*var;
+
+	for (var=cvar_vars ; var ; var=var->next)
+		if (!strcmp (var_name, var->name))
+			return var;
+
+	return NULL;
+}
+
+void Cvar_RegisterVariable (cvar_t *variable)
+{
+	char	*oldstr;
+
+	if (Cvar_FindVar (variable->name))
+		return;
+
+	// copy the value off, because future sets will Z_Free it
+	oldstr = variable->string;
+	variable->string = Z_Malloc (strlen(variable->string)+1);
+	strcpy (variable->string, oldstr);
+	variable->value = atof (variable->string);
+
+	variable->next = cvar_vars;
+	cvar_vars = variable;
+}
+
+void Cvar_Set (char *var_name, char *value)
+{
+	cvar_t	*var;
+
+	var = Cvar_FindVar (var_name);
+	if (!var)
+	{
+		Con_Printf ("Cvar_Set: variable %s not found\n", var_name);
+		return;
+	}
+
+	free (var->string);
+	var->string = Z_Malloc (strlen(value)+1);
+	strcpy (var->string, value);
+	var->value = atof (var->string);
+}
+
+// there's no console to run them from
+void Cmd_AddCommand (char *cmd_name, xcommand_t function)
+{
+}
+
+/*
+============
+Cmd_SetArgs
+
+md5bench runs each command itself, with the arguments straight from the command line
+============
+*/
+void Cmd_SetArgs (int argc, char **argv)
+{
+	cmd_argc = argc;
+	cmd_argv = argv;
+}
+
+int Cmd_Argc (void)
+{
+	return cmd_argc;
+}
+
+char *Cmd_Argv (int arg)
+{
+	if (arg < 0 || arg >= cmd_argc)
+		return "";
+
+	return cmd_argv[arg];
+}